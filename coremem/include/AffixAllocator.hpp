@@ -0,0 +1,65 @@
+#pragma once
+
+#include <IAllocator.hpp>
+
+namespace coremem
+{
+/*
+Wraps another allocator and surrounds each block with a user prefix and a
+suffix canary.
+
+  parent block
+  v
+  |..|  prefix  | header |      user block       | suffix canary |
+                         ^ returned address
+
+  * prefix - prefixSize bytes of user data, e.g. a debug tag or a ref count.
+             Accessible through GetPrefix().
+  * header - block size, offset to the parent block and a canary word.
+  * suffix - suffixSize bytes filled with a pattern. Buffer overruns are
+             detected by CheckCanaries() and asserted on free.
+
+Stack it on top of any allocator to debug memory corruption in a single
+subsystem without touching the rest of the allocator chain.
+*/
+class AffixAllocator : public IAllocator
+{
+private:
+  struct AffixHeader
+  {
+    size_t size;
+    size_t offset; // from the parent block to the user block
+    uint32_t canary;
+  };
+
+public:
+  static constexpr uint32_t HEADER_CANARY = 0xC0DEFACE;
+  static constexpr uint8_t SUFFIX_PATTERN = 0xFD;
+
+  AffixAllocator(IAllocator& parent, size_t prefixSize, size_t suffixSize);
+
+  virtual ~AffixAllocator();
+
+  virtual void* allocate(size_t size, size_t alignment) override;
+  virtual void free(void* p) override;
+  virtual void clear() override;
+  virtual bool owns(const void* p) const override;
+  virtual bool hasExactOwnership() const override
+  {
+    return this->m_Parent.hasExactOwnership();
+  }
+
+  // user prefix of a block returned by allocate
+  void* GetPrefix(void* p) const;
+  // false if the header or the suffix of the block were overwritten
+  bool CheckCanaries(const void* p) const;
+
+private:
+  const AffixHeader* getHeader(const void* p) const;
+
+  IAllocator& m_Parent;
+
+  const size_t PREFIX_SIZE;
+  const size_t SUFFIX_SIZE;
+};
+} // namespace coremem
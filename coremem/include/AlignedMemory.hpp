@@ -0,0 +1,179 @@
+#pragma once
+
+#include <IAllocator.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace coremem
+{
+/*
+Helpers for memory which has to be aligned beyond alignof(max_align_t).
+
+  * SIMD kernels want every stream of an SoA array to start on a cache line
+(64 bytes) so loads never split lines and AVX-512 loads are naturally aligned.
+  * DMA-style staging copies (e.g. to mapped vulkan memory) prefer page (4096)
+aligned blocks.
+  * Data written by different threads must not share a cache line, otherwise
+the line ping-pongs between cores (false sharing).
+
+SoA layout of N elements with streams A, B, C:
+
+  base                 base + offset(B)      base + offset(C)
+   v                    v                     v
+  |AAAAAAAAAAAAA.......|BBBBBBBBBBBBBBB.....|CCCCCCCCC..........|
+                ^ padding up to the stream alignment
+*/
+static constexpr size_t CACHE_LINE_SIZE = 64;
+static constexpr size_t PAGE_SIZE = 4096;
+
+// allocates memory from the OS with an arbitrary power of two alignment
+void* AlignedAlloc(size_t memSize, size_t alignment);
+void AlignedFree(void* p);
+
+/* Owns an aligned block of OS memory. Move-only. */
+class AlignedBuffer final
+{
+public:
+  AlignedBuffer() = default;
+  AlignedBuffer(size_t memSize, size_t alignment = CACHE_LINE_SIZE);
+  ~AlignedBuffer();
+
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+  AlignedBuffer(AlignedBuffer&& other) noexcept;
+  AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+
+  inline void* GetMemory() const
+  {
+    return this->m_Memory;
+  }
+  inline size_t GetMemorySize() const
+  {
+    return this->m_MemorySize;
+  }
+
+private:
+  void* m_Memory = nullptr;
+  size_t m_MemorySize = 0;
+};
+
+/* Wraps T so that it occupies whole cache lines. Use for per-thread counters
+ * and blocks, e.g. std::vector<CacheLinePadded<Counter>>. */
+template <typename T>
+struct alignas(CACHE_LINE_SIZE) CacheLinePadded
+{
+  T value{};
+};
+
+// size of one per-thread block, rounded up so neighbour blocks never share a
+// cache line
+static inline size_t PaddedBlockSize(
+    size_t blockSize, size_t alignment = CACHE_LINE_SIZE)
+{
+  return pointer_math::AlignUp(blockSize, alignment);
+}
+
+static inline void* GetThreadBlock(
+    void* base, size_t paddedBlockSize, size_t threadIndex)
+{
+  return reinterpret_cast<void*>(
+      reinterpret_cast<uintptr_t>(base) + paddedBlockSize * threadIndex);
+}
+
+/*
+Computes the layout of an SoA array with one stream per type in Ts.
+Every stream starts at a multiple of the stream alignment relative to the base
+address, so the whole array is aligned as long as the base is.
+*/
+template <typename... Ts>
+struct SoALayout
+{
+  static constexpr size_t STREAM_COUNT = sizeof...(Ts);
+
+  static size_t StreamOffset(
+      size_t streamIndex, size_t capacity,
+      size_t alignment = CACHE_LINE_SIZE)
+  {
+    assert(streamIndex <= STREAM_COUNT);
+    const size_t sizes[] = {sizeof(Ts)...};
+
+    size_t offset = 0;
+    for (size_t i = 0; i < streamIndex; ++i)
+    {
+      offset += pointer_math::AlignUp(sizes[i] * capacity, alignment);
+    }
+    return offset;
+  }
+
+  // memory required for the whole array, base assumed to be aligned
+  static size_t MemorySize(size_t capacity, size_t alignment = CACHE_LINE_SIZE)
+  {
+    return StreamOffset(STREAM_COUNT, capacity, alignment);
+  }
+};
+
+/*
+Non-owning view of an SoA array placed in a memory block. The memory can come
+from any IAllocator or from an AlignedBuffer:
+
+  using Particles = coremem::SoAArray<glm::vec4, glm::vec4, float>;
+  coremem::AlignedBuffer mem(Particles::Layout::MemorySize(count));
+  Particles particles(mem.GetMemory(), count);
+  glm::vec4* positions = particles.Stream<0>();
+*/
+template <typename... Ts>
+class SoAArray
+{
+public:
+  using Layout = SoALayout<Ts...>;
+
+  SoAArray() = default;
+  SoAArray(void* mem, size_t capacity, size_t alignment = CACHE_LINE_SIZE)
+    : m_Memory(mem), m_Capacity(capacity)
+  {
+    assert(
+        pointer_math::GetAdjustment(mem, alignment) == 0 &&
+        "SoAArray memory is not aligned to the stream alignment.");
+    for (size_t i = 0; i < Layout::STREAM_COUNT; ++i)
+    {
+      m_Offsets[i] = Layout::StreamOffset(i, capacity, alignment);
+    }
+  }
+
+  // allocates the array from an allocator, memory is owned by the allocator
+  static SoAArray Allocate(
+      IAllocator& allocator, size_t capacity,
+      size_t alignment = CACHE_LINE_SIZE)
+  {
+    void* mem =
+        allocator.allocate(Layout::MemorySize(capacity, alignment), alignment);
+    assert(mem != nullptr && "Unable to allocate SoA array. Out of memory?!");
+    return SoAArray(mem, capacity, alignment);
+  }
+
+  template <size_t I>
+  inline auto* Stream() const
+  {
+    using T = std::tuple_element_t<I, std::tuple<Ts...>>;
+    return reinterpret_cast<T*>(
+        reinterpret_cast<uintptr_t>(m_Memory) + m_Offsets[I]);
+  }
+
+  inline void* GetMemory() const
+  {
+    return m_Memory;
+  }
+  inline size_t GetCapacity() const
+  {
+    return m_Capacity;
+  }
+
+private:
+  void* m_Memory = nullptr;
+  size_t m_Capacity = 0;
+  size_t m_Offsets[sizeof...(Ts) > 0 ? sizeof...(Ts) : 1]{};
+};
+} // namespace coremem
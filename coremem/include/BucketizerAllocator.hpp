@@ -0,0 +1,57 @@
+#pragma once
+
+#include <PoolAllocator.hpp>
+
+#include <vector>
+
+namespace coremem
+{
+/*
+Array of pool allocators, one per size class. The given memory is split evenly
+between the buckets:
+
+ minSize      minSize+step   minSize+2*step        maxSize
+|  pool 0    |   pool 1     |    pool 2     | ... | pool N |
+^ mem                                                      ^ mem + memSize
+
+A request is served by the first bucket whose size class fits it, so
+allocation and deallocation stay O(1) pool operations. Requests larger than
+maxSize, requests with an alignment above the bucket alignment, and requests
+hitting an exhausted bucket return nullptr, which makes the bucketizer a good
+primary for FallbackAllocator or the small side of SegregatorAllocator.
+*/
+class BucketizerAllocator : public IAllocator
+{
+public:
+  BucketizerAllocator(
+      size_t memSize, const void* mem, size_t minSize, size_t maxSize,
+      size_t step, size_t alignment = alignof(std::max_align_t));
+
+  virtual ~BucketizerAllocator();
+
+  virtual void* allocate(size_t size, size_t alignment) override;
+  virtual void free(void* p) override;
+  virtual void clear() override;
+
+  inline size_t GetBucketCount() const
+  {
+    return this->m_Buckets.size();
+  }
+  inline const PoolAllocator& GetBucket(size_t index) const
+  {
+    return *this->m_Buckets[index];
+  }
+
+private:
+  size_t bucketIndexForSize(size_t size) const;
+  size_t bucketIndexForAddress(const void* p) const;
+
+  const size_t MIN_SIZE;
+  const size_t MAX_SIZE;
+  const size_t STEP;
+  const size_t ALIGNMENT;
+
+  size_t m_BucketMemorySize;
+  std::vector<PoolAllocator*> m_Buckets;
+};
+} // namespace coremem
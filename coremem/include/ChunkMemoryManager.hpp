@@ -200,8 +200,13 @@ public:
   }
 
 private:
-  static const size_t ALLOC_SIZE =
-      (sizeof(ObjectType) + alignof(ObjectType)) * MAX_CHUNK_OBJECTS;
+  // slots are packed at the aligned object stride, only the chunk start may
+  // need an adjustment of up to alignof - 1 bytes.
+  static constexpr size_t ALLOC_SIZE =
+      ((sizeof(ObjectType) + alignof(ObjectType) - 1) &
+       ~(alignof(ObjectType) - 1)) *
+          MAX_CHUNK_OBJECTS +
+      (alignof(ObjectType) - 1);
 
   const char* m_AllocatorTag = nullptr;
   MemoryChunks m_Chunks;
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <IAllocator.hpp>
+
+namespace coremem
+{
+/*
+Composed allocator which tries the primary allocator first and falls back to
+the secondary one if the primary is out of memory.
+
+   allocate ---> primary ---(nullptr)---> fallback
+   free     ---> primary.owns(p) ? primary : fallback
+
+Typical use is a fast fixed size arena backed by a slower general purpose
+allocator (e.g. SystemAllocator) for the rare overflow. The primary must own
+exactly (hasExactOwnership), otherwise it would take the fallback's blocks.
+The composed allocators do not own any memory themselves, so memory size and
+used memory are reported by the wrapped allocators.
+
+clear() clears both. Blocks of a SystemAllocator fallback survive it and are
+still freed through this allocator.
+*/
+class FallbackAllocator : public IAllocator
+{
+public:
+  FallbackAllocator(IAllocator& primary, IAllocator& fallback);
+
+  virtual ~FallbackAllocator();
+
+  virtual void* allocate(size_t size, size_t alignment) override;
+  virtual void free(void* p) override;
+  virtual void clear() override;
+  virtual bool owns(const void* p) const override;
+  virtual bool hasExactOwnership() const override
+  {
+    return this->m_Primary.hasExactOwnership() &&
+           this->m_Fallback.hasExactOwnership();
+  }
+
+private:
+  IAllocator& m_Primary;
+  IAllocator& m_Fallback;
+};
+} // namespace coremem
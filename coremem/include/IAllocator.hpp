@@ -1,11 +1,23 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
 
 namespace coremem
 {
 namespace pointer_math
 {
-static inline void* AlignForward(void* address, uint8_t alignment)
+static inline bool IsPowerOfTwo(size_t value)
+{
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+// rounds size up to the next multiple of alignment (power of two)
+static inline size_t AlignUp(size_t size, size_t alignment)
+{
+  return (size + (alignment - 1)) & ~(alignment - 1);
+}
+
+static inline void* AlignForward(void* address, size_t alignment)
 {
   return (void*)((reinterpret_cast<uintptr_t>(address) +
                   static_cast<uintptr_t>(alignment - 1)) &
@@ -13,20 +25,20 @@ static inline void* AlignForward(void* address, uint8_t alignment)
 }
 
 // returns the number of bytes needed to align the address
-static inline uint8_t GetAdjustment(const void* address, uint8_t alignment)
+static inline size_t GetAdjustment(const void* address, size_t alignment)
 {
-  uint8_t adjustment = alignment - (reinterpret_cast<uintptr_t>(address) &
-                                    static_cast<uintptr_t>(alignment - 1));
+  size_t adjustment = alignment - (reinterpret_cast<uintptr_t>(address) &
+                                   static_cast<uintptr_t>(alignment - 1));
 
   return adjustment == alignment ? 0 : adjustment;
 }
 
-static inline uint8_t GetAdjustment(
-    const void* address, uint8_t alignment, uint8_t extra)
+static inline size_t GetAdjustment(
+    const void* address, size_t alignment, size_t extra)
 {
-  uint8_t adjustment = GetAdjustment(address, alignment);
+  size_t adjustment = GetAdjustment(address, alignment);
 
-  uint8_t neededSpace = extra;
+  size_t neededSpace = extra;
 
   if (adjustment < neededSpace)
   {
@@ -48,10 +60,28 @@ public:
   IAllocator(const size_t memSize, const void* mem);
   virtual ~IAllocator();
 
-  virtual void* allocate(size_t size, uint8_t alignment) = 0;
+  /* alignment must be a power of two, it's not limited in size so cache line
+   * (64) or page (4096) aligned blocks can be requested as well. */
+  virtual void* allocate(size_t size, size_t alignment) = 0;
   virtual void free(void* p) = 0;
   virtual void clear() = 0;
 
+  // true if p was handed out by this allocator. Used by composed allocators
+  // (fallback, segregator, ...) to route free calls to the right owner.
+  virtual bool owns(const void* p) const
+  {
+    const uintptr_t adr = reinterpret_cast<uintptr_t>(p);
+    const uintptr_t first =
+        reinterpret_cast<uintptr_t>(this->m_MemoryFirstAddress);
+    return first <= adr && adr < first + this->m_MemorySize;
+  }
+  // false if owns() may answer true for foreign blocks as well (see
+  // SystemAllocator). Composed allocators only route by exact owners.
+  virtual bool hasExactOwnership() const
+  {
+    return true;
+  }
+
   // ACCESSOR
   inline size_t GetMemorySize() const
   {
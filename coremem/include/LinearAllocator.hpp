@@ -26,7 +26,7 @@ public:
 
   virtual ~LinearAllocator();
 
-  virtual void* allocate(size_t size, uint8_t alignment) override;
+  virtual void* allocate(size_t size, size_t alignment) override;
   virtual void free(void* p) override;
   virtual void clear() override;
 };
@@ -23,12 +23,14 @@ public:
   MemoryManager(const MemoryManager&) = delete;
   MemoryManager& operator=(MemoryManager&) = delete;
 
-  inline void* Allocate(size_t memSize, const char* user = nullptr)
+  inline void* Allocate(
+      size_t memSize, const char* user = nullptr,
+      size_t alignment = alignof(uint8_t))
   {
     printf(
         "%s allocated %zu bytes of global memory.",
         user != nullptr ? user : "Unknown", memSize);
-    void* pMemory = m_MemoryAllocator->allocate(memSize, alignof(uint8_t));
+    void* pMemory = m_MemoryAllocator->allocate(memSize, alignment);
 
     this->m_PendingMemory.push_back(
         std::pair<const char*, void*>(user, pMemory));
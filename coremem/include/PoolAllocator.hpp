@@ -27,19 +27,26 @@ class PoolAllocator : public IAllocator
 {
 private:
   const size_t OBJECT_SIZE;
-  const uint8_t OBJECT_ALIGNMENT;
+  const size_t OBJECT_ALIGNMENT;
+  // distance between two slots, object size rounded up to the alignment so
+  // every slot (not only the first one) stays aligned.
+  const size_t SLOT_SIZE;
 
   void** freeList;
 
 public:
   PoolAllocator(
       size_t memSize, const void* mem, size_t objectSize,
-      uint8_t objectAlignment);
+      size_t objectAlignment);
 
   virtual ~PoolAllocator();
 
-  virtual void* allocate(size_t size, uint8_t alignment) override;
+  virtual void* allocate(size_t size, size_t alignment) override;
   virtual void free(void* p) override;
   virtual void clear() override;
+
+  // memory required to hold objectCount objects including start adjustment
+  static size_t RequiredMemorySize(
+      size_t objectCount, size_t objectSize, size_t objectAlignment);
 };
 } // namespace coremem
\ No newline at end of file
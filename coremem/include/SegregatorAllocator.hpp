@@ -0,0 +1,57 @@
+#pragma once
+
+#include <IAllocator.hpp>
+
+namespace coremem
+{
+/*
+Composed allocator which routes requests by size.
+
+   size <= threshold ---> small allocator
+   size >  threshold ---> large allocator
+
+Segregators can be nested to build a size class ladder, e.g. small objects
+from a BucketizerAllocator, medium ones from a StackAllocator and huge blocks
+straight from the OS:
+
+  SegregatorAllocator medium(4096, stack, system);
+  SegregatorAllocator root(256, buckets, medium);
+
+free() is routed by ownership, the allocation size is not needed. The side
+that owns exactly(hasExactOwnership) is asked, so one side may end in a
+SystemAllocator, e.g. a small side of FallbackAllocator(pool, system) with a
+large side of an arena. At least one side has to own exactly.
+*/
+class SegregatorAllocator : public IAllocator
+{
+public:
+  SegregatorAllocator(
+      size_t threshold, IAllocator& smallAllocator,
+      IAllocator& largeAllocator);
+
+  virtual ~SegregatorAllocator();
+
+  virtual void* allocate(size_t size, size_t alignment) override;
+  virtual void free(void* p) override;
+  virtual void clear() override;
+  virtual bool owns(const void* p) const override;
+  virtual bool hasExactOwnership() const override
+  {
+    return this->m_Small.hasExactOwnership() &&
+           this->m_Large.hasExactOwnership();
+  }
+
+  inline size_t GetThreshold() const
+  {
+    return this->THRESHOLD;
+  }
+
+private:
+  const size_t THRESHOLD;
+
+  IAllocator& m_Small;
+  IAllocator& m_Large;
+  // the side free() asks, the other one gets what it doesn't own
+  const bool m_RouteBySmall;
+};
+} // namespace coremem
@@ -28,7 +28,7 @@ class StackAllocator : public IAllocator
 private:
   struct AllocMetaInfo
   {
-    uint8_t adjustment;
+    size_t adjustment; // wide enough for page aligned allocations
   };
 
 public:
@@ -36,7 +36,7 @@ public:
 
   virtual ~StackAllocator();
 
-  virtual void* allocate(size_t size, uint8_t alignment) override;
+  virtual void* allocate(size_t size, size_t alignment) override;
   virtual void free(void* p) override;
   virtual void clear() override;
 };
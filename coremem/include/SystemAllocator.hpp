@@ -0,0 +1,36 @@
+#pragma once
+
+#include <IAllocator.hpp>
+
+namespace coremem
+{
+/*
+Forwards every request to the OS (aligned malloc). Not fast, but never runs
+out of memory while the OS doesn't, so it's meant as the last stage of a
+composed allocator, e.g. FallbackAllocator(arena, system) or the large side of
+a SegregatorAllocator for huge blocks.
+
+The allocator can't tell its own blocks apart from foreign ones, owns() answers
+true for any non-null address. Keep it last in a chain.
+
+clear() does nothing, so a composed allocator can be cleared as a whole (e.g.
+a frame arena with a system overflow). The system blocks are kept and still
+have to be freed one by one, the allocation count keeps counting them.
+*/
+class SystemAllocator : public IAllocator
+{
+public:
+  SystemAllocator();
+
+  virtual ~SystemAllocator();
+
+  virtual void* allocate(size_t size, size_t alignment) override;
+  virtual void free(void* p) override;
+  virtual void clear() override;
+  virtual bool owns(const void* p) const override;
+  virtual bool hasExactOwnership() const override
+  {
+    return false;
+  }
+};
+} // namespace coremem
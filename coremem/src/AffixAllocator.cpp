@@ -0,0 +1,116 @@
+#include <AffixAllocator.hpp>
+#include <cassert>
+#include <cstring>
+
+using namespace coremem;
+
+AffixAllocator::AffixAllocator(
+    IAllocator& parent, size_t prefixSize, size_t suffixSize)
+  : IAllocator(0, nullptr), m_Parent(parent), PREFIX_SIZE(prefixSize),
+    SUFFIX_SIZE(suffixSize)
+{
+}
+
+AffixAllocator::~AffixAllocator()
+{
+}
+
+void* AffixAllocator::allocate(size_t memSize, size_t alignment)
+{
+  assert(memSize > 0 && "allocate called with memSize = 0.");
+  assert(
+      pointer_math::IsPowerOfTwo(alignment) &&
+      "alignment must be a power of two.");
+
+  if (alignment < alignof(AffixHeader)) alignment = alignof(AffixHeader);
+
+  // user block offset keeps the user block aligned as long as the parent
+  // block is, and leaves room for prefix + header in front of it
+  const size_t offset =
+      pointer_math::AlignUp(this->PREFIX_SIZE + sizeof(AffixHeader), alignment);
+
+  union
+  {
+    void* asVoidPtr;
+    uintptr_t asUptr;
+  };
+
+  asVoidPtr = this->m_Parent.allocate(
+      offset + memSize + this->SUFFIX_SIZE, alignment);
+  if (asVoidPtr == nullptr) return nullptr;
+
+  asUptr += offset;
+
+  AffixHeader* header =
+      reinterpret_cast<AffixHeader*>(asUptr - sizeof(AffixHeader));
+  header->size = memSize;
+  header->offset = offset;
+  header->canary = HEADER_CANARY;
+
+  if (this->SUFFIX_SIZE > 0)
+  {
+    std::memset(
+        reinterpret_cast<void*>(asUptr + memSize), SUFFIX_PATTERN,
+        this->SUFFIX_SIZE);
+  }
+
+  this->m_MemoryUsed += memSize;
+  this->m_MemoryAllocations++;
+
+  return asVoidPtr;
+}
+
+void AffixAllocator::free(void* mem)
+{
+  if (mem == nullptr) return;
+
+  assert(CheckCanaries(mem) && "AffixAllocator detected memory corruption!");
+
+  const AffixHeader* header = getHeader(mem);
+  this->m_MemoryUsed -= header->size;
+  this->m_MemoryAllocations--;
+
+  this->m_Parent.free(reinterpret_cast<void*>(
+      reinterpret_cast<uintptr_t>(mem) - header->offset));
+}
+
+void AffixAllocator::clear()
+{
+  this->m_Parent.clear();
+  this->m_MemoryUsed = 0;
+  this->m_MemoryAllocations = 0;
+}
+
+bool AffixAllocator::owns(const void* mem) const
+{
+  return this->m_Parent.owns(mem);
+}
+
+void* AffixAllocator::GetPrefix(void* mem) const
+{
+  assert(this->PREFIX_SIZE > 0 && "AffixAllocator has no prefix.");
+  return reinterpret_cast<void*>(
+      reinterpret_cast<uintptr_t>(mem) - sizeof(AffixHeader) -
+      this->PREFIX_SIZE);
+}
+
+bool AffixAllocator::CheckCanaries(const void* mem) const
+{
+  const AffixHeader* header = getHeader(mem);
+  if (header->canary != HEADER_CANARY) return false;
+
+  const uint8_t* suffix = static_cast<const uint8_t*>(mem) + header->size;
+  for (size_t i = 0; i < this->SUFFIX_SIZE; ++i)
+  {
+    if (suffix[i] != SUFFIX_PATTERN) return false;
+  }
+
+  return true;
+}
+
+const AffixAllocator::AffixHeader* AffixAllocator::getHeader(
+    const void* mem) const
+{
+  return reinterpret_cast<const AffixHeader*>(
+      reinterpret_cast<uintptr_t>(mem) - sizeof(AffixHeader));
+}
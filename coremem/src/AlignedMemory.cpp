@@ -0,0 +1,69 @@
+#include <AlignedMemory.hpp>
+
+#include <cstdlib>
+
+#if defined(_WIN32)
+  #include <malloc.h>
+#endif
+
+using namespace coremem;
+
+void* coremem::AlignedAlloc(size_t memSize, size_t alignment)
+{
+  assert(memSize > 0 && "AlignedAlloc called with memSize = 0.");
+  assert(
+      pointer_math::IsPowerOfTwo(alignment) &&
+      "alignment must be a power of two.");
+
+  // both APIs require at least pointer alignment
+  if (alignment < sizeof(void*)) alignment = sizeof(void*);
+
+#if defined(_WIN32)
+  return _aligned_malloc(memSize, alignment);
+#else
+  void* p = nullptr;
+  if (posix_memalign(&p, alignment, memSize) != 0) return nullptr;
+  return p;
+#endif
+}
+
+void coremem::AlignedFree(void* p)
+{
+#if defined(_WIN32)
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+AlignedBuffer::AlignedBuffer(size_t memSize, size_t alignment)
+  : m_Memory(AlignedAlloc(memSize, alignment)), m_MemorySize(memSize)
+{
+  assert(this->m_Memory != nullptr && "Failed to allocate aligned memory.");
+}
+
+AlignedBuffer::~AlignedBuffer()
+{
+  if (this->m_Memory != nullptr) AlignedFree(this->m_Memory);
+  this->m_Memory = nullptr;
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept
+  : m_Memory(other.m_Memory), m_MemorySize(other.m_MemorySize)
+{
+  other.m_Memory = nullptr;
+  other.m_MemorySize = 0;
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) noexcept
+{
+  if (this != &other)
+  {
+    if (this->m_Memory != nullptr) AlignedFree(this->m_Memory);
+    this->m_Memory = other.m_Memory;
+    this->m_MemorySize = other.m_MemorySize;
+    other.m_Memory = nullptr;
+    other.m_MemorySize = 0;
+  }
+  return *this;
+}
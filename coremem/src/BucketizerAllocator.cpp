@@ -0,0 +1,114 @@
+#include <BucketizerAllocator.hpp>
+#include <cassert>
+
+using namespace coremem;
+
+BucketizerAllocator::BucketizerAllocator(
+    size_t memSize, const void* mem, size_t minSize, size_t maxSize,
+    size_t step, size_t alignment)
+  : IAllocator(memSize, mem),
+    MIN_SIZE(pointer_math::AlignUp(
+        minSize < sizeof(uintptr_t) ? sizeof(uintptr_t) : minSize,
+        alignment)),
+    MAX_SIZE(maxSize), STEP(pointer_math::AlignUp(step, alignment)),
+    ALIGNMENT(alignment)
+{
+  assert(
+      pointer_math::IsPowerOfTwo(alignment) &&
+      "alignment must be a power of two.");
+  assert(step > 0 && "BucketizerAllocator step shall be > 0");
+  assert(MIN_SIZE <= MAX_SIZE && "BucketizerAllocator empty size range");
+
+  const size_t bucketCount = (MAX_SIZE - MIN_SIZE + STEP - 1) / STEP + 1;
+
+  // keep every bucket start aligned
+  this->m_BucketMemorySize =
+      (memSize / bucketCount) & ~(this->ALIGNMENT - 1);
+
+  this->m_Buckets.reserve(bucketCount);
+  for (size_t i = 0; i < bucketCount; ++i)
+  {
+    const void* bucketMem = reinterpret_cast<const void*>(
+        reinterpret_cast<uintptr_t>(mem) + i * this->m_BucketMemorySize);
+    const size_t objectSize = this->MIN_SIZE + i * this->STEP;
+
+    assert(
+        PoolAllocator::RequiredMemorySize(1, objectSize, alignment) <=
+            this->m_BucketMemorySize &&
+        "BucketizerAllocator memory too small to hold one object per bucket");
+
+    this->m_Buckets.push_back(new PoolAllocator(
+        this->m_BucketMemorySize, bucketMem, objectSize, alignment));
+  }
+}
+
+BucketizerAllocator::~BucketizerAllocator()
+{
+  for (auto bucket : this->m_Buckets)
+  {
+    delete bucket;
+  }
+  this->m_Buckets.clear();
+}
+
+size_t BucketizerAllocator::bucketIndexForSize(size_t size) const
+{
+  if (size <= this->MIN_SIZE) return 0;
+  return (size - this->MIN_SIZE + this->STEP - 1) / this->STEP;
+}
+
+size_t BucketizerAllocator::bucketIndexForAddress(const void* p) const
+{
+  return (reinterpret_cast<uintptr_t>(p) -
+          reinterpret_cast<uintptr_t>(this->m_MemoryFirstAddress)) /
+         this->m_BucketMemorySize;
+}
+
+void* BucketizerAllocator::allocate(size_t memSize, size_t alignment)
+{
+  assert(memSize > 0 && "allocate called with memSize = 0.");
+
+  if (memSize > this->MAX_SIZE || alignment > this->ALIGNMENT) return nullptr;
+
+  const size_t index = bucketIndexForSize(memSize);
+  if (index >= this->m_Buckets.size()) return nullptr;
+
+  PoolAllocator* bucket = this->m_Buckets[index];
+  const size_t objectSize = this->MIN_SIZE + index * this->STEP;
+
+  void* p = bucket->allocate(objectSize, this->ALIGNMENT);
+  if (p == nullptr) return nullptr;
+
+  this->m_MemoryUsed += objectSize;
+  this->m_MemoryAllocations++;
+
+  return p;
+}
+
+void BucketizerAllocator::free(void* mem)
+{
+  if (mem == nullptr) return;
+
+  assert(
+      this->owns(mem) &&
+      "Freeing memory which was not allocated by BucketizerAllocator.");
+
+  const size_t index = bucketIndexForAddress(mem);
+  assert(index < this->m_Buckets.size());
+
+  this->m_Buckets[index]->free(mem);
+
+  this->m_MemoryUsed -= this->MIN_SIZE + index * this->STEP;
+  this->m_MemoryAllocations--;
+}
+
+void BucketizerAllocator::clear()
+{
+  for (auto bucket : this->m_Buckets)
+  {
+    bucket->clear();
+  }
+
+  this->m_MemoryUsed = 0;
+  this->m_MemoryAllocations = 0;
+}
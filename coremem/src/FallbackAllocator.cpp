@@ -0,0 +1,58 @@
+#include <FallbackAllocator.hpp>
+#include <cassert>
+
+using namespace coremem;
+
+FallbackAllocator::FallbackAllocator(IAllocator& primary, IAllocator& fallback)
+  : IAllocator(0, nullptr), m_Primary(primary), m_Fallback(fallback)
+{
+  assert(
+      primary.hasExactOwnership() &&
+      "FallbackAllocator primary must own exactly, free is routed by it.");
+}
+
+FallbackAllocator::~FallbackAllocator()
+{
+}
+
+void* FallbackAllocator::allocate(size_t memSize, size_t alignment)
+{
+  assert(memSize > 0 && "allocate called with memSize = 0.");
+
+  void* p = this->m_Primary.allocate(memSize, alignment);
+  if (p == nullptr) p = this->m_Fallback.allocate(memSize, alignment);
+
+  if (p != nullptr) this->m_MemoryAllocations++;
+
+  return p;
+}
+
+void FallbackAllocator::free(void* mem)
+{
+  if (mem == nullptr) return;
+
+  if (this->m_Primary.owns(mem)) { this->m_Primary.free(mem); }
+  else
+  {
+    assert(
+        this->m_Fallback.owns(mem) &&
+        "Freeing memory which was not allocated by FallbackAllocator.");
+    this->m_Fallback.free(mem);
+  }
+
+  this->m_MemoryAllocations--;
+}
+
+void FallbackAllocator::clear()
+{
+  this->m_Primary.clear();
+  this->m_Fallback.clear();
+  // a SystemAllocator keeps its blocks on clear, they are still ours to free
+  this->m_MemoryAllocations =
+      this->m_Primary.GetAllocationCount() + this->m_Fallback.GetAllocationCount();
+}
+
+bool FallbackAllocator::owns(const void* mem) const
+{
+  return this->m_Primary.owns(mem) || this->m_Fallback.owns(mem);
+}
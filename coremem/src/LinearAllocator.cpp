@@ -13,9 +13,12 @@ LinearAllocator::~LinearAllocator()
   this->clear();
 }
 
-void* LinearAllocator::allocate(size_t memSize, uint8_t alignment)
+void* LinearAllocator::allocate(size_t memSize, size_t alignment)
 {
   assert(memSize > 0 && "allocate called with memSize = 0.");
+  assert(
+      pointer_math::IsPowerOfTwo(alignment) &&
+      "alignment must be a power of two.");
 
   union
   {
@@ -29,7 +32,7 @@ void* LinearAllocator::allocate(size_t memSize, uint8_t alignment)
   asUptr += this->m_MemoryUsed;
 
   // get adjustment to align address
-  uint8_t adjustment = pointer_math::GetAdjustment(asVoidPtr, alignment);
+  size_t adjustment = pointer_math::GetAdjustment(asVoidPtr, alignment);
 
   // check if there is enough memory available
   if (this->m_MemoryUsed + memSize + adjustment > this->m_MemorySize)
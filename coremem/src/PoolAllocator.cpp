@@ -6,11 +6,15 @@
 using namespace coremem;
 
 PoolAllocator::PoolAllocator(
-    size_t memSize, const void* mem, size_t objectSize, uint8_t objectAlignment)
+    size_t memSize, const void* mem, size_t objectSize, size_t objectAlignment)
   : IAllocator(memSize, mem), OBJECT_SIZE(objectSize),
-    OBJECT_ALIGNMENT(objectAlignment)
+    OBJECT_ALIGNMENT(objectAlignment),
+    SLOT_SIZE(pointer_math::AlignUp(objectSize, objectAlignment))
 {
   assert(objectSize >= sizeof(uintptr_t) && "Size of object shall be > uintptr_t");
+  assert(
+      pointer_math::IsPowerOfTwo(objectAlignment) &&
+      "alignment must be a power of two.");
   this->clear();
 }
 
@@ -19,7 +23,7 @@ PoolAllocator::~PoolAllocator()
   this->freeList = nullptr;
 }
 
-void* PoolAllocator::allocate(size_t memSize, uint8_t alignment)
+void* PoolAllocator::allocate(size_t memSize, size_t alignment)
 {
   assert(memSize > 0 && "allocate called with memSize = 0.");
   assert(memSize == this->OBJECT_SIZE && alignment == this->OBJECT_ALIGNMENT);
@@ -51,11 +55,10 @@ void PoolAllocator::free(void* mem)
 
 void PoolAllocator::clear()
 {
-  uint8_t adjustment = pointer_math::GetAdjustment(
+  size_t adjustment = pointer_math::GetAdjustment(
       this->m_MemoryFirstAddress, this->OBJECT_ALIGNMENT);
 
-  size_t numObjects =
-      (size_t)std::floor((this->m_MemorySize - adjustment) / this->OBJECT_SIZE);
+  size_t numObjects = (this->m_MemorySize - adjustment) / this->SLOT_SIZE;
 
   union
   {
@@ -72,12 +75,23 @@ void PoolAllocator::clear()
 
   void** p = this->freeList;
 
-  for (int i = 0; i < (numObjects - 1); ++i)
+  for (size_t i = 0; i + 1 < numObjects; ++i)
   {
-    *p = (void*)((uintptr_t)p + this->OBJECT_SIZE);
+    *p = (void*)((uintptr_t)p + this->SLOT_SIZE);
 
     p = (void**)*p;
   }
 
   *p = nullptr;
+
+  this->m_MemoryUsed = 0;
+  this->m_MemoryAllocations = 0;
+}
+
+size_t PoolAllocator::RequiredMemorySize(
+    size_t objectCount, size_t objectSize, size_t objectAlignment)
+{
+  // worst case start adjustment is alignment - 1 bytes
+  return pointer_math::AlignUp(objectSize, objectAlignment) * objectCount +
+         (objectAlignment - 1);
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <SegregatorAllocator.hpp>
+#include <cassert>
+
+using namespace coremem;
+
+SegregatorAllocator::SegregatorAllocator(
+    size_t threshold, IAllocator& smallAllocator, IAllocator& largeAllocator)
+  : IAllocator(0, nullptr), THRESHOLD(threshold), m_Small(smallAllocator),
+    m_Large(largeAllocator),
+    m_RouteBySmall(smallAllocator.hasExactOwnership())
+{
+  assert(
+      (smallAllocator.hasExactOwnership() ||
+       largeAllocator.hasExactOwnership()) &&
+      "SegregatorAllocator needs one side owning exactly to route free.");
+}
+
+SegregatorAllocator::~SegregatorAllocator()
+{
+}
+
+void* SegregatorAllocator::allocate(size_t memSize, size_t alignment)
+{
+  assert(memSize > 0 && "allocate called with memSize = 0.");
+
+  void* p = memSize <= this->THRESHOLD
+                ? this->m_Small.allocate(memSize, alignment)
+                : this->m_Large.allocate(memSize, alignment);
+
+  if (p != nullptr) this->m_MemoryAllocations++;
+
+  return p;
+}
+
+void SegregatorAllocator::free(void* mem)
+{
+  if (mem == nullptr) return;
+
+  assert(
+      this->owns(mem) &&
+      "Freeing memory which was not allocated by SegregatorAllocator.");
+
+  // small allocators are usually bounded arenas, so ask them if they can tell
+  if (this->m_RouteBySmall)
+  {
+    if (this->m_Small.owns(mem)) { this->m_Small.free(mem); }
+    else { this->m_Large.free(mem); }
+  }
+  else
+  {
+    if (this->m_Large.owns(mem)) { this->m_Large.free(mem); }
+    else { this->m_Small.free(mem); }
+  }
+
+  this->m_MemoryAllocations--;
+}
+
+void SegregatorAllocator::clear()
+{
+  this->m_Small.clear();
+  this->m_Large.clear();
+  // a SystemAllocator keeps its blocks on clear, they are still ours to free
+  this->m_MemoryAllocations =
+      this->m_Small.GetAllocationCount() + this->m_Large.GetAllocationCount();
+}
+
+bool SegregatorAllocator::owns(const void* mem) const
+{
+  return this->m_Small.owns(mem) || this->m_Large.owns(mem);
+}
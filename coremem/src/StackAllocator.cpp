@@ -1,5 +1,6 @@
 #include <StackAllocator.hpp>
 #include <cassert>
+#include <cstring>
 
 #include <iostream>
 
@@ -15,15 +16,17 @@ StackAllocator::~StackAllocator()
   this->clear();
 }
 
-void* StackAllocator::allocate(size_t memSize, uint8_t alignment)
+void* StackAllocator::allocate(size_t memSize, size_t alignment)
 {
   assert(memSize > 0 && "allocate called with memSize = 0.");
+  assert(
+      pointer_math::IsPowerOfTwo(alignment) &&
+      "alignment must be a power of two.");
 
   union
   {
     void* asVoidPtr;
     uintptr_t asUptr;
-    AllocMetaInfo* asMeta;
   };
 
   asVoidPtr = (void*)this->m_MemoryFirstAddress;
@@ -31,8 +34,8 @@ void* StackAllocator::allocate(size_t memSize, uint8_t alignment)
   // current address
   asUptr += this->m_MemoryUsed;
 
-  uint8_t adjustment =
-      pointer_math::GetAdjustment(asVoidPtr, alignment, sizeof(AllocMetaInfo)); //+ extra for header
+  size_t adjustment = pointer_math::GetAdjustment(
+      asVoidPtr, alignment, sizeof(AllocMetaInfo)); //+ extra for header
 
   // check if there is enough memory available
   if (this->m_MemoryUsed + memSize + adjustment > this->m_MemorySize)
@@ -41,12 +44,16 @@ void* StackAllocator::allocate(size_t memSize, uint8_t alignment)
     return nullptr;
   }
 
-  // store alignment in allocation meta info
-  asMeta->adjustment = adjustment;
-
   // determine aligned memory address
   asUptr += adjustment;
 
+  // store alignment in allocation meta info, right in front of the block.
+  // The header may be unaligned for small alignments, so copy it bytewise.
+  AllocMetaInfo meta{adjustment};
+  std::memcpy(
+      reinterpret_cast<void*>(asUptr - sizeof(AllocMetaInfo)), &meta,
+      sizeof(AllocMetaInfo));
+
   // update book keeping
   this->m_MemoryUsed += memSize + adjustment;
   this->m_MemoryAllocations++;
@@ -57,22 +64,18 @@ void* StackAllocator::allocate(size_t memSize, uint8_t alignment)
 
 void StackAllocator::free(void* mem)
 {
-  union
-  {
-    void* asVoidPtr;
-    uintptr_t asUptr;
-    AllocMetaInfo* asMeta;
-  };
-
-  asVoidPtr = mem;
-
   // get meta info
-  asUptr -= sizeof(AllocMetaInfo);
-
-  // free used memory
+  AllocMetaInfo meta{};
+  std::memcpy(
+      &meta,
+      reinterpret_cast<const void*>(
+          reinterpret_cast<uintptr_t>(mem) - sizeof(AllocMetaInfo)),
+      sizeof(AllocMetaInfo));
+
+  // free used memory, the allocation started "adjustment" bytes before mem
   this->m_MemoryUsed -=
       ((uintptr_t)this->m_MemoryFirstAddress + this->m_MemoryUsed) -
-      ((uintptr_t)mem + asMeta->adjustment);
+      ((uintptr_t)mem - meta.adjustment);
 
   // decrement allocation count
   this->m_MemoryAllocations--;
@@ -0,0 +1,44 @@
+#include <SystemAllocator.hpp>
+#include <AlignedMemory.hpp>
+#include <cassert>
+
+using namespace coremem;
+
+SystemAllocator::SystemAllocator() : IAllocator(0, nullptr)
+{
+}
+
+SystemAllocator::~SystemAllocator()
+{
+  assert(
+      this->m_MemoryAllocations == 0 &&
+      "SystemAllocator destroyed with pending allocations.");
+}
+
+void* SystemAllocator::allocate(size_t memSize, size_t alignment)
+{
+  assert(memSize > 0 && "allocate called with memSize = 0.");
+
+  void* p = AlignedAlloc(memSize, alignment);
+  if (p != nullptr) this->m_MemoryAllocations++;
+
+  return p;
+}
+
+void SystemAllocator::free(void* mem)
+{
+  if (mem == nullptr) return;
+
+  AlignedFree(mem);
+  this->m_MemoryAllocations--;
+}
+
+void SystemAllocator::clear()
+{
+  // nothing to reset, every block stays until it is freed
+}
+
+bool SystemAllocator::owns(const void* mem) const
+{
+  return mem != nullptr;
+}
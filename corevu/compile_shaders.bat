@@ -5,4 +5,8 @@ C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\point_light.vert -o shaders\point_l
 C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\point_light.frag -o shaders\point_light.frag.spv
 
 C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\texture_shader.vert -o shaders\texture_shader.vert.spv
-C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\texture_shader.frag -o shaders\texture_shader.frag.spv
\ No newline at end of file
+C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\texture_shader.frag -o shaders\texture_shader.frag.spv
+
+C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\particle_nbody.comp -o shaders\particle_nbody.comp.spv
+C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\particle.vert -o shaders\particle.vert.spv
+C:\VulkanSDK\1.3.261.1\Bin\glslc.exe shaders\particle.frag -o shaders\particle.frag.spv
\ No newline at end of file
@@ -0,0 +1,18 @@
+#!/bin/sh
+# compile_shaders.bat for Linux and macOS, glslc of the Vulkan SDK or the PATH
+set -e
+cd "$(dirname "$0")"
+
+GLSLC=glslc
+if [ -n "$VULKAN_SDK" ] && [ -x "$VULKAN_SDK/bin/glslc" ]; then
+  GLSLC="$VULKAN_SDK/bin/glslc"
+fi
+
+for shader in \
+    simple_shader.frag simple_shader.vert \
+    point_light.vert point_light.frag \
+    texture_shader.vert texture_shader.frag \
+    particle_nbody.comp particle.vert particle.frag
+do
+  "$GLSLC" "shaders/$shader" -o "shaders/$shader.spv"
+done
@@ -26,7 +26,8 @@ public:
   void unmap();
 
   void writeToBuffer(
-      void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+      const void* data, VkDeviceSize size = VK_WHOLE_SIZE,
+      VkDeviceSize offset = 0);
   VkResult flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
   VkDescriptorBufferInfo descriptorInfo(
       VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
@@ -5,6 +5,8 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <geometry/corevu_bounds.hpp>
+
 namespace corevu
 {
 
@@ -57,6 +59,15 @@ public:
   {
     return glm::vec3{m_inverse_view_matrix[3]};
   }
+  // world space planes of projection * view, pointing inwards
+  CoreVuFrustum getFrustum() const
+  {
+    return CoreVuFrustum::FromMatrix(m_projection_matrix * m_view_matrix);
+  }
+  /* World space ray through a viewport point given in NDC(-1..1, y down like
+   * the screen), from the near to the far plane: direction is that whole
+   * span, distances along it are 0 at near and 1 at far. */
+  CoreVuRay getRay(const glm::vec2& ndc) const;
 
 private:
   glm::mat4 m_projection_matrix{1.f};
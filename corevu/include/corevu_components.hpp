@@ -0,0 +1,214 @@
+#pragma once
+
+#include "corevu_model.hpp"
+#include "corevu_texture.hpp"
+#include "culling/corevu_occlusion_buffer.hpp"
+#include "ecs/corevu_ecs_types.hpp"
+
+// libs
+#include <glm/gtc/matrix_transform.hpp>
+
+// std
+#include <memory>
+
+namespace corevu
+{
+
+/*
+Local TRS relative to the parent(or the world for roots) with cached matrices.
+
+TRS is only changed through the setters, they mark the transform dirty. The
+TransformSystem recomputes local, world and normal matrices of dirty transforms
+and their children once per frame, everything else reads the cached matrices.
+Static objects thus cost no matrix math per frame.
+*/
+class TransformComponent
+{
+public:
+  TransformComponent() = default;
+  TransformComponent(
+      const glm::vec3& translation, const glm::vec3& rotation = glm::vec3{0.f},
+      const glm::vec3& scale = glm::vec3{1.f})
+    : m_translation{translation}, m_scale{scale}, m_rotation{rotation}
+  {
+  }
+
+  const glm::vec3& GetTranslation() const
+  {
+    return m_translation;
+  }
+  const glm::vec3& GetScale() const
+  {
+    return m_scale;
+  }
+  const glm::vec3& GetRotation() const // all components in rad
+  {
+    return m_rotation;
+  }
+  void SetTranslation(const glm::vec3& translation)
+  {
+    m_translation = translation;
+    m_dirty = true;
+  }
+  void SetScale(const glm::vec3& scale)
+  {
+    m_scale = scale;
+    m_dirty = true;
+  }
+  void SetRotation(const glm::vec3& rotation)
+  {
+    m_rotation = rotation;
+    m_dirty = true;
+  }
+
+  bool IsDirty() const
+  {
+    return m_dirty;
+  }
+  // parent is changed through TransformSystem::setParent
+  CoreVuEntity GetParent() const
+  {
+    return m_parent;
+  }
+
+  // cached by TransformSystem::update
+  const glm::mat4& GetLocalMatrix() const
+  {
+    return m_local_matrix;
+  }
+  const glm::mat4& GetWorldMatrix() const
+  {
+    return m_world_matrix;
+  }
+  const glm::mat3& GetNormalMatrix() const
+  {
+    return m_normal_matrix;
+  }
+  /* World matrix blended between the last two simulation steps by
+   * TransformSystem::interpolate, what renderers draw. Equals the world
+   * matrix when nothing interpolates. */
+  const glm::mat4& GetRenderMatrix() const
+  {
+    return m_render_matrix;
+  }
+
+  // evaluates the local matrix from TRS, not cached
+  glm::mat4 ToMat4() const
+  {
+    /* NOTE that's a dumb straighforward solution for rotation around arbitrary
+    axis, below is more optimized solution with YXZ transform auto transform =
+    glm::translate(glm::mat4x4{1.f}, translation);
+    // For rotation is more common to use Tait-Btyan angles YXZ instad of proper
+    Euler angles transform = glm::rotate(transform, rotation.y,
+    glm::vec3{0.f, 1.f, 0.f}); transform = glm::rotate(transform, rotation.x,
+    glm::vec3{1.f, 0.f, 0.f}); transform = glm::rotate(transform, rotation.z,
+    glm::vec3{0.f, 0.f, 1.f}); transform = glm::scale(transform, scale);
+
+    return transform; */
+
+    // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
+    // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
+    // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+    /* NOTE: Extrinsic vs Intrinsic coordinate systems.
+      to interprete rotation as Intrinsic read/apply transforms as YXZ and for
+      Extrinsic ZXY(current impl)
+     */
+    const float c3 = glm::cos(m_rotation.z);
+    const float s3 = glm::sin(m_rotation.z);
+    const float c2 = glm::cos(m_rotation.x);
+    const float s2 = glm::sin(m_rotation.x);
+    const float c1 = glm::cos(m_rotation.y);
+    const float s1 = glm::sin(m_rotation.y);
+    return glm::mat4{
+        {
+            m_scale.x * (c1 * c3 + s1 * s2 * s3),
+            m_scale.x * (c2 * s3),
+            m_scale.x * (c1 * s2 * s3 - c3 * s1),
+            0.0f,
+        },
+        {
+            m_scale.y * (c3 * s1 * s2 - c1 * s3),
+            m_scale.y * (c2 * c3),
+            m_scale.y * (c1 * c3 * s2 + s1 * s3),
+            0.0f,
+        },
+        {
+            m_scale.z * (c2 * s1),
+            m_scale.z * (-s2),
+            m_scale.z * (c1 * c2),
+            0.0f,
+        },
+        {m_translation.x, m_translation.y, m_translation.z, 1.0f}};
+
+    /* NOTE:
+    glm::mat2 scale_mat = {{scale.x, .0f}, {.0f, scale.y}}; // glm take conlumns
+    transform2d = rotation_mat *
+           scale_mat; // scale transform is applied first then rotation then
+                      // traslation. In glm::mat order of operation is reveresd.
+                      */
+  }
+
+private:
+  friend class TransformSystem;
+
+  glm::vec3
+      m_translation{}; /* translation of positions shall not be affected w - 0. */
+  glm::vec3 m_scale{1.f, 1.f, 1.f};
+  glm::vec3 m_rotation{};
+
+  CoreVuEntity m_parent{NULL_ENTITY};
+  bool m_dirty{true};
+  // TransformSystem update index of the last local/world matrix change
+  uint32_t m_local_update{0};
+  uint32_t m_world_update{0};
+
+  glm::mat4 m_local_matrix{1.f};
+  glm::mat4 m_world_matrix{1.f};
+  glm::mat3 m_normal_matrix{1.f};
+  // world matrix before the last update that changed it
+  glm::mat4 m_previous_world_matrix{1.f};
+  glm::mat4 m_render_matrix{1.f};
+};
+
+struct PointLightComponent
+{
+  glm::vec3 color{1.f};
+  float intensity{1.f};
+  //float range{10.f}; // temporary not used
+};
+
+// basic physics
+struct RigidBody2dComponent
+{
+  glm::vec2 velocity{0.f};
+  float mass{1.0f};
+};
+
+/* Asset references. Models and textures are shared between entities, the
+ * components only hold a reference. */
+struct ModelComponent
+{
+  std::shared_ptr<CoreVuModel> model{nullptr};
+};
+
+struct TextureComponent
+{
+  std::shared_ptr<CoreVuTexture> diffuse_map{nullptr};
+};
+
+/* Marks an entity whose world transform, model and texture never change after
+ * the scene is built. CoreVuStaticBatcher merges such meshes into shared
+ * batches, nothing else treats them differently. */
+struct StaticComponent
+{
+};
+
+/* Designates an occluder, the CullingSystem rasterizes its mesh with the world
+ * matrix of the TransformComponent. Needs no ModelComponent, an invisible
+ * occluder works as well. */
+struct OccluderComponent
+{
+  std::shared_ptr<const CoreVuOccluderMesh> mesh{nullptr};
+};
+
+} // namespace corevu
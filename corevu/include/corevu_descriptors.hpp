@@ -3,6 +3,7 @@
 #include <corevu_device.hpp>
 
 // std
+#include <array>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -114,10 +115,13 @@ private:
   friend class CoreVuDescriptorWriter;
 };
 
-/* Class to make creation of descriptors easier. */
+/* Class to make creation of descriptors easier. The writes are kept inline,
+ * writing a set does not allocate. */
 class CoreVuDescriptorWriter
 {
 public:
+  static constexpr uint32_t MAX_WRITES = 8;
+
   CoreVuDescriptorWriter(
       CoreVuDescriptorSetLayout& setLayout, CoreVuDescriptorPool& pool);
 
@@ -132,7 +136,8 @@ public:
 private:
   CoreVuDescriptorSetLayout& m_set_ayout;
   CoreVuDescriptorPool& m_pool;
-  std::vector<VkWriteDescriptorSet> m_writes;
+  std::array<VkWriteDescriptorSet, MAX_WRITES> m_writes{};
+  uint32_t m_write_count{0};
 };
 
 } // namespace corevu
\ No newline at end of file
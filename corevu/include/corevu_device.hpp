@@ -38,6 +38,9 @@ public:
 #endif
 
   CoreVuDevice(CoreVuWindow& window);
+  /* Headless: no surface and no swapchain, for compute and offscreen work,
+   * e.g. on a software implementation like lavapipe without a display. */
+  CoreVuDevice();
   ~CoreVuDevice();
 
   // Not copyable or movable
@@ -66,6 +69,10 @@ public:
   {
     return presentQueue_;
   }
+  bool isHeadless() const
+  {
+    return window == nullptr;
+  }
 
   SwapChainSupportDetails getSwapChainSupport()
   {
@@ -125,18 +132,17 @@ private:
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  CoreVuWindow& window;
+  CoreVuWindow* window; // nullptr when headless
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
 
   const std::vector<const char*> validationLayers = {
       "VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char*> deviceExtensions = {
-      VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  const std::vector<const char*> deviceExtensions;
 };
 
 } // namespace corevu
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <corevu_camera.hpp>
+#include <corevu_components.hpp>
 #include <corevu_descriptors.hpp>
-#include <corevu_gameobject.hpp>
+#include <ecs/corevu_world.hpp>
+#include <events/corevu_event_bus.hpp>
 
 // lib
 #include <vulkan/vulkan.h>
@@ -31,15 +33,34 @@ struct GlobalUbo
   int point_light_count{0};
 };
 
-struct FrameInfo
+// one draw the render systems record, lod indexes CoreVuModel::GetLod()
+struct CoreVuDrawItem
+{
+  CoreVuEntity entity;
+  uint32_t lod;
+};
+
+// what recording a frame needs, see CoreVuRenderThread. The systems of a frame
+// running ahead of the render thread get a FrameInfo without these
+struct CoreVuRenderContext
 {
   int frame_index;
-  float frame_time;
   VkCommandBuffer command_buffer;
-  CoreVuCamera& camera;
   VkDescriptorSet global_descriptor_set;
   CoreVuDescriptorPool& frame_descriptor_pool;
-  CoreVuGameObject::ObjectContainer& game_objects;
+};
+
+struct FrameInfo
+{
+  int frame_index; // -1 with a render thread
+  float frame_time;
+  VkCommandBuffer command_buffer; // VK_NULL_HANDLE with a render thread
+  CoreVuCamera& camera;
+  VkDescriptorSet global_descriptor_set;
+  CoreVuDescriptorPool* frame_descriptor_pool; // nullptr with a render thread
+  CoreVuWorld& world;
+  CoreVuJobSystem& job_system; // for parallel work inside systems
+  CoreVuEventBus& event_bus;   // delivered after the systems of the frame
 };
 
 } // namespace corevu
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <cstdint>
+
+namespace corevu
+{
+/*
+Fixed simulation step with an accumulator, rendering at its own rate.
+
+  CoreVuFrameLoop loop{1.f / 60.f};
+  loop.setRenderRate(144); // 0: as fast as presenting allows
+  while (running)
+  {
+    const uint32_t steps = loop.beginFrame(); // real time since the last one
+    for (uint32_t i = 0; i < steps; ++i)
+    {
+      simulate(loop.getStep()); // always the same dt
+    }
+    transform_system.interpolate(frame_info, loop.getAlpha());
+    render();
+    loop.waitForRenderSlot();
+  }
+
+Real time goes into the accumulator, every full step taken out of it is one
+simulation step, the rest is how far the rendered frame is into the next step:
+
+  accumulator |=====|=====|==       steps 2, alpha = 2 / 5
+              step  step  rest
+
+Determinism: the simulation only ever sees getStep(), how often it runs per
+frame depends on the frame rate, the result of n steps does not.
+
+Spiral of death: if a step costs more than it simulates, every frame owes more
+steps than the last one. A frame runs at most max_steps, the time of the
+steps it could not run is dropped(getDroppedSteps()) and the simulation runs
+slower than real time instead of freezing the frame rate. Frame times above
+MAX_FRAME_TIME(breakpoints, window drags) are clamped for the same reason.
+
+waitForRenderSlot() paces rendering with absolute deadlines, each one interval
+after the last, so frames on time don't drift by how much a wait overslept. A
+late frame moves the schedule: the next deadline is one interval after it,
+catching up would follow a hitch with a burst of frames. It sleeps until
+shortly before the deadline and yields for the rest, sleep alone oversleeps by
+up to the scheduler tick.
+*/
+class CoreVuFrameLoop
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr float DEFAULT_STEP = 1.f / 60.f;
+  static constexpr uint32_t DEFAULT_MAX_STEPS = 5;
+  static constexpr float MAX_FRAME_TIME = .25f;
+
+  explicit CoreVuFrameLoop(
+      float step = DEFAULT_STEP, uint32_t max_steps = DEFAULT_MAX_STEPS);
+
+  // measures the time since the last call(since construction or reset())
+  uint32_t beginFrame();
+  // same with a given frame time, for replays and tests
+  uint32_t advance(float elapsed);
+
+  // restarts the clock, drops the accumulated time
+  void reset();
+
+  // Hz, 0 disables pacing
+  void setRenderRate(float rate);
+  void waitForRenderSlot();
+
+  float getStep() const
+  {
+    return m_step;
+  }
+  // accumulated time in steps after the steps of this frame, [0, 1)
+  float getAlpha() const
+  {
+    return static_cast<float>(m_accumulator / m_step);
+  }
+  // real time of this frame after clamping
+  float getFrameTime() const
+  {
+    return m_frame_time;
+  }
+  uint32_t getStepCount() const
+  {
+    return m_step_count;
+  }
+  // steps skipped by the max_steps cap so far
+  uint64_t getDroppedSteps() const
+  {
+    return m_dropped_steps;
+  }
+
+private:
+  float m_step;
+  uint32_t m_max_steps;
+  double m_accumulator{0.0}; // real time not simulated yet
+  float m_frame_time{0.f};
+  uint32_t m_step_count{0};
+  uint64_t m_dropped_steps{0};
+  Clock::time_point m_last_time;
+
+  Clock::duration m_render_interval{0};
+  Clock::time_point m_next_render{};
+};
+} // namespace corevu
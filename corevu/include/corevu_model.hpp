@@ -2,16 +2,21 @@
 
 #include "corevu_device.hpp"
 #include "corevu_buffer.hpp"
+#include "geometry/corevu_bounds.hpp"
 
 #define GLM_FORCE_RADIANS           // to be sure that no change depending on system
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE // instead of -1 to 1 ?
 #include <glm/glm.hpp>
 
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace corevu
 {
+class CoreVuJobSystem;
+class CoreVuMeshBvh;
+
 class CoreVuModel
 {
 public:
@@ -61,12 +66,40 @@ public:
     }
   };
 
+  /* One level of detail: a range of the shared index buffer and its
+   * geometric error, how far(model space) the surface may be off the full
+   * mesh. LOD 0 is the full mesh with error 0. */
+  struct Lod
+  {
+    uint32_t first_index;
+    uint32_t index_count;
+    float error;
+  };
+  static constexpr uint32_t MAX_LODS = 5;
+  static constexpr uint32_t MIN_LOD_TRIANGLES = 64;
+
   struct Builder
   {
     std::vector<Vertex> vertices{};
     std::vector<Index> indices{};
+    // model space, set by loadModel() or computeBounds()
+    CoreVuAabb bounds{};
+    CoreVuSphere bounding_sphere{};
+    // empty: a single LOD over all indices
+    std::vector<Lod> lods{};
 
     void loadModel(const std::string& filename);
+    void computeBounds();
+    /* Simplifies the indexed mesh to half the triangles per LOD(SimplifyMesh)
+     * and appends the LOD indices behind the full ones. Stops at MAX_LODS,
+     * below MIN_LOD_TRIANGLES or when a level saves less than a quarter. */
+    void generateLods();
+
+    /* Ray queries need the triangles on the CPU, only models that build a
+     * BVH keep them(in the BVH, over the full mesh, LOD 0). Call it after
+     * generateLods(), job_system may be null. */
+    std::shared_ptr<const CoreVuMeshBvh> bvh{};
+    void buildBvh(CoreVuJobSystem* job_system = nullptr);
   };
 
   CoreVuModel(CoreVuDevice& device, const Builder& builder);
@@ -75,11 +108,53 @@ public:
   CoreVuModel(const CoreVuModel&) = delete;
   CoreVuModel& operator=(const CoreVuModel&) = delete;
 
+  // with a job system the model gets a BVH built on it, see Builder::buildBvh
   static std::shared_ptr<CoreVuModel> CreateModelFromPath(
-      CoreVuDevice& device, const std::string& path);
+      CoreVuDevice& device, const std::string& path,
+      CoreVuJobSystem* bvh_job_system = nullptr);
 
   void Bind(VkCommandBuffer command_buffer);
-  void Draw(VkCommandBuffer command_buffer);
+  void Draw(VkCommandBuffer command_buffer, uint32_t lod = 0);
+
+  uint32_t GetLodCount() const
+  {
+    return static_cast<uint32_t>(m_lods.size());
+  }
+  const Lod& GetLod(uint32_t lod) const
+  {
+    return m_lods[lod];
+  }
+
+  /* LOD for a model whose errors show error_scale times as big on screen
+   * (screen height fractions per model unit, see CullingSystem): the coarsest
+   * one with error_scale * error below max_error. It only moves off previous
+   * once the error is hysteresis(fraction) past the limit, so objects at the
+   * boundary don't pop every frame. */
+  uint32_t SelectLod(
+      float error_scale, float max_error, float hysteresis,
+      uint32_t previous) const
+  {
+    return SelectLod(m_lods, error_scale, max_error, hysteresis, previous);
+  }
+  // the same over any LOD chain, lods must not be empty
+  static uint32_t SelectLod(
+      std::span<const Lod> lods, float error_scale, float max_error,
+      float hysteresis, uint32_t previous);
+
+  // model space box and sphere around all vertices
+  const CoreVuAabb& GetBounds() const
+  {
+    return m_bounds;
+  }
+  const CoreVuSphere& GetBoundingSphere() const
+  {
+    return m_bounding_sphere;
+  }
+  // model space triangles for ray queries, nullptr if none were kept
+  const CoreVuMeshBvh* GetBvh() const
+  {
+    return m_bvh.get();
+  }
 
 private:
   void createVertexBuffers(const std::vector<Vertex>& vertices);
@@ -102,5 +177,10 @@ private:
   bool m_had_index_buffer;
   std::unique_ptr<CoreVuBuffer> m_index_buffer{nullptr};
   uint32_t m_index_count;
+  std::vector<Lod> m_lods;
+
+  CoreVuAabb m_bounds{};
+  CoreVuSphere m_bounding_sphere{};
+  std::shared_ptr<const CoreVuMeshBvh> m_bvh{};
 };
 } // namespace corevu
\ No newline at end of file
@@ -65,5 +65,31 @@ private:
   VkPipeline m_graphics_pipeline;
   VkShaderModule m_vulkan_vert_shader_module;
   VkShaderModule m_vulkan_frag_shader_module;
+
+  friend class CoreVuComputePipeline;
+};
+
+/* One compute shader, dispatched outside of render passes.
+
+  CoreVuComputePipeline pipeline{device, pipeline_layout, "x.comp.spv"};
+  pipeline.Bind(command_buffer);
+  vkCmdDispatch(command_buffer, group_count, 1, 1);
+*/
+class CoreVuComputePipeline
+{
+public:
+  CoreVuComputePipeline(
+      CoreVuDevice& device, VkPipelineLayout pipeline_layout,
+      const std::string& comp_filepath);
+  ~CoreVuComputePipeline();
+  CoreVuComputePipeline(const CoreVuComputePipeline&) = delete;
+  CoreVuComputePipeline& operator=(const CoreVuComputePipeline&) = delete;
+
+  void Bind(VkCommandBuffer command_buffer);
+
+private:
+  CoreVuDevice& m_device;
+  VkPipeline m_compute_pipeline;
+  VkShaderModule m_vulkan_comp_shader_module;
 };
 } // namespace corevu
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 #include <glm/vec3.hpp>
 
+#include <atomic>
 #include <string>
 
 namespace corevu
@@ -48,9 +49,10 @@ private:
   void initWindow();
 
 private:
-  int m_width;
-  int m_height;
-  bool m_framebuffer_is_resized{false};
+  // set by glfw on the main thread, read by the thread presenting
+  std::atomic<int> m_width;
+  std::atomic<int> m_height;
+  std::atomic<bool> m_framebuffer_is_resized{false};
 
   std::string m_window_name;
 
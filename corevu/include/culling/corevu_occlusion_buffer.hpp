@@ -0,0 +1,134 @@
+#pragma once
+
+#include <geometry/corevu_bounds.hpp>
+#include <jobs/corevu_job_system.hpp>
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace corevu
+{
+/* Triangles an occluder is drawn with into the occlusion buffer, usually a
+ * simplified version of the rendered mesh(a box for a wall, no small details).
+ * Model space, 3 indices per triangle. */
+struct CoreVuOccluderMesh
+{
+  std::vector<glm::vec3> positions{};
+  std::vector<uint32_t> indices{};
+
+  // 12 triangles of the box
+  static CoreVuOccluderMesh Box(const CoreVuAabb& box);
+
+  CoreVuAabb getBounds() const;
+};
+
+/*
+Software depth buffer for occlusion culling on the CPU, a few big occluders are
+rasterized at low resolution, then the bounds of the candidates are tested
+against it before anything is recorded.
+
+  buffer.begin(projection * view);
+  buffer.addOccluder(wall_mesh, wall_world_matrix); // triangle setup only
+  buffer.rasterize(job_system);                      // bands in parallel
+  if (!buffer.isVisible(world_box)) ...              // culled
+
+Depth is NDC z(0 near, 1 far), every pixel keeps the nearest occluder depth.
+On top of the pixels sits one level of 8x8 tiles holding the farthest depth of
+their pixels:
+
+  pixels 256x128                 tiles 32x16
+  +--+--+--+--+--               +-----+-----
+  |.2|.3|.3|1 |                 | 1   |      max of the 8x8 pixels below
+  |.2|.2|.3|1 |      ->         |     |
+  +--+--+--+--+--               +-----+-----
+
+A box is projected to a pixel rect and its nearest depth. It is hidden when
+every pixel of the rect has an occluder in front of it. Tiles with a farther
+max depth than the box are the only ones looked into pixel by pixel, fully
+covered tiles are rejected with one compare.
+
+Rasterizing works like the masked occlusion culling rasterizers, only with a
+plain depth per pixel instead of coverage masks: the three edge functions and
+the depth plane are set up once per triangle, then 4 pixels of a row are
+evaluated per SSE step(scalar without SSE), the covered lanes take the min
+depth. The screen is split into bands of rows, every band is one job and
+rasterizes all triangles clipped to its rows, no pixel is shared between jobs.
+
+Conservative where it matters: triangles crossing the near plane are dropped
+(less occlusion, never wrong) and boxes reaching behind the camera are always
+visible. Coverage is sampled at pixel centers like the GPU does.
+*/
+class CoreVuOcclusionBuffer
+{
+public:
+  static constexpr uint32_t WIDTH = 256;
+  static constexpr uint32_t HEIGHT = 128;
+  static constexpr uint32_t TILE_SIZE = 8;
+  static constexpr uint32_t TILES_X = WIDTH / TILE_SIZE;
+  static constexpr uint32_t TILES_Y = HEIGHT / TILE_SIZE;
+  // rows per rasterizing job, a multiple of the tile size
+  static constexpr uint32_t BAND_HEIGHT = 16;
+  // triangles past it are not added
+  static constexpr uint32_t DEFAULT_TRIANGLE_BUDGET = 16384;
+
+  CoreVuOcclusionBuffer();
+
+  // clears the buffer and the triangles
+  void begin(const glm::mat4& view_projection);
+
+  /* Transforms and sets up the triangles of mesh. Returns false, adding
+   * nothing, once the triangle budget is used up. */
+  bool addOccluder(const CoreVuOccluderMesh& mesh, const glm::mat4& world);
+  void rasterize(CoreVuJobSystem& job_system);
+
+  // world space box against the rasterized occluders, thread safe
+  bool isVisible(const CoreVuAabb& world_box) const;
+
+  void setTriangleBudget(uint32_t budget)
+  {
+    m_triangle_budget = budget;
+  }
+  uint32_t getTriangleCount() const
+  {
+    return static_cast<uint32_t>(m_triangles.size());
+  }
+  float getDepth(uint32_t x, uint32_t y) const
+  {
+    return m_depth[y * WIDTH + x];
+  }
+
+private:
+  // edge i: a[i] * x + b[i] * y + c[i] >= 0 inside, depth: z = z_a * x +
+  // z_b * y + z_c, pixel coordinates
+  struct Triangle
+  {
+    float a[3];
+    float b[3];
+    float c[3];
+    float z_a;
+    float z_b;
+    float z_c;
+    int32_t min_x;
+    int32_t max_x;
+    int32_t min_y;
+    int32_t max_y;
+  };
+
+  void rasterizeBand(uint32_t band);
+  void updateTiles(uint32_t tile_row);
+
+  glm::mat4 m_view_projection{1.f};
+  std::vector<Triangle> m_triangles;
+  std::vector<glm::vec4> m_clip; // scratch of addOccluder
+  uint32_t m_triangle_budget{DEFAULT_TRIANGLE_BUDGET};
+
+  std::vector<float> m_depth;      // WIDTH x HEIGHT
+  std::vector<float> m_tile_depth; // TILES_X x TILES_Y, farthest pixel
+};
+} // namespace corevu
@@ -0,0 +1,69 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// set by the COREVU_TRACK_ALLOCATIONS cmake option
+#ifndef COREVU_TRACK_ALLOCATIONS
+#define COREVU_TRACK_ALLOCATIONS 0
+#endif
+
+namespace corevu
+{
+/*
+Counts the heap allocations of frames that should not allocate at all, the
+debug/CI check of a steady state frame.
+
+  for (frame...)
+  {
+    if (frame >= WARMUP_FRAMES) CoreVuAllocTracker::beginFrame();
+    ... // any thread allocating now is counted
+    if (frame >= WARMUP_FRAMES) CoreVuAllocTracker::endFrame();
+  }
+  CoreVuAllocTracker::report(std::cout);
+  if (CoreVuAllocTracker::getAllocationCount() > 0) fail();
+
+Built with COREVU_TRACK_ALLOCATIONS the global operator new/delete are
+replaced, every allocation made while a frame is open is counted on any
+thread and filed under its call site: the call stack and the innermost
+CoreVuAllocScope of the thread(the scheduler opens one per system). The
+report lists the sites, symbolized where the platform can(dbghelp, execinfo).
+Frames nest, the render thread can open its own next to the main thread's.
+
+Only operator new is seen, malloc of C libraries and drivers is not. Without
+the option the functions do nothing and the counts stay 0, ENABLED tells.
+*/
+class CoreVuAllocTracker
+{
+public:
+  static constexpr bool ENABLED = COREVU_TRACK_ALLOCATIONS != 0;
+  static constexpr uint32_t MAX_STACK_FRAMES = 12;
+  // distinct call sites kept, later ones are only counted
+  static constexpr uint32_t MAX_SITES = 256;
+
+  static void beginFrame();
+  static void endFrame();
+
+  // counted since the last reset()
+  static uint64_t getAllocationCount();
+  static uint64_t getAllocatedBytes();
+  static void reset();
+  // sites by allocation count
+  static void report(std::ostream& out);
+};
+
+// names the allocations of this thread in the report while it is alive
+class CoreVuAllocScope
+{
+public:
+  explicit CoreVuAllocScope(const char* name);
+  ~CoreVuAllocScope();
+  CoreVuAllocScope(const CoreVuAllocScope&) = delete;
+  CoreVuAllocScope& operator=(const CoreVuAllocScope&) = delete;
+
+private:
+  const char* m_previous;
+};
+} // namespace corevu
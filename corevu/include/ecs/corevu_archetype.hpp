@@ -0,0 +1,169 @@
+#pragma once
+
+#include <ecs/corevu_ecs_types.hpp>
+
+// std
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace corevu
+{
+/*
+Storage of all entities with exactly the same component set.
+
+Chunk memory layout(CHUNK_SIZE bytes, every column cache line aligned):
+
+|versions[types]|entities[cap]..|column A[cap]....|column B[cap].......|
+
+Entities are packed densely: all chunks except the last one are full. Removing
+an entity moves the last entity of the archetype into the hole(swap-remove),
+so iteration never has to skip empty slots.
+
+versions holds one change version per column: the version of the last write
+to any row of it. Structural changes(an entity moved in, swap-remove) count as
+write to every column of the chunk.
+*/
+class CoreVuArchetype
+{
+public:
+  static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+  struct Chunk
+  {
+    uint8_t* memory{nullptr};
+    uint32_t count{0};
+  };
+
+  // location of an entity inside the archetype
+  struct Slot
+  {
+    uint32_t chunk;
+    uint32_t row;
+  };
+
+  CoreVuArchetype(const ComponentMask& mask);
+  ~CoreVuArchetype();
+
+  CoreVuArchetype(const CoreVuArchetype&) = delete;
+  CoreVuArchetype& operator=(const CoreVuArchetype&) = delete;
+
+  const ComponentMask& getMask() const
+  {
+    return m_mask;
+  }
+  const std::vector<ComponentTypeId>& getTypes() const
+  {
+    return m_types;
+  }
+  bool hasComponent(ComponentTypeId id) const
+  {
+    return m_mask.test(id);
+  }
+  uint32_t getChunkCapacity() const
+  {
+    return m_chunk_capacity;
+  }
+  size_t getChunkCount() const
+  {
+    return m_chunks.size();
+  }
+  const Chunk& getChunk(size_t index) const
+  {
+    return m_chunks[index];
+  }
+  size_t getEntityCount() const
+  {
+    return m_entity_count;
+  }
+
+  CoreVuEntity* getEntities(size_t chunk) const
+  {
+    return reinterpret_cast<CoreVuEntity*>(
+        m_chunks[chunk].memory + m_entities_offset);
+  }
+  void* getColumn(size_t chunk, ComponentTypeId id) const
+  {
+    return m_chunks[chunk].memory + m_column_offsets[id];
+  }
+  template <typename T>
+  T* getColumn(size_t chunk) const
+  {
+    return static_cast<T*>(
+        getColumn(chunk, CoreVuComponentRegistry::GetId<T>()));
+  }
+  void* getComponent(const Slot& slot, ComponentTypeId id) const
+  {
+    return static_cast<uint8_t*>(getColumn(slot.chunk, id)) +
+           slot.row * m_component_sizes[id];
+  }
+
+  // written from several jobs at once(different columns or the same version)
+  ChangeVersion getChangeVersion(size_t chunk, ComponentTypeId id) const
+  {
+    return getChangeVersions(chunk)[m_column_indices[id]].load(
+        std::memory_order_relaxed);
+  }
+  void setChangeVersion(
+      size_t chunk, ComponentTypeId id, ChangeVersion version) const
+  {
+    getChangeVersions(chunk)[m_column_indices[id]].store(
+        version, std::memory_order_relaxed);
+  }
+
+  /* Reserves a slot for the entity at the end of the archetype. Component
+   * memory of the slot is left uninitialized, the caller must construct every
+   * column. */
+  Slot allocateSlot(CoreVuEntity entity, ChangeVersion version);
+
+  /* Destroys the components at slot and fills the hole with the last entity.
+   * Returns the entity which was moved into slot or NULL_ENTITY if the slot
+   * was the last one. */
+  CoreVuEntity removeSlot(const Slot& slot, ChangeVersion version);
+
+  // cached archetype graph edges for add/remove of a single component
+  CoreVuArchetype* getAddEdge(ComponentTypeId id) const
+  {
+    return m_add_edges[id];
+  }
+  CoreVuArchetype* getRemoveEdge(ComponentTypeId id) const
+  {
+    return m_remove_edges[id];
+  }
+  void setAddEdge(ComponentTypeId id, CoreVuArchetype* archetype)
+  {
+    m_add_edges[id] = archetype;
+  }
+  void setRemoveEdge(ComponentTypeId id, CoreVuArchetype* archetype)
+  {
+    m_remove_edges[id] = archetype;
+  }
+
+private:
+  std::atomic<ChangeVersion>* getChangeVersions(size_t chunk) const
+  {
+    return reinterpret_cast<std::atomic<ChangeVersion>*>(
+        m_chunks[chunk].memory);
+  }
+  void setChunkChanged(size_t chunk, ChangeVersion version);
+
+  void computeLayout();
+  void freeChunk(Chunk& chunk);
+
+  ComponentMask m_mask;
+  std::vector<ComponentTypeId> m_types;
+
+  uint32_t m_chunk_capacity{0};
+  size_t m_entities_offset{0};
+  std::array<uint32_t, MAX_COMPONENT_TYPES> m_column_indices{};
+  std::array<size_t, MAX_COMPONENT_TYPES> m_column_offsets{};
+  std::array<size_t, MAX_COMPONENT_TYPES> m_component_sizes{};
+
+  std::vector<Chunk> m_chunks;
+  Chunk m_spare_chunk{}; // keeps one empty chunk to avoid alloc/free thrashing
+  size_t m_entity_count{0};
+
+  std::array<CoreVuArchetype*, MAX_COMPONENT_TYPES> m_add_edges{};
+  std::array<CoreVuArchetype*, MAX_COMPONENT_TYPES> m_remove_edges{};
+};
+} // namespace corevu
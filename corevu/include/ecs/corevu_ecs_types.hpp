@@ -0,0 +1,147 @@
+#pragma once
+
+// libs
+#include <AlignedMemory.hpp>
+
+// std
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace corevu
+{
+/* BIG ECS NOTE:
+ * . An entity is only an id. Its data lives in components(plain structs).
+ * . Entities with the same set of component types share an archetype. An
+ *   archetype stores its entities in fixed size chunks, each chunk keeps one
+ *   contiguous column(SoA) per component type.
+ * . Systems run queries("all entities with Transform and Model but without
+ *   Texture") which visit only matching archetypes and walk their columns
+ *   linearly, no per-object branching or pointer chasing.
+ * . Adding/removing a component moves the entity to another archetype, so
+ *   structural changes are more expensive than component writes.
+ * . Every chunk remembers per column the change version of its last write.
+ *   Systems deriving data(matrix caches, light buffers, bounds) filter their
+ *   queries with changedSince() and skip chunks nothing wrote to since their
+ *   last run.
+ */
+
+/* An entity id carries a generation next to its index:
+ *
+ *   | generation(12 bit) | index(20 bit) |
+ *
+ * Indices of destroyed entities are recycled with the next generation, an id
+ * kept after its entity was destroyed never matches the entity reusing the
+ * index(until the generation wraps after 4096 reuses of that index). */
+using CoreVuEntity = uint32_t;
+static constexpr CoreVuEntity NULL_ENTITY = ~CoreVuEntity{0};
+static constexpr uint32_t ENTITY_INDEX_BITS = 20;
+static constexpr uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+static constexpr uint32_t ENTITY_GENERATION_MASK =
+    ~CoreVuEntity{0} >> ENTITY_INDEX_BITS;
+// the last index is never used, NULL_ENTITY would be one of its ids
+static constexpr uint32_t MAX_ENTITIES = ENTITY_INDEX_MASK;
+
+inline uint32_t GetEntityIndex(CoreVuEntity entity)
+{
+  return entity & ENTITY_INDEX_MASK;
+}
+inline uint32_t GetEntityGeneration(CoreVuEntity entity)
+{
+  return entity >> ENTITY_INDEX_BITS;
+}
+inline CoreVuEntity MakeEntity(uint32_t index, uint32_t generation)
+{
+  return ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS) |
+         (index & ENTITY_INDEX_MASK);
+}
+
+using ComponentTypeId = uint32_t;
+static constexpr size_t MAX_COMPONENT_TYPES = 64;
+using ComponentMask = std::bitset<MAX_COMPONENT_TYPES>;
+
+/* World wide counter, see CoreVuWorld::newChangeVersion(). 64 bit so it never
+ * wraps around. */
+using ChangeVersion = uint64_t;
+
+/* Type-erased description of a component type, used by archetypes to
+ * construct, move and destroy column elements without knowing the type. */
+struct ComponentInfo
+{
+  ComponentTypeId id;
+  size_t size;
+  size_t alignment;
+
+  void (*default_construct)(void* dst);
+  void (*move_construct)(void* dst, void* src); // src stays alive(moved-from)
+  void (*destroy)(void* ptr);
+};
+
+class CoreVuComponentRegistry
+{
+public:
+  // const T(read only access in queries) is the same component as T
+  template <typename T>
+  static ComponentTypeId GetId()
+  {
+    if constexpr (std::is_const_v<T>)
+    {
+      return GetId<std::remove_const_t<T>>();
+    }
+    else
+    {
+      // thread-safe static initialization registers each type once
+      static const ComponentTypeId id = registerInfo(makeInfo<T>());
+      return id;
+    }
+  }
+
+  template <typename T>
+  static ComponentMask GetMask()
+  {
+    ComponentMask mask{};
+    mask.set(GetId<T>());
+    return mask;
+  }
+
+  template <typename... Ts>
+  static ComponentMask GetMaskOf()
+  {
+    ComponentMask mask{};
+    (mask.set(GetId<Ts>()), ...);
+    return mask;
+  }
+
+  static const ComponentInfo& GetInfo(ComponentTypeId id);
+  static size_t GetRegisteredCount();
+
+private:
+  template <typename T>
+  static ComponentInfo makeInfo()
+  {
+    static_assert(
+        std::is_default_constructible_v<T> &&
+            std::is_move_constructible_v<T>,
+        "Components must be default and move constructible.");
+    // columns start on a cache line of a cache line aligned chunk
+    static_assert(
+        alignof(T) <= coremem::CACHE_LINE_SIZE,
+        "Components can't be aligned past a cache line.");
+
+    ComponentInfo info{};
+    info.size = sizeof(T);
+    info.alignment = alignof(T);
+    info.default_construct = [](void* dst) { new (dst) T{}; };
+    info.move_construct = [](void* dst, void* src)
+    { new (dst) T{std::move(*static_cast<T*>(src))}; };
+    info.destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+    return info;
+  }
+
+  static ComponentTypeId registerInfo(ComponentInfo info);
+};
+
+} // namespace corevu
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ecs/corevu_ecs_types.hpp>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace corevu
+{
+/*
+Hands out entity ids, recycling the indices of destroyed entities.
+
+Freed ids go into a free list with their generation already incremented.
+reserve() may be called from any number of jobs at once: it pops the free list
+by decrementing an atomic cursor, once that is exhausted it counts up new
+indices behind the ones in use. Nothing is written but the two atomics, so
+reserving threads never block each other.
+
+       free list                       indices in use  | reserved new
+  | e7 | e2 | e9 | e4 |               0 ........ count | count + n
+             ^ cursor, reserve() takes [cursor - 1]
+
+flush() commits the reservations: taken entries leave the free list and the
+reserved new indices count as used. allocate(), free() and flush() must not
+run concurrently with anything else.
+*/
+class CoreVuEntityAllocator
+{
+public:
+  CoreVuEntityAllocator() = default;
+  CoreVuEntityAllocator(const CoreVuEntityAllocator&) = delete;
+  CoreVuEntityAllocator& operator=(const CoreVuEntityAllocator&) = delete;
+
+  CoreVuEntity allocate();
+  // thread safe against other reserve() calls
+  CoreVuEntity reserve();
+  void free(CoreVuEntity entity);
+  void flush();
+
+  // indices ever handed out, valid after flush()
+  uint32_t getIndexCount() const
+  {
+    return m_index_count;
+  }
+
+private:
+  std::vector<CoreVuEntity> m_free;
+  std::atomic<int64_t> m_free_cursor{0}; // m_free[0, cursor) is still free
+  std::atomic<uint32_t> m_reserved_new{0};
+  uint32_t m_index_count{0};
+};
+} // namespace corevu
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <ecs/corevu_ecs_types.hpp>
+
+// std
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuEventBus;
+class CoreVuWorld;
+class CoreVuJobSystem;
+
+/*
+Records structural changes(create/destroy entity, add/remove component) while
+the world must not change, e.g. in systems running as parallel jobs, and plays
+them back at a single sync point.
+
+  auto& commands = scheduler.getCommandBuffer(); // the calling thread's one
+  const auto bullet = commands.createEntity(world, TransformComponent{...});
+  commands.addComponent(bullet, RigidBody2dComponent{...});
+  commands.destroyEntity(target);
+  ...
+  commands.apply(world); // main thread, nothing else touching the world
+
+Ids of new entities are reserved right away(CoreVuWorld::reserveEntity), they
+can be used by later commands or stored in components before the entity
+exists. Components are moved into an arena of blocks owned by the buffer, the
+blocks are kept after apply() so recording stops allocating once warmed up.
+apply() creates the recorded entities first, then plays back the other
+commands in recording order. Those on entities which are not alive anymore by
+then are dropped. With an event bus, every created entity publishes an
+EntitySpawnedEvent and every destroyed one an EntityDespawnedEvent.
+*/
+class CoreVuEntityCommandBuffer
+{
+public:
+  CoreVuEntityCommandBuffer() = default;
+  ~CoreVuEntityCommandBuffer();
+
+  CoreVuEntityCommandBuffer(const CoreVuEntityCommandBuffer&) = delete;
+  CoreVuEntityCommandBuffer& operator=(const CoreVuEntityCommandBuffer&) =
+      delete;
+
+  template <typename... Ts>
+  CoreVuEntity createEntity(CoreVuWorld& world, Ts&&... components)
+  {
+    const CoreVuEntity entity = reserveEntity(world);
+    m_commands.push_back(Command{CommandType::Create, 0, entity, nullptr});
+    (pushComponent(
+         CommandType::CreateComponent, entity, std::forward<Ts>(components)),
+     ...);
+    return entity;
+  }
+
+  void destroyEntity(CoreVuEntity entity)
+  {
+    m_commands.push_back(Command{CommandType::Destroy, 0, entity, nullptr});
+  }
+
+  template <typename T>
+  void addComponent(CoreVuEntity entity, T&& component = T{})
+  {
+    pushComponent(
+        CommandType::AddComponent, entity, std::forward<T>(component));
+  }
+
+  template <typename T>
+  void removeComponent(CoreVuEntity entity)
+  {
+    m_commands.push_back(Command{
+        CommandType::RemoveComponent, CoreVuComponentRegistry::GetId<T>(),
+        entity, nullptr});
+  }
+
+  // event_bus may be null
+  void apply(CoreVuWorld& world, CoreVuEventBus* event_bus = nullptr);
+
+  bool isEmpty() const
+  {
+    return m_commands.empty();
+  }
+
+private:
+  enum class CommandType : uint8_t
+  {
+    Create,
+    CreateComponent, // follow their Create
+    Destroy,
+    AddComponent,
+    RemoveComponent,
+  };
+
+  struct Command
+  {
+    CommandType type;
+    ComponentTypeId id;
+    CoreVuEntity entity;
+    void* component; // in the arena, owned by the command until applied
+  };
+
+  static constexpr size_t BLOCK_SIZE = 16 * 1024;
+  struct alignas(64) Block
+  {
+    std::byte memory[BLOCK_SIZE];
+  };
+
+  template <typename T>
+  void pushComponent(CommandType type, CoreVuEntity entity, T&& component)
+  {
+    using Type = std::decay_t<T>;
+    static_assert(sizeof(Type) <= BLOCK_SIZE && alignof(Type) <= 64);
+    void* memory = allocate(sizeof(Type), alignof(Type));
+    new (memory) Type{std::forward<T>(component)};
+    m_commands.push_back(Command{
+        type, CoreVuComponentRegistry::GetId<Type>(), entity, memory});
+  }
+
+  friend class CoreVuEntityCommands;
+
+  // the two steps of apply(), see CoreVuEntityCommands::apply
+  void applyCreates(CoreVuWorld& world, CoreVuEventBus* event_bus);
+  void applyChanges(CoreVuWorld& world, CoreVuEventBus* event_bus);
+
+  static CoreVuEntity reserveEntity(CoreVuWorld& world);
+  void* allocate(size_t size, size_t alignment);
+  // destroys the components of commands not applied
+  void clear();
+
+  std::vector<Command> m_commands;
+  std::vector<std::unique_ptr<Block>> m_blocks;
+  size_t m_block{0};
+  size_t m_offset{0};
+};
+
+/* One command buffer per thread of the job system, jobs record into the
+ * buffer of the thread they run on, so they never contend. The scheduler owns
+ * one and applies it after the systems of a frame are done.
+ *
+ * Which thread runs a job is up to work stealing, so an entity created by one
+ * job may be in any buffer. apply() therefore creates the entities of all
+ * buffers first and only then plays back the other commands buffer by buffer:
+ * a component added to an entity reserved by another job this frame is never
+ * dropped. Inside a buffer the recording order holds, changes of different
+ * threads on the same entity have no order among each other. */
+class CoreVuEntityCommands
+{
+public:
+  explicit CoreVuEntityCommands(CoreVuJobSystem& job_system);
+
+  CoreVuEntityCommands(const CoreVuEntityCommands&) = delete;
+  CoreVuEntityCommands& operator=(const CoreVuEntityCommands&) = delete;
+
+  // buffer of the calling thread, which has to be one of the job system
+  CoreVuEntityCommandBuffer& get();
+  // event_bus may be null, see CoreVuEntityCommandBuffer::apply
+  void apply(CoreVuWorld& world, CoreVuEventBus* event_bus = nullptr);
+
+private:
+  CoreVuJobSystem& m_job_system;
+  std::vector<std::unique_ptr<CoreVuEntityCommandBuffer>> m_buffers;
+};
+} // namespace corevu
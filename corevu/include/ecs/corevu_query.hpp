@@ -0,0 +1,249 @@
+#pragma once
+
+#include <ecs/corevu_archetype.hpp>
+#include <jobs/corevu_job_system.hpp>
+
+// std
+#include <type_traits>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuWorld;
+
+/*
+Typed query over all archetypes containing every component in Ts and none of
+the excluded ones. Only matching archetypes are visited, their columns are
+walked linearly:
+
+  world.query<TransformComponent, ModelComponent>()
+      .without<TextureComponent>()
+      .each([](CoreVuEntity e, TransformComponent& t, ModelComponent& m) {});
+
+eachChunk() hands out whole columns, use it for SIMD or batched work:
+
+  query.eachChunk([](uint32_t count, const CoreVuEntity* entities,
+                     TransformComponent* transforms, ModelComponent* models) {});
+
+eachChunkParallel() splits the chunks of all matching archetypes into batches
+of chunks_per_job, runs them as jobs(parallelFor) and returns once all of them
+are done, the calling thread works on them too. Batching keeps the job count
+at chunks / chunks_per_job, 100k entities are a few hundred jobs and not one
+per chunk. The callback must only touch the rows of the chunk it gets, then
+the result does not depend on the thread count.
+
+Change tracking: every visited chunk counts as written for each non const
+component in Ts, so columns which are only read should be asked for as const:
+
+  world.query<const TransformComponent, ModelComponent>() // writes models
+
+changedSince<Us...>(version) skips chunks where none of Us was written after
+version. A system deriving data keeps the version of its last run:
+
+  const ChangeVersion since = m_version;
+  m_version = world.newChangeVersion();
+  world.query<const TransformComponent, PointLightComponent>()
+      .changedSince<TransformComponent>(since)
+      .writeVersion(m_version)
+      .each(...);
+
+writeVersion() stamps the writes of the query with the version of the run, so
+they don't show up as changes in its next run(other systems see them).
+
+The matching archetypes come from a view cached in the world per include and
+exclude mask, a query never tests all archetypes of the world. See
+CoreVuWorld::getMatchingArchetypes(). The view grows when archetypes are
+created, so no structural change that creates one may happen while a query
+iterates(asserted), neither from the callback nor from another thread. Jobs
+record them in a CoreVuEntityCommands instead.
+*/
+template <typename... Ts>
+class CoreVuQuery
+{
+public:
+  CoreVuQuery(const CoreVuWorld& world, ChangeVersion write_version)
+    : m_world{world},
+      m_include{CoreVuComponentRegistry::GetMaskOf<Ts...>()},
+      m_write_version{write_version}
+  {
+  }
+
+  template <typename... Us>
+  CoreVuQuery& without()
+  {
+    m_exclude |= CoreVuComponentRegistry::GetMaskOf<Us...>();
+    m_archetypes = nullptr;
+    return *this;
+  }
+
+  template <typename... Us>
+  CoreVuQuery& changedSince(ChangeVersion version)
+  {
+    m_changed |= CoreVuComponentRegistry::GetMaskOf<Us...>();
+    m_changed_since = version;
+    return *this;
+  }
+
+  CoreVuQuery& writeVersion(ChangeVersion version)
+  {
+    m_write_version = version;
+    return *this;
+  }
+
+  bool matches(const CoreVuArchetype& archetype) const
+  {
+    const auto& mask = archetype.getMask();
+    return (mask & m_include) == m_include && (mask & m_exclude).none();
+  }
+
+  bool changed(const CoreVuArchetype& archetype, size_t chunk) const
+  {
+    if (m_changed.none()) return true;
+
+    for (auto id : archetype.getTypes())
+    {
+      if (m_changed.test(id) &&
+          archetype.getChangeVersion(chunk, id) > m_changed_since)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <typename Fn>
+  void eachChunk(Fn&& fn) const
+  {
+    const IterationScope scope{*this};
+    const auto& archetypes = getArchetypes();
+    const size_t archetype_count = archetypes.size();
+    for (size_t i = 0; i < archetype_count; ++i)
+    {
+      auto* archetype = archetypes[i];
+      for (size_t chunk = 0; chunk < archetype->getChunkCount(); ++chunk)
+      {
+        if (!changed(*archetype, chunk)) continue;
+
+        markWritten(*archetype, chunk);
+        fn(archetype->getChunk(chunk).count, archetype->getEntities(chunk),
+           archetype->template getColumn<Ts>(chunk)...);
+      }
+    }
+  }
+
+  static constexpr uint32_t DEFAULT_CHUNKS_PER_JOB = 4;
+
+  template <typename Fn>
+  void eachChunkParallel(
+      CoreVuJobSystem& job_system, Fn&& fn,
+      uint32_t chunks_per_job = DEFAULT_CHUNKS_PER_JOB) const
+  {
+    // the chunks of all archetypes as one range, archetype after archetype
+    const IterationScope scope{*this};
+    const auto& archetypes = getArchetypes();
+    const size_t archetype_count = archetypes.size();
+    uint32_t chunk_count = 0;
+    for (size_t i = 0; i < archetype_count; ++i)
+    {
+      chunk_count += static_cast<uint32_t>(archetypes[i]->getChunkCount());
+    }
+
+    job_system.parallelFor(
+        chunk_count, chunks_per_job,
+        [&](uint32_t begin, uint32_t end)
+        {
+          size_t archetype = 0;
+          uint32_t first = 0; // range index of the archetype's first chunk
+          for (uint32_t index = begin; index < end; ++index)
+          {
+            while (index - first >= archetypes[archetype]->getChunkCount())
+            {
+              first += static_cast<uint32_t>(
+                  archetypes[archetype]->getChunkCount());
+              archetype++;
+            }
+            auto* current = archetypes[archetype];
+            const size_t chunk = index - first;
+            if (!changed(*current, chunk)) continue;
+
+            markWritten(*current, chunk);
+            fn(current->getChunk(chunk).count, current->getEntities(chunk),
+               current->template getColumn<Ts>(chunk)...);
+          }
+        });
+  }
+
+  template <typename Fn>
+  void each(Fn&& fn) const
+  {
+    eachChunk(
+        [&fn](uint32_t count, const CoreVuEntity* entities, Ts*... columns)
+        {
+          for (uint32_t i = 0; i < count; ++i)
+          {
+            fn(entities[i], columns[i]...);
+          }
+        });
+  }
+
+  // matching entities, changedSince() is not taken into account
+  size_t count() const
+  {
+    size_t result = 0;
+    const auto& archetypes = getArchetypes();
+    const size_t archetype_count = archetypes.size();
+    for (size_t i = 0; i < archetype_count; ++i)
+    {
+      result += archetypes[i]->getEntityCount();
+    }
+    return result;
+  }
+
+  // defined in corevu_world.hpp
+  const std::vector<CoreVuArchetype*>& getArchetypes() const;
+
+private:
+  // counts the iteration in the world, see CoreVuWorld::getOrCreateArchetype
+  struct IterationScope
+  {
+    explicit IterationScope(const CoreVuQuery& query) : world{query.m_world}
+    {
+      BeginIteration(world);
+    }
+    ~IterationScope()
+    {
+      EndIteration(world);
+    }
+    IterationScope(const IterationScope&) = delete;
+    IterationScope& operator=(const IterationScope&) = delete;
+
+    const CoreVuWorld& world;
+  };
+  // defined in corevu_world.hpp
+  static void BeginIteration(const CoreVuWorld& world);
+  static void EndIteration(const CoreVuWorld& world);
+
+  void markWritten(const CoreVuArchetype& archetype, size_t chunk) const
+  {
+    (
+        [&]
+        {
+          if constexpr (!std::is_const_v<Ts>)
+          {
+            archetype.setChangeVersion(
+                chunk, CoreVuComponentRegistry::GetId<Ts>(), m_write_version);
+          }
+        }(),
+        ...);
+  }
+
+  const CoreVuWorld& m_world;
+  ComponentMask m_include;
+  ComponentMask m_exclude{};
+  mutable const std::vector<CoreVuArchetype*>* m_archetypes{nullptr};
+
+  ComponentMask m_changed{};
+  ChangeVersion m_changed_since{0};
+  ChangeVersion m_write_version;
+};
+} // namespace corevu
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <corevu_frame_info.hpp>
+#include <ecs/corevu_ecs_types.hpp>
+#include <ecs/corevu_entity_commands.hpp>
+#include <jobs/corevu_job_system.hpp>
+
+// std
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace corevu
+{
+/* Shared state that is not a component is declared through tag types, the
+ * scheduler orders accesses to them like accesses to a component column. */
+struct CommandBufferResource // recording into FrameInfo::command_buffer
+{
+};
+struct GlobalUboResource // the per frame GlobalUbo
+{
+};
+
+/* Components and resources a system reads and writes. */
+class CoreVuSystemAccess
+{
+public:
+  template <typename... Ts>
+  CoreVuSystemAccess& read()
+  {
+    m_reads |= CoreVuComponentRegistry::GetMaskOf<Ts...>();
+    return *this;
+  }
+  template <typename... Ts>
+  CoreVuSystemAccess& write()
+  {
+    m_writes |= CoreVuComponentRegistry::GetMaskOf<Ts...>();
+    return *this;
+  }
+
+  // two systems conflict if one of them writes anything the other one touches
+  bool conflictsWith(const CoreVuSystemAccess& other) const
+  {
+    return (m_writes & (other.m_reads | other.m_writes)).any() ||
+           (other.m_writes & m_reads).any();
+  }
+
+private:
+  ComponentMask m_reads{};
+  ComponentMask m_writes{};
+};
+
+struct CoreVuSystemTiming
+{
+  std::string name;
+  double last_ms{0.0};
+  double total_ms{0.0};
+  double max_ms{0.0};
+  uint64_t frames{0};
+};
+
+/*
+Runs the registered systems of a frame as jobs.
+
+  scheduler.addSystem(
+      "point_light_update",
+      CoreVuSystemAccess{}.write<TransformComponent>().read<PointLightComponent>(),
+      [&](FrameInfo& frame_info) { ... });
+  scheduler.run(frame_info);
+
+Every frame the enabled systems are put into a dependency graph: a system
+depends on each system registered before it which it conflicts with. Systems
+without a path between them run concurrently, conflicting ones always in
+registration order, so the result is the same as running them one after the
+other on a single thread.
+
+Systems must not change the structure of the world(create/destroy entities,
+add/remove components), they record those into getCommandBuffer() instead.
+The buffers are applied once all systems of the frame are done, then the
+events they published(FrameInfo::event_bus) are dispatched, together with the
+spawn and despawn events of the applied commands.
+*/
+class CoreVuScheduler
+{
+public:
+  using SystemId = uint32_t;
+  using SystemFunction = std::function<void(FrameInfo&)>;
+
+  explicit CoreVuScheduler(CoreVuJobSystem& job_system);
+
+  CoreVuScheduler(const CoreVuScheduler&) = delete;
+  CoreVuScheduler& operator=(const CoreVuScheduler&) = delete;
+
+  SystemId addSystem(
+      std::string name, const CoreVuSystemAccess& access,
+      SystemFunction function);
+  void setEnabled(SystemId id, bool enabled);
+
+  // blocks until all systems of the frame are done, their commands applied
+  // and their events dispatched
+  void run(FrameInfo& frame_info);
+
+  // entity command buffer of the calling thread, see CoreVuEntityCommands
+  CoreVuEntityCommandBuffer& getCommandBuffer()
+  {
+    return m_commands.get();
+  }
+
+  const CoreVuSystemTiming& getTiming(SystemId id) const
+  {
+    return m_systems[id]->timing;
+  }
+  void printReport(std::ostream& out) const;
+
+private:
+  struct System
+  {
+    CoreVuSystemAccess access;
+    SystemFunction function;
+    bool enabled{true};
+
+    // per frame graph
+    std::vector<SystemId> dependents;
+    uint32_t dependency_count{0};
+    std::atomic<uint32_t> remaining{0};
+
+    CoreVuSystemTiming timing;
+  };
+
+  void buildGraph();
+  void runSystem(SystemId id, FrameInfo& frame_info);
+
+  CoreVuJobSystem& m_job_system;
+  std::vector<std::unique_ptr<System>> m_systems;
+  CoreVuJobCounter m_frame_counter;
+  CoreVuEntityCommands m_commands;
+};
+} // namespace corevu
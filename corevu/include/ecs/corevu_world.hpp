@@ -0,0 +1,355 @@
+#pragma once
+
+#include <ecs/corevu_archetype.hpp>
+#include <ecs/corevu_entity_allocator.hpp>
+#include <ecs/corevu_query.hpp>
+
+// std
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace corevu
+{
+/*
+Owns all entities and their components, grouped in archetypes.
+
+  CoreVuWorld world;
+  auto e = world.createEntity(TransformComponent{}, ModelComponent{model});
+  world.addComponent(e, TextureComponent{texture});
+  world.query<TransformComponent>().each(...);
+
+References returned by getComponent/addComponent are invalidated by any
+structural change(create/destroy entity, add/remove component) in the same
+archetype.
+
+Change versions: getComponent<T>() of a non const T, queries with non const
+components and structural changes stamp the chunk column with the current
+change version. newChangeVersion() hands the current version to a system and
+moves on, so every write after it gets a newer one:
+
+  writes(v5) | system A: since 0, takes v5 | writes(v6) | system A: since 5
+                 sees the v5 writes                         sees the v6 ones
+*/
+class CoreVuWorld
+{
+public:
+  CoreVuWorld();
+  ~CoreVuWorld();
+
+  CoreVuWorld(const CoreVuWorld&) = delete;
+  CoreVuWorld& operator=(const CoreVuWorld&) = delete;
+
+  CoreVuEntity createEntity();
+
+  template <typename... Ts>
+  CoreVuEntity createEntity(Ts&&... components)
+  {
+    const ComponentMask mask =
+        CoreVuComponentRegistry::GetMaskOf<std::decay_t<Ts>...>();
+    auto* archetype = getOrCreateArchetype(mask);
+
+    const CoreVuEntity entity = allocateEntity();
+    const auto slot = archetype->allocateSlot(entity, getChangeVersion());
+    (new (archetype->getComponent(
+         slot, CoreVuComponentRegistry::GetId<std::decay_t<Ts>>()))
+         std::decay_t<Ts>{std::forward<Ts>(components)},
+     ...);
+
+    setRecord(entity, archetype, slot);
+    return entity;
+  }
+
+  /* Creates count entities with the components of mask in one go, components
+   * are default constructed. fill(archetype, chunk, first_row, row_count) is
+   * called once per run of new rows inside a chunk, to overwrite whole
+   * columns at once(the scene loader copies them straight from the file):
+   *
+   *   world.createEntities(mask, 100'000,
+   *     [&](CoreVuArchetype& archetype, size_t chunk, uint32_t first_row,
+   *         uint32_t row_count) { std::memcpy(...); });
+   */
+  template <typename Fn>
+  void createEntities(const ComponentMask& mask, size_t count, Fn&& fill)
+  {
+    auto* archetype = getOrCreateArchetype(mask);
+    const ChangeVersion version = getChangeVersion();
+    m_records.reserve(m_records.size() + count);
+
+    size_t created = 0;
+    while (created < count)
+    {
+      CoreVuEntity entity = allocateEntity();
+      const auto first = archetype->allocateSlot(entity, version);
+      setRecord(entity, archetype, first);
+
+      uint32_t row_count = 1;
+      while (created + row_count < count &&
+             first.row + row_count < archetype->getChunkCapacity())
+      {
+        entity = allocateEntity();
+        setRecord(entity, archetype, archetype->allocateSlot(entity, version));
+        row_count++;
+      }
+
+      for (auto id : archetype->getTypes())
+      {
+        const auto& info = CoreVuComponentRegistry::GetInfo(id);
+        auto* column = static_cast<uint8_t*>(
+                           archetype->getColumn(first.chunk, id)) +
+                       first.row * info.size;
+        for (uint32_t row = 0; row < row_count; ++row)
+        {
+          info.default_construct(column + row * info.size);
+        }
+      }
+      fill(*archetype, size_t{first.chunk}, first.row, row_count);
+      created += row_count;
+    }
+  }
+
+  /* Id for an entity created later through createReservedEntity(), usually
+   * by a command buffer. Thread safe against other reserveEntity() calls, so
+   * jobs can hand out ids while the world is otherwise read only. The entity
+   * is not alive until it is created. */
+  CoreVuEntity reserveEntity()
+  {
+    return m_allocator.reserve();
+  }
+
+  /* Creates a reserved entity in the archetype of mask, components are left
+   * unconstructed: construct(id, memory) is called once per component. */
+  template <typename Fn>
+  void createReservedEntity(
+      CoreVuEntity entity, const ComponentMask& mask, Fn&& construct)
+  {
+    m_allocator.flush();
+    if (m_records.size() < m_allocator.getIndexCount())
+    {
+      m_records.resize(m_allocator.getIndexCount());
+    }
+    assert(
+        m_records[GetEntityIndex(entity)].archetype == nullptr &&
+        "Entity was not reserved");
+
+    auto* archetype = getOrCreateArchetype(mask);
+    const auto slot = archetype->allocateSlot(entity, getChangeVersion());
+    for (auto id : archetype->getTypes())
+    {
+      construct(id, archetype->getComponent(slot, id));
+    }
+    setRecord(entity, archetype, slot);
+    m_alive_count++;
+  }
+
+  void destroyEntity(CoreVuEntity entity);
+  bool isAlive(CoreVuEntity entity) const
+  {
+    const uint32_t index = GetEntityIndex(entity);
+    return entity != NULL_ENTITY && index < m_records.size() &&
+           m_records[index].archetype != nullptr &&
+           m_records[index].generation == GetEntityGeneration(entity);
+  }
+
+  template <typename T>
+  T& addComponent(CoreVuEntity entity, T&& component = T{})
+  {
+    using Type = std::decay_t<T>;
+    const ComponentTypeId id = CoreVuComponentRegistry::GetId<Type>();
+    if (hasComponent<Type>(entity))
+    {
+      Type& existing = *getComponent<Type>(entity);
+      existing = std::forward<T>(component);
+      return existing;
+    }
+
+    const auto& record = moveEntity(entity, addEdge(entity, id), id);
+    return *new (record.archetype->getComponent(record.slot, id))
+        Type{std::forward<T>(component)};
+  }
+
+  // type erased versions, component is moved from
+  void addComponent(CoreVuEntity entity, ComponentTypeId id, void* component);
+  void removeComponent(CoreVuEntity entity, ComponentTypeId id);
+
+  template <typename T>
+  void removeComponent(CoreVuEntity entity)
+  {
+    const ComponentTypeId id = CoreVuComponentRegistry::GetId<T>();
+    if (!hasComponent<T>(entity)) return;
+
+    moveEntity(entity, removeEdge(entity, id), id);
+  }
+
+  template <typename T>
+  bool hasComponent(CoreVuEntity entity) const
+  {
+    assert(isAlive(entity) && "Entity is not alive");
+    return getRecord(entity).archetype->hasComponent(
+        CoreVuComponentRegistry::GetId<T>());
+  }
+
+  // getComponent<const T>() for reads, T is assumed to be written
+  template <typename T>
+  T* getComponent(CoreVuEntity entity) const
+  {
+    return getComponent<T>(entity, getChangeVersion());
+  }
+
+  // writes are stamped with write_version, see CoreVuQuery::writeVersion()
+  template <typename T>
+  T* getComponent(CoreVuEntity entity, ChangeVersion write_version) const
+  {
+    assert(isAlive(entity) && "Entity is not alive");
+    const auto& record = getRecord(entity);
+    const ComponentTypeId id = CoreVuComponentRegistry::GetId<T>();
+    if (!record.archetype->hasComponent(id)) return nullptr;
+    if constexpr (!std::is_const_v<T>)
+    {
+      record.archetype->setChangeVersion(
+          record.slot.chunk, id, write_version);
+    }
+    return static_cast<T*>(record.archetype->getComponent(record.slot, id));
+  }
+
+  template <typename... Ts>
+  CoreVuQuery<Ts...> query() const
+  {
+    return CoreVuQuery<Ts...>{*this, getChangeVersion()};
+  }
+
+  /* Archetypes having all of include and none of exclude. The list is built
+   * on first use and kept up to date when archetypes are created, so a query
+   * costs O(matching archetypes) no matter how many others exist. The
+   * reference stays valid, but it is extended in place by structural changes
+   * creating an archetype: those must not happen while it is iterated, see
+   * CoreVuQuery. */
+  const std::vector<CoreVuArchetype*>& getMatchingArchetypes(
+      const ComponentMask& include, const ComponentMask& exclude) const;
+
+  // version writes get right now
+  ChangeVersion getChangeVersion() const
+  {
+    return m_change_version.load(std::memory_order_relaxed);
+  }
+  // returns the current version and advances, see above
+  ChangeVersion newChangeVersion()
+  {
+    return m_change_version.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t getEntityCount() const
+  {
+    return m_alive_count;
+  }
+  /* Grows whenever an entity leaves an archetype(destroyed, component added
+   * or removed). Systems mirroring entities outside of the world compare it
+   * with the count of their last run to know if they have to look for gone
+   * ones. */
+  uint64_t getRemovalCount() const
+  {
+    return m_removal_count;
+  }
+  const std::vector<CoreVuArchetype*>& getArchetypes() const
+  {
+    return m_archetype_list;
+  }
+
+private:
+  struct EntityRecord
+  {
+    CoreVuArchetype* archetype{nullptr};
+    CoreVuArchetype::Slot slot{};
+    uint32_t generation{0};
+  };
+
+  struct QueryView
+  {
+    ComponentMask include;
+    ComponentMask exclude;
+    std::vector<CoreVuArchetype*> archetypes;
+
+    bool matches(const ComponentMask& mask) const
+    {
+      return (mask & include) == include && (mask & exclude).none();
+    }
+  };
+
+  CoreVuEntity allocateEntity();
+  EntityRecord& getRecord(CoreVuEntity entity)
+  {
+    return m_records[GetEntityIndex(entity)];
+  }
+  const EntityRecord& getRecord(CoreVuEntity entity) const
+  {
+    return m_records[GetEntityIndex(entity)];
+  }
+  void setRecord(
+      CoreVuEntity entity, CoreVuArchetype* archetype,
+      const CoreVuArchetype::Slot& slot)
+  {
+    getRecord(entity) =
+        EntityRecord{archetype, slot, GetEntityGeneration(entity)};
+  }
+  CoreVuArchetype* getOrCreateArchetype(const ComponentMask& mask);
+  CoreVuArchetype* addEdge(CoreVuEntity entity, ComponentTypeId id);
+  CoreVuArchetype* removeEdge(CoreVuEntity entity, ComponentTypeId id);
+
+  /* Moves the entity into target, moving all shared components. The column
+   * of skip_id in target(if any) is left unconstructed for the caller. */
+  const EntityRecord& moveEntity(
+      CoreVuEntity entity, CoreVuArchetype* target, ComponentTypeId skip_id);
+
+  CoreVuEntityAllocator m_allocator;
+  std::vector<EntityRecord> m_records; // by entity index
+  size_t m_alive_count{0};
+  uint64_t m_removal_count{0};
+  std::atomic<ChangeVersion> m_change_version{1};
+
+  std::unordered_map<ComponentMask, std::unique_ptr<CoreVuArchetype>>
+      m_archetypes;
+  std::vector<CoreVuArchetype*> m_archetype_list; // in creation order
+  CoreVuArchetype* m_empty_archetype{nullptr};
+
+  template <typename... Ts>
+  friend class CoreVuQuery;
+  // queries iterating right now, only counted with asserts enabled
+  mutable std::atomic<uint32_t> m_iterating_queries{0};
+
+  // views are created lazily by queries, possibly from several jobs at once
+  mutable std::mutex m_views_mutex;
+  mutable std::vector<std::unique_ptr<QueryView>> m_views;
+  mutable std::unordered_multimap<size_t, QueryView*> m_view_lookup;
+};
+
+template <typename... Ts>
+void CoreVuQuery<Ts...>::BeginIteration(
+    [[maybe_unused]] const CoreVuWorld& world)
+{
+#ifndef NDEBUG
+  world.m_iterating_queries.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+template <typename... Ts>
+void CoreVuQuery<Ts...>::EndIteration(
+    [[maybe_unused]] const CoreVuWorld& world)
+{
+#ifndef NDEBUG
+  world.m_iterating_queries.fetch_sub(1, std::memory_order_relaxed);
+#endif
+}
+
+template <typename... Ts>
+const std::vector<CoreVuArchetype*>& CoreVuQuery<Ts...>::getArchetypes() const
+{
+  if (m_archetypes == nullptr)
+  {
+    m_archetypes = &m_world.getMatchingArchetypes(m_include, m_exclude);
+  }
+  return *m_archetypes;
+}
+} // namespace corevu
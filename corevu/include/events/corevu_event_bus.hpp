@@ -0,0 +1,180 @@
+#pragma once
+
+#include <jobs/corevu_job_system.hpp>
+
+// std
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace corevu
+{
+/*
+Typed events between systems, delivered in batches once per frame.
+
+  bus.subscribe<EntitySpawnedEvent>(
+      [&](std::span<const EntitySpawnedEvent> events) { ... });
+  ...
+  bus.publish(EntitySpawnedEvent{entity}); // from any job, no locks
+  ...
+  bus.dispatch(); // frame boundary, main thread
+
+Every event type has its own channel with one buffer per job system thread.
+publish() appends to the buffer of the calling thread, so publishing jobs never
+touch the same memory. dispatch() concatenates the thread buffers(thread 0
+first) and hands the whole batch to each subscriber in subscription order:
+
+  thread 0 | a0 a1 |                 subscriber 1( a0 a1 b0 c0 c1 c2 )
+  thread 1 | b0 |       -> merge ->  subscriber 2( a0 a1 b0 c0 c1 c2 )
+  thread 2 | c0 c1 c2 |
+
+Buffers are cleared but keep their capacity, after the first frames neither
+publish() nor dispatch() allocate. Events published during dispatch() are
+delivered by the next one at the latest.
+
+Channels are created by subscribe() or registerEvent(), both only from the main
+thread while no job publishes and not from inside a subscriber. Publishing an
+event type nobody registered is a bug and asserts. Events are plain values,
+copied into the buffers. The events of the engine itself(spawns, despawns,
+collisions) are in corevu_events.hpp.
+*/
+class CoreVuEventBus
+{
+public:
+  using SubscriptionId = uint32_t;
+
+  explicit CoreVuEventBus(CoreVuJobSystem& job_system)
+    : m_job_system{job_system}
+  {
+  }
+
+  CoreVuEventBus(const CoreVuEventBus&) = delete;
+  CoreVuEventBus& operator=(const CoreVuEventBus&) = delete;
+
+  template <typename T>
+  void registerEvent()
+  {
+    getOrCreateChannel<T>();
+  }
+
+  template <typename T, typename Fn>
+  SubscriptionId subscribe(Fn&& fn)
+  {
+    auto& channel = getOrCreateChannel<T>();
+    const SubscriptionId id = m_next_subscription++;
+    channel.subscribers.push_back(
+        Subscriber<T>{id, std::function<void(std::span<const T>)>{
+                              std::forward<Fn>(fn)}});
+    return id;
+  }
+
+  template <typename T>
+  void unsubscribe(SubscriptionId id)
+  {
+    auto& subscribers = getOrCreateChannel<T>().subscribers;
+    std::erase_if(
+        subscribers, [id](const auto& subscriber)
+        { return subscriber.id == id; });
+  }
+
+  // from the main thread or any job of the job system
+  template <typename T>
+  void publish(const T& event)
+  {
+    const uint32_t type = GetEventType<std::decay_t<T>>();
+    assert(
+        type < m_channels.size() && m_channels[type] != nullptr &&
+        "Event type was not registered");
+    auto& channel = static_cast<Channel<std::decay_t<T>>&>(*m_channels[type]);
+    channel.threads[m_job_system.getThreadIndex()].events.push_back(event);
+  }
+
+  // delivers everything published since the last dispatch, main thread only
+  void dispatch();
+
+private:
+  template <typename T>
+  struct Subscriber
+  {
+    SubscriptionId id;
+    std::function<void(std::span<const T>)> function;
+  };
+
+  struct ChannelBase
+  {
+    virtual ~ChannelBase() = default;
+    virtual void dispatch() = 0;
+  };
+
+  template <typename T>
+  struct Channel final : ChannelBase
+  {
+    // own cache lines, threads publish next to each other
+    struct alignas(64) ThreadEvents
+    {
+      std::vector<T> events;
+    };
+
+    explicit Channel(uint32_t thread_count) : threads(thread_count)
+    {
+    }
+
+    void dispatch() override
+    {
+      merged.clear();
+      for (auto& thread : threads)
+      {
+        merged.insert(merged.end(), thread.events.begin(), thread.events.end());
+        thread.events.clear();
+      }
+      if (merged.empty()) return;
+
+      const std::span<const T> batch{merged};
+      for (auto& subscriber : subscribers)
+      {
+        subscriber.function(batch);
+      }
+    }
+
+    std::vector<ThreadEvents> threads;
+    std::vector<T> merged;
+    std::vector<Subscriber<T>> subscribers;
+  };
+
+  template <typename T>
+  static uint32_t GetEventType()
+  {
+    static_assert(
+        std::is_trivially_destructible_v<T> && std::is_copy_constructible_v<T>,
+        "Events must be plain values.");
+    static const uint32_t type = NextEventType();
+    return type;
+  }
+  static uint32_t NextEventType();
+
+  template <typename T>
+  Channel<T>& getOrCreateChannel()
+  {
+    assert(m_job_system.isMainThread() && "Channels change on the main thread");
+    const uint32_t type = GetEventType<T>();
+    if (type >= m_channels.size())
+    {
+      m_channels.resize(type + 1);
+    }
+    if (m_channels[type] == nullptr)
+    {
+      m_channels[type] =
+          std::make_unique<Channel<T>>(m_job_system.getThreadCount());
+    }
+    return static_cast<Channel<T>&>(*m_channels[type]);
+  }
+
+  CoreVuJobSystem& m_job_system;
+  std::vector<std::unique_ptr<ChannelBase>> m_channels; // by event type
+  SubscriptionId m_next_subscription{0};
+};
+} // namespace corevu
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <ecs/corevu_ecs_types.hpp>
+
+namespace corevu
+{
+/* Events of the engine itself, published on the CoreVuEventBus of the frame.
+ * Spawns and despawns are registered by the command buffers applying them,
+ * collisions are published by a job, register CollisionEvent at startup. */
+
+// an entity created through a command buffer, alive from this frame on
+struct EntitySpawnedEvent
+{
+  CoreVuEntity entity;
+};
+
+// an entity destroyed through a command buffer, not alive anymore when the
+// event is delivered
+struct EntityDespawnedEvent
+{
+  CoreVuEntity entity;
+};
+
+// two entities whose boxes overlap, a pair of CoreVuBroadphase::findPairs()
+struct CollisionEvent
+{
+  CoreVuEntity a;
+  CoreVuEntity b;
+};
+} // namespace corevu
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "corevu_gameobject.hpp"
+#include "corevu_components.hpp"
 #include "corevu_window.hpp"
 
 namespace corevu
@@ -23,7 +23,7 @@ public:
   };
 
   void moveInPlaneXZ(
-      GLFWwindow* window, float dt, CoreVuGameObject& gameObject);
+      GLFWwindow* window, float dt, TransformComponent& transform);
 
   KeyMappings keys{};
   float moveSpeed{3.f};
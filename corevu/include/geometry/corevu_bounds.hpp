@@ -0,0 +1,213 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace corevu
+{
+/*
+Bounding volumes and the overlap tests between them, shared by the spatial
+index, culling and picking. Everything is plain data with inline functions.
+
+Planes are stored as vec4{normal, d}, a point p is on the inner side when
+dot(normal, p) + d >= 0. Frustum planes point into the frustum.
+*/
+
+struct CoreVuAabb
+{
+  // empty: min > max, expanding by anything gives that thing
+  glm::vec3 min{std::numeric_limits<float>::max()};
+  glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+  static CoreVuAabb FromCenterExtents(
+      const glm::vec3& center, const glm::vec3& extents)
+  {
+    return CoreVuAabb{center - extents, center + extents};
+  }
+
+  bool isEmpty() const
+  {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+  }
+  glm::vec3 getCenter() const
+  {
+    return (min + max) * 0.5f;
+  }
+  // half size
+  glm::vec3 getExtents() const
+  {
+    return (max - min) * 0.5f;
+  }
+  // half the surface area, the cost metric of the BVH
+  float getPerimeter() const
+  {
+    const glm::vec3 size = max - min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+  }
+
+  void expand(const glm::vec3& point)
+  {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+  void expand(const CoreVuAabb& other)
+  {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+  }
+  bool contains(const CoreVuAabb& other) const
+  {
+    return glm::all(glm::lessThanEqual(min, other.min)) &&
+           glm::all(glm::lessThanEqual(other.max, max));
+  }
+
+  /* Box around the transformed box(Arvo): the extents go through the
+   * absolute of the linear part, no need to transform all 8 corners. */
+  CoreVuAabb transformed(const glm::mat4& matrix) const
+  {
+    const glm::vec3 center = glm::vec3{matrix * glm::vec4{getCenter(), 1.f}};
+    const glm::mat3 linear{matrix};
+    const glm::mat3 absolute{
+        glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2])};
+    return FromCenterExtents(center, absolute * getExtents());
+  }
+};
+
+inline CoreVuAabb Union(const CoreVuAabb& a, const CoreVuAabb& b)
+{
+  return CoreVuAabb{glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+struct CoreVuSphere
+{
+  glm::vec3 center{0.f};
+  float radius{0.f};
+};
+
+struct CoreVuRay
+{
+  glm::vec3 origin{0.f};
+  glm::vec3 direction{0.f, 0.f, 1.f}; // not necessarily normalized
+  float max_distance{std::numeric_limits<float>::max()}; // in direction units
+};
+
+struct CoreVuFrustum
+{
+  enum Plane
+  {
+    Left,
+    Right,
+    Bottom,
+    Top,
+    Near,
+    Far,
+    PLANE_COUNT
+  };
+
+  std::array<glm::vec4, PLANE_COUNT> planes{};
+
+  /* Planes of a projection * view matrix(Gribb/Hartmann), in the space the
+   * matrix maps from. Clip depth is 0..1, so the near plane is row 2 alone. */
+  static CoreVuFrustum FromMatrix(const glm::mat4& matrix)
+  {
+    const glm::mat4 rows = glm::transpose(matrix);
+    CoreVuFrustum frustum;
+    frustum.planes[Left] = rows[3] + rows[0];
+    frustum.planes[Right] = rows[3] - rows[0];
+    frustum.planes[Bottom] = rows[3] + rows[1];
+    frustum.planes[Top] = rows[3] - rows[1];
+    frustum.planes[Near] = rows[2];
+    frustum.planes[Far] = rows[3] - rows[2];
+    for (auto& plane : frustum.planes)
+    {
+      plane /= glm::length(glm::vec3{plane});
+    }
+    return frustum;
+  }
+};
+
+inline bool Intersects(const CoreVuAabb& a, const CoreVuAabb& b)
+{
+  return glm::all(glm::lessThanEqual(a.min, b.max)) &&
+         glm::all(glm::lessThanEqual(b.min, a.max));
+}
+
+inline bool Intersects(const CoreVuAabb& box, const CoreVuSphere& sphere)
+{
+  const glm::vec3 closest = glm::clamp(sphere.center, box.min, box.max);
+  const glm::vec3 offset = sphere.center - closest;
+  return glm::dot(offset, offset) <= sphere.radius * sphere.radius;
+}
+
+inline bool Intersects(const CoreVuFrustum& frustum, const CoreVuSphere& sphere)
+{
+  for (const auto& plane : frustum.planes)
+  {
+    if (glm::dot(glm::vec3{plane}, sphere.center) + plane.w < -sphere.radius)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+enum class CoreVuContainment
+{
+  Outside,
+  Intersecting,
+  Inside,
+};
+
+/* Box against the planes in plane_mask(bit per CoreVuFrustum::Plane). Planes
+ * the box is fully inside of are cleared from plane_mask, children of the box
+ * don't need to test them again. */
+inline CoreVuContainment Classify(
+    const CoreVuFrustum& frustum, const CoreVuAabb& box, uint32_t& plane_mask)
+{
+  const glm::vec3 center = box.getCenter();
+  const glm::vec3 extents = box.getExtents();
+  for (uint32_t i = 0; i < CoreVuFrustum::PLANE_COUNT; ++i)
+  {
+    if ((plane_mask & (1u << i)) == 0) continue;
+
+    const glm::vec4& plane = frustum.planes[i];
+    const float distance = glm::dot(glm::vec3{plane}, center) + plane.w;
+    const float radius = glm::dot(glm::abs(glm::vec3{plane}), extents);
+    if (distance < -radius) return CoreVuContainment::Outside;
+    if (distance >= radius) plane_mask &= ~(1u << i);
+  }
+  return plane_mask == 0 ? CoreVuContainment::Inside
+                         : CoreVuContainment::Intersecting;
+}
+
+inline bool Intersects(const CoreVuFrustum& frustum, const CoreVuAabb& box)
+{
+  uint32_t plane_mask = (1u << CoreVuFrustum::PLANE_COUNT) - 1;
+  return Classify(frustum, box, plane_mask) != CoreVuContainment::Outside;
+}
+
+/* Slab test, inverse_direction = 1 / ray.direction(infinities for zero
+ * components are fine). Returns the entry distance through distance, 0 if the
+ * origin is inside. */
+inline bool IntersectRay(
+    const CoreVuRay& ray, const glm::vec3& inverse_direction,
+    const CoreVuAabb& box, float& distance)
+{
+  const glm::vec3 t0 = (box.min - ray.origin) * inverse_direction;
+  const glm::vec3 t1 = (box.max - ray.origin) * inverse_direction;
+  const glm::vec3 t_near = glm::min(t0, t1);
+  const glm::vec3 t_far = glm::max(t0, t1);
+  const float enter = std::max({t_near.x, t_near.y, t_near.z, 0.f});
+  const float exit = std::min({t_far.x, t_far.y, t_far.z, ray.max_distance});
+  distance = enter;
+  return enter <= exit;
+}
+} // namespace corevu
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <geometry/corevu_bounds.hpp>
+#include <simd/corevu_ray_intersect.hpp>
+
+// std
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuJobSystem;
+
+struct CoreVuMeshHit
+{
+  static constexpr uint32_t NO_TRIANGLE = UINT32_MAX;
+
+  // indices[3 * triangle + 0..2] of the mesh the BVH was built from
+  uint32_t triangle{NO_TRIANGLE};
+  float distance{0.f};        // along the ray, in direction units
+  glm::vec2 barycentric{0.f}; // weights of the second and third corner
+
+  bool isHit() const
+  {
+    return triangle != NO_TRIANGLE;
+  }
+};
+
+/*
+Bounding volume hierarchy over the triangles of one mesh, for ray casts and
+picking against the exact surface. Static, built once when the mesh loads:
+
+  CoreVuMeshBvh bvh;
+  bvh.build(positions, indices, &job_system);
+  const CoreVuMeshHit hit = bvh.raycast(model_space_ray);
+  if (hit.isHit()) ... indices[3 * hit.triangle]
+
+Nodes split at the best of BIN_COUNT candidate planes per axis by the surface
+area heuristic(binned SAH): the expected cost of a split is the chance a ray
+through the node enters each child, their surface area ratio, times the
+triangle tests in it. Leaf triangles are tested a whole group of
+CoreVuTriangleSoA::GROUP_SIZE at once, so the heuristic counts groups, not
+triangles, and leaves fill up to a group before splitting pays:
+
+  nodes:  [0: root] [1: a  2: b] [3: c  4: d] ...   children are pairs
+  slots:  | leaf c: t7 t2 t9 -- -- -- -- -- | leaf d: t4 t0 .. |
+          each leaf starts a group, the rest holds empty triangles
+
+Subtrees of PARALLEL_BUILD_TRIANGLES and more are built as jobs when a job
+system is given, the calling thread helps while waiting. The build only
+reads positions and indices, the BVH keeps its own copy of the triangles.
+
+raycast() walks one ray near child first and skips nodes behind the closest
+hit. The packet version walks CoreVuRayPacket::SIZE coherent rays(picking a
+region, shadow or gameplay rays from one point) together, a node is visited
+once for all active rays and the box and triangle tests run over the packet
+lanes.
+*/
+class CoreVuMeshBvh
+{
+public:
+  static constexpr uint32_t BIN_COUNT = 16;
+  // larger nodes are split even if the heuristic would keep them
+  static constexpr uint32_t MAX_LEAF_TRIANGLES =
+      2 * CoreVuTriangleSoA::GROUP_SIZE;
+  static constexpr uint32_t MAX_DEPTH = 64;
+  static constexpr uint32_t PARALLEL_BUILD_TRIANGLES = 4096;
+  // relative costs of a node visit and a group of triangle tests
+  static constexpr float TRAVERSAL_COST = 1.f;
+  static constexpr float GROUP_COST = 2.f;
+
+  struct Node
+  {
+    CoreVuAabb box;
+    // leaf: first triangle slot, internal: left child, the right one follows
+    uint32_t first{0};
+    uint32_t count{0}; // triangles of a leaf, 0 for internal nodes
+
+    bool isLeaf() const
+    {
+      return count > 0;
+    }
+  };
+
+  CoreVuMeshBvh() = default;
+
+  // indices are triangles, 3 per triangle, job_system may be null
+  void build(
+      std::span<const glm::vec3> positions, std::span<const uint32_t> indices,
+      CoreVuJobSystem* job_system = nullptr);
+  void clear();
+
+  // closest triangle hit before ray.max_distance
+  CoreVuMeshHit raycast(const CoreVuRay& ray) const;
+  /* Closest hits of the active lanes: lanes hitting something before their
+   * max_distance get hits[lane] replaced and their max_distance shrunk to it.
+   * Returns those lanes. */
+  uint32_t raycast(
+      CoreVuRayPacket& packet, uint32_t active, CoreVuMeshHit* hits) const;
+
+  const CoreVuAabb& getBounds() const
+  {
+    static const CoreVuAabb empty{};
+    return m_nodes.empty() ? empty : m_nodes[0].box;
+  }
+  std::span<const Node> getNodes() const
+  {
+    return m_nodes;
+  }
+  uint32_t getTriangleCount() const
+  {
+    return m_triangle_count;
+  }
+  // triangles plus the empty ones filling the groups of the leaves
+  uint32_t getSlotCount() const
+  {
+    return m_slot_count;
+  }
+  uint32_t getDepth() const
+  {
+    return m_depth;
+  }
+
+private:
+  struct Build;
+
+  void buildNode(
+      Build& build, uint32_t node_index, uint32_t begin, uint32_t end,
+      uint32_t depth);
+  // moves the triangles of the leaves into group aligned slots
+  void layoutTriangles(
+      const Build& build, std::span<const glm::vec3> positions,
+      std::span<const uint32_t> indices);
+  CoreVuTriangleSoA getTriangles() const;
+
+  std::vector<Node> m_nodes;
+  // 9 streams of m_slot_count floats, see CoreVuTriangleSoA
+  std::vector<float> m_triangle_data;
+  // mesh triangle of every slot, NO_TRIANGLE for the empty ones
+  std::vector<uint32_t> m_slot_triangles;
+  uint32_t m_triangle_count{0};
+  uint32_t m_slot_count{0};
+  uint32_t m_depth{0};
+};
+} // namespace corevu
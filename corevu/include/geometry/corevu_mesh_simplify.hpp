@@ -0,0 +1,44 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corevu
+{
+/*
+Quadric error mesh simplification(Garland/Heckbert) by edge collapses onto
+existing vertices: the result only indexes into the same vertex list, so LODs
+can share one vertex buffer and differ only by their index range.
+
+  float error = 0.f;
+  std::vector<uint32_t> lod =
+      SimplifyMesh(positions, normals, indices, indices.size() / 2, &error);
+
+Vertices with the same position(seams of normals or uvs) are welded and
+collapse together. After a collapse every corner takes the vertex at the new
+position with the closest normal, normals may be empty to take the first one.
+
+Every position carries the quadric of its triangle planes, open borders add
+planes perpendicular to their edges so the silhouette holds. Each pass sorts
+all edges by the cheaper collapse direction and collapses greedily, a vertex
+at most once per pass, until the target is reached or nothing collapses any
+more. Collapses flipping a triangle are rejected, as are those turning one
+away from the input surface it covers(the merged normals of its corners), so
+folds can't build up over many small turns either.
+
+error receives the geometric error of the result, the largest collapse
+distance, in mesh units.
+*/
+std::vector<uint32_t> SimplifyMesh(
+    std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+    std::span<const uint32_t> indices, size_t target_index_count,
+    float* error = nullptr);
+} // namespace corevu
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <jobs/corevu_work_stealing_queue.hpp>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuJobCounter;
+
+/* A job stores its callable inline, no allocation happens per job. */
+struct alignas(64) CoreVuJob
+{
+  static constexpr size_t PAYLOAD_SIZE = 96;
+
+  void (*function)(CoreVuJob& job){nullptr};
+  CoreVuJobCounter* counter{nullptr};
+  CoreVuJob* next{nullptr}; // continuation and main thread job lists
+  // from allocation until the function returned, the slot can't be reused
+  std::atomic<bool> in_use{false};
+  alignas(16) std::byte payload[PAYLOAD_SIZE];
+};
+
+/*
+Counts unfinished jobs. A counter is incremented when a job is started with it
+and decremented once the job has finished, wait() returns when it reached zero.
+Jobs started through runAfter() stay parked on the counter until it reaches
+zero.
+
+The counter must outlive all jobs referencing it, so always wait() on it
+before it goes out of scope.
+*/
+class CoreVuJobCounter
+{
+public:
+  CoreVuJobCounter() = default;
+  CoreVuJobCounter(const CoreVuJobCounter&) = delete;
+  CoreVuJobCounter& operator=(const CoreVuJobCounter&) = delete;
+
+  bool isDone() const
+  {
+    // a finishing job keeps m_finishing raised until it stopped touching
+    // the counter, so a done counter may be destroyed right away
+    return m_value.load(std::memory_order_acquire) == 0 &&
+           m_finishing.load(std::memory_order_acquire) == 0;
+  }
+
+private:
+  friend class CoreVuJobSystem;
+
+  std::atomic<uint32_t> m_value{0};
+  std::atomic<uint32_t> m_finishing{0};
+  std::mutex m_mutex; // guards m_continuations
+  CoreVuJob* m_continuations{nullptr};
+};
+
+/*
+Work stealing job system, the concurrency core of the engine.
+
+The thread creating the job system is the main thread, it takes part in the
+work whenever it waits. thread_count includes the main thread, a job system with
+a thread_count of 1 runs everything on the main thread.
+
+  CoreVuJobCounter counter;
+  job_system.run([&] { loadModel(a); }, &counter);
+  job_system.run([&] { loadModel(b); }, &counter);
+  job_system.runAfter(counter, [&] { buildBvh(); }, &bvh_counter);
+  job_system.wait(bvh_counter); // executes jobs while waiting
+
+  job_system.parallelFor(count, 256, [&](uint32_t begin, uint32_t end) {});
+
+  // jobs touching GLFW or other main thread only APIs
+  job_system.runOnMainThread([&] { glfwSetWindowTitle(...); }, &counter);
+
+Every thread owns a deque and a ring of CoreVuJob. Jobs started by a thread go
+into its own deque, idle threads steal from the others and go to sleep when
+there is nothing to steal. A ring slot is reused once its job has finished, a
+thread starting more than MAX_JOBS_PER_THREAD jobs in flight(or finding its
+deque full) executes pending jobs until a slot frees up, like wait() does. So
+any number of jobs can be started, past the limit the starting thread simply
+helps working them off.
+
+Only the main thread and the workers may start or wait for jobs.
+*/
+class CoreVuJobSystem
+{
+public:
+  static constexpr uint32_t MAX_JOBS_PER_THREAD = 4096;
+
+  explicit CoreVuJobSystem(uint32_t thread_count = DefaultThreadCount());
+  ~CoreVuJobSystem();
+
+  CoreVuJobSystem(const CoreVuJobSystem&) = delete;
+  CoreVuJobSystem& operator=(const CoreVuJobSystem&) = delete;
+
+  static uint32_t DefaultThreadCount()
+  {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  template <typename Fn>
+  void run(Fn&& fn, CoreVuJobCounter* counter = nullptr)
+  {
+    pushJob(createJob(std::forward<Fn>(fn), counter));
+  }
+
+  // fn starts only after dependency reached zero
+  template <typename Fn>
+  void runAfter(
+      CoreVuJobCounter& dependency, Fn&& fn,
+      CoreVuJobCounter* counter = nullptr)
+  {
+    addContinuation(dependency, createJob(std::forward<Fn>(fn), counter));
+  }
+
+  // fn only ever runs on the main thread, inside wait() or
+  // runMainThreadJobs()
+  template <typename Fn>
+  void runOnMainThread(Fn&& fn, CoreVuJobCounter* counter = nullptr)
+  {
+    pushMainThreadJob(createJob(std::forward<Fn>(fn), counter));
+  }
+
+  /* Calls fn(begin, end) for batches of [0, count) in parallel and returns
+   * when all batches are done. The calling thread executes the first batch. */
+  template <typename Fn>
+  void parallelFor(uint32_t count, uint32_t batch_size, Fn&& fn)
+  {
+    if (count == 0) return;
+    batch_size = std::max(batch_size, 1u);
+    if (count <= batch_size || getThreadCount() == 1)
+    {
+      fn(0u, count);
+      return;
+    }
+
+    CoreVuJobCounter counter;
+    for (uint32_t begin = batch_size; begin < count; begin += batch_size)
+    {
+      const uint32_t end = std::min(begin + batch_size, count);
+      run([&fn, begin, end] { fn(begin, end); }, &counter);
+    }
+    fn(0u, batch_size);
+    wait(counter);
+  }
+
+  // executes other jobs until the counter reached zero
+  void wait(const CoreVuJobCounter& counter);
+
+  // executes queued main thread jobs, returns how many ran
+  uint32_t runMainThreadJobs();
+
+  uint32_t getThreadCount() const
+  {
+    return static_cast<uint32_t>(m_threads.size());
+  }
+  bool isMainThread() const;
+  // index of the calling thread in [0, getThreadCount()), 0 is the main thread
+  uint32_t getThreadIndex() const;
+
+private:
+  struct alignas(64) ThreadData
+  {
+    CoreVuWorkStealingQueue queue;
+    std::unique_ptr<CoreVuJob[]> jobs;
+    uint32_t next_job{0};
+    uint32_t random_state{0};
+  };
+
+  template <typename Fn>
+  CoreVuJob* createJob(Fn&& fn, CoreVuJobCounter* counter)
+  {
+    using Function = std::decay_t<Fn>;
+    static_assert(
+        sizeof(Function) <= CoreVuJob::PAYLOAD_SIZE,
+        "Job captures too much, capture a pointer to the data instead");
+    static_assert(alignof(Function) <= 16, "Job callable over aligned");
+
+    CoreVuJob* job = allocateJob();
+    new (job->payload) Function{std::forward<Fn>(fn)};
+    job->function = [](CoreVuJob& self)
+    {
+      auto* function = std::launder(reinterpret_cast<Function*>(self.payload));
+      (*function)();
+      function->~Function();
+    };
+    job->counter = counter;
+    job->next = nullptr;
+    if (counter != nullptr)
+    {
+      counter->m_value.fetch_add(1, std::memory_order_relaxed);
+    }
+    return job;
+  }
+
+  // blocks on a full ring or deque, executing other jobs meanwhile
+  CoreVuJob* allocateJob();
+  void pushJob(CoreVuJob* job);
+  void pushMainThreadJob(CoreVuJob* job);
+  void addContinuation(CoreVuJobCounter& dependency, CoreVuJob* job);
+
+  CoreVuJob* findJob(uint32_t thread_index);
+  void execute(CoreVuJob* job);
+  // runs one main thread or queued job, yields if there is none
+  void helpOnce();
+  void workerLoop(uint32_t thread_index);
+
+  std::vector<std::unique_ptr<ThreadData>> m_threads; // [0] is the main thread
+  std::vector<std::thread> m_workers;
+
+  // sleeping of idle workers
+  std::atomic<int64_t> m_queued_jobs{0};
+  std::atomic<uint32_t> m_sleeping_workers{0};
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake_condition;
+  std::atomic<bool> m_stop{false};
+
+  std::mutex m_main_thread_mutex;
+  CoreVuJob* m_main_thread_jobs{nullptr};      // head
+  CoreVuJob* m_main_thread_jobs_tail{nullptr}; // FIFO order
+};
+} // namespace corevu
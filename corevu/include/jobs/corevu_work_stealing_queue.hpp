@@ -0,0 +1,111 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+
+namespace corevu
+{
+struct CoreVuJob;
+
+/*
+Chase-Lev work stealing deque with a fixed capacity.
+
+          steal()                         push()/pop()
+            |                                  |
+  | ....... |top| job | job | job | job |bottom| ....... |
+
+The owning thread pushes and pops at the bottom(LIFO, hot in cache), other
+threads steal the oldest jobs from the top. Only the owner may call tryPush()
+and pop(), steal() is safe from any thread. tryPush() fails on a full queue,
+the caller has to make room(see CoreVuJobSystem::pushJob).
+
+Memory orders follow "Correct and Efficient Work-Stealing for Weak Memory
+Models"(Le, Pop, Cohen, Zappa Nardelli 2013).
+*/
+class CoreVuWorkStealingQueue
+{
+public:
+  static constexpr int64_t CAPACITY = 4096;
+  static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Power of two expected");
+
+  bool tryPush(CoreVuJob* job)
+  {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_acquire);
+    if (bottom - top >= CAPACITY)
+    {
+      return false;
+    }
+
+    m_jobs[bottom & MASK].store(job, std::memory_order_relaxed);
+    // release: the job is published together with the new bottom
+    m_bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  CoreVuJob* pop()
+  {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) // empty
+    {
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    CoreVuJob* job = m_jobs[bottom & MASK].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+      // last job, race against stealers
+      if (!m_top.compare_exchange_strong(
+              top, top + 1, std::memory_order_seq_cst,
+              std::memory_order_relaxed))
+      {
+        job = nullptr;
+      }
+      m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+  }
+
+  CoreVuJob* steal()
+  {
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+    if (top >= bottom)
+    {
+      return nullptr;
+    }
+
+    CoreVuJob* job = m_jobs[top & MASK].load(std::memory_order_relaxed);
+    if (!m_top.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst,
+            std::memory_order_relaxed))
+    {
+      return nullptr; // lost against another stealer or the owner
+    }
+    return job;
+  }
+
+  size_t size() const
+  {
+    const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    const int64_t top = m_top.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+  }
+
+private:
+  static constexpr int64_t MASK = CAPACITY - 1;
+
+  // top and bottom on separate cache lines, stealers hammer top
+  alignas(64) std::atomic<int64_t> m_top{0};
+  alignas(64) std::atomic<int64_t> m_bottom{0};
+  alignas(64) std::atomic<CoreVuJob*> m_jobs[CAPACITY]{};
+};
+} // namespace corevu
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <ecs/corevu_ecs_types.hpp>
+#include <geometry/corevu_bounds.hpp>
+#include <jobs/corevu_job_system.hpp>
+#include <simd/corevu_box_overlap.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuEventBus;
+
+// two proxies whose boxes overlap, a < b
+struct CoreVuBroadphasePair
+{
+  uint32_t a;
+  uint32_t b;
+};
+
+enum class CoreVuBroadphaseMode : uint8_t
+{
+  SweepAndPrune, // boxes of any size, best when most of them move a little
+  SpatialHash    // boxes of similar size, cost independent of the motion
+};
+
+/*
+Overlapping box pairs of many moving objects, the step before narrowphase.
+
+  const auto proxy = broadphase.createProxy(box, entity);
+  broadphase.moveProxy(proxy, moved_box); // every frame, just stores the box
+  broadphase.findPairs(job_system);
+  for (const auto& pair : broadphase.getPairs())
+  {
+    collide(broadphase.getEntity(pair.a), broadphase.getEntity(pair.b));
+  }
+  broadphase.publishPairs(event_bus); // or hand them to other systems
+  broadphase.destroyProxy(proxy);
+
+Pairs are one compact array, valid until the next findPairs(). The work is
+split into fixed batches whose pairs are appended in batch order, so the
+array is the same for any thread count. Boxes are kept as SoA streams
+indexed by proxy, the candidates of both modes go through OverlapBoxes(simd).
+
+Sweep and prune: the proxies stay sorted by min x from one call to the next,
+each call re-sorts them by insertion sort, which costs about one swap per box
+that passed another one, nearly nothing for coherent motion. Then every box
+only needs testing against the boxes starting before its max x:
+
+  x --> [---a---]
+           [--b--]          a: b, c are candidates(start inside a)
+              [-----c-----] b: c
+                    [-d-]   c: d
+
+The sorted boxes are copied into streams, the candidates of a box are one
+contiguous range of them, found by binary search and tested in parallel.
+
+Spatial hash: every box goes into each grid cell it touches, the cells are
+hashed into a table about the entry count large(counting sort, O(n)), the
+entries of one bucket are tested against each other in parallel over the
+buckets. A pair is reported only by the cell holding the min corner of the
+intersection of the boxes, so pairs sharing several cells come out once,
+entries of other cells hashed into the same bucket are skipped.
+
+  +----+----+        a and b share cells 0 and 1, the intersection starts
+  | a  |a b |        in cell 1, only cell 1 reports the pair
+  |  0 | 1  |
+  +----+----+
+
+The cell size defaults to twice the mean box size, boxes much larger than a
+cell land in many of them, sweep and prune does not care.
+*/
+class CoreVuBroadphase
+{
+public:
+  using ProxyId = uint32_t;
+  static constexpr ProxyId NULL_PROXY = UINT32_MAX;
+
+  struct Stats
+  {
+    CoreVuBroadphaseMode mode{CoreVuBroadphaseMode::SweepAndPrune};
+    uint64_t tests{0};  // candidate boxes tested
+    uint64_t swaps{0};  // insertion sort moves(sweep and prune)
+    uint32_t entries{0}; // box-cell entries(spatial hash)
+    float cell_size{0.f};
+  };
+
+  explicit CoreVuBroadphase(
+      CoreVuBroadphaseMode mode = CoreVuBroadphaseMode::SweepAndPrune);
+
+  ProxyId createProxy(const CoreVuAabb& box, CoreVuEntity entity);
+  void destroyProxy(ProxyId proxy);
+  void moveProxy(ProxyId proxy, const CoreVuAabb& box);
+  void clear();
+
+  void findPairs(CoreVuJobSystem& job_system);
+  const std::vector<CoreVuBroadphasePair>& getPairs() const
+  {
+    return m_pairs;
+  }
+  /* A CollisionEvent per pair of the last findPairs(), in pair order. From
+   * the main thread or a job, CollisionEvent has to be registered. */
+  void publishPairs(CoreVuEventBus& event_bus) const;
+
+  CoreVuEntity getEntity(ProxyId proxy) const
+  {
+    return m_entities[proxy];
+  }
+  CoreVuAabb getAabb(ProxyId proxy) const
+  {
+    return CoreVuAabb{
+        {m_min_x[proxy], m_min_y[proxy], m_min_z[proxy]},
+        {m_max_x[proxy], m_max_y[proxy], m_max_z[proxy]}};
+  }
+  uint32_t getProxyCount() const
+  {
+    return m_proxy_count;
+  }
+
+  void setMode(CoreVuBroadphaseMode mode)
+  {
+    m_mode = mode;
+  }
+  CoreVuBroadphaseMode getMode() const
+  {
+    return m_mode;
+  }
+  // spatial hash cell size, 0 picks one from the boxes every call
+  void setCellSize(float size)
+  {
+    m_cell_size = size;
+  }
+  const Stats& getStats() const
+  {
+    return m_stats;
+  }
+
+private:
+  struct CellEntry
+  {
+    int32_t x;
+    int32_t y;
+    int32_t z;
+    uint32_t proxy;
+  };
+
+  void sweepAndPrune(CoreVuJobSystem& job_system);
+  void spatialHash(CoreVuJobSystem& job_system);
+  void sortOrder();
+  float chooseCellSize() const;
+  // batch_count batches of pairs and tests into m_pairs and the stats
+  void mergePairs(uint32_t batch_count);
+
+  CoreVuBroadphaseMode m_mode;
+  float m_cell_size{0.f};
+  Stats m_stats{};
+
+  // per proxy, destroyed ones hold an empty box
+  std::vector<float> m_min_x;
+  std::vector<float> m_min_y;
+  std::vector<float> m_min_z;
+  std::vector<float> m_max_x;
+  std::vector<float> m_max_y;
+  std::vector<float> m_max_z;
+  std::vector<CoreVuEntity> m_entities;
+  std::vector<uint8_t> m_alive;
+  std::vector<uint8_t> m_in_order; // proxy is in m_order
+  std::vector<ProxyId> m_free;
+  uint32_t m_proxy_count{0};
+  // proxies created or destroyed since the last sort, they move far in it
+  uint32_t m_unsorted{0};
+
+  // sweep and prune, m_order is kept from call to call
+  std::vector<ProxyId> m_order;
+  // candidate boxes in m_order or bucket order, min xyz, max xyz
+  std::vector<float> m_sorted[6];
+
+  // spatial hash
+  std::vector<uint32_t> m_entry_offsets; // per proxy, prefix of cell counts
+  std::vector<CellEntry> m_entries;
+  std::vector<uint32_t> m_entry_buckets;
+  std::vector<CellEntry> m_bucket_entries; // entries sorted by bucket
+  std::vector<uint32_t> m_buckets; // bucket b is [m_buckets[b], [b + 1])
+
+  // per batch of the pair pass
+  std::vector<std::vector<CoreVuBroadphasePair>> m_batch_pairs;
+  std::vector<uint64_t> m_batch_tests;
+  std::vector<CoreVuBroadphasePair> m_pairs;
+};
+} // namespace corevu
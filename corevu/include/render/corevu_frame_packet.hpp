@@ -0,0 +1,109 @@
+#pragma once
+
+#include <corevu_frame_info.hpp>
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuModel;
+class CoreVuTexture;
+
+// the frame packet as a scheduler resource, extracting systems write it
+struct FramePacketResource
+{
+};
+
+// draws in recording order, one stream per field
+struct CoreVuDrawList
+{
+  std::vector<glm::mat4> model_matrices;
+  std::vector<glm::mat3> normal_matrices;
+  std::vector<CoreVuModel*> models;
+  std::vector<CoreVuTexture*> textures; // nullptr for untextured draws
+  std::vector<uint32_t> lods;
+
+  void push(
+      const glm::mat4& model_matrix, const glm::mat3& normal_matrix,
+      CoreVuModel* model, CoreVuTexture* texture, uint32_t lod)
+  {
+    model_matrices.push_back(model_matrix);
+    normal_matrices.push_back(normal_matrix);
+    models.push_back(model);
+    textures.push_back(texture);
+    lods.push_back(lod);
+  }
+  void clear()
+  {
+    model_matrices.clear();
+    normal_matrices.clear();
+    models.clear();
+    textures.clear();
+    lods.clear();
+  }
+  size_t size() const
+  {
+    return models.size();
+  }
+};
+
+// point light billboards in recording order
+struct CoreVuLightList
+{
+  std::vector<glm::vec4> positions;
+  std::vector<glm::vec4> colors; // w is intensity
+  std::vector<float> ranges;
+
+  void push(const glm::vec4& position, const glm::vec4& color, float range)
+  {
+    positions.push_back(position);
+    colors.push_back(color);
+    ranges.push_back(range);
+  }
+  void clear()
+  {
+    positions.clear();
+    colors.clear();
+    ranges.clear();
+  }
+  size_t size() const
+  {
+    return positions.size();
+  }
+};
+
+/*
+Everything recording a frame needs, copied out of the world by the systems of
+the frame. Once submitted to CoreVuRenderThread it is read only and the world
+can move on to the next frame.
+
+  main thread   | frame N: systems, extract -> packet A | frame N+1 -> B | ..
+  render thread |          ...            | record A  | record B | ..
+
+Models and textures are referenced, not copied: like for any GPU resource in
+use they must outlive the frames in flight. The lists keep their capacity
+over clear(), a steady frame does not allocate.
+*/
+struct CoreVuFramePacket
+{
+  uint64_t frame{0};
+  float frame_time{0.f};
+  GlobalUbo ubo{}; // camera matrices and lights
+  CoreVuDrawList textured;
+  CoreVuDrawList meshes;
+  CoreVuLightList lights;
+
+  void clear()
+  {
+    textured.clear();
+    meshes.clear();
+    lights.clear();
+  }
+};
+} // namespace corevu
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <jobs/corevu_job_system.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corevu
+{
+// order of the passes in a queue, opaque draws first
+enum class CoreVuDrawPass : uint8_t
+{
+  Opaque = 0,
+  Transparent = 1
+};
+
+// one draw: its sort key and whatever the submitting system needs back
+struct CoreVuRenderItem
+{
+  uint64_t key;
+  uint32_t payload;
+};
+
+/*
+Sort keys of draws, sorting them sorts the draws in submission order. The
+pass is always on top, below it the opaque and transparent layouts differ:
+
+  bit 63   60        52        36        20   16        0
+  opaque  | pass | pipeline | material | mesh | lod | depth   |  front to back
+          |  4   |    8     |    16    |  16  |  4  |   16    |  inside a state
+
+  bit 63   60             36         28         16     4     0
+  transp. | pass |  depth(inv)  | pipeline | material | mesh | lod |
+          |  4   |      24      |    8     |    12    |  12  |  4  |
+
+Opaque draws are grouped by the most expensive state change first, depth
+only orders draws sharing all state(early z). Transparent ones have to come
+back to front, depth goes on top and is inverted, state only breaks ties.
+
+Depth is the distance to the camera as the bits of the float: the bits of a
+positive float grow with it, the top 16/24 of them(exponent and the upper
+mantissa) quantize it relative to its magnitude, no depth range needed. Fields
+are truncated to their width, ids from HashDrawResource spread resources over
+them, two resources colliding only cost extra binds.
+*/
+uint64_t MakeOpaqueDrawKey(
+    uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod,
+    float depth);
+uint64_t MakeTransparentDrawKey(
+    uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod,
+    float depth);
+inline CoreVuDrawPass GetDrawPass(uint64_t key)
+{
+  return static_cast<CoreVuDrawPass>(key >> 60);
+}
+// id of a mesh/texture/pipeline object for the key fields, from its address
+uint32_t HashDrawResource(const void* resource);
+
+/*
+Draws of a frame, sorted by key with a parallel LSD radix sort.
+
+  queue.clear();
+  for (...) queue.push(MakeOpaqueDrawKey(...), draw_index);
+  queue.sort(frame_info.job_system);
+  for (const CoreVuRenderItem& item : queue.getItems()) record(item.payload);
+
+The sort is stable, draws with equal keys stay in push order. It runs
+RADIX_BITS per pass from the lowest digit up, passes whose digit is the same
+for all keys(unused fields, one pipeline) are skipped, one counting pass
+finds them. Each pass splits the items into blocks: block histograms in
+parallel, their prefix sums, then every block scatters its items in
+parallel.
+
+  items -> | block 0 | block 1 | ... |  histogram per block
+           digit 0: b0 b1 ..  digit 1: b0 b1 ..   offsets, block order kept
+
+Nothing is allocated once the queue saw its largest frame, items, scratch
+and histograms keep their capacity over clear().
+*/
+class CoreVuRenderQueue
+{
+public:
+  static constexpr uint32_t RADIX_BITS = 8;
+  static constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+  static constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+  // items a block has at least, smaller queues sort on one thread
+  static constexpr uint32_t MIN_BLOCK_SIZE = 4096;
+
+  void clear()
+  {
+    m_items.clear();
+  }
+  void reserve(size_t count)
+  {
+    m_items.reserve(count);
+  }
+  void push(uint64_t key, uint32_t payload)
+  {
+    m_items.push_back(CoreVuRenderItem{key, payload});
+  }
+
+  void sort(CoreVuJobSystem& job_system);
+
+  std::span<const CoreVuRenderItem> getItems() const
+  {
+    return m_items;
+  }
+  size_t size() const
+  {
+    return m_items.size();
+  }
+  // radix passes the last sort ran, the others were skipped
+  uint32_t getSortedPasses() const
+  {
+    return m_sorted_passes;
+  }
+
+private:
+  std::vector<CoreVuRenderItem> m_items;
+  std::vector<CoreVuRenderItem> m_scratch;
+  // block_count * RADIX_SIZE, block major
+  std::vector<uint32_t> m_histograms;
+  // all digits of all passes, RADIX_PASSES * RADIX_SIZE per block
+  std::vector<uint32_t> m_digit_counts;
+  uint32_t m_sorted_passes{0};
+};
+} // namespace corevu
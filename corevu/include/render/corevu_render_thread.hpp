@@ -0,0 +1,101 @@
+#pragma once
+
+#include <render/corevu_frame_packet.hpp>
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace corevu
+{
+/*
+Records frames on a thread of its own while the main thread builds the next
+one. Frames are handed over as CoreVuFramePacket through a bounded ring:
+
+  auto& packet = render_thread.beginPacket(); // blocks while the ring is full
+  packet.clear();
+  extract(world, packet);
+  render_thread.submitPacket();               // record(packet) runs later
+  ...
+  render_thread.flush(); // before destroying anything the packets reference
+
+  ring of 2:   [ A: recorded ] [ B: written by main ]   one frame apart
+               released after record(A) returned, reused for frame N+2
+
+With the default of 2 packets the main thread runs at most one frame ahead,
+the frame time is the longer of the two stages instead of their sum. The
+record function owns everything per frame in flight(command buffers, frame
+descriptor pools, uniform buffers), it picks them by the swap chain frame
+index, which only the render thread knows. The GPU side is bounded by
+MAX_FRAMES_IN_FLIGHT on top of that, the fences of the swap chain block the
+render thread, a full ring then blocks the main thread.
+
+A threaded render thread calls record only from its own thread, it must not
+touch the world or the job system. Exceptions thrown by record stop the
+thread and are rethrown by every later call on the main thread. Not threaded,
+submitPacket() records right away, the serial loop for comparison.
+*/
+class CoreVuRenderThread
+{
+public:
+  static constexpr uint32_t DEFAULT_PACKET_COUNT = 2;
+  using RecordFunction = std::function<void(const CoreVuFramePacket&)>;
+
+  // times are summed up over all frames, read them after flush()
+  struct Stats
+  {
+    uint64_t frames{0};
+    double record_ms{0.0}; // inside record
+    double stall_ms{0.0};  // main thread waiting for a free packet
+    double idle_ms{0.0};   // render thread waiting for a packet
+  };
+
+  explicit CoreVuRenderThread(
+      RecordFunction record, bool threaded = true,
+      uint32_t packet_count = DEFAULT_PACKET_COUNT);
+  ~CoreVuRenderThread();
+  CoreVuRenderThread(const CoreVuRenderThread&) = delete;
+  CoreVuRenderThread& operator=(const CoreVuRenderThread&) = delete;
+
+  CoreVuFramePacket& beginPacket();
+  void submitPacket();
+  // until all submitted packets are recorded
+  void flush();
+
+  bool isThreaded() const
+  {
+    return m_thread.joinable();
+  }
+  const Stats& getStats() const
+  {
+    return m_stats;
+  }
+
+private:
+  void threadMain();
+  void record(const CoreVuFramePacket& packet);
+  // under m_mutex
+  void rethrowError();
+
+  RecordFunction m_record;
+  std::vector<CoreVuFramePacket> m_packets;
+  uint64_t m_frame{0};
+
+  std::mutex m_mutex;
+  std::condition_variable m_submitted; // render thread waits
+  std::condition_variable m_released;  // main thread waits
+  uint32_t m_read_index{0};
+  uint32_t m_pending{0}; // submitted, not yet released
+  bool m_writing{false};
+  bool m_stop{false};
+  std::exception_ptr m_error{};
+
+  Stats m_stats{};
+  std::thread m_thread;
+};
+} // namespace corevu
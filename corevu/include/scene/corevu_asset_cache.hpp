@@ -0,0 +1,55 @@
+#pragma once
+
+#include "corevu_device.hpp"
+#include "corevu_model.hpp"
+#include "corevu_texture.hpp"
+
+// std
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace corevu
+{
+/*
+Loads every model/texture once and remembers the path it came from.
+
+  CoreVuAssetCache assets{device};
+  auto vase = assets.getModel("assets/models/smooth_vase.obj");
+  assets.getModel("assets/models/smooth_vase.obj"); // same model, no parsing
+
+Scenes reference assets by path, the scene writer asks the cache for the path
+of a model(getPath) and the loader resolves the paths through it again.
+Assets stay alive as long as the cache does.
+
+Given a job system every model keeps a CoreVuMeshBvh built on it while
+loading, for ray casts and picking(SpatialIndexSystem::raycast).
+*/
+class CoreVuAssetCache
+{
+public:
+  explicit CoreVuAssetCache(
+      CoreVuDevice& device, CoreVuJobSystem* bvh_job_system = nullptr)
+    : m_device{device}, m_bvh_job_system{bvh_job_system}
+  {
+  }
+
+  CoreVuAssetCache(const CoreVuAssetCache&) = delete;
+  CoreVuAssetCache& operator=(const CoreVuAssetCache&) = delete;
+
+  std::shared_ptr<CoreVuModel> getModel(const std::string& path);
+  std::shared_ptr<CoreVuTexture> getTexture(const std::string& path);
+
+  // path the asset was loaded from, nullptr if it didn't come from the cache
+  const std::string* getPath(const CoreVuModel* model) const;
+  const std::string* getPath(const CoreVuTexture* texture) const;
+
+private:
+  CoreVuDevice& m_device;
+  CoreVuJobSystem* m_bvh_job_system;
+
+  std::unordered_map<std::string, std::shared_ptr<CoreVuModel>> m_models;
+  std::unordered_map<std::string, std::shared_ptr<CoreVuTexture>> m_textures;
+  std::unordered_map<const void*, std::string> m_paths;
+};
+} // namespace corevu
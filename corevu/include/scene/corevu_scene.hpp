@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ecs/corevu_world.hpp"
+
+// std
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuAssetCache;
+class TransformSystem;
+
+/*
+Saves all entities of a world into a binary scene file and loads it back, see
+scene/corevu_scene_format.hpp for the layout.
+
+  CoreVuScene::Save(world, "level.cvscene", &assets);
+  ...
+  auto entities =
+      CoreVuScene::Load("level.cvscene", world, transform_system, &assets);
+
+Nothing is parsed on load: the file is memory mapped, every stored archetype
+is created with all its entities at once(CoreVuWorld::createEntities) and the
+columns are copied chunk by chunk straight from the mapping. Only transforms
+and asset references are converted row by row.
+
+Components are stored by a stable name, the built in ones:
+  "transform"      TRS + parent, the hierarchy is relinked through
+                   transform_system
+  "point_light"    raw column
+  "rigid_body_2d"  raw column
+  "static"         raw column(tag)
+  "model"          index into the asset table(path from the asset cache)
+  "texture"        index into the asset table
+
+Other trivially copyable components can be added with RegisterComponent<T>().
+Components without a name are not saved, neither are archetypes with none of
+the named components. Unknown names in a file are skipped on load.
+
+assets may be nullptr for scenes without model/texture components.
+*/
+class CoreVuScene
+{
+public:
+  /* Stores T as raw column, its layout becomes part of the file format:
+   * changing T requires a new name. Has to be called before Save/Load. */
+  template <typename T>
+  static void RegisterComponent(const char* name)
+  {
+    static_assert(
+        std::is_trivially_copyable_v<T>,
+        "Scene components stored as raw column must be trivially copyable.");
+    registerRawComponent(
+        name, CoreVuComponentRegistry::GetId<T>(),
+        static_cast<uint32_t>(sizeof(T)));
+  }
+
+  static void Save(
+      const CoreVuWorld& world, const std::string& path,
+      const CoreVuAssetCache* assets);
+
+  // returns the created entities in file order
+  static std::vector<CoreVuEntity> Load(
+      const std::string& path, CoreVuWorld& world,
+      TransformSystem& transform_system, CoreVuAssetCache* assets);
+
+private:
+  static void registerRawComponent(
+      const char* name, ComponentTypeId id, uint32_t size);
+};
+} // namespace corevu
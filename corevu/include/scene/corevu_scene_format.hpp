@@ -0,0 +1,99 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+namespace corevu
+{
+/*
+Binary scene file(.cvscene), little endian, every section 64 byte aligned so
+columns can be read straight out of the mapped file.
+
+|Header|archetype entries|column entries|columns...|asset entries|asset paths|
+
+  Header          magic, version, counts and section offsets
+  ArchetypeEntry  one per stored archetype: entity count and its columns
+  ColumnEntry     stable component name, stored row size, offset of the data
+  column data     entity_count rows of stored_size bytes, in ECS row order
+  AssetEntry      type(model/texture) + path, components refer to assets by
+                  index into this table
+
+Entities have no table of their own: file entity ids are assigned in archetype
+order(first archetype rows 0..n, next one continues), references between
+entities(transform parents) use these ids.
+
+Columns of trivially copyable components are stored exactly as in the ECS
+chunk, they are loaded with one memcpy per chunk. Components with pointers or
+caches(transforms, asset references) have a file specific row layout.
+*/
+namespace scene_format
+{
+constexpr uint32_t MAGIC = 0x43535643; // "CVSC"
+// bumped on incompatible changes, the loader refuses other versions
+constexpr uint32_t VERSION = 1;
+constexpr uint64_t SECTION_ALIGNMENT = 64;
+constexpr uint32_t NULL_INDEX = ~uint32_t{0};
+constexpr uint32_t MAX_NAME_LENGTH = 32;
+
+enum class AssetType : uint32_t
+{
+  Model = 0,
+  Texture = 1,
+};
+
+struct Header
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t file_size;
+  uint64_t entity_count;
+  uint32_t asset_count;
+  uint32_t archetype_count;
+  uint64_t archetypes_offset; // ArchetypeEntry[archetype_count]
+  uint64_t assets_offset;     // AssetEntry[asset_count]
+};
+
+struct AssetEntry
+{
+  AssetType type;
+  uint32_t path_length;
+  uint64_t path_offset; // not null terminated
+};
+
+struct ArchetypeEntry
+{
+  uint32_t entity_count;
+  uint32_t column_count;
+  uint64_t columns_offset; // ColumnEntry[column_count]
+};
+
+struct ColumnEntry
+{
+  char name[MAX_NAME_LENGTH]; // null terminated
+  uint32_t stored_size;       // bytes per row
+  uint32_t reserved;
+  uint64_t data_offset;
+};
+
+// row of the "transform" column
+struct TransformRow
+{
+  float translation[3];
+  float rotation[3];
+  float scale[3];
+  uint32_t parent; // file entity id or NULL_INDEX
+};
+
+// row of the "model" and "texture" columns
+struct AssetRow
+{
+  uint32_t asset; // index into the asset table or NULL_INDEX
+};
+
+static_assert(sizeof(Header) == 48);
+static_assert(sizeof(AssetEntry) == 16);
+static_assert(sizeof(ArchetypeEntry) == 16);
+static_assert(sizeof(ColumnEntry) == 48);
+static_assert(sizeof(TransformRow) == 40);
+} // namespace scene_format
+} // namespace corevu
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "corevu_device.hpp"
+#include "corevu_model.hpp"
+#include "ecs/corevu_world.hpp"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corevu
+{
+class CoreVuAssetCache;
+class CoreVuJobSystem;
+class CoreVuTexture;
+
+struct CoreVuStaticBatchStats
+{
+  uint32_t objects{0}; // static meshes merged into batches
+  uint32_t batches{0};
+  uint32_t skipped{0}; // static meshes left as they are
+  uint64_t vertices{0};
+  uint64_t triangles{0};
+};
+
+// one static mesh as CoreVuStaticBatcher::Merge() sees it
+struct CoreVuStaticBatchMesh
+{
+  // model space vertices, indices and bounding sphere
+  const CoreVuModel::Builder* source;
+  glm::mat4 world_matrix;
+  bool textured;
+  const CoreVuTexture* texture;
+};
+
+struct CoreVuStaticBatch
+{
+  // world space, bounds computed, no LODs or BVH yet
+  CoreVuModel::Builder builder;
+  // the merged meshes, indices into the meshes given to Merge(), in order
+  std::vector<uint32_t> meshes;
+};
+
+/*
+Opt-in batching of static geometry at scene build time. Every draw of a small
+prop costs a push constant, a Bind and a Draw, no matter how few triangles it
+has. Entities with a StaticComponent, a TransformComponent and a
+ModelComponent are merged instead: their vertices are transformed into world
+space once and copied into shared vertex/index buffers, one CoreVuModel per
+batch.
+
+  CoreVuStaticBatcher batcher{device, assets, &job_system};
+  const CoreVuStaticBatchStats stats = batcher.build(world);
+
+Meshes are grouped by what the render systems switch between, the pipeline
+(textured or not) and the texture, and by a grid cell of their world bounding
+sphere, so culling still drops the batches far away:
+
+  cell (0, 0)          cell (1, 0)
+  | vase cube vase |   | rock rock |    untextured
+  | crate crate    |                   texture "wood"
+   -> 3 batches, each with its world bounds and an identity transform
+
+Every batch becomes an entity of its own with TransformComponent,
+ModelComponent and the TextureComponent of its group. Its LODs are generated
+on the merged mesh and, if any of the merged models had a BVH, it gets one as
+well, so culling and picking work as for any other model(picking returns the
+batch entity). The merged entities only lose their ModelComponent and
+TextureComponent, transforms, hierarchy and occluders stay.
+
+The source vertices are read back from the model files through the asset
+cache, models without a path(procedural ones) are skipped, as are groups of
+a single mesh: there is no draw to save. Batches have no path either, so a
+scene has to be saved before it is batched.
+*/
+class CoreVuStaticBatcher
+{
+public:
+  static constexpr float DEFAULT_CELL_SIZE = 16.f;
+  // a full group is split into batches of at most that many vertices
+  static constexpr uint32_t MAX_BATCH_VERTICES = 1u << 20;
+
+  // job_system may be null
+  CoreVuStaticBatcher(
+      CoreVuDevice& device, CoreVuAssetCache& assets,
+      CoreVuJobSystem* job_system = nullptr)
+    : m_device{device}, m_assets{assets}, m_job_system{job_system}
+  {
+  }
+
+  CoreVuStaticBatcher(const CoreVuStaticBatcher&) = delete;
+  CoreVuStaticBatcher& operator=(const CoreVuStaticBatcher&) = delete;
+
+  // world units, larger cells give fewer batches and coarser culling
+  void setCellSize(float cell_size)
+  {
+    m_cell_size = cell_size;
+  }
+
+  CoreVuStaticBatchStats build(CoreVuWorld& world);
+
+  /* The CPU part of build(), no device needed: groups the meshes, splits the
+   * groups at MAX_BATCH_VERTICES and merges every batch of 2 or more meshes.
+   * Meshes that are in no batch are left out. job_system may be null. */
+  static std::vector<CoreVuStaticBatch> Merge(
+      std::span<const CoreVuStaticBatchMesh> meshes, float cell_size,
+      CoreVuJobSystem* job_system = nullptr);
+
+private:
+  CoreVuDevice& m_device;
+  CoreVuAssetCache& m_assets;
+  CoreVuJobSystem* m_job_system;
+  float m_cell_size{DEFAULT_CELL_SIZE};
+};
+} // namespace corevu
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <geometry/corevu_bounds.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace corevu
+{
+/* Axis aligned boxes of N objects, one float stream per component. */
+struct CoreVuBoxSoA
+{
+  const float* min_x;
+  const float* min_y;
+  const float* min_z;
+  const float* max_x;
+  const float* max_y;
+  const float* max_z;
+};
+
+/*
+Overlap test of one box against the boxes [begin, end) of boxes, writes the
+indices of the overlapping ones to hits(room for end - begin) and returns how
+many.
+
+  const size_t hit_count = OverlapBoxes(box, boxes, first, last, hits);
+
+Same rule as Intersects(CoreVuAabb, CoreVuAabb), touching boxes overlap. The
+box is broadcast once, W boxes are tested per step(AVX2: 8), all 6 compares
+of a lane are anded into one mask and compacted into hits like CullSpheres
+does, indices keep their order. Below AVX2 the scalar loop runs.
+*/
+size_t OverlapBoxes(
+    const CoreVuAabb& box, const CoreVuBoxSoA& boxes, uint32_t begin,
+    uint32_t end, uint32_t* hits);
+} // namespace corevu
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <geometry/corevu_bounds.hpp>
+#include <simd/corevu_transform_batch.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace corevu
+{
+/* Bounding spheres of N objects, one float stream per component. */
+struct CoreVuSphereSoA
+{
+  const float* center_x;
+  const float* center_y;
+  const float* center_z;
+  const float* radius;
+};
+
+/*
+Frustum test of many bounding spheres at once, writes the indices of the ones
+intersecting the frustum to visible(room for count) and returns how many.
+
+  CoreVuSphereSoA spheres{xs, ys, zs, radii};
+  const size_t visible_count =
+      CullSpheres(camera.getFrustum(), spheres, count, visible);
+
+Every plane is broadcast once, then W spheres are tested per step(4 SSE4.2,
+8 AVX2, 16 AVX-512), each lane is one sphere:
+
+  center_x | x0 x1 x2 x3 |   dot(normal, center) + d >= -radius
+  center_y | y0 y1 y2 y3 |   for all 6 planes -> lane mask 1 0 1 1
+  ...                                          -> visible 0 2 3
+
+The mask is compacted into the index list without branches(AVX-512 stores it
+compressed), indices keep their order. Same level selection as
+ComputeTransformMatrices(GetSimdLevel()), the rest goes through the scalar
+path. Spheres are conservative: a visible one might still be outside near the
+frustum corners, a culled one is never visible.
+*/
+size_t CullSpheres(
+    const CoreVuFrustum& frustum, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible);
+} // namespace corevu
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <geometry/corevu_bounds.hpp>
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace corevu
+{
+/* Triangles as a corner and the two edges leaving it, one float stream per
+ * component. Streams are laid out in groups of GROUP_SIZE, unused slots of a
+ * group hold degenerate triangles(all zero) that nothing hits. */
+struct CoreVuTriangleSoA
+{
+  static constexpr uint32_t GROUP_SIZE = 8;
+
+  const float* v0_x;
+  const float* v0_y;
+  const float* v0_z;
+  const float* e1_x; // v1 - v0
+  const float* e1_y;
+  const float* e1_z;
+  const float* e2_x; // v2 - v0
+  const float* e2_y;
+  const float* e2_z;
+};
+
+struct CoreVuTriangleHit
+{
+  static constexpr uint32_t NO_TRIANGLE = UINT32_MAX;
+
+  uint32_t triangle{NO_TRIANGLE}; // slot in the CoreVuTriangleSoA
+  float distance{0.f};            // along the ray, in direction units
+  float u{0.f};                   // barycentric weights of v1 and v2
+  float v{0.f};
+
+  bool isHit() const
+  {
+    return triangle != NO_TRIANGLE;
+  }
+};
+
+/* SIZE rays traversing together, one float array per component. Lanes that
+ * are not set stay out of every active mask. */
+struct CoreVuRayPacket
+{
+  static constexpr uint32_t SIZE = 8;
+  static constexpr uint32_t ALL_ACTIVE = (1u << SIZE) - 1;
+
+  alignas(32) float origin_x[SIZE]{};
+  alignas(32) float origin_y[SIZE]{};
+  alignas(32) float origin_z[SIZE]{};
+  alignas(32) float direction_x[SIZE]{};
+  alignas(32) float direction_y[SIZE]{};
+  alignas(32) float direction_z[SIZE]{};
+  alignas(32) float inverse_x[SIZE]{};
+  alignas(32) float inverse_y[SIZE]{};
+  alignas(32) float inverse_z[SIZE]{};
+  // shrinks to the closest hit while the packet traverses
+  alignas(32) float max_distance[SIZE]{};
+
+  void set(uint32_t lane, const CoreVuRay& ray)
+  {
+    origin_x[lane] = ray.origin.x;
+    origin_y[lane] = ray.origin.y;
+    origin_z[lane] = ray.origin.z;
+    direction_x[lane] = ray.direction.x;
+    direction_y[lane] = ray.direction.y;
+    direction_z[lane] = ray.direction.z;
+    inverse_x[lane] = SafeInverse(ray.direction.x);
+    inverse_y[lane] = SafeInverse(ray.direction.y);
+    inverse_z[lane] = SafeInverse(ray.direction.z);
+    max_distance[lane] = ray.max_distance;
+  }
+  /* Large instead of infinite for zero components: a ray in the plane of a
+   * box side gives 0 * large, not the NaN of 0 * inf that the SIMD min/max
+   * would turn into a miss. */
+  static float SafeInverse(float value)
+  {
+    constexpr float TINY = 1e-20f;
+    return 1.f / (value >= 0.f ? std::max(value, TINY)
+                               : std::min(value, -TINY));
+  }
+  CoreVuRay get(uint32_t lane) const
+  {
+    return CoreVuRay{
+        {origin_x[lane], origin_y[lane], origin_z[lane]},
+        {direction_x[lane], direction_y[lane], direction_z[lane]},
+        max_distance[lane]};
+  }
+};
+
+/*
+Ray tests of the mesh BVH(CoreVuMeshBvh), two ways to fill the lanes:
+
+  one ray, many triangles          many rays, one box or triangle
+  v0_x | t0 t1 .. t7 |             origin_x | r0 r1 .. r7 |
+  v0_y | t0 t1 .. t7 |  ray        origin_y | r0 r1 .. r7 |  box/triangle
+  ...                   broadcast  ...                       broadcast
+
+IntersectTriangles tests one ray against whole groups of a CoreVuTriangleSoA,
+[begin, end) must be group aligned. The packet versions test the active lanes
+of a CoreVuRayPacket against one box, or one after the other against the
+triangles [begin, end). Triangles are two sided(Moeller-Trumbore), boxes use
+the slab test of IntersectRay(). Same level selection as CullSpheres, AVX2
+does 8 lanes per step, below it the scalar loops run.
+*/
+
+/* Closest triangle of [begin, end) nearer than hit.distance(set it to the ray
+ * max_distance first), replaces hit and returns true if there is one. */
+bool IntersectTriangles(
+    const CoreVuRay& ray, const CoreVuTriangleSoA& triangles, uint32_t begin,
+    uint32_t end, CoreVuTriangleHit& hit);
+
+// lanes of active whose ray enters box before its max_distance
+uint32_t IntersectPacketBox(
+    const CoreVuRayPacket& packet, uint32_t active, const CoreVuAabb& box);
+
+/* Closer hits of the active lanes replace hits[lane] and shrink the packet
+ * max_distance. Returns the lanes that hit anything. */
+uint32_t IntersectPacketTriangles(
+    CoreVuRayPacket& packet, uint32_t active,
+    const CoreVuTriangleSoA& triangles, uint32_t begin, uint32_t end,
+    CoreVuTriangleHit* hits);
+} // namespace corevu
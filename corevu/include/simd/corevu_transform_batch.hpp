@@ -0,0 +1,70 @@
+#pragma once
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace corevu
+{
+enum class CoreVuSimdLevel : uint8_t
+{
+  Scalar,
+  SSE42,
+  AVX2,
+  AVX512
+};
+
+const char* ToString(CoreVuSimdLevel level);
+
+/* Translation, rotation(Tait-Bryan YXZ like TransformComponent) and scale of N
+ * objects, one float stream per component. */
+struct CoreVuTransformSoA
+{
+  const float* translation_x;
+  const float* translation_y;
+  const float* translation_z;
+  const float* rotation_x;
+  const float* rotation_y;
+  const float* rotation_z;
+  const float* scale_x;
+  const float* scale_y;
+  const float* scale_z;
+};
+
+/*
+Batch version of TransformComponent::ToMat4() and the normal matrix.
+
+  CoreVuTransformSoA soa{tx, ty, tz, rx, ry, rz, sx, sy, sz};
+  ComputeTransformMatrices(soa, count, model_matrices, normal_matrices);
+
+Takes W objects per step(4 SSE4.2, 8 AVX2, 16 AVX-512), each lane of a register
+is one object:
+
+  rotation_y | y0 y1 y2 y3 | -> sin/cos -> 12 model + 9 normal entries
+  rotation_x | x0 x1 x2 x3 |               per register, written out as
+  ...                                      mat4/mat3 of 4 objects
+
+The instruction set is picked once at startup from what the cpu supports, the
+rest of a batch that doesn't fill a register goes through the scalar path. The
+vector paths use their own sin/cos polynomial, results are within a few ulp of
+the scalar ones(glm::sin/glm::cos).
+
+normal_matrices can be nullptr if only the model matrices are needed. The
+normal matrix is the analytic inverse transpose of the upper 3x3 of the model:
+rotation columns divided by their scale.
+*/
+void ComputeTransformMatrices(
+    const CoreVuTransformSoA& transforms, size_t count,
+    glm::mat4* model_matrices, glm::mat3* normal_matrices);
+
+// best level the cpu and the os support
+CoreVuSimdLevel GetSupportedSimdLevel();
+
+// level used by ComputeTransformMatrices and CullSpheres, forcing one is meant
+// for benchmarks and is clamped to the supported level
+CoreVuSimdLevel GetSimdLevel();
+void SetSimdLevel(CoreVuSimdLevel level);
+} // namespace corevu
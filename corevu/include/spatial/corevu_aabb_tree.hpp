@@ -0,0 +1,309 @@
+#pragma once
+
+#include <ecs/corevu_ecs_types.hpp>
+#include <geometry/corevu_bounds.hpp>
+#include <jobs/corevu_job_system.hpp>
+
+// std
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace corevu
+{
+struct CoreVuRayHit
+{
+  CoreVuEntity entity{NULL_ENTITY};
+  float distance{0.f}; // along the ray, in direction units
+};
+
+/*
+Dynamic bounding volume hierarchy over entity AABBs, updated incrementally
+instead of being rebuilt every frame.
+
+  const auto proxy = tree.createProxy(box, entity);
+  tree.moveProxy(proxy, moved_box); // cheap while it stays in its fat box
+  tree.queryFrustum(frustum, [&](CoreVuEntity e) { visible.push_back(e); });
+  tree.destroyProxy(proxy);
+
+Leaves keep the exact box of their entity and a fat box grown by a margin
+relative to its size. Internal nodes bound the fat boxes of their children:
+
+             [root]
+            /      \
+        [n1]        [n2]         internal: union of the children
+       /    \      /    \
+     (a)    (b)  (c)    (d)      leaves: fat box, exact box, entity
+
+Moving an entity only touches the tree when its new box leaves the fat one,
+the leaf is then removed and inserted again. Insertion walks down to the
+sibling with the lowest surface area cost, the walk back up refits the boxes
+and applies AVL rotations, so the height stays logarithmic whatever order
+entities arrive in. Queries descend only into nodes overlapping the query,
+O(log n + hits) for local queries.
+
+Queries report leaves whose exact box overlaps. They only read the tree, any
+number of them can run in parallel while nothing modifies it, the batch
+versions do exactly that on the job system.
+*/
+class CoreVuAabbTree
+{
+public:
+  using ProxyId = int32_t;
+  static constexpr ProxyId NULL_PROXY = -1;
+
+  // fat boxes grow by this part of their size on every side
+  static constexpr float FAT_MARGIN_RATIO = 0.1f;
+  static constexpr float MIN_FAT_MARGIN = 0.01f;
+
+  CoreVuAabbTree() = default;
+
+  ProxyId createProxy(const CoreVuAabb& box, CoreVuEntity entity);
+  void destroyProxy(ProxyId proxy);
+  // returns true if the leaf was reinserted
+  bool moveProxy(ProxyId proxy, const CoreVuAabb& box);
+  void clear();
+
+  CoreVuEntity getEntity(ProxyId proxy) const
+  {
+    return m_nodes[proxy].entity;
+  }
+  const CoreVuAabb& getAabb(ProxyId proxy) const
+  {
+    return m_nodes[proxy].box;
+  }
+  const CoreVuAabb& getFatAabb(ProxyId proxy) const
+  {
+    return m_nodes[proxy].fat_box;
+  }
+
+  uint32_t getProxyCount() const
+  {
+    return m_proxy_count;
+  }
+  int32_t getHeight() const
+  {
+    return m_root == NULL_PROXY ? 0 : m_nodes[m_root].height;
+  }
+  // checks links, heights and boxes of the whole tree, for tests and asserts
+  bool validate() const;
+
+  // fn(entity) per leaf overlapping box
+  template <typename Fn>
+  void queryAabb(const CoreVuAabb& box, Fn&& fn) const
+  {
+    traverse(
+        [&](const CoreVuAabb& node) { return Intersects(node, box); },
+        [&](const Node& leaf)
+        {
+          if (Intersects(leaf.box, box)) fn(leaf.entity);
+        });
+  }
+
+  template <typename Fn>
+  void querySphere(const CoreVuSphere& sphere, Fn&& fn) const
+  {
+    traverse(
+        [&](const CoreVuAabb& node) { return Intersects(node, sphere); },
+        [&](const Node& leaf)
+        {
+          if (Intersects(leaf.box, sphere)) fn(leaf.entity);
+        });
+  }
+
+  /* Subtrees fully inside the frustum are reported without further tests,
+   * planes a node is inside of are skipped for its children. */
+  template <typename Fn>
+  void queryFrustum(const CoreVuFrustum& frustum, Fn&& fn) const
+  {
+    if (m_root == NULL_PROXY) return;
+
+    struct Entry
+    {
+      ProxyId node;
+      uint32_t plane_mask;
+    };
+    std::array<Entry, MAX_STACK_SIZE> stack;
+    size_t size = 0;
+    stack[size++] = Entry{m_root, (1u << CoreVuFrustum::PLANE_COUNT) - 1};
+    while (size > 0)
+    {
+      Entry entry = stack[--size];
+      const Node& node = m_nodes[entry.node];
+      const CoreVuContainment containment =
+          Classify(frustum, node.isLeaf() ? node.box : node.fat_box,
+                   entry.plane_mask);
+      if (containment == CoreVuContainment::Outside) continue;
+
+      if (node.isLeaf())
+      {
+        fn(node.entity);
+      }
+      else if (containment == CoreVuContainment::Inside)
+      {
+        reportAll(entry.node, fn);
+      }
+      else
+      {
+        assert(size + 2 <= MAX_STACK_SIZE && "Tree is too deep");
+        stack[size++] = Entry{node.child1, entry.plane_mask};
+        stack[size++] = Entry{node.child2, entry.plane_mask};
+      }
+    }
+  }
+
+  /* fn(entity, distance) per leaf the ray hits, returns the new max distance
+   * of the ray: ray.max_distance to get all hits, distance to keep only
+   * closer ones, 0 to stop. Nearer children are visited first. */
+  template <typename Fn>
+  void raycast(const CoreVuRay& ray, Fn&& fn) const
+  {
+    if (m_root == NULL_PROXY) return;
+
+    CoreVuRay clipped = ray;
+    const glm::vec3 inverse_direction = 1.f / ray.direction;
+    std::array<ProxyId, MAX_STACK_SIZE> stack;
+    size_t size = 0;
+    stack[size++] = m_root;
+    while (size > 0)
+    {
+      const Node& node = m_nodes[stack[--size]];
+      float distance = 0.f;
+      if (node.isLeaf())
+      {
+        if (IntersectRay(clipped, inverse_direction, node.box, distance))
+        {
+          clipped.max_distance = fn(node.entity, distance);
+          if (clipped.max_distance <= 0.f) return;
+        }
+        continue;
+      }
+      if (!IntersectRay(clipped, inverse_direction, node.fat_box, distance))
+      {
+        continue;
+      }
+
+      float distance1 = 0.f;
+      float distance2 = 0.f;
+      const bool hit1 = IntersectRay(
+          clipped, inverse_direction, m_nodes[node.child1].fat_box, distance1);
+      const bool hit2 = IntersectRay(
+          clipped, inverse_direction, m_nodes[node.child2].fat_box, distance2);
+      assert(size + 2 <= MAX_STACK_SIZE && "Tree is too deep");
+      // the nearer child goes on top
+      if (hit1 && hit2 && distance1 < distance2)
+      {
+        stack[size++] = node.child2;
+        stack[size++] = node.child1;
+      }
+      else
+      {
+        if (hit1) stack[size++] = node.child1;
+        if (hit2) stack[size++] = node.child2;
+      }
+    }
+  }
+
+  CoreVuRayHit raycastClosest(const CoreVuRay& ray) const;
+
+  /* Batch queries: every query runs as its own item of a parallelFor, the
+   * results of query i go to results[i](cleared first, capacity is kept). */
+  void queryAabbs(
+      CoreVuJobSystem& job_system, std::span<const CoreVuAabb> boxes,
+      std::vector<std::vector<CoreVuEntity>>& results) const;
+  void querySpheres(
+      CoreVuJobSystem& job_system, std::span<const CoreVuSphere> spheres,
+      std::vector<std::vector<CoreVuEntity>>& results) const;
+  void queryFrustums(
+      CoreVuJobSystem& job_system, std::span<const CoreVuFrustum> frustums,
+      std::vector<std::vector<CoreVuEntity>>& results) const;
+  // hits[i] is the closest hit of rays[i], NULL_ENTITY if there is none
+  void raycastClosest(
+      CoreVuJobSystem& job_system, std::span<const CoreVuRay> rays,
+      std::span<CoreVuRayHit> hits) const;
+
+private:
+  // the AVL rotations keep the height below 1.44 * log2(proxies) + 2
+  static constexpr size_t MAX_STACK_SIZE = 128;
+
+  struct Node
+  {
+    CoreVuAabb fat_box;        // leaves: grown box, internal: children union
+    CoreVuAabb box;            // leaves only, exact box of the entity
+    ProxyId parent{NULL_PROXY}; // next free node while unused
+    ProxyId child1{NULL_PROXY};
+    ProxyId child2{NULL_PROXY};
+    int32_t height{0};         // leaves 0, unused -1
+    CoreVuEntity entity{NULL_ENTITY};
+
+    bool isLeaf() const
+    {
+      return child1 == NULL_PROXY;
+    }
+  };
+
+  template <typename Overlaps, typename Leaf>
+  void traverse(Overlaps&& overlaps, Leaf&& leaf) const
+  {
+    if (m_root == NULL_PROXY) return;
+
+    std::array<ProxyId, MAX_STACK_SIZE> stack;
+    size_t size = 0;
+    stack[size++] = m_root;
+    while (size > 0)
+    {
+      const Node& node = m_nodes[stack[--size]];
+      if (node.isLeaf())
+      {
+        leaf(node);
+      }
+      else if (overlaps(node.fat_box))
+      {
+        assert(size + 2 <= MAX_STACK_SIZE && "Tree is too deep");
+        stack[size++] = node.child1;
+        stack[size++] = node.child2;
+      }
+    }
+  }
+
+  // every leaf below node, no tests
+  template <typename Fn>
+  void reportAll(ProxyId root, Fn& fn) const
+  {
+    std::array<ProxyId, MAX_STACK_SIZE> stack;
+    size_t size = 0;
+    stack[size++] = root;
+    while (size > 0)
+    {
+      const Node& node = m_nodes[stack[--size]];
+      if (node.isLeaf())
+      {
+        fn(node.entity);
+      }
+      else
+      {
+        stack[size++] = node.child1;
+        stack[size++] = node.child2;
+      }
+    }
+  }
+
+  static CoreVuAabb Fatten(const CoreVuAabb& box);
+
+  ProxyId allocateNode();
+  void freeNode(ProxyId node);
+  void insertLeaf(ProxyId leaf);
+  void removeLeaf(ProxyId leaf);
+  // refits boxes and heights from node up to the root, rotating on the way
+  void refitUpwards(ProxyId node);
+  ProxyId balance(ProxyId node);
+  int32_t validateSubtree(ProxyId node, ProxyId parent) const;
+
+  std::vector<Node> m_nodes;
+  ProxyId m_root{NULL_PROXY};
+  ProxyId m_free_list{NULL_PROXY};
+  uint32_t m_proxy_count{0};
+};
+} // namespace corevu
@@ -0,0 +1,187 @@
+#pragma once
+
+#include "corevu_components.hpp"
+#include "corevu_frame_info.hpp"
+
+// std
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <vector>
+
+namespace corevu
+{
+// the visible lists as a scheduler resource, render systems read them
+struct VisibilityResource
+{
+};
+
+struct CoreVuCullStats
+{
+  uint32_t tested{0};
+  uint32_t drawn{0};
+  uint32_t culled{0};   // outside the frustum
+  uint32_t small{0};    // in the frustum, below the minimum screen size
+  uint32_t occluded{0}; // in the frustum, behind occluders
+  uint32_t occluders{0};
+  uint32_t occluder_triangles{0};
+  uint32_t lods[CoreVuModel::MAX_LODS]{}; // drawn per LOD
+};
+
+/*
+Frustum, size and occlusion culling plus LOD selection of everything with a
+TransformComponent and a ModelComponent, before the render systems record
+their draws.
+
+  culling_system.update(frame_info); // after the TransformSystem
+  render_system.renderGameObjects(frame_info, culling_system.getVisible());
+
+Every chunk is a job: the bounding spheres of the models go through the world
+matrices into SoA streams(radius scaled by the largest axis scale), then
+CullSpheres tests them 4-16 at a time. The visible entities of all chunks are
+concatenated in query order, split like the render systems draw them: without
+and with a TextureComponent.
+
+Screen size: the world sphere of everything in the frustum is projected,
+objects smaller than the minimum screen size(fraction of the screen height)
+are dropped. The rest gets a LOD: error_scale turns the model space error of a
+LOD into a fraction of the screen height at that distance, the coarsest LOD
+within the max LOD error is drawn(CoreVuModel::SelectLod). The last LOD of
+every entity is kept and only left once the error is LOD_HYSTERESIS past the
+limit, objects at a boundary don't switch back and forth.
+
+  screen height 1.0  ->  error 0.001 = 1 pixel at 1000 pixels height
+
+Occlusion: entities with an OccluderComponent in the frustum are rasterized
+into a CoreVuOcclusionBuffer first, biggest on screen first until the triangle
+budget is used up. The chunk jobs then test the world box of every object that
+passed the frustum against it. Temporal coherence: an occluder that was itself
+hidden behind other occluders last frame is not rasterized this frame, it
+would add nothing but triangles. Its own test runs as usual, so it comes back
+the frame after it shows up again.
+
+Per frame counts are plotted to Tracy("drawn", "culled", "occluded"),
+printReport() gives the totals.
+*/
+class CullingSystem
+{
+public:
+  explicit CullingSystem(uint32_t thread_count);
+  CullingSystem(const CullingSystem&) = delete;
+  CullingSystem& operator=(const CullingSystem&) = delete;
+
+  void update(FrameInfo& frame_info);
+
+  static constexpr float DEFAULT_LOD_ERROR = .001f;
+  static constexpr float DEFAULT_MIN_SCREEN_SIZE = .002f;
+  static constexpr float LOD_HYSTERESIS = .25f;
+
+  // largest LOD error on screen, fraction of the screen height
+  void setLodError(float max_error)
+  {
+    m_lod_error = max_error;
+  }
+  // smallest projected diameter drawn, fraction of the screen height
+  void setMinScreenSize(float min_size)
+  {
+    m_min_screen_size = min_size;
+  }
+  void setOcclusionEnabled(bool enabled)
+  {
+    m_occlusion_enabled = enabled;
+  }
+  CoreVuOcclusionBuffer& getOcclusionBuffer()
+  {
+    return m_occlusion;
+  }
+
+  std::span<const CoreVuDrawItem> getVisible() const
+  {
+    return m_visible;
+  }
+  std::span<const CoreVuDrawItem> getVisibleTextured() const
+  {
+    return m_visible_textured;
+  }
+  // of the last update
+  const CoreVuCullStats& getStats() const
+  {
+    return m_stats;
+  }
+
+  void printReport(std::ostream& out) const;
+
+private:
+  struct ChunkWork
+  {
+    uint32_t count;
+    const CoreVuEntity* entities;
+    const TransformComponent* transforms;
+    const ModelComponent* models;
+    bool textured;
+  };
+
+  struct ChunkCounts
+  {
+    uint32_t small;
+    uint32_t occluded;
+    uint32_t lods[CoreVuModel::MAX_LODS];
+  };
+
+  // by entity index, results of the last update
+  struct EntityState
+  {
+    uint8_t hidden; // occluded
+    uint8_t lod;
+  };
+
+  struct OccluderWork
+  {
+    const CoreVuOccluderMesh* mesh;
+    const glm::mat4* world;
+    float screen_size; // world radius over camera distance
+  };
+
+  // scratch of one job system thread
+  struct alignas(64) ThreadScratch
+  {
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> radius;
+    std::vector<uint32_t> indices;
+  };
+
+  void rasterizeOccluders(FrameInfo& frame_info);
+  void cullChunk(
+      const ChunkWork& chunk, ThreadScratch& scratch,
+      std::vector<CoreVuDrawItem>& visible, ChunkCounts& counts);
+
+  std::vector<CoreVuDrawItem> m_visible;
+  std::vector<CoreVuDrawItem> m_visible_textured;
+  std::vector<ChunkWork> m_chunks;
+  // per chunk results, kept to reuse their capacity
+  std::vector<std::vector<CoreVuDrawItem>> m_chunk_visible;
+  std::vector<ChunkCounts> m_chunk_counts;
+  std::vector<EntityState> m_entities;
+  std::vector<ThreadScratch> m_scratch;
+  CoreVuFrustum m_frustum{};
+  glm::vec3 m_eye{0.f};
+  float m_projection_scale{1.f}; // |projection[1][1]|
+  bool m_perspective{true};
+  float m_lod_error{DEFAULT_LOD_ERROR};
+  float m_min_screen_size{DEFAULT_MIN_SCREEN_SIZE};
+
+  CoreVuOcclusionBuffer m_occlusion;
+  bool m_occlusion_enabled{true};
+  bool m_occlusion_active{false}; // this frame, any triangles rasterized
+  std::vector<OccluderWork> m_occluders;
+
+  CoreVuCullStats m_stats{};
+  uint64_t m_frames{0};
+  uint64_t m_total_drawn{0};
+  uint64_t m_total_culled{0};
+  uint64_t m_total_occluded{0};
+  uint64_t m_total_small{0};
+};
+} // namespace corevu
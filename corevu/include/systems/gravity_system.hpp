@@ -1,72 +1,44 @@
 #pragma once
-#include <corevu_gameobject.hpp>
 
-// std
-#include <vector>
+#include "corevu_components.hpp"
+#include "corevu_frame_info.hpp"
+#include "physics/corevu_gravity_solver.hpp"
 
 namespace corevu
 {
+/*
+2d gravity between all entities with a TransformComponent and a
+RigidBody2dComponent, x and y of the translation are the position:
+
+  scheduler.addSystem(
+      "gravity",
+      CoreVuSystemAccess{}.write<TransformComponent, RigidBody2dComponent>(),
+      [&](FrameInfo& frame_info) { gravity.update(frame_info, 5); });
+
+The bodies are gathered into the SoA streams of a CoreVuGravitySolver, stepped
+there and written back, so the solver picks exact or Barnes-Hut by the body
+count(getSolver() to configure it). More substeps result in a more stable
+simulation, but take longer to compute.
+*/
 class GravityPhysicsSystem
 {
 public:
-  GravityPhysicsSystem(float strength) : strengthGravity{strength}
+  explicit GravityPhysicsSystem(float strength) : m_solver{strength}
   {
   }
+  GravityPhysicsSystem(const GravityPhysicsSystem&) = delete;
+  GravityPhysicsSystem& operator=(const GravityPhysicsSystem&) = delete;
 
-  const float strengthGravity;
+  // advances the bodies by frame_info.frame_time in substeps
+  void update(FrameInfo& frame_info, uint32_t substeps = 1);
 
-  // dt stands for delta time, and specifies the amount of time to advance the
-  // simulation substeps is how many intervals to divide the forward time step
-  // in. More substeps result in a more stable simulation, but takes longer to
-  // compute
-  void update(
-      std::vector<CoreVuGameObject>& objs, float dt, unsigned int substeps = 1)
+  CoreVuGravitySolver& getSolver()
   {
-    const float stepDelta = dt / substeps;
-    for (int i = 0; i < substeps; i++)
-    {
-      stepSimulation(objs, stepDelta);
-    }
-  }
-
-  glm::vec2 computeForce(
-      CoreVuGameObject& fromObj, CoreVuGameObject& toObj) const
-  {
-    auto offset = fromObj.transform.translation - toObj.transform.translation;
-    float distanceSquared = glm::dot(offset, offset);
-
-    // clown town - just going to return 0 if objects are too close together...
-    if (glm::abs(distanceSquared) < 1e-10f) { return {.0f, .0f}; }
-
-    float force = strengthGravity * toObj.rigid_body.mass *
-                  fromObj.rigid_body.mass / distanceSquared;
-    return force * offset / glm::sqrt(distanceSquared);
+    return m_solver;
   }
 
 private:
-  void stepSimulation(std::vector<CoreVuGameObject>& physicsObjs, float dt)
-  {
-    // Loops through all pairs of objects and applies attractive force between
-    // them
-    for (auto iterA = physicsObjs.begin(); iterA != physicsObjs.end(); ++iterA)
-    {
-      auto& objA = *iterA;
-      for (auto iterB = iterA; iterB != physicsObjs.end(); ++iterB)
-      {
-        if (iterA == iterB) continue;
-        auto& objB = *iterB;
-
-        auto force = computeForce(objA, objB);
-        objA.rigid_body.velocity += dt * -force / objA.rigid_body.mass;
-        objB.rigid_body.velocity += dt * force / objB.rigid_body.mass;
-      }
-    }
-
-    // update each objects position based on its final velocity
-    for (auto& obj : physicsObjs)
-    {
-      obj.transform.translation += dt * obj.rigid_body.velocity;
-    }
-  }
+  CoreVuGravitySolver m_solver;
+  CoreVuGravityBodies m_bodies;
 };
-} // namespace corevu
\ No newline at end of file
+} // namespace corevu
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "corevu_buffer.hpp"
+#include "corevu_descriptors.hpp"
+#include "corevu_device.hpp"
+#include "corevu_frame_info.hpp"
+#include "corevu_pipeline.hpp"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace corevu
+{
+/* One particle as the shaders see it(std430), 48 bytes. */
+struct GpuParticle
+{
+  glm::vec4 position{0.f}; // xy position, z mass
+  glm::vec4 velocity{0.f}; // xy velocity
+  glm::vec4 color{1.f};
+};
+
+/*
+2d n-body particles living on the gpu only: the state is uploaded once, then
+the compute shader steps it and the vertex shader draws it from the same
+storage buffers, nothing comes back to the cpu(download() is for tests).
+
+  GpuParticleSystem particles{device, render_pass, global_set_layout, state};
+  ...
+  particles.simulate(command_buffer, dt); // before the render pass begins
+  renderer.BeginSwapChainRenderPass(command_buffer);
+  particles.render(frame_info);
+
+Two buffers ping-pong, each step reads all positions from one and writes the
+stepped particles to the other:
+
+  set 0: binding 0 = A, binding 1 = B      step: binding 0 -> binding 1
+  set 1: binding 0 = B, binding 1 = A      draw: binding 1 of the last set
+
+particle_nbody.comp is the tiled all pairs kernel: each workgroup of
+WORKGROUP_SIZE particles loads one tile of positions into shared memory,
+every invocation sums the pull of the tile, the next tile is loaded, so each
+position is read from the buffer once per workgroup instead of once per
+particle. The force law and the semi implicit euler are the ones of
+CoreVuGravitySolver(exact mode), same strength and softening give the same
+orbits up to float rounding.
+
+particle.vert draws one instanced billboard(6 vertices) per particle, the
+instance index is the particle index, no vertex buffers.
+
+Without a render pass(VK_NULL_HANDLE, e.g. on a headless device) only the
+compute part is created and render() must not be called.
+*/
+class GpuParticleSystem
+{
+public:
+  // local_size_x of particle_nbody.comp
+  static constexpr uint32_t WORKGROUP_SIZE = 256;
+
+  GpuParticleSystem(
+      CoreVuDevice& device, VkRenderPass render_pass,
+      VkDescriptorSetLayout global_descriptor_set_layout,
+      const std::vector<GpuParticle>& particles);
+  ~GpuParticleSystem();
+  GpuParticleSystem(const GpuParticleSystem&) = delete;
+  GpuParticleSystem& operator=(const GpuParticleSystem&) = delete;
+
+  /* Records one step, outside of a render pass. Steps recorded one after
+   * another(also over frames in flight) are ordered by barriers. */
+  void simulate(VkCommandBuffer command_buffer, float dt);
+  // draws the state of the last recorded step
+  void render(FrameInfo& frame_info);
+
+  /* Copies the current state back, waits for the device. For validation,
+   * not per frame. */
+  void download(std::vector<GpuParticle>& particles);
+
+  uint32_t getParticleCount() const
+  {
+    return m_particle_count;
+  }
+  void setStrength(float strength)
+  {
+    m_strength = strength;
+  }
+  void setSoftening(float softening)
+  {
+    m_softening = softening;
+  }
+  // billboard radius in world units
+  void setParticleSize(float size)
+  {
+    m_particle_size = size;
+  }
+
+private:
+  void createBuffers(const std::vector<GpuParticle>& particles);
+  void createDescriptorSets();
+  void createComputePipeline();
+  void createPipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout);
+  void createPipeline(VkRenderPass render_pass);
+
+  CoreVuDevice& m_corevu_device;
+  uint32_t m_particle_count;
+  float m_strength{1.f};
+  float m_softening{0.f};
+  float m_particle_size{.01f};
+
+  std::array<std::unique_ptr<CoreVuBuffer>, 2> m_particle_buffers{};
+  std::unique_ptr<CoreVuDescriptorPool> m_descriptor_pool{nullptr};
+  std::unique_ptr<CoreVuDescriptorSetLayout> m_descriptor_set_layout{nullptr};
+  std::array<VkDescriptorSet, 2> m_descriptor_sets{};
+  uint32_t m_current_set{1}; // binding 1 of it holds the current state
+
+  std::unique_ptr<CoreVuComputePipeline> m_compute_pipeline{nullptr};
+  VkPipelineLayout m_compute_pipeline_layout{VK_NULL_HANDLE};
+  std::unique_ptr<CoreVuPipeline> m_corevu_pipeline{nullptr};
+  VkPipelineLayout m_pipeline_layout{VK_NULL_HANDLE};
+};
+} // namespace corevu
@@ -2,12 +2,15 @@
 
 #include "corevu_camera.hpp"
 #include "corevu_device.hpp"
-#include "corevu_gameobject.hpp"
+#include "corevu_components.hpp"
 #include "corevu_window.hpp"
 #include "corevu_pipeline.hpp"
 #include "corevu_frame_info.hpp"
+#include "render/corevu_frame_packet.hpp"
+#include "render/corevu_render_queue.hpp"
 
 // std
+#include <array>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
@@ -32,7 +35,11 @@ public:
   PointLightSystem& operator=(const PointLightSystem&) = delete;
 
   void update(FrameInfo& frame_info, GlobalUbo& global_ubo);
-  void render(FrameInfo& frame_info);
+  // back to front into lights, on the thread running the systems
+  void extractLights(FrameInfo& frame_info, CoreVuLightList& lights);
+  // on the thread recording the frame, see CoreVuRenderThread
+  void render(
+      const CoreVuRenderContext& context, const CoreVuLightList& lights);
 
 private:
   void createPipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout);
@@ -43,5 +50,12 @@ private:
 
   std::unique_ptr<CoreVuPipeline> m_corevu_pipeline{nullptr};
   VkPipelineLayout m_pipeline_layout;
+
+  // light table of the last update, rebuilt when lights changed
+  ChangeVersion m_change_version{0};
+  std::array<PointLight, MAX_LIGHTS> m_lights{};
+  int m_light_count{0};
+  // sorts the billboards back to front, payload is the light entity
+  CoreVuRenderQueue m_queue;
 };
 } // namespace corevu
\ No newline at end of file
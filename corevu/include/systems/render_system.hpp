@@ -2,16 +2,19 @@
 
 #include "corevu_camera.hpp"
 #include "corevu_device.hpp"
-#include "corevu_gameobject.hpp"
+#include "corevu_components.hpp"
 #include "corevu_window.hpp"
 #include "corevu_pipeline.hpp"
 #include "corevu_frame_info.hpp"
+#include "render/corevu_frame_packet.hpp"
+#include "render/corevu_render_queue.hpp"
 
 // std
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
+#include <span>
 
 namespace corevu
 {
@@ -31,7 +34,14 @@ public:
   RenderSystem(const RenderSystem&) = delete;
   RenderSystem& operator=(const RenderSystem&) = delete;
 
-  void renderGameObjects(FrameInfo& frame_info);
+  // visible: entities without TextureComponent, see CullingSystem. Sorted by
+  // model into draws, on the thread running the systems
+  void extractDraws(
+      FrameInfo& frame_info, std::span<const CoreVuDrawItem> visible,
+      CoreVuDrawList& draws);
+  // on the thread recording the frame, see CoreVuRenderThread
+  void renderGameObjects(
+      const CoreVuRenderContext& context, const CoreVuDrawList& draws);
 
 private:
   void createPipelineLayout(VkDescriptorSetLayout global_descriptor_set_layout);
@@ -42,5 +52,7 @@ private:
 
   std::unique_ptr<CoreVuPipeline> m_corevu_pipeline{nullptr};
   VkPipelineLayout m_pipeline_layout;
+  // sorts the draws by model, payload indexes the visible span
+  CoreVuRenderQueue m_queue;
 };
 } // namespace corevu
\ No newline at end of file
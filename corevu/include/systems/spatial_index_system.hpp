@@ -0,0 +1,109 @@
+#pragma once
+
+#include "corevu_components.hpp"
+#include "corevu_frame_info.hpp"
+#include "geometry/corevu_mesh_bvh.hpp"
+#include "spatial/corevu_aabb_tree.hpp"
+
+// std
+#include <span>
+#include <vector>
+
+namespace corevu
+{
+// the index as a scheduler resource, queries read it, update() writes it
+struct SpatialIndexResource
+{
+};
+
+struct CoreVuPickHit
+{
+  CoreVuEntity entity{NULL_ENTITY};
+  float distance{0.f}; // along the ray, in direction units
+  // of the model(CoreVuMeshHit), NO_TRIANGLE where only the box was hit
+  uint32_t triangle{CoreVuMeshHit::NO_TRIANGLE};
+  glm::vec2 barycentric{0.f};
+
+  bool isHit() const
+  {
+    return entity != NULL_ENTITY;
+  }
+};
+
+/*
+Keeps a CoreVuAabbTree over the world boxes of all entities with a
+TransformComponent and a ModelComponent(model bounds through the world
+matrix), for frustum, sphere, box and ray queries:
+
+  scheduler.addSystem(
+      "spatial_index",
+      CoreVuSystemAccess{}
+          .read<TransformComponent, ModelComponent>()
+          .write<SpatialIndexResource>(),
+      [&](FrameInfo& frame_info) { spatial_index.update(frame_info); });
+  ...
+  spatial_index.getTree().querySphere(sphere, [&](CoreVuEntity e) {});
+
+Runs after the TransformSystem. Only chunks whose transforms or models were
+written since the last update are visited, entities that left(destroyed or
+lost a component) are looked for only when the world reports removals, so a
+static scene costs nothing per frame.
+
+Ray casts and picking go through the tree to the entities whose box the ray
+enters, nearest first, and then into the CoreVuMeshBvh of their model:
+
+  const CoreVuPickHit hit =
+      spatial_index.raycast(world, camera.getRay(cursor_ndc));
+
+  world ray --tree--> entity boxes --inverse world matrix--> model space ray
+            --mesh BVH--> closest triangle, the distance stays the same
+
+Models without a BVH(see CoreVuAssetCache) are hit by their world box. Ray
+casts only read the world and the index, any number can run in parallel while
+nothing writes either of them.
+*/
+class SpatialIndexSystem
+{
+public:
+  SpatialIndexSystem() = default;
+  SpatialIndexSystem(const SpatialIndexSystem&) = delete;
+  SpatialIndexSystem& operator=(const SpatialIndexSystem&) = delete;
+
+  void update(FrameInfo& frame_info);
+
+  const CoreVuAabbTree& getTree() const
+  {
+    return m_tree;
+  }
+
+  // closest hit before ray.max_distance
+  CoreVuPickHit raycast(const CoreVuWorld& world, const CoreVuRay& ray) const;
+  /* hits[i] for rays[i]. Every CoreVuRayPacket::SIZE rays form a packet that
+   * goes through the mesh BVHs together, packets run in parallel. Neighbours
+   * should be coherent(a region of the screen, a spread from one point). */
+  void raycast(
+      const CoreVuWorld& world, CoreVuJobSystem& job_system,
+      std::span<const CoreVuRay> rays, std::span<CoreVuPickHit> hits) const;
+
+private:
+  // packets collecting more entities go ray by ray
+  static constexpr uint32_t MAX_PACKET_CANDIDATES = 64;
+  static constexpr uint32_t PACKET_BATCH_SIZE = 4;
+
+  struct Entry
+  {
+    CoreVuEntity entity{NULL_ENTITY};
+    CoreVuAabbTree::ProxyId proxy{CoreVuAabbTree::NULL_PROXY};
+  };
+
+  void removeGone(const CoreVuWorld& world);
+  void raycastPacket(
+      const CoreVuWorld& world, std::span<const CoreVuRay> rays,
+      std::span<CoreVuPickHit> hits) const;
+
+  CoreVuAabbTree m_tree;
+  std::vector<Entry> m_entries; // by entity index
+  ChangeVersion m_change_version{0};
+  uint64_t m_removal_count{0};
+};
+} // namespace corevu
@@ -4,11 +4,15 @@
 #include <corevu_descriptors.hpp>
 #include <corevu_device.hpp>
 #include <corevu_frame_info.hpp>
-#include <corevu_gameobject.hpp>
+#include <corevu_components.hpp>
 #include <corevu_pipeline.hpp>
+#include <render/corevu_frame_packet.hpp>
+#include <render/corevu_render_queue.hpp>
 
 // std
 #include <memory>
+#include <span>
+#include <unordered_map>
 #include <vector>
 
 namespace corevu
@@ -24,11 +28,19 @@ public:
   TextureRenderSystem(const TextureRenderSystem&) = delete;
   TextureRenderSystem& operator=(const TextureRenderSystem&) = delete;
 
-  void renderGameObjects(FrameInfo& frameInfo);
+  // visible: entities with TextureComponent, see CullingSystem
+  // sorted by texture and model into draws, on the thread running the systems
+  void extractDraws(
+      FrameInfo& frameInfo, std::span<const CoreVuDrawItem> visible,
+      CoreVuDrawList& draws);
+  // on the thread recording the frame, see CoreVuRenderThread
+  void renderGameObjects(
+      const CoreVuRenderContext& context, const CoreVuDrawList& draws);
 
 private:
   void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
   void createPipeline(VkRenderPass renderPass);
+  VkDescriptorSet getTextureSet(CoreVuTexture& texture);
 
   CoreVuDevice& m_device;
 
@@ -36,5 +48,11 @@ private:
   VkPipelineLayout m_pipeline_layout;
 
   std::unique_ptr<CoreVuDescriptorSetLayout> m_render_system_layout;
+  // a set per texture drawn so far, the textures must outlive the system
+  static constexpr uint32_t MAX_TEXTURES = 256;
+  std::unique_ptr<CoreVuDescriptorPool> m_texture_pool;
+  std::unordered_map<const CoreVuTexture*, VkDescriptorSet> m_texture_sets;
+  // sorts the draws by texture and model, payload indexes the visible span
+  CoreVuRenderQueue m_queue;
 };
 } // namespace corevu
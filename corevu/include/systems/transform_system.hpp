@@ -0,0 +1,81 @@
+#pragma once
+
+#include "corevu_components.hpp"
+#include "corevu_frame_info.hpp"
+
+// std
+#include <atomic>
+#include <vector>
+
+namespace corevu
+{
+
+/*
+Keeps the cached matrices of all TransformComponents up to date.
+
+update() runs in two steps:
+  1. every transform in a chunk written since the last update(chunk
+     parallel): dirty ones recompute their local matrix in batches through
+     ComputeTransformMatrices(simd), roots take it as world matrix.
+  2. children level by level(parallel inside a level), parents are always on
+     a lower level so they are final when their children read them. A child
+     recomputes its world matrix if its local matrix or its parent's world
+     matrix changed in this update.
+
+        root        level 0(step 1)
+       /    \
+    child  child    level 1
+      |
+    child           level 2
+
+Normal matrices are derived from the world matrix, so non uniform scale of a
+parent is handled as well.
+
+With a fixed simulation step update() runs once per step and interpolate()
+once per rendered frame, see CoreVuFrameLoop. Every world matrix write keeps
+the previous one, interpolate() blends the two into the render matrix:
+
+  step n-1        step n          alpha = accumulator / step
+     |---------------|-----x
+     previous      world   render = TRS(lerp T, slerp R, lerp S)
+
+Only transforms that moved in the last update are blended, the next update
+settles them(render = world) before anything else. Both matrices are split
+into translation, rotation and scale, the rotation is blended along the
+shorter arc so it neither shrinks nor changes speed between two steps.
+Sheared world matrices(non uniform scale of a parent under a rotated child)
+can't be split and are blended per element. Normal matrices are not blended.
+Render matrices are written without stamping a change version, interpolating
+does not make transforms look changed to other systems.
+*/
+class TransformSystem
+{
+public:
+  TransformSystem() = default;
+  TransformSystem(const TransformSystem&) = delete;
+  TransformSystem& operator=(const TransformSystem&) = delete;
+
+  /* Links child to parent, NULL_ENTITY makes it a root again. The local TRS of
+   * the child is kept and now relative to the parent. */
+  void setParent(CoreVuWorld& world, CoreVuEntity child, CoreVuEntity parent);
+
+  void update(FrameInfo& frame_info);
+  // render matrices of the transforms the last update moved, alpha in [0, 1]
+  void interpolate(FrameInfo& frame_info, float alpha);
+
+private:
+  void rebuildLevels(CoreVuWorld& world, ChangeVersion version);
+  static void StoreWorldMatrix(
+      TransformComponent& transform, const glm::mat4& world_matrix,
+      uint32_t update_index);
+
+  uint32_t m_update_index{0};
+  ChangeVersion m_change_version{0};
+
+  // entities with a parent grouped by depth, [0] holds depth 1
+  std::vector<std::vector<CoreVuEntity>> m_levels;
+  std::atomic<bool> m_hierarchy_dirty{true};
+  // moved by the last update, one list per job system thread
+  std::vector<std::vector<CoreVuEntity>> m_moved;
+};
+} // namespace corevu
@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec2 fragOffset;
+layout(location = 1) in vec4 fragColor;
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+  // shaping to be a circle, fading to the edge
+  float distance = sqrt(dot(fragOffset, fragOffset));
+  if (distance >= 1.0)
+    discard;
+
+  outColor = vec4(fragColor.rgb, fragColor.a * (1.0 - distance * distance));
+}
@@ -0,0 +1,62 @@
+#version 450
+
+const vec2 OFFSETS[6] = vec2[](
+    vec2(-1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, -1.0), vec2(1.0, -1.0),
+    vec2(-1.0, 1.0), vec2(1.0, 1.0));
+
+layout(location = 0) out vec2 fragOffset;
+layout(location = 1) out vec4 fragColor;
+
+struct Particle
+{
+  vec4 position; // xy position, z mass
+  vec4 velocity; // xy velocity
+  vec4 color;
+};
+
+// the state the last compute step wrote
+layout(std430, set = 1, binding = 1) readonly buffer Particles
+{
+  Particle particles[];
+};
+
+layout(push_constant) uniform Push
+{
+  float size; // billboard radius
+}
+push;
+
+struct PointLight
+{
+  vec4 position; // ignore w
+  vec4 color;    // w as light intensity
+};
+layout(set = 0, binding = 0) uniform GlobalUniformBufferObject // UBO
+{
+  mat4 projectionMatrix;
+  mat4 viewMatrix;
+  mat4 invViewMatrix;
+  vec4 ambientLightColor; // w as ambient intensity, xyz as color
+  PointLight pointLights[10];
+  int pointLightCount;
+}
+ubo;
+
+void main()
+{
+  // one instance per particle, no vertex buffers
+  Particle particle = particles[gl_InstanceIndex];
+  fragOffset = OFFSETS[gl_VertexIndex];
+  fragColor = particle.color;
+
+  // billboard in world space, particles live in the xy plane
+  vec3 cameraRightWorld = {
+      ubo.viewMatrix[0][0], ubo.viewMatrix[1][0], ubo.viewMatrix[2][0]};
+  vec3 cameraUpWorld = {
+      ubo.viewMatrix[0][1], ubo.viewMatrix[1][1], ubo.viewMatrix[2][1]};
+  vec3 positionWorld = vec3(particle.position.xy, 0.0) +
+                       cameraRightWorld * fragOffset.x * push.size +
+                       cameraUpWorld * fragOffset.y * push.size;
+  gl_Position =
+      ubo.projectionMatrix * ubo.viewMatrix * vec4(positionWorld, 1.0);
+}
@@ -87,7 +87,7 @@ void CoreVuBuffer::unmap() {
  * @param offset (Optional) Byte offset from beginning of mapped region
  *
  */
-void CoreVuBuffer::writeToBuffer(void *data, VkDeviceSize size, VkDeviceSize offset) {
+void CoreVuBuffer::writeToBuffer(const void *data, VkDeviceSize size, VkDeviceSize offset) {
   assert(m_mapped && "Cannot copy to unmapped buffer");
  
   if (size == VK_WHOLE_SIZE) {
@@ -129,4 +129,18 @@ void CoreVuCamera::setViewYXZ(
   m_inverse_view_matrix[3][1] = position.y;
   m_inverse_view_matrix[3][2] = position.z;
 }
+
+CoreVuRay CoreVuCamera::getRay(const glm::vec2& ndc) const
+{
+  // clip depth 0..1, the near and the far plane point under ndc
+  const glm::mat4 inverse_projection = glm::inverse(m_projection_matrix);
+  glm::vec4 near_point = inverse_projection * glm::vec4{ndc, 0.f, 1.f};
+  glm::vec4 far_point = inverse_projection * glm::vec4{ndc, 1.f, 1.f};
+  near_point /= near_point.w;
+  far_point /= far_point.w;
+
+  const glm::vec3 origin{m_inverse_view_matrix * near_point};
+  const glm::vec3 end{m_inverse_view_matrix * far_point};
+  return CoreVuRay{origin, end - origin, 1.f};
+}
 } // namespace corevu
\ No newline at end of file
@@ -184,7 +184,10 @@ CoreVuDescriptorWriter& CoreVuDescriptorWriter::writeBuffer(
   write.pBufferInfo = bufferInfo;
   write.descriptorCount = 1;
 
-  m_writes.push_back(write);
+  assert(
+      m_write_count < MAX_WRITES &&
+      "CoreVuDescriptorWriter::MAX_WRITES exceeded");
+  m_writes[m_write_count++] = write;
   return *this;
 }
 
@@ -208,7 +211,10 @@ CoreVuDescriptorWriter& CoreVuDescriptorWriter::writeImage(
   write.pImageInfo = imageInfo;
   write.descriptorCount = 1;
 
-  m_writes.push_back(write);
+  assert(
+      m_write_count < MAX_WRITES &&
+      "CoreVuDescriptorWriter::MAX_WRITES exceeded");
+  m_writes[m_write_count++] = write;
   return *this;
 }
 
@@ -228,12 +234,11 @@ bool CoreVuDescriptorWriter::build(VkDescriptorSet& set)
 
 void CoreVuDescriptorWriter::overwrite(VkDescriptorSet& set)
 {
-  for (auto& write : m_writes)
+  for (uint32_t i = 0; i < m_write_count; ++i)
   {
-    write.dstSet = set;
+    m_writes[i].dstSet = set;
   }
   //sets to write to the newly created set/or alreaady used one
   vkUpdateDescriptorSets(
-      m_pool.m_device.device(), static_cast<uint32_t>(m_writes.size()),
-      m_writes.data(), 0, nullptr);
+      m_pool.m_device.device(), m_write_count, m_writes.data(), 0, nullptr);
 }
\ No newline at end of file
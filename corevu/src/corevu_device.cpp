@@ -50,7 +50,8 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-CoreVuDevice::CoreVuDevice(CoreVuWindow& window) : window{window}
+CoreVuDevice::CoreVuDevice(CoreVuWindow& window)
+  : window{&window}, deviceExtensions{VK_KHR_SWAPCHAIN_EXTENSION_NAME}
 {
   createInstance();
   setupDebugMessenger();
@@ -60,6 +61,15 @@ CoreVuDevice::CoreVuDevice(CoreVuWindow& window) : window{window}
   createCommandPool();
 }
 
+CoreVuDevice::CoreVuDevice() : window{nullptr}, deviceExtensions{}
+{
+  createInstance();
+  setupDebugMessenger();
+  pickPhysicalDevice();
+  createLogicalDevice();
+  createCommandPool();
+}
+
 CoreVuDevice::~CoreVuDevice()
 {
   vkDestroyCommandPool(device_, commandPool, nullptr);
@@ -70,7 +80,10 @@ CoreVuDevice::~CoreVuDevice()
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (surface_ != VK_NULL_HANDLE)
+  {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -318,7 +331,7 @@ void CoreVuDevice::createCommandPool()
 
 void CoreVuDevice::createSurface()
 {
-  window.CreateWindowSurface(instance, &surface_);
+  window->CreateWindowSurface(instance, &surface_);
 }
 
 bool CoreVuDevice::isDeviceSuitable(VkPhysicalDevice device)
@@ -327,8 +340,9 @@ bool CoreVuDevice::isDeviceSuitable(VkPhysicalDevice device)
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported)
+  // headless devices present nothing
+  bool swapChainAdequate = isHeadless();
+  if (extensionsSupported && !isHeadless())
   {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() &&
@@ -401,12 +415,14 @@ bool CoreVuDevice::checkValidationLayerSupport()
 
 std::vector<const char*> CoreVuDevice::getRequiredExtensions()
 {
-  uint32_t glfwExtensionCount = 0;
-  const char** glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char*> extensions(
-      glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char*> extensions{};
+  if (!isHeadless())
+  {
+    uint32_t glfwExtensionCount = 0;
+    const char** glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers)
   {
@@ -479,14 +495,27 @@ QueueFamilyIndices CoreVuDevice::findQueueFamilies(VkPhysicalDevice device)
   int i = 0;
   for (const auto& queueFamily : queueFamilies)
   {
+    // compute work(particles) is recorded into the graphics command buffers
+    const VkQueueFlags graphicsCompute =
+        VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
     if (queueFamily.queueCount > 0 &&
-        queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        (queueFamily.queueFlags & graphicsCompute) == graphicsCompute)
     {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
     }
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    if (isHeadless())
+    {
+      // nothing is presented, the present queue is the graphics one
+      presentSupport = indices.graphicsFamilyHasValue &&
+                       indices.graphicsFamily == static_cast<uint32_t>(i);
+    }
+    else
+    {
+      vkGetPhysicalDeviceSurfaceSupportKHR(
+          device, i, surface_, &presentSupport);
+    }
     if (queueFamily.queueCount > 0 && presentSupport)
     {
       indices.presentFamily = i;
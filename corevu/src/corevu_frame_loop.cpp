@@ -0,0 +1,100 @@
+#include "corevu_frame_loop.hpp"
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+namespace corevu
+{
+
+namespace
+{
+// waitForRenderSlot() sleeps until this long before the deadline
+constexpr std::chrono::milliseconds SPIN_MARGIN{1};
+} // namespace
+
+CoreVuFrameLoop::CoreVuFrameLoop(float step, uint32_t max_steps)
+    : m_step{step}, m_max_steps{max_steps}, m_last_time{Clock::now()}
+{
+  assert(step > 0.f && "CoreVuFrameLoop step must be positive");
+  assert(max_steps > 0 && "CoreVuFrameLoop needs at least one step a frame");
+}
+
+uint32_t CoreVuFrameLoop::beginFrame()
+{
+  const auto now = Clock::now();
+  const float elapsed =
+      std::chrono::duration<float, std::chrono::seconds::period>(
+          now - m_last_time)
+          .count();
+  m_last_time = now;
+  return advance(elapsed);
+}
+
+uint32_t CoreVuFrameLoop::advance(float elapsed)
+{
+  m_frame_time = std::clamp(elapsed, 0.f, MAX_FRAME_TIME);
+  m_accumulator += m_frame_time;
+
+  const auto owed = static_cast<uint64_t>(m_accumulator / m_step);
+  m_step_count = static_cast<uint32_t>(
+      std::min<uint64_t>(owed, m_max_steps));
+  m_accumulator -= static_cast<double>(m_step_count) * m_step;
+
+  if (owed > m_max_steps)
+  {
+    // keep the fraction, drop the steps that did not fit
+    m_dropped_steps += owed - m_max_steps;
+    m_accumulator -= static_cast<double>(owed - m_max_steps) * m_step;
+  }
+  return m_step_count;
+}
+
+void CoreVuFrameLoop::reset()
+{
+  m_last_time = Clock::now();
+  m_accumulator = 0.0;
+  m_step_count = 0;
+}
+
+void CoreVuFrameLoop::setRenderRate(float rate)
+{
+  m_render_interval =
+      rate > 0.f
+          ? std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / rate))
+          : Clock::duration{0};
+  m_next_render = Clock::now() + m_render_interval;
+}
+
+void CoreVuFrameLoop::waitForRenderSlot()
+{
+  ZoneScoped;
+
+  if (m_render_interval == Clock::duration{0}) return;
+
+  const auto now = Clock::now();
+  if (now >= m_next_render)
+  {
+    // late, the next frame is due one interval from now and not earlier,
+    // otherwise a hitch would be followed by a burst of frames
+    m_next_render = now + m_render_interval;
+    return;
+  }
+
+  if (m_next_render - now > SPIN_MARGIN)
+  {
+    std::this_thread::sleep_until(m_next_render - SPIN_MARGIN);
+  }
+  while (Clock::now() < m_next_render)
+  {
+    std::this_thread::yield();
+  }
+  m_next_render += m_render_interval;
+}
+
+} // namespace corevu
@@ -1,4 +1,6 @@
 #include "corevu_model.hpp"
+#include <geometry/corevu_mesh_bvh.hpp>
+#include <geometry/corevu_mesh_simplify.hpp>
 #include <global_utils.hpp>
 
 // libs
@@ -9,7 +11,9 @@
 #include <glm/gtx/hash.hpp>
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <unordered_map>
 #include <iostream>
 
@@ -30,22 +34,69 @@ struct hash<corevu::CoreVuModel::Vertex>
 
 using namespace corevu;
 
+namespace
+{
+/* Sphere around the box center, a bit larger than the minimal one but stable:
+ * the same vertices always give the same sphere. */
+void ComputeBounds(
+    const std::vector<CoreVuModel::Vertex>& vertices, CoreVuAabb& bounds,
+    CoreVuSphere& sphere)
+{
+  bounds = CoreVuAabb{};
+  for (const auto& vertex : vertices)
+  {
+    bounds.expand(vertex.position);
+  }
+  if (bounds.isEmpty())
+  {
+    sphere = CoreVuSphere{};
+    return;
+  }
+
+  float radius_squared = 0.f;
+  const glm::vec3 center = bounds.getCenter();
+  for (const auto& vertex : vertices)
+  {
+    const glm::vec3 offset = vertex.position - center;
+    radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+  }
+  sphere = CoreVuSphere{center, std::sqrt(radius_squared)};
+}
+} // namespace
+
 CoreVuModel::CoreVuModel(CoreVuDevice& device, const Builder& builder)
   : m_corevu_device{device}
 {
   createVertexBuffers(builder.vertices);
   createIndexBuffers(builder.indices);
+
+  m_lods = builder.lods;
+  if (m_lods.empty())
+  {
+    m_lods.push_back(Lod{0, m_index_count, 0.f});
+  }
+
+  m_bvh = builder.bvh;
+  m_bounds = builder.bounds;
+  m_bounding_sphere = builder.bounding_sphere;
+  if (m_bounds.isEmpty())
+  {
+    // vertices filled by hand, bounds were never computed
+    ComputeBounds(builder.vertices, m_bounds, m_bounding_sphere);
+  }
 }
 
 CoreVuModel::~CoreVuModel()
 {
 }
 
-void CoreVuModel::Draw(VkCommandBuffer command_buffer)
+void CoreVuModel::Draw(VkCommandBuffer command_buffer, uint32_t lod)
 {
   if (m_had_index_buffer)
   {
-    vkCmdDrawIndexed(command_buffer, m_index_count, 1, 0, 0, 0);
+    const Lod& range = m_lods[std::min(lod, GetLodCount() - 1)];
+    vkCmdDrawIndexed(
+        command_buffer, range.index_count, 1, range.first_index, 0, 0);
   }
   else
   {
@@ -54,16 +105,45 @@ void CoreVuModel::Draw(VkCommandBuffer command_buffer)
 }
 
 std::shared_ptr<CoreVuModel> corevu::CoreVuModel::CreateModelFromPath(
-    CoreVuDevice& device, const std::string& path)
+    CoreVuDevice& device, const std::string& path,
+    CoreVuJobSystem* bvh_job_system)
 {
   Builder builder{};
   builder.loadModel(path);
+  builder.generateLods();
+  if (bvh_job_system != nullptr)
+  {
+    builder.buildBvh(bvh_job_system);
+  }
   std::cout << "Load Model:" << path
-            << " vertex count:" << builder.vertices.size() << std::endl;
+            << " vertex count:" << builder.vertices.size()
+            << " lods:" << std::max<size_t>(builder.lods.size(), 1)
+            << " bvh nodes:"
+            << (builder.bvh ? builder.bvh->getNodes().size() : 0)
+            << std::endl;
 
   return std::make_shared<CoreVuModel>(device, builder);
 }
 
+uint32_t CoreVuModel::SelectLod(
+    std::span<const Lod> lods, float error_scale, float max_error,
+    float hysteresis, uint32_t previous)
+{
+  const float coarser_limit = max_error * (1.f - hysteresis);
+  const float finer_limit = max_error * (1.f + hysteresis);
+  const auto count = static_cast<uint32_t>(lods.size());
+  uint32_t lod = std::min(previous, count - 1);
+  while (lod + 1 < count && lods[lod + 1].error * error_scale <= coarser_limit)
+  {
+    lod++;
+  }
+  while (lod > 0 && lods[lod].error * error_scale > finer_limit)
+  {
+    lod--;
+  }
+  return lod;
+}
+
 void CoreVuModel::Bind(VkCommandBuffer command_buffer)
 {
   if (m_vertex_buffer)
@@ -315,4 +395,86 @@ void corevu::CoreVuModel::Builder::loadModel(const std::string& filename)
       indices.push_back(unique_vertices[vertex]);
     }
   }
+
+  computeBounds();
+}
+
+void corevu::CoreVuModel::Builder::computeBounds()
+{
+  ComputeBounds(vertices, bounds, bounding_sphere);
+}
+
+void corevu::CoreVuModel::Builder::generateLods()
+{
+  ZoneScoped;
+  lods.clear();
+  if (indices.empty())
+  {
+    return;
+  }
+
+  std::vector<glm::vec3> positions(vertices.size());
+  std::vector<glm::vec3> normals(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i)
+  {
+    positions[i] = vertices[i].position;
+    normals[i] = vertices[i].normal;
+  }
+  std::vector<uint32_t> full(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    full[i] = indices[i].value;
+  }
+
+  lods.push_back(Lod{0, static_cast<uint32_t>(full.size()), 0.f});
+  for (uint32_t level = 1; level < MAX_LODS; ++level)
+  {
+    // always from the full mesh, simplifying a simplified one adds up errors
+    const size_t target = (full.size() / 3 >> level) * 3;
+    if (target < MIN_LOD_TRIANGLES * 3) break;
+
+    float error = 0.f;
+    const std::vector<uint32_t> lod_indices =
+        SimplifyMesh(positions, normals, full, target, &error);
+    if (lod_indices.size() * 4 > lods.back().index_count * 3) break;
+
+    lods.push_back(Lod{
+        static_cast<uint32_t>(indices.size()),
+        static_cast<uint32_t>(lod_indices.size()),
+        std::max(error, lods.back().error)});
+    indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+  }
+}
+
+void corevu::CoreVuModel::Builder::buildBvh(CoreVuJobSystem* job_system)
+{
+  ZoneScoped;
+  std::vector<glm::vec3> positions(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i)
+  {
+    positions[i] = vertices[i].position;
+  }
+
+  // LOD 0 only, the other ones are coarser copies behind it
+  std::vector<uint32_t> full;
+  if (indices.empty())
+  {
+    full.resize(vertices.size() - vertices.size() % 3);
+    for (size_t i = 0; i < full.size(); ++i)
+    {
+      full[i] = static_cast<uint32_t>(i);
+    }
+  }
+  else
+  {
+    full.resize(lods.empty() ? indices.size() : lods[0].index_count);
+    for (size_t i = 0; i < full.size(); ++i)
+    {
+      full[i] = indices[i].value;
+    }
+  }
+
+  auto mesh_bvh = std::make_shared<CoreVuMeshBvh>();
+  mesh_bvh->build(positions, full, job_system);
+  bvh = std::move(mesh_bvh);
 }
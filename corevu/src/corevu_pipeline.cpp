@@ -272,3 +272,59 @@ void CoreVuPipeline::createShaderModule(
     throw std::runtime_error("FAILURE::can't create shader module");
   }
 }
+
+CoreVuComputePipeline::CoreVuComputePipeline(
+    CoreVuDevice& device, VkPipelineLayout pipeline_layout,
+    const std::string& comp_filepath)
+  : m_device{device}
+{
+  assert(
+      pipeline_layout != VK_NULL_HANDLE &&
+      "ASSERT::can't create compute pipeline::no pipeline layout provided.");
+
+  auto comp_code = CoreVuPipeline::readFile(comp_filepath);
+  std::cout << "file is read for " << comp_filepath << " "
+            << (int)comp_code.size() << std::endl;
+
+  VkShaderModuleCreateInfo module_info{};
+  module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  module_info.codeSize = comp_code.size();
+  module_info.pCode = reinterpret_cast<const uint32_t*>(comp_code.data());
+  if (vkCreateShaderModule(
+          m_device.device(), &module_info, nullptr,
+          &m_vulkan_comp_shader_module) != VK_SUCCESS)
+  {
+    throw std::runtime_error("FAILURE::can't create shader module");
+  }
+
+  VkComputePipelineCreateInfo pipeline_info{};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = m_vulkan_comp_shader_module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.layout = pipeline_layout;
+  pipeline_info.basePipelineIndex = -1;
+  pipeline_info.basePipelineHandle = VK_NULL_HANDLE;
+
+  if (vkCreateComputePipelines(
+          m_device.device(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr,
+          &m_compute_pipeline) != VK_SUCCESS)
+  {
+    throw std::runtime_error("FAILURE::can't create compute pipeline");
+  }
+}
+
+CoreVuComputePipeline::~CoreVuComputePipeline()
+{
+  vkDestroyShaderModule(
+      m_device.device(), m_vulkan_comp_shader_module, nullptr);
+  vkDestroyPipeline(m_device.device(), m_compute_pipeline, nullptr);
+}
+
+void CoreVuComputePipeline::Bind(VkCommandBuffer command_buffer)
+{
+  vkCmdBindPipeline(
+      command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_compute_pipeline);
+}
@@ -0,0 +1,353 @@
+#include "culling/corevu_occlusion_buffer.hpp"
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+// SSE2 is part of every x86-64 target, no extra compile flags needed
+#if defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COREVU_OCCLUSION_SSE 1
+#include <emmintrin.h>
+#else
+#define COREVU_OCCLUSION_SSE 0
+#endif
+
+namespace corevu
+{
+namespace
+{
+// clip w below it counts as behind the camera
+constexpr float MIN_CLIP_W = 1e-5f;
+// twice the pixel area a triangle needs to be rasterized
+constexpr float MIN_AREA = 1e-6f;
+
+glm::vec3 ToScreen(const glm::vec4& clip)
+{
+  const float inverse_w = 1.f / clip.w;
+  return glm::vec3{
+      (clip.x * inverse_w * .5f + .5f) *
+          static_cast<float>(CoreVuOcclusionBuffer::WIDTH),
+      (clip.y * inverse_w * .5f + .5f) *
+          static_cast<float>(CoreVuOcclusionBuffer::HEIGHT),
+      clip.z * inverse_w};
+}
+} // namespace
+
+CoreVuOccluderMesh CoreVuOccluderMesh::Box(const CoreVuAabb& box)
+{
+  CoreVuOccluderMesh mesh{};
+  mesh.positions = {
+      {box.min.x, box.min.y, box.min.z}, {box.max.x, box.min.y, box.min.z},
+      {box.max.x, box.max.y, box.min.z}, {box.min.x, box.max.y, box.min.z},
+      {box.min.x, box.min.y, box.max.z}, {box.max.x, box.min.y, box.max.z},
+      {box.max.x, box.max.y, box.max.z}, {box.min.x, box.max.y, box.max.z}};
+  // both windings are rasterized, only the faces matter
+  mesh.indices = {0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 4, 5, 0, 5, 1,
+                  3, 2, 6, 3, 6, 7, 0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2};
+  return mesh;
+}
+
+CoreVuAabb CoreVuOccluderMesh::getBounds() const
+{
+  CoreVuAabb bounds{};
+  for (const auto& position : positions)
+  {
+    bounds.expand(position);
+  }
+  return bounds;
+}
+
+CoreVuOcclusionBuffer::CoreVuOcclusionBuffer()
+    : m_depth(WIDTH * HEIGHT, 1.f), m_tile_depth(TILES_X * TILES_Y, 1.f)
+{
+}
+
+void CoreVuOcclusionBuffer::begin(const glm::mat4& view_projection)
+{
+  m_view_projection = view_projection;
+  m_triangles.clear();
+  std::fill(m_depth.begin(), m_depth.end(), 1.f);
+  std::fill(m_tile_depth.begin(), m_tile_depth.end(), 1.f);
+}
+
+bool CoreVuOcclusionBuffer::addOccluder(
+    const CoreVuOccluderMesh& mesh, const glm::mat4& world)
+{
+  assert(mesh.indices.size() % 3 == 0 && "Occluder mesh is not triangles");
+  const size_t triangle_count = mesh.indices.size() / 3;
+  if (m_triangles.size() + triangle_count > m_triangle_budget)
+  {
+    return false;
+  }
+
+  const glm::mat4 transform = m_view_projection * world;
+  m_clip.resize(mesh.positions.size());
+  for (size_t i = 0; i < mesh.positions.size(); ++i)
+  {
+    m_clip[i] = transform * glm::vec4{mesh.positions[i], 1.f};
+  }
+
+  const float width = static_cast<float>(WIDTH);
+  const float height = static_cast<float>(HEIGHT);
+  for (size_t t = 0; t < triangle_count; ++t)
+  {
+    const glm::vec4& c0 = m_clip[mesh.indices[t * 3 + 0]];
+    const glm::vec4& c1 = m_clip[mesh.indices[t * 3 + 1]];
+    const glm::vec4& c2 = m_clip[mesh.indices[t * 3 + 2]];
+    if (c0.w < MIN_CLIP_W || c1.w < MIN_CLIP_W || c2.w < MIN_CLIP_W)
+    {
+      continue;
+    }
+
+    glm::vec3 v0 = ToScreen(c0);
+    glm::vec3 v1 = ToScreen(c1);
+    glm::vec3 v2 = ToScreen(c2);
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (std::abs(area) < MIN_AREA)
+    {
+      continue;
+    }
+    if (area < 0.f)
+    {
+      std::swap(v1, v2);
+      area = -area;
+    }
+
+    const float min_x = std::min({v0.x, v1.x, v2.x});
+    const float max_x = std::max({v0.x, v1.x, v2.x});
+    const float min_y = std::min({v0.y, v1.y, v2.y});
+    const float max_y = std::max({v0.y, v1.y, v2.y});
+    if (max_x < 0.f || max_y < 0.f || min_x >= width || min_y >= height ||
+        std::min({v0.z, v1.z, v2.z}) > 1.f)
+    {
+      continue;
+    }
+
+    Triangle triangle{};
+    const glm::vec3* vertices[3] = {&v0, &v1, &v2};
+    for (int e = 0; e < 3; ++e)
+    {
+      const glm::vec3& from = *vertices[e];
+      const glm::vec3& to = *vertices[(e + 1) % 3];
+      triangle.a[e] = from.y - to.y;
+      triangle.b[e] = to.x - from.x;
+      triangle.c[e] = from.x * to.y - to.x * from.y;
+    }
+    const float inverse_area = 1.f / area;
+    triangle.z_a = ((v1.z - v0.z) * (v2.y - v0.y) -
+                    (v2.z - v0.z) * (v1.y - v0.y)) *
+                   inverse_area;
+    triangle.z_b = ((v2.z - v0.z) * (v1.x - v0.x) -
+                    (v1.z - v0.z) * (v2.x - v0.x)) *
+                   inverse_area;
+    triangle.z_c = v0.z - triangle.z_a * v0.x - triangle.z_b * v0.y;
+    triangle.min_x = std::max(static_cast<int32_t>(std::floor(min_x)), 0);
+    triangle.max_x = std::min(
+        static_cast<int32_t>(std::ceil(max_x)),
+        static_cast<int32_t>(WIDTH) - 1);
+    triangle.min_y = std::max(static_cast<int32_t>(std::floor(min_y)), 0);
+    triangle.max_y = std::min(
+        static_cast<int32_t>(std::ceil(max_y)),
+        static_cast<int32_t>(HEIGHT) - 1);
+    m_triangles.push_back(triangle);
+  }
+  return true;
+}
+
+void CoreVuOcclusionBuffer::rasterize(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  job_system.parallelFor(
+      HEIGHT / BAND_HEIGHT, 1,
+      [this](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t band = begin; band < end; ++band)
+        {
+          rasterizeBand(band);
+        }
+      });
+}
+
+void CoreVuOcclusionBuffer::rasterizeBand(uint32_t band)
+{
+  const int32_t band_min_y = static_cast<int32_t>(band * BAND_HEIGHT);
+  const int32_t band_max_y = band_min_y + static_cast<int32_t>(BAND_HEIGHT) - 1;
+
+  for (const Triangle& triangle : m_triangles)
+  {
+    const int32_t min_y = std::max(triangle.min_y, band_min_y);
+    const int32_t max_y = std::min(triangle.max_y, band_max_y);
+    // whole SSE registers, WIDTH is a multiple of 4
+    const int32_t min_x = triangle.min_x & ~3;
+
+    for (int32_t y = min_y; y <= max_y; ++y)
+    {
+      const float center_y = static_cast<float>(y) + .5f;
+      const float start_x = static_cast<float>(min_x) + .5f;
+      float* row = m_depth.data() + static_cast<size_t>(y) * WIDTH;
+      float edge[3];
+      for (int e = 0; e < 3; ++e)
+      {
+        edge[e] =
+            triangle.a[e] * start_x + triangle.b[e] * center_y + triangle.c[e];
+      }
+      const float depth =
+          triangle.z_a * start_x + triangle.z_b * center_y + triangle.z_c;
+
+#if COREVU_OCCLUSION_SSE
+      const __m128 lane = _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+      const __m128 zero = _mm_setzero_ps();
+      __m128 e0 = _mm_add_ps(
+          _mm_set1_ps(edge[0]), _mm_mul_ps(_mm_set1_ps(triangle.a[0]), lane));
+      __m128 e1 = _mm_add_ps(
+          _mm_set1_ps(edge[1]), _mm_mul_ps(_mm_set1_ps(triangle.a[1]), lane));
+      __m128 e2 = _mm_add_ps(
+          _mm_set1_ps(edge[2]), _mm_mul_ps(_mm_set1_ps(triangle.a[2]), lane));
+      __m128 z = _mm_add_ps(
+          _mm_set1_ps(depth), _mm_mul_ps(_mm_set1_ps(triangle.z_a), lane));
+      const __m128 step0 = _mm_set1_ps(triangle.a[0] * 4.f);
+      const __m128 step1 = _mm_set1_ps(triangle.a[1] * 4.f);
+      const __m128 step2 = _mm_set1_ps(triangle.a[2] * 4.f);
+      const __m128 step_z = _mm_set1_ps(triangle.z_a * 4.f);
+
+      for (int32_t x = min_x; x <= triangle.max_x; x += 4)
+      {
+        const __m128 inside = _mm_and_ps(
+            _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+            _mm_cmpge_ps(e2, zero));
+        if (_mm_movemask_ps(inside) != 0)
+        {
+          const __m128 old_depth = _mm_loadu_ps(row + x);
+          const __m128 new_depth = _mm_min_ps(old_depth, z);
+          _mm_storeu_ps(
+              row + x, _mm_or_ps(
+                           _mm_and_ps(inside, new_depth),
+                           _mm_andnot_ps(inside, old_depth)));
+        }
+        e0 = _mm_add_ps(e0, step0);
+        e1 = _mm_add_ps(e1, step1);
+        e2 = _mm_add_ps(e2, step2);
+        z = _mm_add_ps(z, step_z);
+      }
+#else
+      for (int32_t x = min_x; x <= triangle.max_x; ++x)
+      {
+        const float dx = static_cast<float>(x - min_x);
+        if (edge[0] + triangle.a[0] * dx >= 0.f &&
+            edge[1] + triangle.a[1] * dx >= 0.f &&
+            edge[2] + triangle.a[2] * dx >= 0.f)
+        {
+          row[x] = std::min(row[x], depth + triangle.z_a * dx);
+        }
+      }
+#endif
+    }
+  }
+
+  for (uint32_t tile_row = band_min_y / TILE_SIZE;
+       tile_row < (band_max_y + 1) / TILE_SIZE; ++tile_row)
+  {
+    updateTiles(tile_row);
+  }
+}
+
+void CoreVuOcclusionBuffer::updateTiles(uint32_t tile_row)
+{
+  for (uint32_t tile_x = 0; tile_x < TILES_X; ++tile_x)
+  {
+    float farthest = 0.f;
+    for (uint32_t y = 0; y < TILE_SIZE; ++y)
+    {
+      const float* row = m_depth.data() +
+                         (tile_row * TILE_SIZE + y) * WIDTH +
+                         tile_x * TILE_SIZE;
+      for (uint32_t x = 0; x < TILE_SIZE; ++x)
+      {
+        farthest = std::max(farthest, row[x]);
+      }
+    }
+    m_tile_depth[tile_row * TILES_X + tile_x] = farthest;
+  }
+}
+
+bool CoreVuOcclusionBuffer::isVisible(const CoreVuAabb& world_box) const
+{
+  glm::vec2 screen_min{std::numeric_limits<float>::max()};
+  glm::vec2 screen_max{std::numeric_limits<float>::lowest()};
+  float nearest = std::numeric_limits<float>::max();
+  // the transform is linear: min corner + the scaled matrix columns
+  const glm::vec3 size = world_box.max - world_box.min;
+  const glm::vec4 origin = m_view_projection[0] * world_box.min.x +
+                           m_view_projection[1] * world_box.min.y +
+                           m_view_projection[2] * world_box.min.z +
+                           m_view_projection[3];
+  const glm::vec4 axis_x = m_view_projection[0] * size.x;
+  const glm::vec4 axis_y = m_view_projection[1] * size.y;
+  const glm::vec4 axis_z = m_view_projection[2] * size.z;
+  for (int corner = 0; corner < 8; ++corner)
+  {
+    glm::vec4 clip = origin;
+    if (corner & 1) clip += axis_x;
+    if (corner & 2) clip += axis_y;
+    if (corner & 4) clip += axis_z;
+    if (clip.w < MIN_CLIP_W)
+    {
+      // reaching behind the camera
+      return true;
+    }
+    const glm::vec3 screen = ToScreen(clip);
+    screen_min = glm::min(screen_min, glm::vec2{screen});
+    screen_max = glm::max(screen_max, glm::vec2{screen});
+    nearest = std::min(nearest, screen.z);
+  }
+
+  // every pixel whose center might be covered
+  const int32_t min_x = std::max(
+      static_cast<int32_t>(std::floor(screen_min.x - .5f)), 0);
+  const int32_t max_x = std::min(
+      static_cast<int32_t>(std::ceil(screen_max.x - .5f)),
+      static_cast<int32_t>(WIDTH) - 1);
+  const int32_t min_y = std::max(
+      static_cast<int32_t>(std::floor(screen_min.y - .5f)), 0);
+  const int32_t max_y = std::min(
+      static_cast<int32_t>(std::ceil(screen_max.y - .5f)),
+      static_cast<int32_t>(HEIGHT) - 1);
+  if (min_x > max_x || min_y > max_y)
+  {
+    // in front of the camera and off screen, a sphere that passed the frustum
+    // test with a box next to the screen
+    return false;
+  }
+
+  const int32_t tile = static_cast<int32_t>(TILE_SIZE);
+  for (int32_t tile_y = min_y / tile; tile_y <= max_y / tile; ++tile_y)
+  {
+    for (int32_t tile_x = min_x / tile; tile_x <= max_x / tile; ++tile_x)
+    {
+      if (m_tile_depth[tile_y * TILES_X + tile_x] < nearest)
+      {
+        // all pixels of the tile are in front
+        continue;
+      }
+      const int32_t y_end = std::min(max_y, tile_y * tile + tile - 1);
+      const int32_t x_end = std::min(max_x, tile_x * tile + tile - 1);
+      for (int32_t y = std::max(min_y, tile_y * tile); y <= y_end; ++y)
+      {
+        const float* row = m_depth.data() + static_cast<size_t>(y) * WIDTH;
+        for (int32_t x = std::max(min_x, tile_x * tile); x <= x_end; ++x)
+        {
+          if (row[x] >= nearest) return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace corevu
@@ -0,0 +1,424 @@
+#include <debug/corevu_alloc_tracker.hpp>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#if COREVU_TRACK_ALLOCATIONS
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <dbghelp.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "dbghelp.lib")
+#endif
+#define COREVU_ALLOC_STACKS 1
+#elif defined(__GLIBC__) || defined(__APPLE__)
+#include <cxxabi.h>
+#include <execinfo.h>
+#define COREVU_ALLOC_STACKS 1
+#else
+#define COREVU_ALLOC_STACKS 0
+#endif
+#endif
+
+namespace corevu
+{
+namespace
+{
+// scope of the allocations of a thread, see CoreVuAllocScope
+thread_local const char* t_scope = nullptr;
+
+#if COREVU_TRACK_ALLOCATIONS
+// no allocation counted while a thread is inside the tracker(recursion)
+thread_local bool t_inside = false;
+
+// CaptureStack, Record and Allocate never inlined, the stacks start at the
+// operator new called, whatever the optimizer did to its callers
+#ifdef _MSC_VER
+#define COREVU_NOINLINE __declspec(noinline)
+#else
+#define COREVU_NOINLINE __attribute__((noinline))
+#endif
+constexpr uint32_t SKIPPED_STACK_FRAMES = 3;
+
+struct Site
+{
+  uint64_t hash;
+  const char* scope;
+  uint32_t frame_count;
+  void* frames[CoreVuAllocTracker::MAX_STACK_FRAMES];
+  uint64_t count;
+  uint64_t bytes;
+};
+
+std::atomic<uint32_t> s_open_frames{0};
+std::atomic<uint64_t> s_count{0};
+std::atomic<uint64_t> s_bytes{0};
+std::mutex s_sites_mutex; // guards the sites
+Site s_sites[CoreVuAllocTracker::MAX_SITES];
+uint32_t s_site_count = 0;
+uint64_t s_dropped_sites = 0; // allocations of sites that did not fit
+
+COREVU_NOINLINE uint32_t CaptureStack(void** frames)
+{
+#if COREVU_ALLOC_STACKS && defined(_WIN32)
+  return RtlCaptureStackBackTrace(
+      SKIPPED_STACK_FRAMES, CoreVuAllocTracker::MAX_STACK_FRAMES, frames,
+      nullptr);
+#elif COREVU_ALLOC_STACKS
+  void* stack[CoreVuAllocTracker::MAX_STACK_FRAMES + SKIPPED_STACK_FRAMES];
+  const int depth = backtrace(
+      stack, CoreVuAllocTracker::MAX_STACK_FRAMES + SKIPPED_STACK_FRAMES);
+  const uint32_t count =
+      static_cast<uint32_t>(std::max(depth, 0)) > SKIPPED_STACK_FRAMES
+          ? static_cast<uint32_t>(depth) - SKIPPED_STACK_FRAMES
+          : 0;
+  std::copy_n(stack + SKIPPED_STACK_FRAMES, count, frames);
+  return count;
+#else
+  (void)frames;
+  return 0;
+#endif
+}
+
+COREVU_NOINLINE void Record(size_t size)
+{
+  if (s_open_frames.load(std::memory_order_relaxed) == 0 || t_inside) return;
+  t_inside = true;
+  s_count.fetch_add(1, std::memory_order_relaxed);
+  s_bytes.fetch_add(size, std::memory_order_relaxed);
+
+  Site site{};
+  site.scope = t_scope;
+  site.frame_count = CaptureStack(site.frames);
+  // fnv-1a over the return addresses and the scope
+  site.hash = 0xCBF29CE484222325ull ^ reinterpret_cast<uintptr_t>(t_scope);
+  for (uint32_t i = 0; i < site.frame_count; ++i)
+  {
+    site.hash ^= reinterpret_cast<uintptr_t>(site.frames[i]);
+    site.hash *= 0x100000001B3ull;
+  }
+
+  {
+    std::lock_guard lock{s_sites_mutex};
+    Site* const end = s_sites + s_site_count;
+    Site* found = std::find_if(
+        s_sites, end,
+        [&](const Site& other) { return other.hash == site.hash; });
+    if (found == end && s_site_count < CoreVuAllocTracker::MAX_SITES)
+    {
+      *found = site;
+      s_site_count++;
+    }
+    if (found != s_sites + CoreVuAllocTracker::MAX_SITES)
+    {
+      found->count++;
+      found->bytes += size;
+    }
+    else
+    {
+      s_dropped_sites++;
+    }
+  }
+  t_inside = false;
+}
+
+void PrintFrame(std::ostream& out, void* address)
+{
+  char line[512];
+#if COREVU_ALLOC_STACKS && defined(_WIN32)
+  static const bool initialized =
+      SymInitialize(GetCurrentProcess(), nullptr, TRUE) != FALSE;
+  alignas(SYMBOL_INFO) char buffer[sizeof(SYMBOL_INFO) + 256];
+  auto* symbol = reinterpret_cast<SYMBOL_INFO*>(buffer);
+  symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+  symbol->MaxNameLen = 255;
+  DWORD64 displacement = 0;
+  IMAGEHLP_LINE64 source{};
+  source.SizeOfStruct = sizeof(source);
+  DWORD line_displacement = 0;
+  const auto process = GetCurrentProcess();
+  const auto address64 = reinterpret_cast<DWORD64>(address);
+  if (initialized &&
+      SymGetLineFromAddr64(process, address64, &line_displacement, &source) &&
+      SymFromAddr(process, address64, &displacement, symbol))
+  {
+    std::snprintf(
+        line, sizeof(line), "%s %s:%lu", symbol->Name, source.FileName,
+        static_cast<unsigned long>(source.LineNumber));
+  }
+  else if (
+      initialized && SymFromAddr(process, address64, &displacement, symbol))
+  {
+    std::snprintf(line, sizeof(line), "%s", symbol->Name);
+  }
+  else
+  {
+    std::snprintf(line, sizeof(line), "%p", address);
+  }
+#elif COREVU_ALLOC_STACKS
+  // "binary(mangled+0x1f) [0x...]", the mangled name is demangled
+  char** symbols = backtrace_symbols(&address, 1);
+  std::snprintf(line, sizeof(line), "%s", symbols ? symbols[0] : "?");
+  char* begin = symbols ? std::strchr(symbols[0], '(') : nullptr;
+  char* end = begin ? std::strchr(begin, '+') : nullptr;
+  if (begin && end && end > begin + 1)
+  {
+    *end = '\0';
+    int status = -1;
+    char* name = abi::__cxa_demangle(begin + 1, nullptr, nullptr, &status);
+    if (status == 0)
+    {
+      std::snprintf(line, sizeof(line), "%s", name);
+    }
+    std::free(name);
+  }
+  std::free(symbols);
+#else
+  std::snprintf(line, sizeof(line), "%p", address);
+#endif
+  out << "      at " << line << '\n';
+}
+#endif
+} // namespace
+
+void CoreVuAllocTracker::beginFrame()
+{
+#if COREVU_TRACK_ALLOCATIONS
+  s_open_frames.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+void CoreVuAllocTracker::endFrame()
+{
+#if COREVU_TRACK_ALLOCATIONS
+  const auto open = s_open_frames.fetch_sub(1, std::memory_order_relaxed);
+  (void)open;
+  assert(open > 0 && "CoreVuAllocTracker::endFrame without beginFrame");
+#endif
+}
+
+uint64_t CoreVuAllocTracker::getAllocationCount()
+{
+#if COREVU_TRACK_ALLOCATIONS
+  return s_count.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+uint64_t CoreVuAllocTracker::getAllocatedBytes()
+{
+#if COREVU_TRACK_ALLOCATIONS
+  return s_bytes.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+void CoreVuAllocTracker::reset()
+{
+#if COREVU_TRACK_ALLOCATIONS
+  std::lock_guard lock{s_sites_mutex};
+  s_count.store(0, std::memory_order_relaxed);
+  s_bytes.store(0, std::memory_order_relaxed);
+  s_site_count = 0;
+  s_dropped_sites = 0;
+#endif
+}
+
+void CoreVuAllocTracker::report(std::ostream& out)
+{
+#if COREVU_TRACK_ALLOCATIONS
+  const bool inside = t_inside;
+  t_inside = true; // the report allocates itself
+
+  // copied, frames may still be running
+  static Site sites[MAX_SITES];
+  uint32_t site_count = 0;
+  uint64_t dropped = 0;
+  {
+    std::lock_guard lock{s_sites_mutex};
+    site_count = s_site_count;
+    dropped = s_dropped_sites;
+    std::copy_n(s_sites, site_count, sites);
+  }
+  std::sort(
+      sites, sites + site_count,
+      [](const Site& a, const Site& b) { return a.count > b.count; });
+
+  out << "Frame allocations: " << getAllocationCount() << " in "
+      << getAllocatedBytes() << " bytes, " << site_count << " call sites";
+  if (dropped > 0)
+  {
+    out << ", " << dropped << " more allocations at sites not kept";
+  }
+  out << '\n';
+  for (uint32_t i = 0; i < site_count; ++i)
+  {
+    const Site& site = sites[i];
+    out << "  " << site.count << " allocations, " << site.bytes
+        << " bytes in " << (site.scope ? site.scope : "no scope") << '\n';
+    for (uint32_t frame = 0; frame < site.frame_count; ++frame)
+    {
+      PrintFrame(out, site.frames[frame]);
+    }
+  }
+  t_inside = inside;
+#else
+  out << "Frame allocations: not tracked, build with "
+         "COREVU_TRACK_ALLOCATIONS\n";
+#endif
+}
+
+CoreVuAllocScope::CoreVuAllocScope(const char* name) : m_previous{t_scope}
+{
+  t_scope = name;
+}
+
+CoreVuAllocScope::~CoreVuAllocScope()
+{
+  t_scope = m_previous;
+}
+} // namespace corevu
+
+#if COREVU_TRACK_ALLOCATIONS
+namespace
+{
+COREVU_NOINLINE void* Allocate(size_t size)
+{
+  void* memory = std::malloc(size > 0 ? size : 1);
+  corevu::Record(size);
+  return memory;
+}
+
+COREVU_NOINLINE void* AllocateAligned(
+    size_t size, std::align_val_t alignment)
+{
+  const auto align = static_cast<size_t>(alignment);
+  // new of 0 bytes must still return a unique pointer, aligned_alloc may
+  // return nullptr for 0 which would throw bad_alloc
+  const size_t bytes = size > 0 ? size : 1;
+#ifdef _WIN32
+  void* memory = _aligned_malloc(bytes, align);
+#else
+  // aligned_alloc wants a multiple of the alignment
+  void* memory = std::aligned_alloc(align, (bytes + align - 1) / align * align);
+#endif
+  corevu::Record(size);
+  return memory;
+}
+
+void FreeAligned(void* memory)
+{
+#ifdef _WIN32
+  _aligned_free(memory);
+#else
+  std::free(memory);
+#endif
+}
+} // namespace
+
+// the replaced global allocation functions, all forms go through the above
+void* operator new(size_t size)
+{
+  if (void* memory = Allocate(size)) return memory;
+  throw std::bad_alloc{};
+}
+void* operator new[](size_t size)
+{
+  if (void* memory = Allocate(size)) return memory;
+  throw std::bad_alloc{};
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  if (void* memory = AllocateAligned(size, alignment)) return memory;
+  throw std::bad_alloc{};
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+  if (void* memory = AllocateAligned(size, alignment)) return memory;
+  throw std::bad_alloc{};
+}
+void* operator new(
+    size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return AllocateAligned(size, alignment);
+}
+void* operator new[](
+    size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return AllocateAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+void operator delete[](void* memory) noexcept
+{
+  std::free(memory);
+}
+void operator delete(void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+void operator delete[](void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+  std::free(memory);
+}
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+  std::free(memory);
+}
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+  FreeAligned(memory);
+}
+void operator delete(
+    void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  FreeAligned(memory);
+}
+void operator delete[](
+    void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  FreeAligned(memory);
+}
+#endif
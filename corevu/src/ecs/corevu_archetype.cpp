@@ -0,0 +1,230 @@
+#include <ecs/corevu_archetype.hpp>
+
+// libs
+#include <AlignedMemory.hpp>
+
+// std
+#include <cassert>
+#include <mutex>
+
+namespace corevu
+{
+
+// *************** Component Registry *********************
+
+namespace
+{
+std::array<ComponentInfo, MAX_COMPONENT_TYPES> g_component_infos{};
+size_t g_component_count = 0;
+std::mutex g_registry_mutex;
+} // namespace
+
+ComponentTypeId CoreVuComponentRegistry::registerInfo(ComponentInfo info)
+{
+  std::lock_guard<std::mutex> lock{g_registry_mutex};
+  assert(
+      g_component_count < MAX_COMPONENT_TYPES &&
+      "Too many component types, increase MAX_COMPONENT_TYPES");
+
+  info.id = static_cast<ComponentTypeId>(g_component_count);
+  g_component_infos[g_component_count] = info;
+  return static_cast<ComponentTypeId>(g_component_count++);
+}
+
+const ComponentInfo& CoreVuComponentRegistry::GetInfo(ComponentTypeId id)
+{
+  assert(id < g_component_count && "Unknown component type");
+  return g_component_infos[id];
+}
+
+size_t CoreVuComponentRegistry::GetRegisteredCount()
+{
+  std::lock_guard<std::mutex> lock{g_registry_mutex};
+  return g_component_count;
+}
+
+// *************** Archetype *********************
+
+CoreVuArchetype::CoreVuArchetype(const ComponentMask& mask) : m_mask{mask}
+{
+  for (ComponentTypeId id = 0; id < MAX_COMPONENT_TYPES; ++id)
+  {
+    if (mask.test(id))
+    {
+      m_column_indices[id] = static_cast<uint32_t>(m_types.size());
+      m_types.push_back(id);
+      m_component_sizes[id] = CoreVuComponentRegistry::GetInfo(id).size;
+    }
+  }
+
+  computeLayout();
+}
+
+CoreVuArchetype::~CoreVuArchetype()
+{
+  for (size_t chunk_index = 0; chunk_index < m_chunks.size(); ++chunk_index)
+  {
+    auto& chunk = m_chunks[chunk_index];
+    for (auto id : m_types)
+    {
+      const auto& info = CoreVuComponentRegistry::GetInfo(id);
+      auto* column = static_cast<uint8_t*>(getColumn(chunk_index, id));
+      for (uint32_t row = 0; row < chunk.count; ++row)
+      {
+        info.destroy(column + row * info.size);
+      }
+    }
+    freeChunk(chunk);
+  }
+  m_chunks.clear();
+
+  if (m_spare_chunk.memory != nullptr)
+  {
+    freeChunk(m_spare_chunk);
+  }
+}
+
+void CoreVuArchetype::computeLayout()
+{
+  static_assert(
+      std::atomic<ChangeVersion>::is_always_lock_free &&
+          sizeof(std::atomic<ChangeVersion>) == sizeof(ChangeVersion),
+      "Change versions are placed in chunk memory");
+  m_entities_offset = coremem::pointer_math::AlignUp(
+      sizeof(ChangeVersion) * m_types.size(), coremem::CACHE_LINE_SIZE);
+
+  auto layoutSize = [this](uint32_t capacity)
+  {
+    size_t offset = coremem::pointer_math::AlignUp(
+        m_entities_offset + sizeof(CoreVuEntity) * capacity,
+        coremem::CACHE_LINE_SIZE);
+    for (auto id : m_types)
+    {
+      const auto& info = CoreVuComponentRegistry::GetInfo(id);
+      // covers info.alignment, see CoreVuComponentRegistry::makeInfo
+      offset = coremem::pointer_math::AlignUp(offset, coremem::CACHE_LINE_SIZE);
+      m_column_offsets[id] = offset;
+      offset += info.size * capacity;
+    }
+    return offset;
+  };
+
+  size_t bytes_per_entity = sizeof(CoreVuEntity);
+  for (auto id : m_types)
+  {
+    bytes_per_entity += m_component_sizes[id];
+  }
+
+  // start with the unpadded estimate and shrink until columns incl. padding fit
+  uint32_t capacity = static_cast<uint32_t>(
+      (CHUNK_SIZE - m_entities_offset) / bytes_per_entity);
+  while (capacity > 0 && layoutSize(capacity) > CHUNK_SIZE)
+  {
+    capacity--;
+  }
+  assert(capacity > 0 && "Components of archetype don't fit into one chunk");
+
+  m_chunk_capacity = capacity;
+  layoutSize(capacity); // final column offsets
+}
+
+void CoreVuArchetype::freeChunk(Chunk& chunk)
+{
+  coremem::AlignedFree(chunk.memory);
+  chunk.memory = nullptr;
+  chunk.count = 0;
+}
+
+void CoreVuArchetype::setChunkChanged(size_t chunk, ChangeVersion version)
+{
+  auto* versions = getChangeVersions(chunk);
+  for (size_t i = 0; i < m_types.size(); ++i)
+  {
+    versions[i].store(version, std::memory_order_relaxed);
+  }
+}
+
+CoreVuArchetype::Slot CoreVuArchetype::allocateSlot(
+    CoreVuEntity entity, ChangeVersion version)
+{
+  if (m_chunks.empty() || m_chunks.back().count == m_chunk_capacity)
+  {
+    Chunk chunk{};
+    if (m_spare_chunk.memory != nullptr)
+    {
+      chunk = m_spare_chunk;
+      m_spare_chunk = Chunk{};
+    }
+    else
+    {
+      chunk.memory = static_cast<uint8_t*>(
+          coremem::AlignedAlloc(CHUNK_SIZE, coremem::CACHE_LINE_SIZE));
+      assert(chunk.memory != nullptr && "Unable to allocate ECS chunk");
+    }
+    chunk.count = 0;
+    auto* versions =
+        reinterpret_cast<std::atomic<ChangeVersion>*>(chunk.memory);
+    for (size_t i = 0; i < m_types.size(); ++i)
+    {
+      new (&versions[i]) std::atomic<ChangeVersion>{0};
+    }
+    m_chunks.push_back(chunk);
+  }
+
+  const uint32_t chunk_index = static_cast<uint32_t>(m_chunks.size() - 1);
+  auto& chunk = m_chunks.back();
+  const uint32_t row = chunk.count++;
+  getEntities(chunk_index)[row] = entity;
+  setChunkChanged(chunk_index, version);
+  m_entity_count++;
+
+  return Slot{chunk_index, row};
+}
+
+CoreVuEntity CoreVuArchetype::removeSlot(
+    const Slot& slot, ChangeVersion version)
+{
+  assert(slot.chunk < m_chunks.size() && slot.row < m_chunks[slot.chunk].count);
+
+  const uint32_t last_chunk = static_cast<uint32_t>(m_chunks.size() - 1);
+  const uint32_t last_row = m_chunks.back().count - 1;
+  const bool is_last = slot.chunk == last_chunk && slot.row == last_row;
+
+  CoreVuEntity moved_entity = NULL_ENTITY;
+  for (auto id : m_types)
+  {
+    const auto& info = CoreVuComponentRegistry::GetInfo(id);
+    void* dst = getComponent(slot, id);
+    info.destroy(dst);
+    if (!is_last)
+    {
+      void* src = getComponent(Slot{last_chunk, last_row}, id);
+      info.move_construct(dst, src);
+      info.destroy(src);
+    }
+  }
+
+  if (!is_last)
+  {
+    moved_entity = getEntities(last_chunk)[last_row];
+    getEntities(slot.chunk)[slot.row] = moved_entity;
+    setChunkChanged(slot.chunk, version);
+  }
+  // lost a row, the chunk is gone if it was the only one
+  setChunkChanged(last_chunk, version);
+
+  m_entity_count--;
+  if (--m_chunks.back().count == 0)
+  {
+    if (m_spare_chunk.memory == nullptr) { m_spare_chunk = m_chunks.back(); }
+    else
+    {
+      freeChunk(m_chunks.back());
+    }
+    m_chunks.pop_back();
+  }
+
+  return moved_entity;
+}
+
+} // namespace corevu
@@ -0,0 +1,62 @@
+#include <ecs/corevu_entity_allocator.hpp>
+
+// std
+#include <cassert>
+
+namespace corevu
+{
+
+CoreVuEntity CoreVuEntityAllocator::allocate()
+{
+  flush();
+  if (!m_free.empty())
+  {
+    const CoreVuEntity entity = m_free.back();
+    m_free.pop_back();
+    m_free_cursor.store(
+        static_cast<int64_t>(m_free.size()), std::memory_order_relaxed);
+    return entity;
+  }
+
+  assert(m_index_count < MAX_ENTITIES && "Out of entity ids");
+  return MakeEntity(m_index_count++, 0);
+}
+
+CoreVuEntity CoreVuEntityAllocator::reserve()
+{
+  const int64_t slot =
+      m_free_cursor.fetch_sub(1, std::memory_order_relaxed) - 1;
+  if (slot >= 0)
+  {
+    return m_free[static_cast<size_t>(slot)];
+  }
+
+  const uint32_t index =
+      m_index_count + m_reserved_new.fetch_add(1, std::memory_order_relaxed);
+  assert(index < MAX_ENTITIES && "Out of entity ids");
+  return MakeEntity(index, 0);
+}
+
+void CoreVuEntityAllocator::free(CoreVuEntity entity)
+{
+  flush();
+  m_free.push_back(
+      MakeEntity(GetEntityIndex(entity), GetEntityGeneration(entity) + 1));
+  m_free_cursor.store(
+      static_cast<int64_t>(m_free.size()), std::memory_order_relaxed);
+}
+
+void CoreVuEntityAllocator::flush()
+{
+  const int64_t cursor = m_free_cursor.load(std::memory_order_relaxed);
+  if (cursor < static_cast<int64_t>(m_free.size()))
+  {
+    m_free.resize(static_cast<size_t>(cursor > 0 ? cursor : 0));
+    m_free_cursor.store(
+        static_cast<int64_t>(m_free.size()), std::memory_order_relaxed);
+  }
+  m_index_count +=
+      m_reserved_new.exchange(0, std::memory_order_relaxed);
+}
+
+} // namespace corevu
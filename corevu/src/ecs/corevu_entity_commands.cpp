@@ -0,0 +1,188 @@
+#include <ecs/corevu_entity_commands.hpp>
+
+#include <ecs/corevu_world.hpp>
+#include <events/corevu_event_bus.hpp>
+#include <events/corevu_events.hpp>
+#include <jobs/corevu_job_system.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+namespace corevu
+{
+
+CoreVuEntityCommandBuffer::~CoreVuEntityCommandBuffer()
+{
+  clear();
+}
+
+CoreVuEntity CoreVuEntityCommandBuffer::reserveEntity(CoreVuWorld& world)
+{
+  return world.reserveEntity();
+}
+
+namespace
+{
+void RegisterEvents(CoreVuEventBus* event_bus)
+{
+  if (event_bus == nullptr) return;
+  event_bus->registerEvent<EntitySpawnedEvent>();
+  event_bus->registerEvent<EntityDespawnedEvent>();
+}
+} // namespace
+
+void CoreVuEntityCommandBuffer::apply(
+    CoreVuWorld& world, CoreVuEventBus* event_bus)
+{
+  RegisterEvents(event_bus);
+  applyCreates(world, event_bus);
+  applyChanges(world, event_bus);
+}
+
+void CoreVuEntityCommandBuffer::applyCreates(
+    CoreVuWorld& world, CoreVuEventBus* event_bus)
+{
+  for (size_t i = 0; i < m_commands.size(); ++i)
+  {
+    const auto& command = m_commands[i];
+    if (command.type != CommandType::Create) continue;
+
+    // the components of the entity follow its create command
+    size_t end = i + 1;
+    ComponentMask mask{};
+    while (end < m_commands.size() &&
+           m_commands[end].type == CommandType::CreateComponent)
+    {
+      mask.set(m_commands[end].id);
+      end++;
+    }
+
+    world.createReservedEntity(
+        command.entity, mask,
+        [&](ComponentTypeId id, void* memory)
+        {
+          for (size_t c = i + 1; c < end; ++c)
+          {
+            if (m_commands[c].id != id) continue;
+            CoreVuComponentRegistry::GetInfo(id).move_construct(
+                memory, m_commands[c].component);
+            return;
+          }
+        });
+    if (event_bus != nullptr)
+    {
+      event_bus->publish(EntitySpawnedEvent{command.entity});
+    }
+    i = end - 1;
+  }
+}
+
+void CoreVuEntityCommandBuffer::applyChanges(
+    CoreVuWorld& world, CoreVuEventBus* event_bus)
+{
+  for (auto& command : m_commands)
+  {
+    switch (command.type)
+    {
+    case CommandType::Create:
+    case CommandType::CreateComponent:
+      break; // done by applyCreates
+    case CommandType::Destroy:
+      if (world.isAlive(command.entity))
+      {
+        world.destroyEntity(command.entity);
+        if (event_bus != nullptr)
+        {
+          event_bus->publish(EntityDespawnedEvent{command.entity});
+        }
+      }
+      break;
+    case CommandType::AddComponent:
+      if (world.isAlive(command.entity))
+      {
+        world.addComponent(command.entity, command.id, command.component);
+      }
+      break;
+    case CommandType::RemoveComponent:
+      if (world.isAlive(command.entity))
+      {
+        world.removeComponent(command.entity, command.id);
+      }
+      break;
+    }
+  }
+  clear();
+}
+
+void* CoreVuEntityCommandBuffer::allocate(size_t size, size_t alignment)
+{
+  if (m_block < m_blocks.size())
+  {
+    const size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= BLOCK_SIZE)
+    {
+      m_offset = offset + size;
+      return m_blocks[m_block]->memory + offset;
+    }
+    m_block++;
+  }
+
+  if (m_block == m_blocks.size())
+  {
+    m_blocks.push_back(std::make_unique<Block>());
+  }
+  m_offset = size;
+  return m_blocks[m_block]->memory;
+}
+
+void CoreVuEntityCommandBuffer::clear()
+{
+  // moved-from components still have to be destroyed
+  for (const auto& command : m_commands)
+  {
+    if (command.component != nullptr)
+    {
+      CoreVuComponentRegistry::GetInfo(command.id).destroy(command.component);
+    }
+  }
+  m_commands.clear();
+  m_block = 0;
+  m_offset = 0;
+}
+
+CoreVuEntityCommands::CoreVuEntityCommands(CoreVuJobSystem& job_system)
+  : m_job_system{job_system}
+{
+  m_buffers.reserve(job_system.getThreadCount());
+  for (uint32_t i = 0; i < job_system.getThreadCount(); ++i)
+  {
+    m_buffers.push_back(std::make_unique<CoreVuEntityCommandBuffer>());
+  }
+}
+
+CoreVuEntityCommandBuffer& CoreVuEntityCommands::get()
+{
+  return *m_buffers[m_job_system.getThreadIndex()];
+}
+
+void CoreVuEntityCommands::apply(
+    CoreVuWorld& world, CoreVuEventBus* event_bus)
+{
+  ZoneScoped;
+  RegisterEvents(event_bus);
+
+  // entities of all buffers first, later commands may refer to any of them
+  for (auto& buffer : m_buffers)
+  {
+    buffer->applyCreates(world, event_bus);
+  }
+  for (auto& buffer : m_buffers)
+  {
+    if (!buffer->isEmpty())
+    {
+      buffer->applyChanges(world, event_bus);
+    }
+  }
+}
+
+} // namespace corevu
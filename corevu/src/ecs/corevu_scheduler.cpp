@@ -0,0 +1,150 @@
+#include <ecs/corevu_scheduler.hpp>
+#include <debug/corevu_alloc_tracker.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+
+namespace corevu
+{
+
+CoreVuScheduler::CoreVuScheduler(CoreVuJobSystem& job_system)
+  : m_job_system{job_system}, m_commands{job_system}
+{
+}
+
+CoreVuScheduler::SystemId CoreVuScheduler::addSystem(
+    std::string name, const CoreVuSystemAccess& access,
+    SystemFunction function)
+{
+  auto system = std::make_unique<System>();
+  system->access = access;
+  system->function = std::move(function);
+  system->timing.name = std::move(name);
+  m_systems.push_back(std::move(system));
+  return static_cast<SystemId>(m_systems.size() - 1);
+}
+
+void CoreVuScheduler::setEnabled(SystemId id, bool enabled)
+{
+  assert(id < m_systems.size() && "Unknown system");
+  m_systems[id]->enabled = enabled;
+}
+
+void CoreVuScheduler::buildGraph()
+{
+  for (auto& system : m_systems)
+  {
+    system->dependents.clear(); // keeps capacity between frames
+    system->dependency_count = 0;
+  }
+
+  for (SystemId later = 0; later < m_systems.size(); ++later)
+  {
+    auto& system = *m_systems[later];
+    if (!system.enabled) continue;
+
+    for (SystemId earlier = 0; earlier < later; ++earlier)
+    {
+      auto& other = *m_systems[earlier];
+      if (other.enabled && other.access.conflictsWith(system.access))
+      {
+        other.dependents.push_back(later);
+        system.dependency_count++;
+      }
+    }
+  }
+}
+
+void CoreVuScheduler::run(FrameInfo& frame_info)
+{
+  ZoneScoped;
+
+  buildGraph();
+
+  for (SystemId id = 0; id < m_systems.size(); ++id)
+  {
+    auto& system = *m_systems[id];
+    system.remaining.store(system.dependency_count, std::memory_order_relaxed);
+  }
+
+  for (SystemId id = 0; id < m_systems.size(); ++id)
+  {
+    auto& system = *m_systems[id];
+    if (system.enabled && system.dependency_count == 0)
+    {
+      m_job_system.run(
+          [this, id, &frame_info] { runSystem(id, frame_info); },
+          &m_frame_counter);
+    }
+  }
+
+  m_job_system.wait(m_frame_counter);
+  m_commands.apply(frame_info.world, &frame_info.event_bus);
+  frame_info.event_bus.dispatch();
+}
+
+void CoreVuScheduler::runSystem(SystemId id, FrameInfo& frame_info)
+{
+  auto& system = *m_systems[id];
+  {
+    ZoneScoped;
+    ZoneName(system.timing.name.c_str(), system.timing.name.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+      CoreVuAllocScope scope{system.timing.name.c_str()};
+      system.function(frame_info);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    auto& timing = system.timing;
+    timing.last_ms =
+        std::chrono::duration<double, std::milli>(end - start).count();
+    timing.total_ms += timing.last_ms;
+    timing.max_ms = std::max(timing.max_ms, timing.last_ms);
+    timing.frames++;
+  }
+
+  // acq_rel: a dependent sees the writes of all systems it waited for
+  for (SystemId dependent : system.dependents)
+  {
+    if (m_systems[dependent]->remaining.fetch_sub(
+            1, std::memory_order_acq_rel) == 1)
+    {
+      m_job_system.run(
+          [this, dependent, &frame_info] { runSystem(dependent, frame_info); },
+          &m_frame_counter);
+    }
+  }
+}
+
+void CoreVuScheduler::printReport(std::ostream& out) const
+{
+  char line[128];
+  std::snprintf(
+      line, sizeof(line), "%-24s %10s %10s %10s %8s\n", "system", "last ms",
+      "avg ms", "max ms", "frames");
+  out << "Scheduler report(" << m_job_system.getThreadCount()
+      << " threads):\n"
+      << line;
+
+  for (const auto& system : m_systems)
+  {
+    const auto& timing = system->timing;
+    const double average =
+        timing.frames > 0 ? timing.total_ms / timing.frames : 0.0;
+    std::snprintf(
+        line, sizeof(line), "%-24s %10.3f %10.3f %10.3f %8llu\n",
+        timing.name.c_str(), timing.last_ms, average, timing.max_ms,
+        static_cast<unsigned long long>(timing.frames));
+    out << line;
+  }
+}
+
+} // namespace corevu
@@ -0,0 +1,212 @@
+#include <ecs/corevu_world.hpp>
+
+namespace corevu
+{
+
+CoreVuWorld::CoreVuWorld()
+{
+  m_empty_archetype = getOrCreateArchetype(ComponentMask{});
+}
+
+CoreVuWorld::~CoreVuWorld()
+{
+  // archetypes destroy their components
+  m_view_lookup.clear();
+  m_views.clear();
+  m_archetype_list.clear();
+  m_archetypes.clear();
+}
+
+CoreVuEntity CoreVuWorld::allocateEntity()
+{
+  const CoreVuEntity entity = m_allocator.allocate();
+  if (m_records.size() < m_allocator.getIndexCount())
+  {
+    m_records.resize(m_allocator.getIndexCount());
+  }
+  m_alive_count++;
+  return entity;
+}
+
+CoreVuEntity CoreVuWorld::createEntity()
+{
+  const CoreVuEntity entity = allocateEntity();
+  setRecord(
+      entity, m_empty_archetype,
+      m_empty_archetype->allocateSlot(entity, getChangeVersion()));
+  return entity;
+}
+
+void CoreVuWorld::destroyEntity(CoreVuEntity entity)
+{
+  assert(isAlive(entity) && "Entity is not alive");
+
+  auto& record = getRecord(entity);
+  const CoreVuEntity moved =
+      record.archetype->removeSlot(record.slot, getChangeVersion());
+  if (moved != NULL_ENTITY)
+  {
+    getRecord(moved).slot = record.slot;
+  }
+
+  record = EntityRecord{};
+  m_allocator.free(entity);
+  m_alive_count--;
+  m_removal_count++;
+}
+
+void CoreVuWorld::addComponent(
+    CoreVuEntity entity, ComponentTypeId id, void* component)
+{
+  assert(isAlive(entity) && "Entity is not alive");
+  const auto& info = CoreVuComponentRegistry::GetInfo(id);
+  const auto& record = getRecord(entity);
+  if (record.archetype->hasComponent(id))
+  {
+    // no move assignment in ComponentInfo, replace the old one
+    void* existing = record.archetype->getComponent(record.slot, id);
+    record.archetype->setChangeVersion(
+        record.slot.chunk, id, getChangeVersion());
+    info.destroy(existing);
+    info.move_construct(existing, component);
+    return;
+  }
+
+  const auto& moved = moveEntity(entity, addEdge(entity, id), id);
+  info.move_construct(moved.archetype->getComponent(moved.slot, id), component);
+}
+
+void CoreVuWorld::removeComponent(CoreVuEntity entity, ComponentTypeId id)
+{
+  assert(isAlive(entity) && "Entity is not alive");
+  if (!getRecord(entity).archetype->hasComponent(id)) return;
+
+  moveEntity(entity, removeEdge(entity, id), id);
+}
+
+CoreVuArchetype* CoreVuWorld::getOrCreateArchetype(const ComponentMask& mask)
+{
+  auto it = m_archetypes.find(mask);
+  if (it != m_archetypes.end())
+  {
+    return it->second.get();
+  }
+
+  // would grow the archetype lists under the iterating queries
+  assert(
+      m_iterating_queries.load(std::memory_order_relaxed) == 0 &&
+      "Archetype created while a query iterates, record it in a "
+      "CoreVuEntityCommands instead");
+  auto archetype = std::make_unique<CoreVuArchetype>(mask);
+  auto* result = archetype.get();
+  m_archetypes.emplace(mask, std::move(archetype));
+  m_archetype_list.push_back(result);
+
+  std::lock_guard<std::mutex> lock{m_views_mutex};
+  for (auto& view : m_views)
+  {
+    if (view->matches(mask))
+    {
+      view->archetypes.push_back(result);
+    }
+  }
+  return result;
+}
+
+const std::vector<CoreVuArchetype*>& CoreVuWorld::getMatchingArchetypes(
+    const ComponentMask& include, const ComponentMask& exclude) const
+{
+  const std::hash<ComponentMask> hasher{};
+  const size_t key = hasher(include) ^ (hasher(exclude) * 0x9E3779B97F4A7C15);
+
+  std::lock_guard<std::mutex> lock{m_views_mutex};
+  auto [begin, end] = m_view_lookup.equal_range(key);
+  for (auto it = begin; it != end; ++it)
+  {
+    if (it->second->include == include && it->second->exclude == exclude)
+    {
+      return it->second->archetypes;
+    }
+  }
+
+  auto view = std::make_unique<QueryView>();
+  view->include = include;
+  view->exclude = exclude;
+  for (auto* archetype : m_archetype_list)
+  {
+    if (view->matches(archetype->getMask()))
+    {
+      view->archetypes.push_back(archetype);
+    }
+  }
+
+  auto* result = view.get();
+  m_views.push_back(std::move(view));
+  m_view_lookup.emplace(key, result);
+  return result->archetypes;
+}
+
+CoreVuArchetype* CoreVuWorld::addEdge(CoreVuEntity entity, ComponentTypeId id)
+{
+  auto* source = getRecord(entity).archetype;
+  auto* target = source->getAddEdge(id);
+  if (target == nullptr)
+  {
+    ComponentMask mask = source->getMask();
+    mask.set(id);
+    target = getOrCreateArchetype(mask);
+    source->setAddEdge(id, target);
+    target->setRemoveEdge(id, source);
+  }
+  return target;
+}
+
+CoreVuArchetype* CoreVuWorld::removeEdge(
+    CoreVuEntity entity, ComponentTypeId id)
+{
+  auto* source = getRecord(entity).archetype;
+  auto* target = source->getRemoveEdge(id);
+  if (target == nullptr)
+  {
+    ComponentMask mask = source->getMask();
+    mask.reset(id);
+    target = getOrCreateArchetype(mask);
+    source->setRemoveEdge(id, target);
+    target->setAddEdge(id, source);
+  }
+  return target;
+}
+
+const CoreVuWorld::EntityRecord& CoreVuWorld::moveEntity(
+    CoreVuEntity entity, CoreVuArchetype* target, ComponentTypeId skip_id)
+{
+  auto& record = getRecord(entity);
+  auto* source = record.archetype;
+  const auto source_slot = record.slot;
+
+  const ChangeVersion version = getChangeVersion();
+  const auto target_slot = target->allocateSlot(entity, version);
+  for (auto id : target->getTypes())
+  {
+    if (id == skip_id) continue;
+
+    assert(source->hasComponent(id));
+    CoreVuComponentRegistry::GetInfo(id).move_construct(
+        target->getComponent(target_slot, id),
+        source->getComponent(source_slot, id));
+  }
+
+  // destroys the moved-from components and the ones not present in target
+  const CoreVuEntity moved = source->removeSlot(source_slot, version);
+  if (moved != NULL_ENTITY)
+  {
+    getRecord(moved).slot = source_slot;
+  }
+
+  record.archetype = target;
+  record.slot = target_slot;
+  m_removal_count++;
+  return record;
+}
+
+} // namespace corevu
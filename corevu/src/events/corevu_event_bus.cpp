@@ -0,0 +1,32 @@
+#include <events/corevu_event_bus.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <atomic>
+
+namespace corevu
+{
+
+uint32_t CoreVuEventBus::NextEventType()
+{
+  static std::atomic<uint32_t> next_type{0};
+  return next_type.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CoreVuEventBus::dispatch()
+{
+  ZoneScoped;
+  assert(m_job_system.isMainThread() && "Events are dispatched on main thread");
+
+  for (auto& channel : m_channels)
+  {
+    if (channel != nullptr)
+    {
+      channel->dispatch();
+    }
+  }
+}
+
+} // namespace corevu
@@ -7,7 +7,7 @@ namespace corevu
 {
 
 void KeyboardMovementController::moveInPlaneXZ(
-    GLFWwindow* window, float dt, CoreVuGameObject& gameObject)
+    GLFWwindow* window, float dt, TransformComponent& transform)
 {
   glm::vec3 rotate{0};
   if (glfwGetKey(window, keys.lookRight) == GLFW_PRESS) rotate.y += 1.f;
@@ -15,18 +15,21 @@ void KeyboardMovementController::moveInPlaneXZ(
   if (glfwGetKey(window, keys.lookUp) == GLFW_PRESS) rotate.x += 1.f;
   if (glfwGetKey(window, keys.lookDown) == GLFW_PRESS) rotate.x -= 1.f;
 
+  glm::vec3 rotation = transform.GetRotation();
   if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon())
   {
-    gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+    rotation += lookSpeed * dt * glm::normalize(rotate);
   }
 
   // limit pitch values between about +/- 85ish degrees
-  gameObject.transform.rotation.x =
-      glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
-  gameObject.transform.rotation.y =
-      glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
+  rotation.x = glm::clamp(rotation.x, -1.5f, 1.5f);
+  rotation.y = glm::mod(rotation.y, glm::two_pi<float>());
+  if (rotation != transform.GetRotation())
+  {
+    transform.SetRotation(rotation);
+  }
 
-  float yaw = gameObject.transform.rotation.y;
+  float yaw = rotation.y;
   const glm::vec3 forwardDir{sin(yaw), 0.f, cos(yaw)};
   const glm::vec3 rightDir{forwardDir.z, 0.f, -forwardDir.x};
   const glm::vec3 upDir{0.f, -1.f, 0.f};
@@ -42,8 +45,8 @@ void KeyboardMovementController::moveInPlaneXZ(
 
   if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon())
   {
-    gameObject.transform.translation +=
-        moveSpeed * dt * glm::normalize(moveDir);
+    transform.SetTranslation(
+        transform.GetTranslation() + moveSpeed * dt * glm::normalize(moveDir));
   }
 }
 } // namespace corevu
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include <geometry/corevu_mesh_bvh.hpp>
+#include <jobs/corevu_job_system.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+
+namespace corevu
+{
+namespace
+{
+constexpr uint32_t GROUP_SIZE = CoreVuTriangleSoA::GROUP_SIZE;
+constexpr uint32_t STREAM_COUNT = 9;
+constexpr uint32_t BOUNDS_BATCH_SIZE = 4096;
+
+uint32_t GroupCount(uint32_t triangles)
+{
+  return (triangles + GROUP_SIZE - 1) / GROUP_SIZE;
+}
+
+template <typename Fn>
+void ForBatches(
+    CoreVuJobSystem* job_system, uint32_t count, uint32_t batch_size, Fn&& fn)
+{
+  if (job_system != nullptr)
+  {
+    job_system->parallelFor(count, batch_size, fn);
+  }
+  else
+  {
+    fn(0u, count);
+  }
+}
+} // namespace
+
+struct CoreVuMeshBvh::Build
+{
+  CoreVuJobSystem* job_system{nullptr};
+  std::vector<CoreVuAabb> boxes;    // by mesh triangle
+  std::vector<glm::vec3> centroids; // by mesh triangle
+  std::vector<uint32_t> references; // mesh triangles, in leaf order
+  std::atomic<uint32_t> node_count{1};
+  std::atomic<uint32_t> depth{0};
+};
+
+void CoreVuMeshBvh::build(
+    std::span<const glm::vec3> positions, std::span<const uint32_t> indices,
+    CoreVuJobSystem* job_system)
+{
+  ZoneScoped;
+  clear();
+  assert(indices.size() % 3 == 0 && "CoreVuMeshBvh takes whole triangles");
+  m_triangle_count = static_cast<uint32_t>(indices.size() / 3);
+  if (m_triangle_count == 0) return;
+
+  Build build{};
+  build.job_system = job_system;
+  build.boxes.resize(m_triangle_count);
+  build.centroids.resize(m_triangle_count);
+  build.references.resize(m_triangle_count);
+  ForBatches(
+      job_system, m_triangle_count, BOUNDS_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          CoreVuAabb box{};
+          box.expand(positions[indices[3 * i + 0]]);
+          box.expand(positions[indices[3 * i + 1]]);
+          box.expand(positions[indices[3 * i + 2]]);
+          build.boxes[i] = box;
+          build.centroids[i] = box.getCenter();
+          build.references[i] = i;
+        }
+      });
+
+  // a binary tree with a triangle or more per leaf has less than 2n nodes
+  m_nodes.resize(2 * static_cast<size_t>(m_triangle_count));
+  buildNode(build, 0, 0, m_triangle_count, 1);
+  m_nodes.resize(build.node_count.load());
+  m_depth = build.depth.load();
+
+  layoutTriangles(build, positions, indices);
+}
+
+void CoreVuMeshBvh::clear()
+{
+  m_nodes.clear();
+  m_triangle_data.clear();
+  m_slot_triangles.clear();
+  m_triangle_count = 0;
+  m_slot_count = 0;
+  m_depth = 0;
+}
+
+void CoreVuMeshBvh::buildNode(
+    Build& build, uint32_t node_index, uint32_t begin, uint32_t end,
+    uint32_t depth)
+{
+  Node& node = m_nodes[node_index];
+  node.box = CoreVuAabb{};
+  CoreVuAabb centroid_box{};
+  for (uint32_t i = begin; i < end; ++i)
+  {
+    const uint32_t triangle = build.references[i];
+    node.box.expand(build.boxes[triangle]);
+    centroid_box.expand(build.centroids[triangle]);
+  }
+
+  const uint32_t count = end - begin;
+  const float leaf_cost = GroupCount(count) * GROUP_COST;
+  const auto makeLeaf = [&]
+  {
+    node.first = begin; // a reference index until layoutTriangles()
+    node.count = count;
+    uint32_t deepest = build.depth.load(std::memory_order_relaxed);
+    while (deepest < depth &&
+           !build.depth.compare_exchange_weak(deepest, depth))
+    {
+    }
+  };
+  if (count == 1 || depth >= MAX_DEPTH)
+  {
+    makeLeaf();
+    return;
+  }
+
+  // binned SAH over the centroids, the cheapest plane of all axes
+  struct Bin
+  {
+    CoreVuAabb box{};
+    uint32_t count{0};
+  };
+  const glm::vec3 extent = centroid_box.max - centroid_box.min;
+  const float parent_area = std::max(node.box.getPerimeter(), 1e-20f);
+  float best_cost = std::numeric_limits<float>::max();
+  int best_axis = -1;
+  uint32_t best_bin = 0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (extent[axis] <= 0.f) continue;
+
+    std::array<Bin, BIN_COUNT> bins{};
+    const float scale = BIN_COUNT / extent[axis];
+    for (uint32_t i = begin; i < end; ++i)
+    {
+      const uint32_t triangle = build.references[i];
+      const auto bin = std::min(
+          BIN_COUNT - 1,
+          static_cast<uint32_t>(
+              (build.centroids[triangle][axis] - centroid_box.min[axis]) *
+              scale));
+      bins[bin].box.expand(build.boxes[triangle]);
+      bins[bin].count++;
+    }
+
+    // right to left sweep first, then test every plane left to right
+    std::array<float, BIN_COUNT> right_costs{};
+    CoreVuAabb right_box{};
+    uint32_t right_count = 0;
+    for (uint32_t bin = BIN_COUNT - 1; bin > 0; --bin)
+    {
+      right_box.expand(bins[bin].box);
+      right_count += bins[bin].count;
+      right_costs[bin] =
+          right_count == 0
+              ? 0.f
+              : right_box.getPerimeter() * GroupCount(right_count);
+    }
+    CoreVuAabb left_box{};
+    uint32_t left_count = 0;
+    for (uint32_t bin = 1; bin < BIN_COUNT; ++bin)
+    {
+      left_box.expand(bins[bin - 1].box);
+      left_count += bins[bin - 1].count;
+      if (left_count == 0 || left_count == count) continue;
+
+      const float cost =
+          TRAVERSAL_COST +
+          GROUP_COST *
+              (left_box.getPerimeter() * GroupCount(left_count) +
+               right_costs[bin]) /
+              parent_area;
+      if (cost < best_cost)
+      {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = bin;
+      }
+    }
+  }
+
+  if (count <= MAX_LEAF_TRIANGLES && best_cost >= leaf_cost)
+  {
+    makeLeaf();
+    return;
+  }
+
+  uint32_t middle = begin;
+  if (best_axis >= 0)
+  {
+    const float scale = BIN_COUNT / extent[best_axis];
+    const float min = centroid_box.min[best_axis];
+    middle = static_cast<uint32_t>(
+        std::partition(
+            build.references.begin() + begin, build.references.begin() + end,
+            [&](uint32_t triangle)
+            {
+              const auto bin = std::min(
+                  BIN_COUNT - 1,
+                  static_cast<uint32_t>(
+                      (build.centroids[triangle][best_axis] - min) * scale));
+              return bin < best_bin;
+            }) -
+        build.references.begin());
+  }
+  if (middle == begin || middle == end)
+  {
+    // all centroids in one point, the order doesn't matter
+    middle = begin + count / 2;
+  }
+
+  const uint32_t children = build.node_count.fetch_add(2);
+  node.first = children;
+  node.count = 0;
+  if (build.job_system != nullptr && count >= PARALLEL_BUILD_TRIANGLES)
+  {
+    CoreVuJobCounter counter;
+    build.job_system->run(
+        [this, &build, children, middle, end, depth]
+        { buildNode(build, children + 1, middle, end, depth + 1); },
+        &counter);
+    buildNode(build, children, begin, middle, depth + 1);
+    build.job_system->wait(counter);
+  }
+  else
+  {
+    buildNode(build, children, begin, middle, depth + 1);
+    buildNode(build, children + 1, middle, end, depth + 1);
+  }
+}
+
+void CoreVuMeshBvh::layoutTriangles(
+    const Build& build, std::span<const glm::vec3> positions,
+    std::span<const uint32_t> indices)
+{
+  ZoneScoped;
+  m_slot_count = 0;
+  for (const Node& node : m_nodes)
+  {
+    if (node.isLeaf())
+    {
+      m_slot_count += GroupCount(node.count) * GROUP_SIZE;
+    }
+  }
+  // empty slots stay all zero, degenerate triangles nothing hits
+  m_triangle_data.assign(
+      static_cast<size_t>(m_slot_count) * STREAM_COUNT, 0.f);
+  m_slot_triangles.assign(m_slot_count, CoreVuMeshHit::NO_TRIANGLE);
+
+  float* streams[STREAM_COUNT];
+  for (uint32_t i = 0; i < STREAM_COUNT; ++i)
+  {
+    streams[i] = m_triangle_data.data() + static_cast<size_t>(i) * m_slot_count;
+  }
+
+  uint32_t slot = 0;
+  for (Node& node : m_nodes)
+  {
+    if (!node.isLeaf()) continue;
+
+    for (uint32_t i = 0; i < node.count; ++i)
+    {
+      const uint32_t triangle = build.references[node.first + i];
+      const glm::vec3& v0 = positions[indices[3 * triangle + 0]];
+      const glm::vec3 e1 = positions[indices[3 * triangle + 1]] - v0;
+      const glm::vec3 e2 = positions[indices[3 * triangle + 2]] - v0;
+      const float values[STREAM_COUNT]{
+          v0.x, v0.y, v0.z, e1.x, e1.y, e1.z, e2.x, e2.y, e2.z};
+      for (uint32_t stream = 0; stream < STREAM_COUNT; ++stream)
+      {
+        streams[stream][slot + i] = values[stream];
+      }
+      m_slot_triangles[slot + i] = triangle;
+    }
+    node.first = slot;
+    slot += GroupCount(node.count) * GROUP_SIZE;
+  }
+}
+
+CoreVuTriangleSoA CoreVuMeshBvh::getTriangles() const
+{
+  const float* data = m_triangle_data.data();
+  const size_t stride = m_slot_count;
+  return CoreVuTriangleSoA{
+      data,              data + stride,     data + 2 * stride,
+      data + 3 * stride, data + 4 * stride, data + 5 * stride,
+      data + 6 * stride, data + 7 * stride, data + 8 * stride};
+}
+
+CoreVuMeshHit CoreVuMeshBvh::raycast(const CoreVuRay& ray) const
+{
+  if (m_nodes.empty()) return CoreVuMeshHit{};
+
+  const CoreVuTriangleSoA triangles = getTriangles();
+  const glm::vec3 inverse_direction = 1.f / ray.direction;
+  CoreVuRay clipped = ray;
+  CoreVuTriangleHit hit{};
+  hit.distance = ray.max_distance;
+
+  struct Entry
+  {
+    uint32_t node;
+    float distance; // where the ray enters the node
+  };
+  std::array<Entry, MAX_DEPTH + 1> stack;
+  size_t size = 0;
+  float distance = 0.f;
+  if (IntersectRay(clipped, inverse_direction, m_nodes[0].box, distance))
+  {
+    stack[size++] = Entry{0, distance};
+  }
+  while (size > 0)
+  {
+    const Entry entry = stack[--size];
+    // a closer hit was found since the node was pushed
+    if (entry.distance > clipped.max_distance) continue;
+
+    const Node& node = m_nodes[entry.node];
+    if (node.isLeaf())
+    {
+      const uint32_t end = node.first + GroupCount(node.count) * GROUP_SIZE;
+      if (IntersectTriangles(clipped, triangles, node.first, end, hit))
+      {
+        clipped.max_distance = hit.distance;
+      }
+      continue;
+    }
+
+    float distance1 = 0.f;
+    float distance2 = 0.f;
+    const bool hit1 = IntersectRay(
+        clipped, inverse_direction, m_nodes[node.first].box, distance1);
+    const bool hit2 = IntersectRay(
+        clipped, inverse_direction, m_nodes[node.first + 1].box, distance2);
+    assert(size + 2 <= stack.size() && "CoreVuMeshBvh is too deep");
+    // the nearer child goes on top
+    if (hit1 && hit2 && distance1 < distance2)
+    {
+      stack[size++] = Entry{node.first + 1, distance2};
+      stack[size++] = Entry{node.first, distance1};
+    }
+    else
+    {
+      if (hit1) stack[size++] = Entry{node.first, distance1};
+      if (hit2) stack[size++] = Entry{node.first + 1, distance2};
+    }
+  }
+
+  if (!hit.isHit()) return CoreVuMeshHit{};
+  return CoreVuMeshHit{
+      m_slot_triangles[hit.triangle], hit.distance, {hit.u, hit.v}};
+}
+
+uint32_t CoreVuMeshBvh::raycast(
+    CoreVuRayPacket& packet, uint32_t active, CoreVuMeshHit* hits) const
+{
+  active &= CoreVuRayPacket::ALL_ACTIVE;
+  if (m_nodes.empty() || active == 0) return 0;
+
+  const CoreVuTriangleSoA triangles = getTriangles();
+  std::array<CoreVuTriangleHit, CoreVuRayPacket::SIZE> triangle_hits{};
+  uint32_t hit_lanes = 0;
+
+  struct Entry
+  {
+    uint32_t node;
+    uint32_t active; // lanes that entered the parent
+  };
+  std::array<Entry, MAX_DEPTH + 1> stack;
+  size_t size = 0;
+  stack[size++] = Entry{0, active};
+  while (size > 0)
+  {
+    const Entry entry = stack[--size];
+    const Node& node = m_nodes[entry.node];
+    // against the current max distances, lanes may have hit meanwhile
+    const uint32_t lanes = IntersectPacketBox(packet, entry.active, node.box);
+    if (lanes == 0) continue;
+
+    if (node.isLeaf())
+    {
+      hit_lanes |= IntersectPacketTriangles(
+          packet, lanes, triangles, node.first, node.first + node.count,
+          triangle_hits.data());
+      continue;
+    }
+
+    // near child first along the first lane, the packet is coherent
+    const uint32_t lane = static_cast<uint32_t>(std::countr_zero(lanes));
+    const glm::vec3 direction{
+        packet.direction_x[lane], packet.direction_y[lane],
+        packet.direction_z[lane]};
+    const Node& left = m_nodes[node.first];
+    const Node& right = m_nodes[node.first + 1];
+    const bool left_first =
+        glm::dot(right.box.getCenter() - left.box.getCenter(), direction) >=
+        0.f;
+    assert(size + 2 <= stack.size() && "CoreVuMeshBvh is too deep");
+    stack[size++] = Entry{left_first ? node.first + 1 : node.first, lanes};
+    stack[size++] = Entry{left_first ? node.first : node.first + 1, lanes};
+  }
+
+  for (uint32_t lane = 0; lane < CoreVuRayPacket::SIZE; ++lane)
+  {
+    if ((hit_lanes >> lane & 1u) == 0) continue;
+
+    const CoreVuTriangleHit& hit = triangle_hits[lane];
+    hits[lane] = CoreVuMeshHit{
+        m_slot_triangles[hit.triangle], hit.distance, {hit.u, hit.v}};
+  }
+  return hit_lanes;
+}
+
+} // namespace corevu
@@ -0,0 +1,384 @@
+#include "geometry/corevu_mesh_simplify.hpp"
+
+// libs
+#include <Tracy.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace corevu
+{
+namespace
+{
+// border planes count that much more than the surface ones
+constexpr double BORDER_WEIGHT = 10.0;
+// smallest cosine between a triangle normal before and after a collapse
+constexpr float MIN_NORMAL_COS = .25f;
+
+/* Sum of squared distances to planes, weighted by triangle area:
+ * Q(p) = sum w * (n.p + d)^2 as the upper half of the symmetric 4x4 matrix. */
+struct Quadric
+{
+  double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+  double weight;
+
+  static Quadric FromPlane(const glm::dvec3& n, double d, double weight)
+  {
+    return Quadric{
+        weight * n.x * n.x, weight * n.x * n.y, weight * n.x * n.z,
+        weight * n.x * d,   weight * n.y * n.y, weight * n.y * n.z,
+        weight * n.y * d,   weight * n.z * n.z, weight * n.z * d,
+        weight * d * d,     weight};
+  }
+
+  void add(const Quadric& other)
+  {
+    a2 += other.a2;
+    ab += other.ab;
+    ac += other.ac;
+    ad += other.ad;
+    b2 += other.b2;
+    bc += other.bc;
+    bd += other.bd;
+    c2 += other.c2;
+    cd += other.cd;
+    d2 += other.d2;
+    weight += other.weight;
+  }
+
+  // mean squared distance of p to the planes
+  double evaluate(const glm::vec3& p) const
+  {
+    const double x = p.x;
+    const double y = p.y;
+    const double z = p.z;
+    const double sum = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z +
+                       2.0 * ad * x + b2 * y * y + 2.0 * bc * y * z +
+                       2.0 * bd * y + c2 * z * z + 2.0 * cd * z + d2;
+    return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+  }
+};
+
+Quadric Sum(const Quadric& a, const Quadric& b)
+{
+  Quadric result = a;
+  result.add(b);
+  return result;
+}
+
+struct Collapse
+{
+  uint32_t from;
+  uint32_t to;
+  double cost;
+};
+
+uint32_t Find(std::vector<uint32_t>& remap, uint32_t point)
+{
+  while (remap[point] != point)
+  {
+    remap[point] = remap[remap[point]];
+    point = remap[point];
+  }
+  return point;
+}
+
+uint64_t EdgeKey(uint32_t a, uint32_t b)
+{
+  return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+}
+} // namespace
+
+std::vector<uint32_t> SimplifyMesh(
+    std::span<const glm::vec3> positions, std::span<const glm::vec3> normals,
+    std::span<const uint32_t> indices, size_t target_index_count,
+    float* error)
+{
+  ZoneScoped;
+  assert(indices.size() % 3 == 0 && "Mesh is not triangles");
+  assert(
+      (normals.empty() || normals.size() == positions.size()) &&
+      "One normal per vertex expected");
+  if (error != nullptr) *error = 0.f;
+  if (indices.size() <= target_index_count)
+  {
+    return std::vector<uint32_t>(indices.begin(), indices.end());
+  }
+
+  // weld vertices by position, the simplifier works on points
+  std::vector<uint32_t> weld(positions.size());
+  std::vector<glm::vec3> points;
+  {
+    std::unordered_map<glm::vec3, uint32_t> ids{};
+    ids.reserve(positions.size());
+    for (size_t v = 0; v < positions.size(); ++v)
+    {
+      const auto [it, inserted] = ids.try_emplace(
+          positions[v], static_cast<uint32_t>(points.size()));
+      if (inserted) points.push_back(positions[v]);
+      weld[v] = it->second;
+    }
+  }
+  const uint32_t point_count = static_cast<uint32_t>(points.size());
+
+  // vertices of every point, to pick one again after collapsing
+  std::vector<uint32_t> wedge_offsets(point_count + 1, 0);
+  std::vector<uint32_t> wedges(positions.size());
+  for (const uint32_t point : weld)
+  {
+    wedge_offsets[point + 1]++;
+  }
+  std::partial_sum(
+      wedge_offsets.begin(), wedge_offsets.end(), wedge_offsets.begin());
+  {
+    std::vector<uint32_t> fill(wedge_offsets.begin(), wedge_offsets.end() - 1);
+    for (uint32_t v = 0; v < static_cast<uint32_t>(weld.size()); ++v)
+    {
+      wedges[fill[weld[v]]++] = v;
+    }
+  }
+
+  // triangles as points, corners keeps the vertex each corner came from
+  std::vector<uint32_t> triangles(indices.size());
+  std::vector<uint32_t> corners(indices.begin(), indices.end());
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    triangles[i] = weld[indices[i]];
+  }
+
+  // area weighted normal of the input surface around every point, collapses
+  // merge them like the quadrics
+  std::vector<glm::vec3> facings(point_count, glm::vec3{0.f});
+  for (size_t t = 0; t < triangles.size(); t += 3)
+  {
+    const glm::vec3& p0 = points[triangles[t]];
+    const glm::vec3 normal = glm::cross(
+        points[triangles[t + 1]] - p0, points[triangles[t + 2]] - p0);
+    for (int c = 0; c < 3; ++c)
+    {
+      facings[triangles[t + c]] += normal;
+    }
+  }
+
+  std::vector<Quadric> quadrics(point_count, Quadric{});
+  std::unordered_map<uint64_t, uint32_t> edge_uses{};
+  edge_uses.reserve(triangles.size());
+  for (size_t t = 0; t < triangles.size(); t += 3)
+  {
+    const glm::dvec3 p0{points[triangles[t + 0]]};
+    const glm::dvec3 p1{points[triangles[t + 1]]};
+    const glm::dvec3 p2{points[triangles[t + 2]]};
+    const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+    const double length = glm::length(normal);
+    if (length <= 0.0) continue;
+
+    const glm::dvec3 n = normal / length;
+    const Quadric plane = Quadric::FromPlane(n, -glm::dot(n, p0), length * .5);
+    for (int c = 0; c < 3; ++c)
+    {
+      quadrics[triangles[t + c]].add(plane);
+      edge_uses[EdgeKey(triangles[t + c], triangles[t + (c + 1) % 3])]++;
+    }
+  }
+  // open borders, a plane through the edge perpendicular to the triangle
+  for (size_t t = 0; t < triangles.size(); t += 3)
+  {
+    const glm::dvec3 p0{points[triangles[t + 0]]};
+    const glm::dvec3 p1{points[triangles[t + 1]]};
+    const glm::dvec3 p2{points[triangles[t + 2]]};
+    const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+    for (int c = 0; c < 3; ++c)
+    {
+      const uint32_t a = triangles[t + c];
+      const uint32_t b = triangles[t + (c + 1) % 3];
+      if (edge_uses[EdgeKey(a, b)] != 1) continue;
+
+      const glm::dvec3 from{points[a]};
+      const glm::dvec3 edge = glm::dvec3{points[b]} - from;
+      const glm::dvec3 border = glm::cross(edge, normal);
+      const double length = glm::length(border);
+      if (length <= 0.0) continue;
+
+      const glm::dvec3 n = border / length;
+      const Quadric plane = Quadric::FromPlane(
+          n, -glm::dot(n, from), BORDER_WEIGHT * glm::dot(edge, edge));
+      quadrics[a].add(plane);
+      quadrics[b].add(plane);
+    }
+  }
+
+  std::vector<uint32_t> remap(point_count);
+  std::iota(remap.begin(), remap.end(), 0u);
+  std::vector<uint8_t> locked(point_count);
+  std::vector<uint32_t> adjacent_offsets(point_count + 1);
+  std::vector<uint32_t> adjacent;
+  std::vector<Collapse> collapses;
+  double max_cost = 0.0;
+
+  // true when moving from to to turns a triangle around from over
+  auto flips = [&](uint32_t from, uint32_t to)
+  {
+    for (uint32_t k = adjacent_offsets[from]; k < adjacent_offsets[from + 1];
+         ++k)
+    {
+      const uint32_t t = adjacent[k];
+      uint32_t corner[3];
+      for (int c = 0; c < 3; ++c)
+      {
+        corner[c] = Find(remap, triangles[t + c]);
+      }
+      if (corner[0] == to || corner[1] == to || corner[2] == to) continue;
+
+      glm::vec3 p[3];
+      glm::vec3 moved[3];
+      for (int c = 0; c < 3; ++c)
+      {
+        p[c] = points[corner[c]];
+        moved[c] = corner[c] == from ? points[to] : p[c];
+      }
+      const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+      const glm::vec3 after =
+          glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+      // turning by more than ~75 degrees counts as well, a fold builds up
+      // over a few collapses otherwise
+      if (glm::dot(before, after) <=
+          MIN_NORMAL_COS * glm::length(before) * glm::length(after))
+      {
+        return true;
+      }
+      // small turns still add up over the collapses of a triangle's corners,
+      // it must keep facing the way the surface it covers did in the input
+      glm::vec3 facing = facings[from];
+      for (int c = 0; c < 3; ++c)
+      {
+        facing += facings[corner[c] == from ? to : corner[c]];
+      }
+      if (!(glm::dot(facing, after) > 0.f))
+      {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  while (triangles.size() > target_index_count)
+  {
+    // triangles around every point
+    std::fill(adjacent_offsets.begin(), adjacent_offsets.end(), 0u);
+    for (const uint32_t point : triangles)
+    {
+      adjacent_offsets[point + 1]++;
+    }
+    std::partial_sum(
+        adjacent_offsets.begin(), adjacent_offsets.end(),
+        adjacent_offsets.begin());
+    adjacent.resize(triangles.size());
+    {
+      std::vector<uint32_t> fill(
+          adjacent_offsets.begin(), adjacent_offsets.end() - 1);
+      for (uint32_t i = 0; i < static_cast<uint32_t>(triangles.size()); ++i)
+      {
+        adjacent[fill[triangles[i]]++] = i - i % 3;
+      }
+    }
+
+    // every edge once per triangle, the cheaper direction
+    collapses.clear();
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+      const uint32_t a = triangles[i];
+      const uint32_t b = triangles[i - i % 3 + (i % 3 + 1) % 3];
+      const Quadric sum = Sum(quadrics[a], quadrics[b]);
+      const double to_b = sum.evaluate(points[b]);
+      const double to_a = sum.evaluate(points[a]);
+      collapses.push_back(
+          to_b <= to_a ? Collapse{a, b, to_b} : Collapse{b, a, to_a});
+    }
+    std::sort(
+        collapses.begin(), collapses.end(),
+        [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+    // a collapse removes about two triangles
+    const size_t excess = (triangles.size() - target_index_count) / 3;
+    const size_t goal = std::max<size_t>(excess / 2, 1);
+    std::fill(locked.begin(), locked.end(), 0);
+    size_t collapsed = 0;
+    for (const Collapse& collapse : collapses)
+    {
+      if (collapsed >= goal) break;
+      if (locked[collapse.from] || locked[collapse.to]) continue;
+      if (flips(collapse.from, collapse.to)) continue;
+
+      remap[collapse.from] = collapse.to;
+      quadrics[collapse.to].add(quadrics[collapse.from]);
+      facings[collapse.to] += facings[collapse.from];
+      locked[collapse.from] = locked[collapse.to] = 1;
+      max_cost = std::max(max_cost, collapse.cost);
+      collapsed++;
+    }
+    if (collapsed == 0) break;
+
+    // drop the triangles that lost an edge
+    size_t write = 0;
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+      const uint32_t a = Find(remap, triangles[t + 0]);
+      const uint32_t b = Find(remap, triangles[t + 1]);
+      const uint32_t c = Find(remap, triangles[t + 2]);
+      if (a == b || b == c || a == c) continue;
+
+      triangles[write + 0] = a;
+      triangles[write + 1] = b;
+      triangles[write + 2] = c;
+      corners[write + 0] = corners[t + 0];
+      corners[write + 1] = corners[t + 1];
+      corners[write + 2] = corners[t + 2];
+      write += 3;
+    }
+    triangles.resize(write);
+    corners.resize(write);
+  }
+
+  // back to vertices, the wedge closest to what the corner had
+  std::vector<uint32_t> result(triangles.size());
+  for (size_t i = 0; i < triangles.size(); ++i)
+  {
+    const uint32_t point = triangles[i];
+    const uint32_t vertex = corners[i];
+    if (weld[vertex] == point)
+    {
+      result[i] = vertex;
+      continue;
+    }
+
+    uint32_t best = wedges[wedge_offsets[point]];
+    if (!normals.empty())
+    {
+      float best_dot = -2.f;
+      for (uint32_t k = wedge_offsets[point]; k < wedge_offsets[point + 1];
+           ++k)
+      {
+        const float dot = glm::dot(normals[vertex], normals[wedges[k]]);
+        if (dot > best_dot)
+        {
+          best_dot = dot;
+          best = wedges[k];
+        }
+      }
+    }
+    result[i] = best;
+  }
+
+  if (error != nullptr)
+  {
+    *error = static_cast<float>(std::sqrt(max_cost));
+  }
+  return result;
+}
+} // namespace corevu
@@ -0,0 +1,294 @@
+#include <jobs/corevu_job_system.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <cassert>
+
+namespace corevu
+{
+
+namespace
+{
+// job system the current thread belongs to and its index in it
+thread_local CoreVuJobSystem* t_job_system = nullptr;
+thread_local uint32_t t_thread_index = 0;
+
+constexpr uint32_t SPINS_BEFORE_SLEEP = 64;
+
+uint32_t nextRandom(uint32_t& state)
+{
+  // xorshift32
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+} // namespace
+
+CoreVuJobSystem::CoreVuJobSystem(uint32_t thread_count)
+{
+  assert(thread_count > 0 && "At least the main thread is needed");
+  assert(t_job_system == nullptr && "Thread already owns a job system");
+
+  m_threads.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; ++i)
+  {
+    auto data = std::make_unique<ThreadData>();
+    data->jobs = std::make_unique<CoreVuJob[]>(MAX_JOBS_PER_THREAD);
+    data->random_state = 0x9E3779B9u * (i + 1);
+    m_threads.push_back(std::move(data));
+  }
+
+  t_job_system = this;
+  t_thread_index = 0;
+
+  m_workers.reserve(thread_count - 1);
+  for (uint32_t i = 1; i < thread_count; ++i)
+  {
+    m_workers.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+CoreVuJobSystem::~CoreVuJobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock{m_sleep_mutex};
+    m_stop.store(true);
+  }
+  m_wake_condition.notify_all();
+  for (auto& worker : m_workers)
+  {
+    worker.join();
+  }
+
+  t_job_system = nullptr;
+}
+
+bool CoreVuJobSystem::isMainThread() const
+{
+  return t_job_system == this && t_thread_index == 0;
+}
+
+uint32_t CoreVuJobSystem::getThreadIndex() const
+{
+  assert(t_job_system == this && "Thread doesn't belong to the job system");
+  return t_thread_index;
+}
+
+CoreVuJob* CoreVuJobSystem::allocateJob()
+{
+  assert(t_job_system == this && "Jobs can only be started from job threads");
+  auto& data = *m_threads[t_thread_index];
+  for (;;)
+  {
+    // next free slot of the ring, jobs finish out of order
+    for (uint32_t i = 0; i < MAX_JOBS_PER_THREAD; ++i)
+    {
+      const uint32_t index = data.next_job++ & (MAX_JOBS_PER_THREAD - 1);
+      CoreVuJob& job = data.jobs[index];
+      if (!job.in_use.load(std::memory_order_acquire))
+      {
+        job.in_use.store(true, std::memory_order_relaxed);
+        return &job;
+      }
+    }
+    // all slots in flight, work them off until one is free
+    helpOnce();
+  }
+}
+
+void CoreVuJobSystem::pushJob(CoreVuJob* job)
+{
+  assert(t_job_system == this && "Jobs can only be started from job threads");
+
+  // counted before it is visible, so a sleeping worker can't miss it
+  m_queued_jobs.fetch_add(1);
+  while (!m_threads[t_thread_index]->queue.tryPush(job))
+  {
+    helpOnce(); // full deque, make room
+  }
+
+  if (m_sleeping_workers.load() > 0)
+  {
+    std::lock_guard<std::mutex> lock{m_sleep_mutex};
+    m_wake_condition.notify_one();
+  }
+}
+
+void CoreVuJobSystem::pushMainThreadJob(CoreVuJob* job)
+{
+  std::lock_guard<std::mutex> lock{m_main_thread_mutex};
+  if (m_main_thread_jobs_tail != nullptr)
+  {
+    m_main_thread_jobs_tail->next = job;
+  }
+  else
+  {
+    m_main_thread_jobs = job;
+  }
+  m_main_thread_jobs_tail = job;
+}
+
+void CoreVuJobSystem::addContinuation(
+    CoreVuJobCounter& dependency, CoreVuJob* job)
+{
+  {
+    std::lock_guard<std::mutex> lock{dependency.m_mutex};
+    if (dependency.m_value.load(std::memory_order_acquire) != 0)
+    {
+      job->next = dependency.m_continuations;
+      dependency.m_continuations = job;
+      return;
+    }
+  }
+  pushJob(job); // dependency is already done
+}
+
+CoreVuJob* CoreVuJobSystem::findJob(uint32_t thread_index)
+{
+  auto& data = *m_threads[thread_index];
+  CoreVuJob* job = data.queue.pop();
+
+  const uint32_t thread_count = getThreadCount();
+  if (job == nullptr && thread_count > 1)
+  {
+    // start at a random victim, so stealers spread over the queues
+    const uint32_t start = nextRandom(data.random_state) % thread_count;
+    for (uint32_t i = 0; i < thread_count && job == nullptr; ++i)
+    {
+      const uint32_t victim = (start + i) % thread_count;
+      if (victim != thread_index)
+      {
+        job = m_threads[victim]->queue.steal();
+      }
+    }
+  }
+
+  if (job != nullptr)
+  {
+    m_queued_jobs.fetch_sub(1);
+  }
+  return job;
+}
+
+void CoreVuJobSystem::execute(CoreVuJob* job)
+{
+  CoreVuJobCounter* counter = job->counter;
+  if (counter != nullptr)
+  {
+    counter->m_finishing.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  job->function(*job);
+  // the job is not touched anymore, its slot can take the next one
+  job->in_use.store(false, std::memory_order_release);
+
+  if (counter == nullptr)
+  {
+    return;
+  }
+
+  if (counter->m_value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    CoreVuJob* continuations = nullptr;
+    {
+      std::lock_guard<std::mutex> lock{counter->m_mutex};
+      continuations = counter->m_continuations;
+      counter->m_continuations = nullptr;
+    }
+    while (continuations != nullptr)
+    {
+      CoreVuJob* next = continuations->next;
+      continuations->next = nullptr;
+      pushJob(continuations);
+      continuations = next;
+    }
+  }
+  // last access to the counter, waiters may destroy it from now on
+  counter->m_finishing.fetch_sub(1, std::memory_order_release);
+}
+
+void CoreVuJobSystem::wait(const CoreVuJobCounter& counter)
+{
+  assert(t_job_system == this && "Only job threads can wait");
+
+  while (!counter.isDone())
+  {
+    helpOnce();
+  }
+}
+
+void CoreVuJobSystem::helpOnce()
+{
+  if (t_thread_index == 0 && runMainThreadJobs() > 0)
+  {
+    return;
+  }
+
+  if (CoreVuJob* job = findJob(t_thread_index))
+  {
+    execute(job);
+  }
+  else
+  {
+    std::this_thread::yield();
+  }
+}
+
+uint32_t CoreVuJobSystem::runMainThreadJobs()
+{
+  assert(isMainThread() && "Main thread jobs can't run on workers");
+
+  CoreVuJob* jobs = nullptr;
+  {
+    std::lock_guard<std::mutex> lock{m_main_thread_mutex};
+    jobs = m_main_thread_jobs;
+    m_main_thread_jobs = nullptr;
+    m_main_thread_jobs_tail = nullptr;
+  }
+
+  uint32_t executed = 0;
+  while (jobs != nullptr)
+  {
+    CoreVuJob* next = jobs->next;
+    jobs->next = nullptr;
+    execute(jobs);
+    jobs = next;
+    executed++;
+  }
+  return executed;
+}
+
+void CoreVuJobSystem::workerLoop(uint32_t thread_index)
+{
+  t_job_system = this;
+  t_thread_index = thread_index;
+
+  uint32_t idle_spins = 0;
+  while (!m_stop.load(std::memory_order_relaxed))
+  {
+    if (CoreVuJob* job = findJob(thread_index))
+    {
+      execute(job);
+      idle_spins = 0;
+      continue;
+    }
+
+    if (++idle_spins < SPINS_BEFORE_SLEEP)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{m_sleep_mutex};
+    m_sleeping_workers.fetch_add(1);
+    m_wake_condition.wait(
+        lock, [this] { return m_stop.load() || m_queued_jobs.load() > 0; });
+    m_sleeping_workers.fetch_sub(1);
+    idle_spins = 0;
+  }
+}
+
+} // namespace corevu
@@ -0,0 +1,506 @@
+#include <physics/corevu_broadphase.hpp>
+
+#include <events/corevu_event_bus.hpp>
+#include <events/corevu_events.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace corevu
+{
+namespace
+{
+// proxies per job of the per proxy passes
+constexpr uint32_t PROXY_BATCH_SIZE = 4096;
+// boxes per batch of the sweep, buckets per batch of the hash pair pass
+constexpr uint32_t SWEEP_BATCH_SIZE = 1024;
+constexpr uint32_t BUCKET_BATCH_SIZE = 4096;
+// candidates handed to OverlapBoxes at once
+constexpr uint32_t CANDIDATE_BATCH_SIZE = 256;
+// each created/destroyed proxy may travel through the whole order in the
+// insertion sort, with more of them than this a full sort is cheaper
+constexpr uint32_t FULL_SORT_PROXIES = 32;
+
+constexpr float EMPTY_MIN = std::numeric_limits<float>::max();
+constexpr float EMPTY_MAX = std::numeric_limits<float>::lowest();
+
+int32_t CellCoordinate(float value, float inverse_cell_size)
+{
+  return static_cast<int32_t>(std::floor(value * inverse_cell_size));
+}
+
+uint32_t HashCell(int32_t x, int32_t y, int32_t z)
+{
+  // Teschner et al., primes spread neighboring cells over the table
+  return (static_cast<uint32_t>(x) * 73856093u) ^
+         (static_cast<uint32_t>(y) * 19349663u) ^
+         (static_cast<uint32_t>(z) * 83492791u);
+}
+
+CoreVuBroadphasePair MakePair(uint32_t a, uint32_t b)
+{
+  return a < b ? CoreVuBroadphasePair{a, b} : CoreVuBroadphasePair{b, a};
+}
+} // namespace
+
+CoreVuBroadphase::CoreVuBroadphase(CoreVuBroadphaseMode mode) : m_mode{mode}
+{
+}
+
+CoreVuBroadphase::ProxyId CoreVuBroadphase::createProxy(
+    const CoreVuAabb& box, CoreVuEntity entity)
+{
+  ProxyId proxy;
+  if (!m_free.empty())
+  {
+    proxy = m_free.back();
+    m_free.pop_back();
+  }
+  else
+  {
+    proxy = static_cast<ProxyId>(m_entities.size());
+    m_min_x.push_back(EMPTY_MIN);
+    m_min_y.push_back(EMPTY_MIN);
+    m_min_z.push_back(EMPTY_MIN);
+    m_max_x.push_back(EMPTY_MAX);
+    m_max_y.push_back(EMPTY_MAX);
+    m_max_z.push_back(EMPTY_MAX);
+    m_entities.push_back(NULL_ENTITY);
+    m_alive.push_back(0);
+    m_in_order.push_back(0);
+  }
+
+  m_entities[proxy] = entity;
+  m_alive[proxy] = 1;
+  moveProxy(proxy, box);
+  if (!m_in_order[proxy])
+  {
+    m_order.push_back(proxy);
+    m_in_order[proxy] = 1;
+  }
+  m_unsorted++;
+  m_proxy_count++;
+  return proxy;
+}
+
+void CoreVuBroadphase::destroyProxy(ProxyId proxy)
+{
+  assert(
+      proxy < m_alive.size() && m_alive[proxy] &&
+      "CoreVuBroadphase::destroyProxy of a dead proxy");
+  // an empty box overlaps nothing and sorts to the end, the next sweep
+  // removes it from the order
+  m_min_x[proxy] = m_min_y[proxy] = m_min_z[proxy] = EMPTY_MIN;
+  m_max_x[proxy] = m_max_y[proxy] = m_max_z[proxy] = EMPTY_MAX;
+  m_entities[proxy] = NULL_ENTITY;
+  m_alive[proxy] = 0;
+  m_free.push_back(proxy);
+  m_unsorted++;
+  m_proxy_count--;
+}
+
+void CoreVuBroadphase::moveProxy(ProxyId proxy, const CoreVuAabb& box)
+{
+  assert(
+      proxy < m_alive.size() && m_alive[proxy] &&
+      "CoreVuBroadphase::moveProxy of a dead proxy");
+  m_min_x[proxy] = box.min.x;
+  m_min_y[proxy] = box.min.y;
+  m_min_z[proxy] = box.min.z;
+  m_max_x[proxy] = box.max.x;
+  m_max_y[proxy] = box.max.y;
+  m_max_z[proxy] = box.max.z;
+}
+
+void CoreVuBroadphase::clear()
+{
+  m_min_x.clear();
+  m_min_y.clear();
+  m_min_z.clear();
+  m_max_x.clear();
+  m_max_y.clear();
+  m_max_z.clear();
+  m_entities.clear();
+  m_alive.clear();
+  m_in_order.clear();
+  m_free.clear();
+  m_order.clear();
+  m_pairs.clear();
+  m_proxy_count = 0;
+  m_unsorted = 0;
+}
+
+void CoreVuBroadphase::findPairs(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  m_stats = Stats{};
+  m_stats.mode = m_mode;
+  if (m_mode == CoreVuBroadphaseMode::SweepAndPrune)
+  {
+    sweepAndPrune(job_system);
+  }
+  else
+  {
+    spatialHash(job_system);
+  }
+}
+
+void CoreVuBroadphase::publishPairs(CoreVuEventBus& event_bus) const
+{
+  ZoneScoped;
+  for (const auto& pair : m_pairs)
+  {
+    event_bus.publish(CollisionEvent{m_entities[pair.a], m_entities[pair.b]});
+  }
+}
+
+void CoreVuBroadphase::sortOrder()
+{
+  ZoneScoped;
+  const auto count = static_cast<uint32_t>(m_order.size());
+  if (m_unsorted > FULL_SORT_PROXIES)
+  {
+    std::sort(
+        m_order.begin(), m_order.end(),
+        [&](ProxyId a, ProxyId b) { return m_min_x[a] < m_min_x[b]; });
+  }
+  else
+  {
+    // coherent motion leaves the order nearly sorted
+    uint64_t swaps = 0;
+    for (uint32_t i = 1; i < count; ++i)
+    {
+      const ProxyId proxy = m_order[i];
+      const float key = m_min_x[proxy];
+      uint32_t j = i;
+      for (; j > 0 && m_min_x[m_order[j - 1]] > key; --j)
+      {
+        m_order[j] = m_order[j - 1];
+      }
+      swaps += i - j;
+      m_order[j] = proxy;
+    }
+    m_stats.swaps = swaps;
+  }
+  m_unsorted = 0;
+
+  // destroyed proxies sorted to the end
+  while (!m_order.empty() && !m_alive[m_order.back()])
+  {
+    m_in_order[m_order.back()] = 0;
+    m_order.pop_back();
+  }
+}
+
+void CoreVuBroadphase::sweepAndPrune(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  sortOrder();
+
+  const auto count = static_cast<uint32_t>(m_order.size());
+  for (auto& stream : m_sorted)
+  {
+    stream.resize(count);
+  }
+  job_system.parallelFor(
+      count, PROXY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          const ProxyId proxy = m_order[i];
+          m_sorted[0][i] = m_min_x[proxy];
+          m_sorted[1][i] = m_min_y[proxy];
+          m_sorted[2][i] = m_min_z[proxy];
+          m_sorted[3][i] = m_max_x[proxy];
+          m_sorted[4][i] = m_max_y[proxy];
+          m_sorted[5][i] = m_max_z[proxy];
+        }
+      });
+
+  const CoreVuBoxSoA boxes{m_sorted[0].data(), m_sorted[1].data(),
+                           m_sorted[2].data(), m_sorted[3].data(),
+                           m_sorted[4].data(), m_sorted[5].data()};
+  const uint32_t batch_count =
+      (count + SWEEP_BATCH_SIZE - 1) / SWEEP_BATCH_SIZE;
+  m_batch_pairs.resize(std::max<size_t>(m_batch_pairs.size(), batch_count));
+  m_batch_tests.resize(batch_count);
+  job_system.parallelFor(
+      batch_count, 1,
+      [&](uint32_t first_batch, uint32_t end_batch)
+      {
+        uint32_t hits[CANDIDATE_BATCH_SIZE];
+        for (uint32_t batch = first_batch; batch < end_batch; ++batch)
+        {
+          auto& pairs = m_batch_pairs[batch];
+          pairs.clear();
+          uint64_t tests = 0;
+
+          const uint32_t begin = batch * SWEEP_BATCH_SIZE;
+          const uint32_t end = std::min(begin + SWEEP_BATCH_SIZE, count);
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            // candidates start between this box's min x and max x
+            const float* min_x = boxes.min_x;
+            const auto last = static_cast<uint32_t>(
+                std::upper_bound(min_x + i + 1, min_x + count, boxes.max_x[i]) -
+                min_x);
+            const CoreVuAabb box{
+                {boxes.min_x[i], boxes.min_y[i], boxes.min_z[i]},
+                {boxes.max_x[i], boxes.max_y[i], boxes.max_z[i]}};
+
+            for (uint32_t first = i + 1; first < last;
+                 first += CANDIDATE_BATCH_SIZE)
+            {
+              const uint32_t candidates_end =
+                  std::min(first + CANDIDATE_BATCH_SIZE, last);
+              const size_t hit_count =
+                  OverlapBoxes(box, boxes, first, candidates_end, hits);
+              for (size_t h = 0; h < hit_count; ++h)
+              {
+                pairs.push_back(MakePair(m_order[i], m_order[hits[h]]));
+              }
+              tests += candidates_end - first;
+            }
+          }
+          m_batch_tests[batch] = tests;
+        }
+      });
+
+  mergePairs(batch_count);
+}
+
+float CoreVuBroadphase::chooseCellSize() const
+{
+  double size_sum = 0.0;
+  for (size_t proxy = 0; proxy < m_alive.size(); ++proxy)
+  {
+    if (!m_alive[proxy]) continue;
+    size_sum += std::max(
+        {m_max_x[proxy] - m_min_x[proxy], m_max_y[proxy] - m_min_y[proxy],
+         m_max_z[proxy] - m_min_z[proxy]});
+  }
+  const float mean_size =
+      m_proxy_count > 0 ? static_cast<float>(size_sum / m_proxy_count) : 0.f;
+  return mean_size > 0.f ? 2.f * mean_size : 1.f;
+}
+
+void CoreVuBroadphase::spatialHash(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  const float cell_size = m_cell_size > 0.f ? m_cell_size : chooseCellSize();
+  const float inverse_cell_size = 1.f / cell_size;
+  m_stats.cell_size = cell_size;
+
+  // cells per proxy, then their offsets
+  const auto proxy_count = static_cast<uint32_t>(m_alive.size());
+  m_entry_offsets.resize(proxy_count + 1);
+  job_system.parallelFor(
+      proxy_count, PROXY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t proxy = begin; proxy < end; ++proxy)
+        {
+          if (!m_alive[proxy])
+          {
+            m_entry_offsets[proxy] = 0;
+            continue;
+          }
+          const auto cells = [&](float min, float max)
+          {
+            return static_cast<uint32_t>(
+                CellCoordinate(max, inverse_cell_size) -
+                CellCoordinate(min, inverse_cell_size) + 1);
+          };
+          m_entry_offsets[proxy] = cells(m_min_x[proxy], m_max_x[proxy]) *
+                                   cells(m_min_y[proxy], m_max_y[proxy]) *
+                                   cells(m_min_z[proxy], m_max_z[proxy]);
+        }
+      });
+  uint32_t entry_count = 0;
+  for (uint32_t proxy = 0; proxy < proxy_count; ++proxy)
+  {
+    const uint32_t cells = m_entry_offsets[proxy];
+    m_entry_offsets[proxy] = entry_count;
+    entry_count += cells;
+  }
+  m_entry_offsets[proxy_count] = entry_count;
+  m_stats.entries = entry_count;
+
+  // the table is about as large as the entries, whole powers of two
+  uint32_t bucket_count = 1;
+  while (bucket_count < entry_count)
+  {
+    bucket_count <<= 1;
+  }
+  const uint32_t bucket_mask = bucket_count - 1;
+
+  m_entries.resize(entry_count);
+  m_entry_buckets.resize(entry_count);
+  job_system.parallelFor(
+      proxy_count, PROXY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t proxy = begin; proxy < end; ++proxy)
+        {
+          if (!m_alive[proxy]) continue;
+          const int32_t x0 = CellCoordinate(m_min_x[proxy], inverse_cell_size);
+          const int32_t y0 = CellCoordinate(m_min_y[proxy], inverse_cell_size);
+          const int32_t z0 = CellCoordinate(m_min_z[proxy], inverse_cell_size);
+          const int32_t x1 = CellCoordinate(m_max_x[proxy], inverse_cell_size);
+          const int32_t y1 = CellCoordinate(m_max_y[proxy], inverse_cell_size);
+          const int32_t z1 = CellCoordinate(m_max_z[proxy], inverse_cell_size);
+
+          uint32_t entry = m_entry_offsets[proxy];
+          for (int32_t z = z0; z <= z1; ++z)
+          {
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+              for (int32_t x = x0; x <= x1; ++x)
+              {
+                m_entry_buckets[entry] = HashCell(x, y, z) & bucket_mask;
+                m_entries[entry++] = CellEntry{x, y, z, proxy};
+              }
+            }
+          }
+        }
+      });
+
+  // counting sort by bucket
+  m_buckets.assign(bucket_count + 1, 0);
+  for (const uint32_t bucket : m_entry_buckets)
+  {
+    m_buckets[bucket + 1]++;
+  }
+  // [b + 1] holds the start of bucket b, after the scatter its end
+  uint32_t start = 0;
+  for (uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+  {
+    const uint32_t size = m_buckets[bucket + 1];
+    m_buckets[bucket + 1] = start;
+    start += size;
+  }
+  m_bucket_entries.resize(entry_count);
+  for (uint32_t entry = 0; entry < entry_count; ++entry)
+  {
+    m_bucket_entries[m_buckets[m_entry_buckets[entry] + 1]++] =
+        m_entries[entry];
+  }
+
+  for (auto& stream : m_sorted)
+  {
+    stream.resize(entry_count);
+  }
+  job_system.parallelFor(
+      entry_count, PROXY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          const ProxyId proxy = m_bucket_entries[i].proxy;
+          m_sorted[0][i] = m_min_x[proxy];
+          m_sorted[1][i] = m_min_y[proxy];
+          m_sorted[2][i] = m_min_z[proxy];
+          m_sorted[3][i] = m_max_x[proxy];
+          m_sorted[4][i] = m_max_y[proxy];
+          m_sorted[5][i] = m_max_z[proxy];
+        }
+      });
+
+  const CoreVuBoxSoA boxes{m_sorted[0].data(), m_sorted[1].data(),
+                           m_sorted[2].data(), m_sorted[3].data(),
+                           m_sorted[4].data(), m_sorted[5].data()};
+  const uint32_t batch_count =
+      (bucket_count + BUCKET_BATCH_SIZE - 1) / BUCKET_BATCH_SIZE;
+  m_batch_pairs.resize(std::max<size_t>(m_batch_pairs.size(), batch_count));
+  m_batch_tests.resize(batch_count);
+  job_system.parallelFor(
+      batch_count, 1,
+      [&](uint32_t first_batch, uint32_t end_batch)
+      {
+        uint32_t hits[CANDIDATE_BATCH_SIZE];
+        for (uint32_t batch = first_batch; batch < end_batch; ++batch)
+        {
+          auto& pairs = m_batch_pairs[batch];
+          pairs.clear();
+          uint64_t tests = 0;
+
+          const uint32_t first_bucket = batch * BUCKET_BATCH_SIZE;
+          const uint32_t end_bucket =
+              std::min(first_bucket + BUCKET_BATCH_SIZE, bucket_count);
+          for (uint32_t bucket = first_bucket; bucket < end_bucket; ++bucket)
+          {
+            const uint32_t bucket_end = m_buckets[bucket + 1];
+            for (uint32_t i = m_buckets[bucket]; i + 1 < bucket_end; ++i)
+            {
+              const CellEntry& cell = m_bucket_entries[i];
+              const CoreVuAabb box{
+                  {boxes.min_x[i], boxes.min_y[i], boxes.min_z[i]},
+                  {boxes.max_x[i], boxes.max_y[i], boxes.max_z[i]}};
+
+              for (uint32_t first = i + 1; first < bucket_end;
+                   first += CANDIDATE_BATCH_SIZE)
+              {
+                const uint32_t candidates_end =
+                    std::min(first + CANDIDATE_BATCH_SIZE, bucket_end);
+                const size_t hit_count =
+                    OverlapBoxes(box, boxes, first, candidates_end, hits);
+                for (size_t h = 0; h < hit_count; ++h)
+                {
+                  const uint32_t j = hits[h];
+                  const CellEntry& other = m_bucket_entries[j];
+                  // other cell in the same bucket, or not the cell the
+                  // intersection starts in
+                  if (other.x != cell.x || other.y != cell.y ||
+                      other.z != cell.z ||
+                      CellCoordinate(
+                          std::max(box.min.x, boxes.min_x[j]),
+                          inverse_cell_size) != cell.x ||
+                      CellCoordinate(
+                          std::max(box.min.y, boxes.min_y[j]),
+                          inverse_cell_size) != cell.y ||
+                      CellCoordinate(
+                          std::max(box.min.z, boxes.min_z[j]),
+                          inverse_cell_size) != cell.z)
+                  {
+                    continue;
+                  }
+                  pairs.push_back(MakePair(cell.proxy, other.proxy));
+                }
+                tests += candidates_end - first;
+              }
+            }
+          }
+          m_batch_tests[batch] = tests;
+        }
+      });
+
+  mergePairs(batch_count);
+}
+
+void CoreVuBroadphase::mergePairs(uint32_t batch_count)
+{
+  ZoneScoped;
+  size_t pair_count = 0;
+  for (uint32_t batch = 0; batch < batch_count; ++batch)
+  {
+    pair_count += m_batch_pairs[batch].size();
+    m_stats.tests += m_batch_tests[batch];
+  }
+
+  m_pairs.resize(pair_count);
+  auto* out = m_pairs.data();
+  for (uint32_t batch = 0; batch < batch_count; ++batch)
+  {
+    out = std::copy(
+        m_batch_pairs[batch].begin(), m_batch_pairs[batch].end(), out);
+  }
+}
+
+} // namespace corevu
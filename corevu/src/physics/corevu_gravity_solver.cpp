@@ -0,0 +1,786 @@
+#include <physics/corevu_gravity_solver.hpp>
+
+#include <simd/corevu_transform_batch.hpp>
+
+#include "../simd/corevu_gravity_kernel.hpp"
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace corevu
+{
+namespace
+{
+// bodies per job of the per body passes
+constexpr uint32_t BODY_BATCH_SIZE = 4096;
+// targets per job of the exact pass, whole registers
+constexpr uint32_t EXACT_BATCH_SIZE = 64;
+// groups per job of the tree walk
+constexpr uint32_t GROUP_BATCH_SIZE = 16;
+// the tree is split into about this many subtrees per thread
+constexpr uint32_t SUBTREES_PER_THREAD = 8;
+constexpr uint32_t MIN_SUBTREE_SIZE = 2048;
+
+// 4 digits of 11 bits cover the 2 * 21 bit morton codes
+constexpr uint32_t RADIX_BITS = 11;
+constexpr uint32_t RADIX_SIZE = 1u << RADIX_BITS;
+constexpr uint32_t RADIX_PASSES = 4;
+// bodies a radix sort block has at least
+constexpr uint32_t MIN_RADIX_BLOCK_SIZE = 16384;
+
+using simd_detail::GRAVITY_MIN_DISTANCE2;
+
+// low 21 bits of v to the even bits
+uint64_t SpreadBits(uint64_t v)
+{
+  v &= 0x1fffff;
+  v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+  v = (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+  v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0full;
+  v = (v | (v << 2)) & 0x3333333333333333ull;
+  v = (v | (v << 1)) & 0x5555555555555555ull;
+  return v;
+}
+
+void GravityScalar(
+    const float* source_x, const float* source_y, const float* source_mass,
+    size_t source_count, const float* target_x, const float* target_y,
+    size_t target_count, float softening2, float* acceleration_x,
+    float* acceleration_y)
+{
+  for (size_t i = 0; i < target_count; ++i)
+  {
+    float sum_x = 0.f;
+    float sum_y = 0.f;
+    for (size_t j = 0; j < source_count; ++j)
+    {
+      const float dx = source_x[j] - target_x[i];
+      const float dy = source_y[j] - target_y[i];
+      const float distance2 = dx * dx + dy * dy;
+      if (distance2 < GRAVITY_MIN_DISTANCE2) continue;
+      const float r2 = distance2 + softening2;
+      const float pull = source_mass[j] / (r2 * std::sqrt(r2));
+      sum_x += pull * dx;
+      sum_y += pull * dy;
+    }
+    acceleration_x[i] = sum_x;
+    acceleration_y[i] = sum_y;
+  }
+}
+
+// the best kernel for whole registers, the scalar loop for the rest
+void Gravity(
+    const float* source_x, const float* source_y, const float* source_mass,
+    size_t source_count, const float* target_x, const float* target_y,
+    size_t target_count, float softening2, float* acceleration_x,
+    float* acceleration_y)
+{
+  size_t done = 0;
+#if COREVU_SIMD_X86
+  if (GetSimdLevel() >= CoreVuSimdLevel::AVX2)
+  {
+    done = simd_detail::GravityAVX2(
+        source_x, source_y, source_mass, source_count, target_x, target_y,
+        target_count, softening2, acceleration_x, acceleration_y);
+  }
+#endif
+  GravityScalar(
+      source_x, source_y, source_mass, source_count, target_x + done,
+      target_y + done, target_count - done, softening2, acceleration_x + done,
+      acceleration_y + done);
+}
+} // namespace
+
+void CoreVuGravityBodies::clear()
+{
+  position_x.clear();
+  position_y.clear();
+  velocity_x.clear();
+  velocity_y.clear();
+  mass.clear();
+}
+
+void CoreVuGravityBodies::reserve(size_t count)
+{
+  position_x.reserve(count);
+  position_y.reserve(count);
+  velocity_x.reserve(count);
+  velocity_y.reserve(count);
+  mass.reserve(count);
+}
+
+void CoreVuGravityBodies::add(
+    float x, float y, float vx, float vy, float body_mass)
+{
+  position_x.push_back(x);
+  position_y.push_back(y);
+  velocity_x.push_back(vx);
+  velocity_y.push_back(vy);
+  mass.push_back(body_mass);
+}
+
+CoreVuGravitySolver::CoreVuGravitySolver(float strength)
+  : m_strength{strength}
+{
+}
+
+void CoreVuGravitySolver::setOpeningAngle(float theta)
+{
+  assert(theta >= 0.f && "Opening angle must not be negative");
+  m_opening_angle = theta;
+}
+
+void CoreVuGravitySolver::computeAccelerations(
+    const CoreVuGravityBodies& bodies, CoreVuJobSystem& job_system,
+    std::vector<float>& acceleration_x, std::vector<float>& acceleration_y)
+{
+  ZoneScoped;
+  const size_t count = bodies.size();
+  assert(
+      count < std::numeric_limits<uint32_t>::max() &&
+      "Too many gravity bodies");
+  acceleration_x.resize(count);
+  acceleration_y.resize(count);
+  m_stats = Stats{};
+  if (count == 0) return;
+
+  const bool exact =
+      m_mode == CoreVuGravityMode::Exact ||
+      (m_mode == CoreVuGravityMode::Auto && count <= m_exact_limit);
+  if (exact)
+  {
+    m_stats.mode = CoreVuGravityMode::Exact;
+    computeExact(
+        bodies, job_system, acceleration_x.data(), acceleration_y.data());
+  }
+  else
+  {
+    m_stats.mode = CoreVuGravityMode::BarnesHut;
+    computeBarnesHut(
+        bodies, job_system, acceleration_x.data(), acceleration_y.data());
+  }
+}
+
+void CoreVuGravitySolver::step(
+    CoreVuGravityBodies& bodies, float dt, CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  computeAccelerations(bodies, job_system, m_acceleration_x, m_acceleration_y);
+  job_system.parallelFor(
+      static_cast<uint32_t>(bodies.size()), BODY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          bodies.velocity_x[i] += dt * m_acceleration_x[i];
+          bodies.velocity_y[i] += dt * m_acceleration_y[i];
+          bodies.position_x[i] += dt * bodies.velocity_x[i];
+          bodies.position_y[i] += dt * bodies.velocity_y[i];
+        }
+      });
+}
+
+double CoreVuGravitySolver::computeEnergy(
+    const CoreVuGravityBodies& bodies, CoreVuJobSystem& job_system) const
+{
+  ZoneScoped;
+  constexpr uint32_t BATCH_SIZE = 64;
+  const uint32_t count = static_cast<uint32_t>(bodies.size());
+  const double softening2 = double{m_softening} * m_softening;
+
+  // one sum per batch, the total doesn't depend on the thread count
+  std::vector<double> sums((count + BATCH_SIZE - 1) / BATCH_SIZE, 0.0);
+  job_system.parallelFor(
+      count, BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        double sum = 0.0;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          const double vx = bodies.velocity_x[i];
+          const double vy = bodies.velocity_y[i];
+          sum += .5 * bodies.mass[i] * (vx * vx + vy * vy);
+          for (uint32_t j = i + 1; j < count; ++j)
+          {
+            const double dx =
+                double{bodies.position_x[j]} - bodies.position_x[i];
+            const double dy =
+                double{bodies.position_y[j]} - bodies.position_y[i];
+            const double distance2 = dx * dx + dy * dy;
+            if (distance2 < GRAVITY_MIN_DISTANCE2) continue;
+            sum -= double{m_strength} * bodies.mass[i] * bodies.mass[j] /
+                   std::sqrt(distance2 + softening2);
+          }
+        }
+        sums[begin / BATCH_SIZE] = sum;
+      });
+  return std::accumulate(sums.begin(), sums.end(), 0.0);
+}
+
+void CoreVuGravitySolver::computeExact(
+    const CoreVuGravityBodies& bodies, CoreVuJobSystem& job_system,
+    float* acceleration_x, float* acceleration_y)
+{
+  ZoneScoped;
+  const uint32_t count = static_cast<uint32_t>(bodies.size());
+  const float softening2 = m_softening * m_softening;
+  job_system.parallelFor(
+      count, EXACT_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        Gravity(
+            bodies.position_x.data(), bodies.position_y.data(),
+            bodies.mass.data(), count, bodies.position_x.data() + begin,
+            bodies.position_y.data() + begin, end - begin, softening2,
+            acceleration_x + begin, acceleration_y + begin);
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          acceleration_x[i] *= m_strength;
+          acceleration_y[i] *= m_strength;
+        }
+      });
+  m_stats.interactions = uint64_t{count} * count;
+}
+
+void CoreVuGravitySolver::computeBarnesHut(
+    const CoreVuGravityBodies& bodies, CoreVuJobSystem& job_system,
+    float* acceleration_x, float* acceleration_y)
+{
+  ZoneScoped;
+  const uint32_t count = static_cast<uint32_t>(bodies.size());
+  computeCodes(bodies, job_system);
+  sortCodes(job_system);
+
+  // bodies in morton order, neighbors in the tree are neighbors in memory
+  m_sorted_x.resize(count);
+  m_sorted_y.resize(count);
+  m_sorted_mass.resize(count);
+  m_sorted_acceleration_x.resize(count);
+  m_sorted_acceleration_y.resize(count);
+  job_system.parallelFor(
+      count, BODY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          const uint32_t body = m_order[i];
+          m_sorted_x[i] = bodies.position_x[body];
+          m_sorted_y[i] = bodies.position_y[body];
+          m_sorted_mass[i] = bodies.mass[body];
+        }
+      });
+
+  buildTree(job_system);
+  walkTree(job_system);
+
+  job_system.parallelFor(
+      count, BODY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          const uint32_t body = m_order[i];
+          acceleration_x[body] = m_strength * m_sorted_acceleration_x[i];
+          acceleration_y[body] = m_strength * m_sorted_acceleration_y[i];
+        }
+      });
+}
+
+void CoreVuGravitySolver::computeCodes(
+    const CoreVuGravityBodies& bodies, CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  const uint32_t count = static_cast<uint32_t>(bodies.size());
+  const uint32_t batch_count = (count + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE;
+
+  // bounds, min x, min y, max x, max y per batch
+  std::vector<float> bounds(batch_count * 4);
+  job_system.parallelFor(
+      count, BODY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        float* batch = &bounds[begin / BODY_BATCH_SIZE * 4];
+        batch[0] = batch[2] = bodies.position_x[begin];
+        batch[1] = batch[3] = bodies.position_y[begin];
+        for (uint32_t i = begin + 1; i < end; ++i)
+        {
+          batch[0] = std::min(batch[0], bodies.position_x[i]);
+          batch[1] = std::min(batch[1], bodies.position_y[i]);
+          batch[2] = std::max(batch[2], bodies.position_x[i]);
+          batch[3] = std::max(batch[3], bodies.position_y[i]);
+        }
+      });
+  float min_x = bounds[0];
+  float min_y = bounds[1];
+  float max_x = bounds[2];
+  float max_y = bounds[3];
+  for (uint32_t b = 1; b < batch_count; ++b)
+  {
+    min_x = std::min(min_x, bounds[b * 4 + 0]);
+    min_y = std::min(min_y, bounds[b * 4 + 1]);
+    max_x = std::max(max_x, bounds[b * 4 + 2]);
+    max_y = std::max(max_y, bounds[b * 4 + 3]);
+  }
+  float size = std::max(max_x - min_x, max_y - min_y);
+  if (!(size > 0.f)) size = 1.f;
+  m_root = Cell{min_x, min_y, size, 0};
+
+  constexpr uint32_t MAX_CELL = (1u << MAX_DEPTH) - 1;
+  const float scale = static_cast<float>(1u << MAX_DEPTH) / size;
+  m_codes.resize(count);
+  m_order.resize(count);
+  job_system.parallelFor(
+      count, BODY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          const uint32_t x = std::min(
+              static_cast<uint32_t>((bodies.position_x[i] - min_x) * scale),
+              MAX_CELL);
+          const uint32_t y = std::min(
+              static_cast<uint32_t>((bodies.position_y[i] - min_y) * scale),
+              MAX_CELL);
+          m_codes[i] = SpreadBits(x) | (SpreadBits(y) << 1);
+          m_order[i] = i;
+        }
+      });
+}
+
+/* LSD radix sort of the codes with the body indices. Every pass counts the
+ * digits per block in parallel, turns the counts into offsets(digit major,
+ * blocks in order, so the sort stays stable) and scatters the blocks in
+ * parallel. Passes where all codes share the digit are skipped. */
+void CoreVuGravitySolver::sortCodes(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  const uint32_t count = static_cast<uint32_t>(m_codes.size());
+  const uint32_t block_count = std::clamp(
+      count / MIN_RADIX_BLOCK_SIZE, 1u, job_system.getThreadCount() * 4);
+  const uint32_t block_size = (count + block_count - 1) / block_count;
+  m_sort_codes.resize(count);
+  m_sort_order.resize(count);
+  m_histograms.resize(block_count * RADIX_SIZE);
+
+  for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+  {
+    const uint32_t shift = pass * RADIX_BITS;
+    job_system.parallelFor(
+        block_count, 1,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t block = begin; block < end; ++block)
+          {
+            uint32_t* histogram = &m_histograms[block * RADIX_SIZE];
+            std::fill(histogram, histogram + RADIX_SIZE, 0u);
+            const uint32_t last = std::min(count, (block + 1) * block_size);
+            for (uint32_t i = block * block_size; i < last; ++i)
+            {
+              histogram[(m_codes[i] >> shift) & (RADIX_SIZE - 1)]++;
+            }
+          }
+        });
+
+    bool single_digit = false;
+    uint32_t offset = 0;
+    for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+    {
+      const uint32_t digit_begin = offset;
+      for (uint32_t block = 0; block < block_count; ++block)
+      {
+        uint32_t& slot = m_histograms[block * RADIX_SIZE + digit];
+        const uint32_t digit_count = slot;
+        slot = offset;
+        offset += digit_count;
+      }
+      single_digit |= offset - digit_begin == count;
+    }
+    if (single_digit) continue;
+
+    job_system.parallelFor(
+        block_count, 1,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t block = begin; block < end; ++block)
+          {
+            uint32_t* histogram = &m_histograms[block * RADIX_SIZE];
+            const uint32_t last = std::min(count, (block + 1) * block_size);
+            for (uint32_t i = block * block_size; i < last; ++i)
+            {
+              const uint32_t slot =
+                  histogram[(m_codes[i] >> shift) & (RADIX_SIZE - 1)]++;
+              m_sort_codes[slot] = m_codes[i];
+              m_sort_order[slot] = m_order[i];
+            }
+          }
+        });
+    std::swap(m_codes, m_sort_codes);
+    std::swap(m_order, m_sort_order);
+  }
+}
+
+/* The top levels are walked twice on the calling thread: first to cut the
+ * tree into subtrees of at most m_subtree_size bodies, which are then built
+ * in parallel, second to lay out the top nodes with the subtrees in between,
+ * depth first. The subtree nodes are copied behind their roots in parallel.
+ * Both walks take the same decisions, so they meet the subtrees in the same
+ * order. */
+void CoreVuGravitySolver::buildTree(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  const uint32_t count = static_cast<uint32_t>(m_codes.size());
+  m_subtree_size = std::max(
+      MIN_SUBTREE_SIZE,
+      count / (job_system.getThreadCount() * SUBTREES_PER_THREAD));
+
+  m_subtree_count = 0;
+  collectSubtrees(0, count, m_root);
+  job_system.parallelFor(
+      static_cast<uint32_t>(m_subtree_count), 1,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          Subtree& subtree = m_subtrees[i];
+          subtree.nodes.clear();
+          buildNode(subtree.nodes, subtree.first, subtree.end, subtree.cell);
+        }
+      });
+
+  m_nodes.clear();
+  size_t subtree = 0;
+  emitTop(0, count, m_root, subtree);
+  assert(subtree == m_subtree_count && "Tree walks took different paths");
+
+  job_system.parallelFor(
+      static_cast<uint32_t>(m_subtree_count), 1,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          const Subtree& subtree = m_subtrees[i];
+          for (size_t n = 1; n < subtree.nodes.size(); ++n)
+          {
+            Node node = subtree.nodes[n];
+            node.next += subtree.offset;
+            m_nodes[subtree.offset + n] = node;
+          }
+        }
+      });
+  m_stats.node_count = static_cast<uint32_t>(m_nodes.size());
+}
+
+CoreVuGravitySolver::Split CoreVuGravitySolver::splitCell(
+    uint32_t first, uint32_t end, Cell cell) const
+{
+  Split split{cell, {first, first, first, first, end}};
+  const uint64_t* codes = m_codes.data();
+  while (split.cell.level < MAX_DEPTH)
+  {
+    const uint32_t shift = 2 * (MAX_DEPTH - 1 - split.cell.level);
+    for (uint32_t quadrant = 1; quadrant < 4; ++quadrant)
+    {
+      split.bounds[quadrant] = static_cast<uint32_t>(
+          std::partition_point(
+              codes + split.bounds[quadrant - 1], codes + end,
+              [&](uint64_t code)
+              { return ((code >> shift) & 3u) < quadrant; }) -
+          codes);
+    }
+
+    uint32_t filled = 0;
+    uint32_t last = 0;
+    for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+    {
+      if (split.bounds[quadrant] == split.bounds[quadrant + 1]) continue;
+      filled++;
+      last = quadrant;
+    }
+    if (filled > 1) return split;
+
+    // a single quadrant gets no node of its own
+    const float half = split.cell.size * .5f;
+    split.cell = Cell{
+        split.cell.x + static_cast<float>(last & 1u) * half,
+        split.cell.y + static_cast<float>(last >> 1) * half, half,
+        split.cell.level + 1};
+  }
+  // all bodies share one code
+  return split;
+}
+
+bool CoreVuGravitySolver::isSubtree(
+    uint32_t first, uint32_t end, const Cell& cell) const
+{
+  return end - first <= m_subtree_size || cell.level == MAX_DEPTH;
+}
+
+void CoreVuGravitySolver::collectSubtrees(
+    uint32_t first, uint32_t end, Cell cell)
+{
+  const Split split = end - first <= m_subtree_size
+                          ? Split{cell, {}}
+                          : splitCell(first, end, cell);
+  if (isSubtree(first, end, split.cell))
+  {
+    if (m_subtree_count == m_subtrees.size()) m_subtrees.emplace_back();
+    Subtree& subtree = m_subtrees[m_subtree_count++];
+    subtree.first = first;
+    subtree.end = end;
+    subtree.cell = split.cell;
+    return;
+  }
+
+  const float half = split.cell.size * .5f;
+  for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+  {
+    const uint32_t begin = split.bounds[quadrant];
+    const uint32_t quadrant_end = split.bounds[quadrant + 1];
+    if (begin == quadrant_end) continue;
+    collectSubtrees(
+        begin, quadrant_end,
+        Cell{
+            split.cell.x + static_cast<float>(quadrant & 1u) * half,
+            split.cell.y + static_cast<float>(quadrant >> 1) * half, half,
+            split.cell.level + 1});
+  }
+}
+
+uint32_t CoreVuGravitySolver::emitTop(
+    uint32_t first, uint32_t end, Cell cell, size_t& subtree)
+{
+  const Split split = end - first <= m_subtree_size
+                          ? Split{cell, {}}
+                          : splitCell(first, end, cell);
+  if (isSubtree(first, end, split.cell))
+  {
+    // the root now, the rest after the parallel build
+    Subtree& built = m_subtrees[subtree++];
+    assert(built.first == first && built.end == end && "Subtree mismatch");
+    built.offset = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.resize(m_nodes.size() + built.nodes.size());
+    m_nodes[built.offset] = built.nodes[0];
+    m_nodes[built.offset].next += built.offset;
+    return built.offset;
+  }
+
+  const uint32_t index = static_cast<uint32_t>(m_nodes.size());
+  m_nodes.emplace_back();
+  Node node{};
+  node.first = first;
+  node.count = end - first;
+  double mass = 0.0;
+  double weighted_x = 0.0;
+  double weighted_y = 0.0;
+  const float half = split.cell.size * .5f;
+  for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+  {
+    const uint32_t begin = split.bounds[quadrant];
+    const uint32_t quadrant_end = split.bounds[quadrant + 1];
+    if (begin == quadrant_end) continue;
+    const uint32_t child = emitTop(
+        begin, quadrant_end,
+        Cell{
+            split.cell.x + static_cast<float>(quadrant & 1u) * half,
+            split.cell.y + static_cast<float>(quadrant >> 1) * half, half,
+            split.cell.level + 1},
+        subtree);
+    const Node& child_node = m_nodes[child];
+    mass += child_node.mass;
+    weighted_x += double{child_node.center_x} * child_node.mass;
+    weighted_y += double{child_node.center_y} * child_node.mass;
+  }
+  node.mass = static_cast<float>(mass);
+  node.next = static_cast<uint32_t>(m_nodes.size());
+  finishNode(
+      node, weighted_x, weighted_y, split.cell.x + half, split.cell.y + half,
+      split.cell.size);
+  m_nodes[index] = node;
+  return index;
+}
+
+void CoreVuGravitySolver::buildNode(
+    std::vector<Node>& nodes, uint32_t first, uint32_t end, Cell cell) const
+{
+  const uint32_t index = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+  Node node{};
+  node.first = first;
+  node.count = end - first;
+  double mass = 0.0;
+  double weighted_x = 0.0;
+  double weighted_y = 0.0;
+
+  const Split split =
+      node.count <= LEAF_SIZE ? Split{cell, {}} : splitCell(first, end, cell);
+  if (node.count <= LEAF_SIZE || split.cell.level == MAX_DEPTH)
+  {
+    // the box of the bodies is tighter than the cell
+    float min_x = m_sorted_x[first];
+    float min_y = m_sorted_y[first];
+    float max_x = min_x;
+    float max_y = min_y;
+    for (uint32_t i = first; i < end; ++i)
+    {
+      mass += m_sorted_mass[i];
+      weighted_x += double{m_sorted_x[i]} * m_sorted_mass[i];
+      weighted_y += double{m_sorted_y[i]} * m_sorted_mass[i];
+      min_x = std::min(min_x, m_sorted_x[i]);
+      min_y = std::min(min_y, m_sorted_y[i]);
+      max_x = std::max(max_x, m_sorted_x[i]);
+      max_y = std::max(max_y, m_sorted_y[i]);
+    }
+    node.leaf = 1;
+    node.mass = static_cast<float>(mass);
+    node.next = index + 1;
+    finishNode(
+        node, weighted_x, weighted_y, (min_x + max_x) * .5f,
+        (min_y + max_y) * .5f, std::max(max_x - min_x, max_y - min_y));
+    nodes[index] = node;
+    return;
+  }
+
+  const float half = split.cell.size * .5f;
+  for (uint32_t quadrant = 0; quadrant < 4; ++quadrant)
+  {
+    const uint32_t begin = split.bounds[quadrant];
+    const uint32_t quadrant_end = split.bounds[quadrant + 1];
+    if (begin == quadrant_end) continue;
+    const uint32_t child = static_cast<uint32_t>(nodes.size());
+    buildNode(
+        nodes, begin, quadrant_end,
+        Cell{
+            split.cell.x + static_cast<float>(quadrant & 1u) * half,
+            split.cell.y + static_cast<float>(quadrant >> 1) * half, half,
+            split.cell.level + 1});
+    const Node& child_node = nodes[child];
+    mass += child_node.mass;
+    weighted_x += double{child_node.center_x} * child_node.mass;
+    weighted_y += double{child_node.center_y} * child_node.mass;
+  }
+  node.mass = static_cast<float>(mass);
+  node.next = static_cast<uint32_t>(nodes.size());
+  finishNode(
+      node, weighted_x, weighted_y, split.cell.x + half, split.cell.y + half,
+      split.cell.size);
+  nodes[index] = node;
+}
+
+void CoreVuGravitySolver::finishNode(
+    Node& node, double weighted_x, double weighted_y, float x, float y,
+    float size) const
+{
+  node.center_x = x;
+  node.center_y = y;
+  if (node.mass > 0.f)
+  {
+    node.center_x = static_cast<float>(weighted_x / node.mass);
+    node.center_y = static_cast<float>(weighted_y / node.mass);
+  }
+  if (m_opening_angle <= 0.f)
+  {
+    node.open_distance2 = std::numeric_limits<float>::infinity();
+    return;
+  }
+  // the center of mass may sit off center, the farthest body is then farther
+  const float dx = node.center_x - x;
+  const float dy = node.center_y - y;
+  const float open_distance =
+      size / m_opening_angle + std::sqrt(dx * dx + dy * dy);
+  node.open_distance2 = open_distance * open_distance;
+}
+
+void CoreVuGravitySolver::walkTree(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  const uint32_t count = static_cast<uint32_t>(m_sorted_x.size());
+  const uint32_t group_count = (count + GROUP_SIZE - 1) / GROUP_SIZE;
+  const uint32_t node_count = static_cast<uint32_t>(m_nodes.size());
+  const float softening2 = m_softening * m_softening;
+  m_lists.resize(job_system.getThreadCount());
+  m_thread_interactions.assign(job_system.getThreadCount(), 0);
+
+  job_system.parallelFor(
+      group_count, GROUP_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        const uint32_t thread = job_system.getThreadIndex();
+        PointMasses& list = m_lists[thread];
+        uint64_t interactions = 0;
+        for (uint32_t group = begin; group < end; ++group)
+        {
+          const uint32_t first = group * GROUP_SIZE;
+          const uint32_t last = std::min(first + GROUP_SIZE, count);
+          float min_x = m_sorted_x[first];
+          float min_y = m_sorted_y[first];
+          float max_x = min_x;
+          float max_y = min_y;
+          for (uint32_t i = first + 1; i < last; ++i)
+          {
+            min_x = std::min(min_x, m_sorted_x[i]);
+            min_y = std::min(min_y, m_sorted_y[i]);
+            max_x = std::max(max_x, m_sorted_x[i]);
+            max_y = std::max(max_y, m_sorted_y[i]);
+          }
+
+          // written through pointers, the list only grows
+          uint32_t size = 0;
+          uint32_t n = 0;
+          while (n < node_count)
+          {
+            const Node& node = m_nodes[n];
+            const uint32_t needed = size + node.count;
+            if (needed > list.x.size())
+            {
+              list.x.resize(std::max<size_t>(needed, list.x.size() * 2));
+              list.y.resize(list.x.size());
+              list.mass.resize(list.x.size());
+            }
+            // distance of the center of mass to the group box
+            const float dx = std::max(
+                std::max(min_x - node.center_x, node.center_x - max_x), 0.f);
+            const float dy = std::max(
+                std::max(min_y - node.center_y, node.center_y - max_y), 0.f);
+            if (dx * dx + dy * dy > node.open_distance2)
+            {
+              list.x[size] = node.center_x;
+              list.y[size] = node.center_y;
+              list.mass[size] = node.mass;
+              size++;
+              n = node.next;
+            }
+            else if (node.leaf != 0)
+            {
+              std::copy_n(&m_sorted_x[node.first], node.count, &list.x[size]);
+              std::copy_n(&m_sorted_y[node.first], node.count, &list.y[size]);
+              std::copy_n(
+                  &m_sorted_mass[node.first], node.count, &list.mass[size]);
+              size = needed;
+              n = node.next;
+            }
+            else
+            {
+              n++;
+            }
+          }
+
+          Gravity(
+              list.x.data(), list.y.data(), list.mass.data(), size,
+              m_sorted_x.data() + first, m_sorted_y.data() + first,
+              last - first, softening2, m_sorted_acceleration_x.data() + first,
+              m_sorted_acceleration_y.data() + first);
+          interactions += uint64_t{size} * (last - first);
+        }
+        m_thread_interactions[thread] += interactions;
+      });
+  m_stats.interactions = std::accumulate(
+      m_thread_interactions.begin(), m_thread_interactions.end(), uint64_t{0});
+}
+} // namespace corevu
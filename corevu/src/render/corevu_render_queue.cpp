@@ -0,0 +1,177 @@
+#include <render/corevu_render_queue.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace corevu
+{
+namespace
+{
+constexpr uint64_t Field(uint32_t value, uint32_t bits, uint32_t shift)
+{
+  return (static_cast<uint64_t>(value) & ((uint64_t{1} << bits) - 1)) << shift;
+}
+
+// top bits of the non negative float, behind the camera counts as 0
+uint32_t DepthBits(float depth, uint32_t bits)
+{
+  const auto float_bits = std::bit_cast<uint32_t>(std::max(depth, 0.f));
+  return float_bits >> (31 - bits);
+}
+} // namespace
+
+uint64_t MakeOpaqueDrawKey(
+    uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod,
+    float depth)
+{
+  return Field(static_cast<uint32_t>(CoreVuDrawPass::Opaque), 4, 60) |
+         Field(pipeline, 8, 52) | Field(material, 16, 36) |
+         Field(mesh, 16, 20) | Field(lod, 4, 16) |
+         Field(DepthBits(depth, 16), 16, 0);
+}
+
+uint64_t MakeTransparentDrawKey(
+    uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod,
+    float depth)
+{
+  constexpr uint32_t DEPTH_MAX = (1u << 24) - 1;
+  return Field(static_cast<uint32_t>(CoreVuDrawPass::Transparent), 4, 60) |
+         Field(DEPTH_MAX - DepthBits(depth, 24), 24, 36) |
+         Field(pipeline, 8, 28) | Field(material, 12, 16) |
+         Field(mesh, 12, 4) | Field(lod, 4, 0);
+}
+
+uint32_t HashDrawResource(const void* resource)
+{
+  // fibonacci hashing, the low bits of an address are alignment
+  const auto address = reinterpret_cast<uintptr_t>(resource);
+  return static_cast<uint32_t>(
+      (static_cast<uint64_t>(address >> 4) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+void CoreVuRenderQueue::sort(CoreVuJobSystem& job_system)
+{
+  ZoneScoped;
+  const auto count = static_cast<uint32_t>(m_items.size());
+  m_sorted_passes = 0;
+  if (count < 2) return;
+
+  const uint32_t block_count = std::clamp(
+      count / MIN_BLOCK_SIZE, 1u, job_system.getThreadCount() * 4);
+  const uint32_t block_size = (count + block_count - 1) / block_count;
+  m_scratch.resize(count);
+  m_histograms.resize(block_count * RADIX_SIZE);
+  m_digit_counts.resize(block_count * RADIX_PASSES * RADIX_SIZE);
+
+  // every digit of every pass counted in one read of the keys
+  job_system.parallelFor(
+      block_count, 1,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t block = begin; block < end; ++block)
+        {
+          uint32_t* counts =
+              &m_digit_counts[block * RADIX_PASSES * RADIX_SIZE];
+          std::fill(counts, counts + RADIX_PASSES * RADIX_SIZE, 0u);
+          const uint32_t last = std::min(count, (block + 1) * block_size);
+          for (uint32_t i = block * block_size; i < last; ++i)
+          {
+            const uint64_t key = m_items[i].key;
+            for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+            {
+              counts[pass * RADIX_SIZE +
+                     ((key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1))]++;
+            }
+          }
+        }
+      });
+
+  bool first_pass = true;
+  for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+  {
+    // a digit all keys share leaves the order as it is
+    bool single_digit = false;
+    for (uint32_t digit = 0; digit < RADIX_SIZE && !single_digit; ++digit)
+    {
+      uint32_t total = 0;
+      for (uint32_t block = 0; block < block_count; ++block)
+      {
+        total += m_digit_counts
+            [(block * RADIX_PASSES + pass) * RADIX_SIZE + digit];
+      }
+      single_digit = total == count;
+    }
+    if (single_digit) continue;
+
+    const uint32_t shift = pass * RADIX_BITS;
+    if (first_pass)
+    {
+      // the items are still where they were counted
+      for (uint32_t block = 0; block < block_count; ++block)
+      {
+        std::copy_n(
+            &m_digit_counts[(block * RADIX_PASSES + pass) * RADIX_SIZE],
+            RADIX_SIZE, &m_histograms[block * RADIX_SIZE]);
+      }
+    }
+    else
+    {
+      job_system.parallelFor(
+          block_count, 1,
+          [&](uint32_t begin, uint32_t end)
+          {
+            for (uint32_t block = begin; block < end; ++block)
+            {
+              uint32_t* histogram = &m_histograms[block * RADIX_SIZE];
+              std::fill(histogram, histogram + RADIX_SIZE, 0u);
+              const uint32_t last = std::min(count, (block + 1) * block_size);
+              for (uint32_t i = block * block_size; i < last; ++i)
+              {
+                histogram[(m_items[i].key >> shift) & (RADIX_SIZE - 1)]++;
+              }
+            }
+          });
+    }
+    first_pass = false;
+
+    // digit major, block minor: the items of a digit keep the block order
+    uint32_t offset = 0;
+    for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+    {
+      for (uint32_t block = 0; block < block_count; ++block)
+      {
+        uint32_t& slot = m_histograms[block * RADIX_SIZE + digit];
+        const uint32_t digit_count = slot;
+        slot = offset;
+        offset += digit_count;
+      }
+    }
+    assert(offset == count && "CoreVuRenderQueue histograms lost items");
+
+    job_system.parallelFor(
+        block_count, 1,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t block = begin; block < end; ++block)
+          {
+            uint32_t* histogram = &m_histograms[block * RADIX_SIZE];
+            const uint32_t last = std::min(count, (block + 1) * block_size);
+            for (uint32_t i = block * block_size; i < last; ++i)
+            {
+              const uint32_t slot =
+                  histogram[(m_items[i].key >> shift) & (RADIX_SIZE - 1)]++;
+              m_scratch[slot] = m_items[i];
+            }
+          }
+        });
+    std::swap(m_items, m_scratch);
+    m_sorted_passes++;
+  }
+}
+
+} // namespace corevu
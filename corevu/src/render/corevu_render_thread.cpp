@@ -0,0 +1,144 @@
+#include <render/corevu_render_thread.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <cassert>
+#include <chrono>
+
+namespace corevu
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double MillisecondsSince(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+} // namespace
+
+CoreVuRenderThread::CoreVuRenderThread(
+    RecordFunction record, bool threaded, uint32_t packet_count)
+  : m_record{std::move(record)}, m_packets(packet_count)
+{
+  assert(packet_count > 0 && "CoreVuRenderThread needs a packet");
+  if (threaded)
+  {
+    m_thread = std::thread{[this] { threadMain(); }};
+  }
+}
+
+CoreVuRenderThread::~CoreVuRenderThread()
+{
+  if (m_thread.joinable())
+  {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stop = true;
+    }
+    m_submitted.notify_one();
+    m_thread.join();
+  }
+}
+
+CoreVuFramePacket& CoreVuRenderThread::beginPacket()
+{
+  ZoneScoped;
+  assert(!m_writing && "CoreVuRenderThread packet already begun");
+  const auto start = Clock::now();
+  std::unique_lock lock{m_mutex};
+  m_released.wait(
+      lock, [this]
+      { return m_pending < m_packets.size() || m_error != nullptr; });
+  rethrowError();
+  m_stats.stall_ms += MillisecondsSince(start);
+
+  m_writing = true;
+  auto& packet = m_packets[(m_read_index + m_pending) % m_packets.size()];
+  packet.frame = m_frame++;
+  return packet;
+}
+
+void CoreVuRenderThread::submitPacket()
+{
+  assert(m_writing && "CoreVuRenderThread packet not begun");
+  m_writing = false;
+  if (!m_thread.joinable())
+  {
+    record(m_packets[m_read_index]);
+    m_read_index = (m_read_index + 1) % m_packets.size();
+    return;
+  }
+
+  {
+    std::lock_guard lock{m_mutex};
+    rethrowError();
+    m_pending++;
+  }
+  m_submitted.notify_one();
+}
+
+void CoreVuRenderThread::flush()
+{
+  ZoneScoped;
+  std::unique_lock lock{m_mutex};
+  m_released.wait(
+      lock, [this] { return m_pending == 0 || m_error != nullptr; });
+  rethrowError();
+}
+
+void CoreVuRenderThread::threadMain()
+{
+  while (true)
+  {
+    const auto start = Clock::now();
+    const CoreVuFramePacket* packet = nullptr;
+    {
+      std::unique_lock lock{m_mutex};
+      // submitted packets are recorded before stopping
+      m_submitted.wait(lock, [this] { return m_pending > 0 || m_stop; });
+      if (m_pending == 0) return;
+      packet = &m_packets[m_read_index];
+    }
+    m_stats.idle_ms += MillisecondsSince(start);
+
+    try
+    {
+      record(*packet);
+    }
+    catch (...)
+    {
+      std::lock_guard lock{m_mutex};
+      m_error = std::current_exception();
+      m_pending = 0;
+      m_released.notify_all();
+      return;
+    }
+
+    {
+      std::lock_guard lock{m_mutex};
+      m_read_index = (m_read_index + 1) % m_packets.size();
+      m_pending--;
+    }
+    m_released.notify_all();
+  }
+}
+
+void CoreVuRenderThread::record(const CoreVuFramePacket& packet)
+{
+  ZoneScoped;
+  const auto start = Clock::now();
+  m_record(packet);
+  m_stats.record_ms += MillisecondsSince(start);
+  m_stats.frames++;
+}
+
+void CoreVuRenderThread::rethrowError()
+{
+  // kept, the thread is gone and nothing submitted later gets recorded
+  if (m_error) std::rethrow_exception(m_error);
+}
+} // namespace corevu
@@ -0,0 +1,50 @@
+#include "scene/corevu_asset_cache.hpp"
+
+namespace corevu
+{
+
+std::shared_ptr<CoreVuModel> CoreVuAssetCache::getModel(
+    const std::string& path)
+{
+  auto it = m_models.find(path);
+  if (it != m_models.end())
+  {
+    return it->second;
+  }
+
+  auto model =
+      CoreVuModel::CreateModelFromPath(m_device, path, m_bvh_job_system);
+  m_paths.emplace(model.get(), path);
+  m_models.emplace(path, model);
+  return model;
+}
+
+std::shared_ptr<CoreVuTexture> CoreVuAssetCache::getTexture(
+    const std::string& path)
+{
+  auto it = m_textures.find(path);
+  if (it != m_textures.end())
+  {
+    return it->second;
+  }
+
+  auto texture = CoreVuTexture::createTextureFromPath(m_device, path);
+  m_paths.emplace(texture.get(), path);
+  m_textures.emplace(path, texture);
+  return texture;
+}
+
+const std::string* CoreVuAssetCache::getPath(const CoreVuModel* model) const
+{
+  auto it = m_paths.find(model);
+  return it != m_paths.end() ? &it->second : nullptr;
+}
+
+const std::string* CoreVuAssetCache::getPath(
+    const CoreVuTexture* texture) const
+{
+  auto it = m_paths.find(texture);
+  return it != m_paths.end() ? &it->second : nullptr;
+}
+
+} // namespace corevu
@@ -0,0 +1,681 @@
+#include "scene/corevu_scene.hpp"
+
+#include "corevu_components.hpp"
+#include "scene/corevu_asset_cache.hpp"
+#include "scene/corevu_scene_format.hpp"
+#include "systems/transform_system.hpp"
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace corevu
+{
+
+namespace
+{
+using namespace scene_format;
+
+struct SaveContext;
+struct LoadContext;
+
+// how one component type is stored, rows are stored_size bytes in the file
+struct ComponentCodec
+{
+  std::string name;
+  ComponentTypeId id;
+  uint32_t stored_size;
+
+  void (*save)(
+      const ComponentCodec& codec, SaveContext& context, const void* column,
+      uint32_t count, uint8_t* rows);
+  // column holds count default constructed components
+  void (*load)(
+      const ComponentCodec& codec, LoadContext& context, const uint8_t* rows,
+      uint32_t count, void* column, const CoreVuEntity* entities);
+};
+
+struct SaveContext
+{
+  const CoreVuWorld* world{nullptr};
+  const CoreVuAssetCache* assets{nullptr};
+  std::vector<uint32_t> file_ids; // entity index -> file entity id
+  std::vector<AssetEntry> asset_entries;
+  std::string asset_paths;
+  std::unordered_map<const void*, uint32_t> asset_indices;
+
+  uint32_t getAssetIndex(
+      AssetType type, const void* asset, const std::string* path)
+  {
+    if (asset == nullptr) return NULL_INDEX;
+
+    auto it = asset_indices.find(asset);
+    if (it != asset_indices.end()) return it->second;
+
+    if (path == nullptr)
+    {
+      throw std::runtime_error(
+          "failed to save scene, asset not loaded through the asset cache");
+    }
+    const uint32_t index = static_cast<uint32_t>(asset_entries.size());
+    asset_entries.push_back(AssetEntry{
+        type, static_cast<uint32_t>(path->size()), asset_paths.size()});
+    asset_paths += *path;
+    asset_indices.emplace(asset, index);
+    return index;
+  }
+};
+
+struct LoadContext
+{
+  std::vector<std::shared_ptr<CoreVuModel>> models; // per asset index
+  std::vector<std::shared_ptr<CoreVuTexture>> textures;
+  std::vector<std::pair<CoreVuEntity, uint32_t>> parents; // child, file id
+};
+
+void SaveRaw(
+    const ComponentCodec& codec, SaveContext&, const void* column,
+    uint32_t count, uint8_t* rows)
+{
+  std::memcpy(rows, column, size_t{count} * codec.stored_size);
+}
+
+void LoadRaw(
+    const ComponentCodec& codec, LoadContext&, const uint8_t* rows,
+    uint32_t count, void* column, const CoreVuEntity*)
+{
+  std::memcpy(column, rows, size_t{count} * codec.stored_size);
+}
+
+void SaveTransforms(
+    const ComponentCodec&, SaveContext& context, const void* column,
+    uint32_t count, uint8_t* rows)
+{
+  const auto* transforms = static_cast<const TransformComponent*>(column);
+  auto* out = reinterpret_cast<TransformRow*>(rows);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const auto& transform = transforms[i];
+    std::memcpy(out[i].translation, &transform.GetTranslation(), 12);
+    std::memcpy(out[i].rotation, &transform.GetRotation(), 12);
+    std::memcpy(out[i].scale, &transform.GetScale(), 12);
+
+    // parents which are destroyed or not saved make the child a root
+    const CoreVuEntity parent = transform.GetParent();
+    const uint32_t index = GetEntityIndex(parent);
+    out[i].parent =
+        context.world->isAlive(parent) && index < context.file_ids.size()
+            ? context.file_ids[index]
+            : NULL_INDEX;
+  }
+}
+
+void LoadTransforms(
+    const ComponentCodec&, LoadContext& context, const uint8_t* rows,
+    uint32_t count, void* column, const CoreVuEntity* entities)
+{
+  auto* transforms = static_cast<TransformComponent*>(column);
+  const auto* in = reinterpret_cast<const TransformRow*>(rows);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    glm::vec3 translation, rotation, scale;
+    std::memcpy(&translation, in[i].translation, 12);
+    std::memcpy(&rotation, in[i].rotation, 12);
+    std::memcpy(&scale, in[i].scale, 12);
+    transforms[i] = TransformComponent{translation, rotation, scale};
+
+    if (in[i].parent != NULL_INDEX)
+    {
+      context.parents.emplace_back(entities[i], in[i].parent);
+    }
+  }
+}
+
+void SaveModels(
+    const ComponentCodec&, SaveContext& context, const void* column,
+    uint32_t count, uint8_t* rows)
+{
+  const auto* models = static_cast<const ModelComponent*>(column);
+  auto* out = reinterpret_cast<AssetRow*>(rows);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const CoreVuModel* model = models[i].model.get();
+    const std::string* path = nullptr;
+    if (model != nullptr && context.assets != nullptr)
+    {
+      path = context.assets->getPath(model);
+    }
+    out[i].asset = context.getAssetIndex(AssetType::Model, model, path);
+  }
+}
+
+void LoadModels(
+    const ComponentCodec&, LoadContext& context, const uint8_t* rows,
+    uint32_t count, void* column, const CoreVuEntity*)
+{
+  auto* models = static_cast<ModelComponent*>(column);
+  const auto* in = reinterpret_cast<const AssetRow*>(rows);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (in[i].asset == NULL_INDEX) continue;
+    if (in[i].asset >= context.models.size() ||
+        context.models[in[i].asset] == nullptr)
+    {
+      throw std::runtime_error("failed to load scene, invalid model index");
+    }
+    models[i].model = context.models[in[i].asset];
+  }
+}
+
+void SaveTextures(
+    const ComponentCodec&, SaveContext& context, const void* column,
+    uint32_t count, uint8_t* rows)
+{
+  const auto* textures = static_cast<const TextureComponent*>(column);
+  auto* out = reinterpret_cast<AssetRow*>(rows);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const CoreVuTexture* texture = textures[i].diffuse_map.get();
+    const std::string* path = nullptr;
+    if (texture != nullptr && context.assets != nullptr)
+    {
+      path = context.assets->getPath(texture);
+    }
+    out[i].asset = context.getAssetIndex(AssetType::Texture, texture, path);
+  }
+}
+
+void LoadTextures(
+    const ComponentCodec&, LoadContext& context, const uint8_t* rows,
+    uint32_t count, void* column, const CoreVuEntity*)
+{
+  auto* textures = static_cast<TextureComponent*>(column);
+  const auto* in = reinterpret_cast<const AssetRow*>(rows);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (in[i].asset == NULL_INDEX) continue;
+    if (in[i].asset >= context.textures.size() ||
+        context.textures[in[i].asset] == nullptr)
+    {
+      throw std::runtime_error("failed to load scene, invalid texture index");
+    }
+    textures[i].diffuse_map = context.textures[in[i].asset];
+  }
+}
+
+struct CodecRegistry
+{
+  std::mutex mutex;
+  std::vector<ComponentCodec> codecs;
+
+  CodecRegistry()
+  {
+    codecs.push_back(ComponentCodec{
+        "transform", CoreVuComponentRegistry::GetId<TransformComponent>(),
+        sizeof(TransformRow), SaveTransforms, LoadTransforms});
+    codecs.push_back(ComponentCodec{
+        "point_light", CoreVuComponentRegistry::GetId<PointLightComponent>(),
+        sizeof(PointLightComponent), SaveRaw, LoadRaw});
+    codecs.push_back(ComponentCodec{
+        "rigid_body_2d",
+        CoreVuComponentRegistry::GetId<RigidBody2dComponent>(),
+        sizeof(RigidBody2dComponent), SaveRaw, LoadRaw});
+    codecs.push_back(ComponentCodec{
+        "static", CoreVuComponentRegistry::GetId<StaticComponent>(),
+        sizeof(StaticComponent), SaveRaw, LoadRaw});
+    codecs.push_back(ComponentCodec{
+        "model", CoreVuComponentRegistry::GetId<ModelComponent>(),
+        sizeof(AssetRow), SaveModels, LoadModels});
+    codecs.push_back(ComponentCodec{
+        "texture", CoreVuComponentRegistry::GetId<TextureComponent>(),
+        sizeof(AssetRow), SaveTextures, LoadTextures});
+  }
+
+  const ComponentCodec* find(ComponentTypeId id) const
+  {
+    for (const auto& codec : codecs)
+    {
+      if (codec.id == id) return &codec;
+    }
+    return nullptr;
+  }
+  const ComponentCodec* find(const char* name) const
+  {
+    for (const auto& codec : codecs)
+    {
+      if (codec.name == name) return &codec;
+    }
+    return nullptr;
+  }
+};
+
+CodecRegistry& GetCodecs()
+{
+  static CodecRegistry registry{};
+  return registry;
+}
+
+uint64_t AlignSection(uint64_t offset)
+{
+  return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+// read only mapping of a whole file
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string& path)
+  {
+#ifdef _WIN32
+    m_file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    LARGE_INTEGER size{};
+    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+    {
+      throw std::runtime_error("failed to open scene file: " + path);
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    if (m_size == 0) return;
+
+    m_mapping =
+        CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping != nullptr)
+    {
+      m_data = static_cast<const uint8_t*>(
+          MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    const int file = open(path.c_str(), O_RDONLY);
+    struct stat info{};
+    if (file < 0 || fstat(file, &info) != 0)
+    {
+      if (file >= 0) close(file);
+      throw std::runtime_error("failed to open scene file: " + path);
+    }
+    m_size = static_cast<size_t>(info.st_size);
+    if (m_size == 0)
+    {
+      close(file);
+      return;
+    }
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data != MAP_FAILED)
+    {
+      madvise(data, m_size, MADV_SEQUENTIAL);
+      m_data = static_cast<const uint8_t*>(data);
+    }
+#endif
+    if (m_data == nullptr)
+    {
+      release();
+      throw std::runtime_error("failed to map scene file: " + path);
+    }
+  }
+
+  ~MappedFile()
+  {
+    release();
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* getData() const
+  {
+    return m_data;
+  }
+  size_t getSize() const
+  {
+    return m_size;
+  }
+
+private:
+  void release()
+  {
+#ifdef _WIN32
+    if (m_data != nullptr) UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_data != nullptr) munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+  }
+
+#ifdef _WIN32
+  HANDLE m_file{INVALID_HANDLE_VALUE};
+  HANDLE m_mapping{nullptr};
+#endif
+  const uint8_t* m_data{nullptr};
+  size_t m_size{0};
+};
+
+// bounds checked view of count Ts at offset
+template <typename T>
+const T* Section(const MappedFile& file, uint64_t offset, uint64_t count)
+{
+  if (offset % alignof(T) != 0 || offset > file.getSize() ||
+      count > (file.getSize() - offset) / sizeof(T))
+  {
+    throw std::runtime_error("failed to load scene, file is corrupt");
+  }
+  return reinterpret_cast<const T*>(file.getData() + offset);
+}
+} // namespace
+
+void CoreVuScene::registerRawComponent(
+    const char* name, ComponentTypeId id, uint32_t size)
+{
+  assert(
+      std::strlen(name) < MAX_NAME_LENGTH && "Scene component name too long");
+
+  auto& registry = GetCodecs();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+  assert(registry.find(name) == nullptr && "Scene component name taken");
+  assert(registry.find(id) == nullptr && "Scene component registered twice");
+  registry.codecs.push_back(ComponentCodec{name, id, size, SaveRaw, LoadRaw});
+}
+
+void CoreVuScene::Save(
+    const CoreVuWorld& world, const std::string& path,
+    const CoreVuAssetCache* assets)
+{
+  ZoneScoped;
+
+  auto& registry = GetCodecs();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+
+  struct StoredArchetype
+  {
+    const CoreVuArchetype* archetype;
+    std::vector<const ComponentCodec*> codecs;
+  };
+  std::vector<StoredArchetype> stored;
+  SaveContext context{};
+  context.world = &world;
+  context.assets = assets;
+
+  // file entity ids in archetype order
+  uint64_t entity_count = 0;
+  for (const auto* archetype : world.getArchetypes())
+  {
+    if (archetype->getEntityCount() == 0) continue;
+
+    StoredArchetype entry{archetype, {}};
+    for (auto id : archetype->getTypes())
+    {
+      if (const auto* codec = registry.find(id))
+      {
+        entry.codecs.push_back(codec);
+      }
+    }
+    if (entry.codecs.empty()) continue;
+
+    for (size_t chunk = 0; chunk < archetype->getChunkCount(); ++chunk)
+    {
+      const auto* entities = archetype->getEntities(chunk);
+      for (uint32_t row = 0; row < archetype->getChunk(chunk).count; ++row)
+      {
+        const uint32_t index = GetEntityIndex(entities[row]);
+        if (index >= context.file_ids.size())
+        {
+          context.file_ids.resize(size_t{index} + 1, NULL_INDEX);
+        }
+        context.file_ids[index] = static_cast<uint32_t>(entity_count++);
+      }
+    }
+    stored.push_back(std::move(entry));
+  }
+  if (entity_count >= NULL_INDEX)
+  {
+    throw std::runtime_error("failed to save scene, too many entities");
+  }
+
+  // header and tables first, the column data behind them
+  uint64_t offset = AlignSection(sizeof(Header));
+  const uint64_t archetypes_offset = offset;
+  offset = AlignSection(offset + stored.size() * sizeof(ArchetypeEntry));
+  std::vector<ArchetypeEntry> archetype_entries;
+  for (const auto& entry : stored)
+  {
+    archetype_entries.push_back(ArchetypeEntry{
+        static_cast<uint32_t>(entry.archetype->getEntityCount()),
+        static_cast<uint32_t>(entry.codecs.size()), offset});
+    offset = AlignSection(offset + entry.codecs.size() * sizeof(ColumnEntry));
+  }
+
+  std::vector<uint8_t> buffer(offset);
+  for (size_t a = 0; a < stored.size(); ++a)
+  {
+    const auto& entry = stored[a];
+    const auto* archetype = entry.archetype;
+    for (size_t c = 0; c < entry.codecs.size(); ++c)
+    {
+      const auto* codec = entry.codecs[c];
+      ColumnEntry column{};
+      std::strncpy(column.name, codec->name.c_str(), MAX_NAME_LENGTH - 1);
+      column.stored_size = codec->stored_size;
+      column.data_offset = buffer.size();
+      std::memcpy(
+          buffer.data() + archetype_entries[a].columns_offset +
+              c * sizeof(ColumnEntry),
+          &column, sizeof(column));
+
+      buffer.resize(AlignSection(
+          buffer.size() + archetype->getEntityCount() * codec->stored_size));
+      uint8_t* rows = buffer.data() + column.data_offset;
+      for (size_t chunk = 0; chunk < archetype->getChunkCount(); ++chunk)
+      {
+        const uint32_t count = archetype->getChunk(chunk).count;
+        codec->save(
+            *codec, context, archetype->getColumn(chunk, codec->id), count,
+            rows);
+        rows += size_t{count} * codec->stored_size;
+      }
+    }
+  }
+
+  const uint64_t assets_offset = buffer.size();
+  const uint64_t paths_offset = AlignSection(
+      assets_offset + context.asset_entries.size() * sizeof(AssetEntry));
+  for (auto& asset : context.asset_entries)
+  {
+    asset.path_offset += paths_offset;
+  }
+  buffer.resize(paths_offset + context.asset_paths.size());
+  if (!context.asset_entries.empty())
+  {
+    std::memcpy(
+        buffer.data() + assets_offset, context.asset_entries.data(),
+        context.asset_entries.size() * sizeof(AssetEntry));
+    std::memcpy(
+        buffer.data() + paths_offset, context.asset_paths.data(),
+        context.asset_paths.size());
+  }
+  if (!archetype_entries.empty())
+  {
+    std::memcpy(
+        buffer.data() + archetypes_offset, archetype_entries.data(),
+        archetype_entries.size() * sizeof(ArchetypeEntry));
+  }
+
+  Header header{};
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.file_size = buffer.size();
+  header.entity_count = entity_count;
+  header.asset_count = static_cast<uint32_t>(context.asset_entries.size());
+  header.archetype_count = static_cast<uint32_t>(archetype_entries.size());
+  header.archetypes_offset = archetypes_offset;
+  header.assets_offset = assets_offset;
+  std::memcpy(buffer.data(), &header, sizeof(header));
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(
+      reinterpret_cast<const char*>(buffer.data()),
+      static_cast<std::streamsize>(buffer.size()));
+  if (!file)
+  {
+    throw std::runtime_error("failed to write scene file: " + path);
+  }
+}
+
+std::vector<CoreVuEntity> CoreVuScene::Load(
+    const std::string& path, CoreVuWorld& world,
+    TransformSystem& transform_system, CoreVuAssetCache* assets)
+{
+  ZoneScoped;
+
+  const MappedFile file{path};
+  const auto& header = *Section<Header>(file, 0, 1);
+  if (header.magic != MAGIC)
+  {
+    throw std::runtime_error("failed to load scene, not a scene file: " + path);
+  }
+  if (header.version != VERSION)
+  {
+    throw std::runtime_error(
+        "failed to load scene, unsupported version " +
+        std::to_string(header.version) + ": " + path);
+  }
+  if (header.file_size != file.getSize() || header.entity_count >= NULL_INDEX)
+  {
+    throw std::runtime_error("failed to load scene, file is corrupt");
+  }
+
+  auto& registry = GetCodecs();
+  std::lock_guard<std::mutex> lock{registry.mutex};
+
+  LoadContext context{};
+  const auto* asset_entries =
+      Section<AssetEntry>(file, header.assets_offset, header.asset_count);
+  context.models.resize(header.asset_count);
+  context.textures.resize(header.asset_count);
+  for (uint32_t i = 0; i < header.asset_count; ++i)
+  {
+    if (assets == nullptr)
+    {
+      throw std::runtime_error("failed to load scene, no asset cache given");
+    }
+    const auto& asset = asset_entries[i];
+    const std::string asset_path{
+        Section<char>(file, asset.path_offset, asset.path_length),
+        asset.path_length};
+    if (asset.type == AssetType::Model)
+    {
+      context.models[i] = assets->getModel(asset_path);
+    }
+    else if (asset.type == AssetType::Texture)
+    {
+      context.textures[i] = assets->getTexture(asset_path);
+    }
+  }
+
+  std::vector<CoreVuEntity> entities(header.entity_count, NULL_ENTITY);
+  const auto* archetype_entries = Section<ArchetypeEntry>(
+      file, header.archetypes_offset, header.archetype_count);
+
+  struct LoadedColumn
+  {
+    const ComponentCodec* codec;
+    const uint8_t* rows;
+  };
+  std::vector<LoadedColumn> columns;
+  uint64_t file_id = 0;
+  for (uint32_t a = 0; a < header.archetype_count; ++a)
+  {
+    const auto& entry = archetype_entries[a];
+    if (file_id + entry.entity_count > header.entity_count)
+    {
+      throw std::runtime_error("failed to load scene, file is corrupt");
+    }
+
+    const auto* column_entries =
+        Section<ColumnEntry>(file, entry.columns_offset, entry.column_count);
+    columns.clear();
+    ComponentMask mask{};
+    for (uint32_t c = 0; c < entry.column_count; ++c)
+    {
+      const auto& column = column_entries[c];
+      if (column.name[MAX_NAME_LENGTH - 1] != '\0')
+      {
+        throw std::runtime_error("failed to load scene, file is corrupt");
+      }
+      const auto* codec = registry.find(column.name);
+      if (codec == nullptr) continue; // not known by this build
+      if (codec->stored_size != column.stored_size)
+      {
+        throw std::runtime_error(
+            std::string{"failed to load scene, layout of "} + column.name +
+            " changed");
+      }
+      columns.push_back(LoadedColumn{
+          codec, Section<uint8_t>(
+                     file, column.data_offset,
+                     uint64_t{entry.entity_count} * column.stored_size)});
+      mask.set(codec->id);
+    }
+
+    world.createEntities(
+        mask, entry.entity_count,
+        [&](CoreVuArchetype& archetype, size_t chunk, uint32_t first_row,
+            uint32_t row_count)
+        {
+          const CoreVuEntity* created =
+              archetype.getEntities(chunk) + first_row;
+          std::memcpy(
+              &entities[file_id], created, row_count * sizeof(CoreVuEntity));
+          for (auto& column : columns)
+          {
+            const auto* codec = column.codec;
+            const size_t size =
+                CoreVuComponentRegistry::GetInfo(codec->id).size;
+            codec->load(
+                *codec, context, column.rows, row_count,
+                static_cast<uint8_t*>(archetype.getColumn(chunk, codec->id)) +
+                    first_row * size,
+                created);
+            column.rows += size_t{row_count} * codec->stored_size;
+          }
+          file_id += row_count;
+        });
+  }
+
+  for (const auto& [child, parent] : context.parents)
+  {
+    if (parent >= entities.size())
+    {
+      throw std::runtime_error("failed to load scene, file is corrupt");
+    }
+    transform_system.setParent(world, child, entities[parent]);
+  }
+  return entities;
+}
+
+} // namespace corevu
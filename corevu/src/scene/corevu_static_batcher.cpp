@@ -0,0 +1,300 @@
+#include "scene/corevu_static_batcher.hpp"
+
+#include "corevu_components.hpp"
+#include "corevu_model.hpp"
+#include "jobs/corevu_job_system.hpp"
+#include "scene/corevu_asset_cache.hpp"
+
+// libs
+#include <Tracy.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+// std
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace corevu
+{
+
+namespace
+{
+struct StaticMesh
+{
+  CoreVuEntity entity;
+  const CoreVuModel* model;
+  uint32_t source; // index into the loaded source meshes
+  bool textured;
+  std::shared_ptr<CoreVuTexture> texture;
+  glm::mat4 world_matrix;
+};
+
+// where a mesh goes in the merged buffers of its batch
+struct MeshRange
+{
+  uint32_t first_vertex;
+  uint32_t first_index;
+};
+
+auto GroupKey(const CoreVuStaticBatchMesh& mesh, const glm::ivec3& cell)
+{
+  return std::make_tuple(
+      mesh.textured, reinterpret_cast<uintptr_t>(mesh.texture), cell.x, cell.y,
+      cell.z);
+}
+
+template <typename Fn>
+void ForEach(
+    CoreVuJobSystem* job_system, uint32_t count, uint32_t batch, Fn&& fn)
+{
+  if (job_system != nullptr)
+  {
+    job_system->parallelFor(count, batch, fn);
+  }
+  else
+  {
+    fn(0u, count);
+  }
+}
+
+/* From the TRS of the transform and its parents, TransformSystem::update may
+ * not have run yet when the scene is built. */
+glm::mat4 ComputeWorldMatrix(
+    const CoreVuWorld& world, const TransformComponent& transform)
+{
+  glm::mat4 matrix = transform.ToMat4();
+  CoreVuEntity parent = transform.GetParent();
+  while (parent != NULL_ENTITY && world.isAlive(parent))
+  {
+    const auto* parent_transform =
+        world.getComponent<const TransformComponent>(parent);
+    if (parent_transform == nullptr) break;
+    matrix = parent_transform->ToMat4() * matrix;
+    parent = parent_transform->GetParent();
+  }
+  return matrix;
+}
+
+uint32_t GetIndexCount(const CoreVuModel::Builder& source)
+{
+  // meshes without indices draw their vertices in order
+  return static_cast<uint32_t>(
+      source.indices.empty() ? source.vertices.size() : source.indices.size());
+}
+
+void AppendMesh(
+    const CoreVuModel::Builder& source, const glm::mat4& world_matrix,
+    const MeshRange& range, CoreVuModel::Builder& batch)
+{
+  const glm::mat3 normal_matrix =
+      glm::inverseTranspose(glm::mat3{world_matrix});
+  CoreVuModel::Vertex* vertices = batch.vertices.data() + range.first_vertex;
+  for (size_t i = 0; i < source.vertices.size(); ++i)
+  {
+    CoreVuModel::Vertex vertex = source.vertices[i];
+    vertex.position = glm::vec3{world_matrix * glm::vec4{vertex.position, 1.f}};
+    vertex.normal = normal_matrix * vertex.normal;
+    if (glm::dot(vertex.normal, vertex.normal) > 0.f)
+    {
+      vertex.normal = glm::normalize(vertex.normal);
+    }
+    vertices[i] = vertex;
+  }
+
+  // a mirroring matrix turns the triangles inside out, swap two corners back
+  const bool mirrored = glm::determinant(glm::mat3{world_matrix}) < 0.f;
+  CoreVuModel::Index* indices = batch.indices.data() + range.first_index;
+  const uint32_t index_count = GetIndexCount(source);
+  for (uint32_t i = 0; i < index_count; ++i)
+  {
+    const uint32_t corner = mirrored && i % 3 != 0 ? i + 3 - 2 * (i % 3) : i;
+    const uint32_t index =
+        source.indices.empty() ? corner : source.indices[corner].value;
+    indices[i] = CoreVuModel::Index{range.first_vertex + index};
+  }
+}
+} // namespace
+
+CoreVuStaticBatchStats CoreVuStaticBatcher::build(CoreVuWorld& world)
+{
+  ZoneScoped;
+  CoreVuStaticBatchStats stats{};
+
+  // static meshes with the models to read back from their files
+  std::vector<StaticMesh> meshes;
+  std::vector<const std::string*> source_paths;
+  std::unordered_map<const CoreVuModel*, uint32_t> source_indices;
+  world.query<const StaticComponent, const TransformComponent,
+              const ModelComponent>()
+      .each(
+          [&](CoreVuEntity entity, const StaticComponent&,
+              const TransformComponent& transform, const ModelComponent& mesh)
+          {
+            if (mesh.model == nullptr) return;
+            const std::string* path = m_assets.getPath(mesh.model.get());
+            if (path == nullptr)
+            {
+              stats.skipped++;
+              return;
+            }
+            const auto [it, inserted] = source_indices.emplace(
+                mesh.model.get(),
+                static_cast<uint32_t>(source_paths.size()));
+            if (inserted) source_paths.push_back(path);
+
+            const auto* texture =
+                world.getComponent<const TextureComponent>(entity);
+            meshes.push_back(StaticMesh{
+                entity, mesh.model.get(), it->second, texture != nullptr,
+                texture != nullptr ? texture->diffuse_map : nullptr,
+                ComputeWorldMatrix(world, transform)});
+          });
+
+  const auto source_count = static_cast<uint32_t>(source_paths.size());
+  std::vector<CoreVuModel::Builder> sources(source_count);
+  ForEach(
+      m_job_system, source_count, 1,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          sources[i].loadModel(*source_paths[i]);
+        }
+      });
+
+  std::vector<CoreVuStaticBatchMesh> batch_meshes;
+  batch_meshes.reserve(meshes.size());
+  for (const StaticMesh& mesh : meshes)
+  {
+    batch_meshes.push_back(CoreVuStaticBatchMesh{
+        &sources[mesh.source], mesh.world_matrix, mesh.textured,
+        mesh.texture.get()});
+  }
+  std::vector<CoreVuStaticBatch> batches =
+      Merge(batch_meshes, m_cell_size, m_job_system);
+
+  for (CoreVuStaticBatch& batch : batches)
+  {
+    // before the LODs are appended to the indices
+    stats.vertices += batch.builder.vertices.size();
+    stats.triangles += batch.builder.indices.size() / 3;
+
+    bool has_bvh = false;
+    for (uint32_t i : batch.meshes)
+    {
+      has_bvh = has_bvh || meshes[i].model->GetBvh() != nullptr;
+    }
+    batch.builder.generateLods();
+    if (has_bvh)
+    {
+      batch.builder.buildBvh(m_job_system);
+    }
+    auto model = std::make_shared<CoreVuModel>(m_device, batch.builder);
+
+    // world space vertices, the batch sits at the origin
+    const CoreVuEntity entity =
+        world.createEntity(TransformComponent{}, ModelComponent{model});
+    const StaticMesh& first = meshes[batch.meshes.front()];
+    if (first.textured)
+    {
+      world.addComponent(entity, TextureComponent{first.texture});
+    }
+    for (uint32_t i : batch.meshes)
+    {
+      world.removeComponent<TextureComponent>(meshes[i].entity);
+      world.removeComponent<ModelComponent>(meshes[i].entity);
+    }
+
+    stats.objects += static_cast<uint32_t>(batch.meshes.size());
+    stats.batches++;
+  }
+  stats.skipped += static_cast<uint32_t>(meshes.size()) - stats.objects;
+  return stats;
+}
+
+std::vector<CoreVuStaticBatch> CoreVuStaticBatcher::Merge(
+    std::span<const CoreVuStaticBatchMesh> meshes, float cell_size,
+    CoreVuJobSystem* job_system)
+{
+  ZoneScoped;
+  const auto mesh_count = static_cast<uint32_t>(meshes.size());
+  std::vector<glm::ivec3> cells(mesh_count);
+  std::vector<uint32_t> order(mesh_count);
+  for (uint32_t i = 0; i < mesh_count; ++i)
+  {
+    const glm::vec3 center{
+        meshes[i].world_matrix *
+        glm::vec4{meshes[i].source->bounding_sphere.center, 1.f}};
+    cells[i] = glm::ivec3{glm::floor(center / cell_size)};
+    order[i] = i;
+  }
+  const auto group_key = [&](uint32_t i)
+  { return GroupKey(meshes[i], cells[i]); };
+
+  // groups by pipeline, texture and cell, input order inside a group
+  std::stable_sort(
+      order.begin(), order.end(),
+      [&](uint32_t a, uint32_t b) { return group_key(a) < group_key(b); });
+
+  std::vector<CoreVuStaticBatch> batches;
+  std::vector<MeshRange> ranges;
+  size_t begin = 0;
+  while (begin < order.size())
+  {
+    // the next batch: same group, up to MAX_BATCH_VERTICES
+    size_t end = begin;
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    while (end < order.size() &&
+           group_key(order[end]) == group_key(order[begin]))
+    {
+      const auto& source = *meshes[order[end]].source;
+      if (end > begin &&
+          vertex_count + source.vertices.size() > MAX_BATCH_VERTICES)
+      {
+        break;
+      }
+      vertex_count += source.vertices.size();
+      index_count += GetIndexCount(source);
+      end++;
+    }
+    if (end - begin < 2)
+    {
+      begin = end;
+      continue;
+    }
+
+    CoreVuStaticBatch& batch = batches.emplace_back();
+    batch.meshes.assign(order.begin() + begin, order.begin() + end);
+    batch.builder.vertices.resize(vertex_count);
+    batch.builder.indices.resize(index_count);
+    ranges.clear();
+    MeshRange range{0, 0};
+    for (uint32_t i : batch.meshes)
+    {
+      ranges.push_back(range);
+      const auto& source = *meshes[i].source;
+      range.first_vertex += static_cast<uint32_t>(source.vertices.size());
+      range.first_index += GetIndexCount(source);
+    }
+    ForEach(
+        job_system, static_cast<uint32_t>(batch.meshes.size()), 16,
+        [&](uint32_t first, uint32_t last)
+        {
+          for (uint32_t i = first; i < last; ++i)
+          {
+            const CoreVuStaticBatchMesh& mesh = meshes[batch.meshes[i]];
+            AppendMesh(
+                *mesh.source, mesh.world_matrix, ranges[i], batch.builder);
+          }
+        });
+    batch.builder.computeBounds();
+    begin = end;
+  }
+  return batches;
+}
+
+} // namespace corevu
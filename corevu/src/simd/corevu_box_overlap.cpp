@@ -0,0 +1,36 @@
+#include <simd/corevu_box_overlap.hpp>
+
+#include "corevu_box_overlap_kernel.hpp"
+
+namespace corevu
+{
+
+size_t OverlapBoxes(
+    const CoreVuAabb& box, const CoreVuBoxSoA& boxes, uint32_t begin,
+    uint32_t end, uint32_t* hits)
+{
+  size_t hit_count = 0;
+  uint32_t done = begin;
+#if COREVU_SIMD_X86
+  if (GetSimdLevel() >= CoreVuSimdLevel::AVX2)
+  {
+    const float packed[6]{box.min.x, box.min.y, box.min.z,
+                          box.max.x, box.max.y, box.max.z};
+    done = simd_detail::OverlapBoxesAVX2(
+        packed, boxes, begin, end, hits, hit_count);
+  }
+#endif
+
+  for (uint32_t i = done; i < end; ++i)
+  {
+    if (boxes.min_x[i] <= box.max.x && box.min.x <= boxes.max_x[i] &&
+        boxes.min_y[i] <= box.max.y && box.min.y <= boxes.max_y[i] &&
+        boxes.min_z[i] <= box.max.z && box.min.z <= boxes.max_z[i])
+    {
+      hits[hit_count++] = i;
+    }
+  }
+  return hit_count;
+}
+
+} // namespace corevu
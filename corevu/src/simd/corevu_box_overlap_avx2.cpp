@@ -0,0 +1,55 @@
+#include "corevu_box_overlap_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+uint32_t OverlapBoxesAVX2(
+    const float* box, const CoreVuBoxSoA& boxes, uint32_t begin, uint32_t end,
+    uint32_t* hits, size_t& hit_count)
+{
+  const __m256 min_x = _mm256_set1_ps(box[0]);
+  const __m256 min_y = _mm256_set1_ps(box[1]);
+  const __m256 min_z = _mm256_set1_ps(box[2]);
+  const __m256 max_x = _mm256_set1_ps(box[3]);
+  const __m256 max_y = _mm256_set1_ps(box[4]);
+  const __m256 max_z = _mm256_set1_ps(box[5]);
+
+  size_t hit_end = hit_count;
+  uint32_t i = begin;
+  for (; i + 8 <= end; i += 8)
+  {
+    // other.min <= box.max and box.min <= other.max on every axis
+    __m256 mask = _mm256_and_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(boxes.min_x + i), max_x, _CMP_LE_OQ),
+        _mm256_cmp_ps(min_x, _mm256_loadu_ps(boxes.max_x + i), _CMP_LE_OQ));
+    mask = _mm256_and_ps(
+        mask,
+        _mm256_cmp_ps(_mm256_loadu_ps(boxes.min_y + i), max_y, _CMP_LE_OQ));
+    mask = _mm256_and_ps(
+        mask,
+        _mm256_cmp_ps(min_y, _mm256_loadu_ps(boxes.max_y + i), _CMP_LE_OQ));
+    mask = _mm256_and_ps(
+        mask,
+        _mm256_cmp_ps(_mm256_loadu_ps(boxes.min_z + i), max_z, _CMP_LE_OQ));
+    mask = _mm256_and_ps(
+        mask,
+        _mm256_cmp_ps(min_z, _mm256_loadu_ps(boxes.max_z + i), _CMP_LE_OQ));
+
+    const auto bits = static_cast<uint32_t>(_mm256_movemask_ps(mask));
+    if (bits == 0) continue; // most candidates miss
+
+    for (uint32_t lane = 0; lane < 8; ++lane)
+    {
+      hits[hit_end] = i + lane;
+      hit_end += (bits >> lane) & 1u;
+    }
+  }
+  hit_count = hit_end;
+  return i;
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <simd/corevu_box_overlap.hpp>
+
+#include "corevu_transform_batch_kernel.hpp"
+
+// std
+#include <cstddef>
+
+namespace corevu
+{
+namespace simd_detail
+{
+/* box: min xyz, max xyz. Same rules as the transform kernels: own translation
+ * unit, whole registers only, returns the index it stopped at, hit_count is
+ * advanced by the hits written. */
+uint32_t OverlapBoxesAVX2(
+    const float* box, const CoreVuBoxSoA& boxes, uint32_t begin, uint32_t end,
+    uint32_t* hits, size_t& hit_count);
+} // namespace simd_detail
+} // namespace corevu
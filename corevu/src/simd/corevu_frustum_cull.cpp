@@ -0,0 +1,50 @@
+#include <simd/corevu_frustum_cull.hpp>
+
+#include "corevu_frustum_cull_kernel.hpp"
+
+namespace corevu
+{
+
+size_t CullSpheres(
+    const CoreVuFrustum& frustum, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible)
+{
+  static_assert(sizeof(frustum.planes) == 24 * sizeof(float));
+  const float* planes = &frustum.planes[0][0];
+
+  size_t visible_count = 0;
+  size_t done = 0;
+  switch (GetSimdLevel())
+  {
+#if COREVU_SIMD_X86
+  case CoreVuSimdLevel::AVX512:
+    done = simd_detail::CullSpheresAVX512(
+        planes, spheres, count, visible, visible_count);
+    break;
+  case CoreVuSimdLevel::AVX2:
+    done = simd_detail::CullSpheresAVX2(
+        planes, spheres, count, visible, visible_count);
+    break;
+  case CoreVuSimdLevel::SSE42:
+    done = simd_detail::CullSpheresSSE42(
+        planes, spheres, count, visible, visible_count);
+    break;
+#endif
+  default:
+    break;
+  }
+
+  for (size_t i = done; i < count; ++i)
+  {
+    const CoreVuSphere sphere{
+        {spheres.center_x[i], spheres.center_y[i], spheres.center_z[i]},
+        spheres.radius[i]};
+    if (Intersects(frustum, sphere))
+    {
+      visible[visible_count++] = static_cast<uint32_t>(i);
+    }
+  }
+  return visible_count;
+}
+
+} // namespace corevu
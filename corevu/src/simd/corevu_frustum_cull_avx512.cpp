@@ -0,0 +1,62 @@
+#include "corevu_frustum_cull_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+namespace
+{
+struct Avx512CullLanes
+{
+  using Float = __m512;
+  using Mask = __mmask16;
+  static constexpr size_t WIDTH = 16;
+
+  static Float Load(const float* p) { return _mm512_loadu_ps(p); }
+  static Float Set(float v) { return _mm512_set1_ps(v); }
+  static Float Add(Float a, Float b) { return _mm512_add_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+  static Float Neg(Float v)
+  {
+    return _mm512_castsi512_ps(_mm512_xor_si512(
+        _mm512_castps_si512(v), _mm512_set1_epi32(0x80000000)));
+  }
+
+  static Mask AllLanes() { return static_cast<Mask>(0xffff); }
+  static Mask And(Mask a, Mask b) { return static_cast<Mask>(a & b); }
+  static Mask GreaterEqual(Float a, Float b)
+  {
+    return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ);
+  }
+  // the inside lanes' indices are stored packed by the compress store
+  static size_t Compact(
+      Mask m, uint32_t first, uint32_t* visible, size_t visible_end)
+  {
+    const __m512i lanes = _mm512_setr_epi32(
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i indices =
+        _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(first)), lanes);
+    _mm512_mask_compressstoreu_epi32(visible + visible_end, m, indices);
+
+    uint32_t bits = m;
+    for (; bits != 0; bits &= bits - 1)
+    {
+      visible_end++;
+    }
+    return visible_end;
+  }
+};
+} // namespace
+
+size_t CullSpheresAVX512(
+    const float* planes, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible, size_t& visible_count)
+{
+  return CullSpheresBatch<Avx512CullLanes>(
+      planes, spheres, count, visible, visible_count);
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
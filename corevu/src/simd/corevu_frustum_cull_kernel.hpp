@@ -0,0 +1,98 @@
+#pragma once
+
+#include <simd/corevu_frustum_cull.hpp>
+
+#include "corevu_transform_batch_kernel.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+namespace corevu
+{
+namespace simd_detail
+{
+/* One translation unit per instruction set, same rules as the transform
+ * kernels. planes are 6 x {nx, ny, nz, d}. They test whole registers only,
+ * return how many spheres they did and add the visible ones to
+ * visible[visible_count..]. */
+size_t CullSpheresSSE42(
+    const float* planes, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible, size_t& visible_count);
+size_t CullSpheresAVX2(
+    const float* planes, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible, size_t& visible_count);
+size_t CullSpheresAVX512(
+    const float* planes, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible, size_t& visible_count);
+
+#if COREVU_SIMD_X86
+// file local in each kernel unit
+namespace
+{
+template <typename V>
+size_t CullSpheresBatch(
+    const float* planes, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible, size_t& visible_count)
+{
+  using Float = typename V::Float;
+  constexpr size_t W = V::WIDTH;
+  constexpr size_t PLANE_COUNT = 6;
+
+  Float normal_x[PLANE_COUNT];
+  Float normal_y[PLANE_COUNT];
+  Float normal_z[PLANE_COUNT];
+  Float distance[PLANE_COUNT];
+  for (size_t p = 0; p < PLANE_COUNT; ++p)
+  {
+    normal_x[p] = V::Set(planes[p * 4 + 0]);
+    normal_y[p] = V::Set(planes[p * 4 + 1]);
+    normal_z[p] = V::Set(planes[p * 4 + 2]);
+    distance[p] = V::Set(planes[p * 4 + 3]);
+  }
+
+  size_t visible_end = visible_count;
+  const size_t vector_count = count - count % W;
+  for (size_t i = 0; i < vector_count; i += W)
+  {
+    const Float x = V::Load(spheres.center_x + i);
+    const Float y = V::Load(spheres.center_y + i);
+    const Float z = V::Load(spheres.center_z + i);
+    const Float negative_radius = V::Neg(V::Load(spheres.radius + i));
+
+    auto inside = V::AllLanes();
+    for (size_t p = 0; p < PLANE_COUNT; ++p)
+    {
+      // summed in the order of the scalar test(glm::dot + d)
+      const Float signed_distance = V::Add(
+          V::Add(
+              V::Add(V::Mul(normal_x[p], x), V::Mul(normal_y[p], y)),
+              V::Mul(normal_z[p], z)),
+          distance[p]);
+      inside =
+          V::And(inside, V::GreaterEqual(signed_distance, negative_radius));
+    }
+    visible_end =
+        V::Compact(inside, static_cast<uint32_t>(i), visible, visible_end);
+  }
+  visible_count = visible_end;
+  return vector_count;
+}
+
+/* Branchless compaction of a lane bit mask: every lane writes its index, only
+ * the inside ones advance the end. */
+inline size_t CompactBits(
+    uint32_t bits, size_t width, uint32_t first, uint32_t* visible,
+    size_t visible_end)
+{
+  for (size_t lane = 0; lane < width; ++lane)
+  {
+    visible[visible_end] = first + static_cast<uint32_t>(lane);
+    visible_end += (bits >> lane) & 1u;
+  }
+  return visible_end;
+}
+} // namespace
+#endif
+} // namespace simd_detail
+} // namespace corevu
@@ -0,0 +1,45 @@
+#include "corevu_frustum_cull_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+namespace
+{
+struct Sse42CullLanes
+{
+  using Float = __m128;
+  using Mask = __m128;
+  static constexpr size_t WIDTH = 4;
+
+  static Float Load(const float* p) { return _mm_loadu_ps(p); }
+  static Float Set(float v) { return _mm_set1_ps(v); }
+  static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+  static Float Neg(Float v) { return _mm_xor_ps(v, _mm_set1_ps(-0.0f)); }
+
+  static Mask AllLanes() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+  static Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+  static Mask GreaterEqual(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+  static size_t Compact(
+      Mask m, uint32_t first, uint32_t* visible, size_t visible_end)
+  {
+    return CompactBits(
+        static_cast<uint32_t>(_mm_movemask_ps(m)), WIDTH, first, visible,
+        visible_end);
+  }
+};
+} // namespace
+
+size_t CullSpheresSSE42(
+    const float* planes, const CoreVuSphereSoA& spheres, size_t count,
+    uint32_t* visible, size_t& visible_count)
+{
+  return CullSpheresBatch<Sse42CullLanes>(
+      planes, spheres, count, visible, visible_count);
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
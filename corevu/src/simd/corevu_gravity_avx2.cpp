@@ -0,0 +1,101 @@
+#include "corevu_gravity_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+namespace
+{
+/* 1 / r^3 from r^2 through rsqrt and one newton step(~1e-7 relative), lanes
+ * closer than GRAVITY_MIN_DISTANCE2 are masked by the caller. */
+inline __m256 InverseCube(__m256 r2)
+{
+  __m256 r = _mm256_rsqrt_ps(r2);
+  const __m256 rr2 = _mm256_mul_ps(_mm256_mul_ps(r2, r), r);
+  r = _mm256_mul_ps(
+      _mm256_mul_ps(_mm256_set1_ps(.5f), r),
+      _mm256_sub_ps(_mm256_set1_ps(3.f), rr2));
+  return _mm256_mul_ps(_mm256_mul_ps(r, r), r);
+}
+
+/* Adds the pull of one source to R target registers, R registers in flight
+ * hide the latency of rsqrt and the multiplies. */
+template <int R>
+inline void Accumulate(
+    const __m256* x, const __m256* y, __m256 sx, __m256 sy, __m256 sm,
+    __m256 softening2, __m256 min_distance2, __m256* ax, __m256* ay)
+{
+  for (int r = 0; r < R; ++r)
+  {
+    const __m256 dx = _mm256_sub_ps(sx, x[r]);
+    const __m256 dy = _mm256_sub_ps(sy, y[r]);
+    const __m256 d2 =
+        _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    const __m256 pull = _mm256_and_ps(
+        _mm256_mul_ps(sm, InverseCube(_mm256_add_ps(d2, softening2))),
+        _mm256_cmp_ps(d2, min_distance2, _CMP_GE_OQ));
+    ax[r] = _mm256_add_ps(ax[r], _mm256_mul_ps(pull, dx));
+    ay[r] = _mm256_add_ps(ay[r], _mm256_mul_ps(pull, dy));
+  }
+}
+
+template <int R>
+void Targets(
+    const float* source_x, const float* source_y, const float* source_mass,
+    size_t source_count, const float* target_x, const float* target_y,
+    float softening2, float* acceleration_x, float* acceleration_y)
+{
+  __m256 x[R];
+  __m256 y[R];
+  __m256 ax[R];
+  __m256 ay[R];
+  for (int r = 0; r < R; ++r)
+  {
+    x[r] = _mm256_loadu_ps(target_x + r * 8);
+    y[r] = _mm256_loadu_ps(target_y + r * 8);
+    ax[r] = _mm256_setzero_ps();
+    ay[r] = _mm256_setzero_ps();
+  }
+  const __m256 soft = _mm256_set1_ps(softening2);
+  const __m256 min_distance2 = _mm256_set1_ps(GRAVITY_MIN_DISTANCE2);
+  for (size_t j = 0; j < source_count; ++j)
+  {
+    Accumulate<R>(
+        x, y, _mm256_broadcast_ss(source_x + j),
+        _mm256_broadcast_ss(source_y + j), _mm256_broadcast_ss(source_mass + j),
+        soft, min_distance2, ax, ay);
+  }
+  for (int r = 0; r < R; ++r)
+  {
+    _mm256_storeu_ps(acceleration_x + r * 8, ax[r]);
+    _mm256_storeu_ps(acceleration_y + r * 8, ay[r]);
+  }
+}
+} // namespace
+
+size_t GravityAVX2(
+    const float* source_x, const float* source_y, const float* source_mass,
+    size_t source_count, const float* target_x, const float* target_y,
+    size_t target_count, float softening2, float* acceleration_x,
+    float* acceleration_y)
+{
+  size_t i = 0;
+  for (; i + 16 <= target_count; i += 16)
+  {
+    Targets<2>(
+        source_x, source_y, source_mass, source_count, target_x + i,
+        target_y + i, softening2, acceleration_x + i, acceleration_y + i);
+  }
+  for (; i + 8 <= target_count; i += 8)
+  {
+    Targets<1>(
+        source_x, source_y, source_mass, source_count, target_x + i,
+        target_y + i, softening2, acceleration_x + i, acceleration_y + i);
+  }
+  return i;
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
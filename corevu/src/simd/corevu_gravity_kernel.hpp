@@ -0,0 +1,25 @@
+#pragma once
+
+#include "corevu_transform_batch_kernel.hpp"
+
+// std
+#include <cstddef>
+
+namespace corevu
+{
+namespace simd_detail
+{
+// pairs closer than this(squared) pull nothing
+constexpr float GRAVITY_MIN_DISTANCE2 = 1e-10f;
+
+/* Accelerations of targets from point masses, without the strength factor:
+ * sum of mass * d / (|d|^2 + softening2)^1.5. Same rules as the transform
+ * kernels: own translation unit, whole registers only, returns how many
+ * targets it wrote to acceleration_x/y. */
+size_t GravityAVX2(
+    const float* source_x, const float* source_y, const float* source_mass,
+    size_t source_count, const float* target_x, const float* target_y,
+    size_t target_count, float softening2, float* acceleration_x,
+    float* acceleration_y);
+} // namespace simd_detail
+} // namespace corevu
@@ -0,0 +1,140 @@
+#include <simd/corevu_ray_intersect.hpp>
+
+#include "corevu_ray_intersect_kernel.hpp"
+
+// std
+#include <cassert>
+
+namespace corevu
+{
+namespace
+{
+// Moeller-Trumbore, two sided, same rules as the kernels
+bool IntersectTriangle(
+    const CoreVuRay& ray, const glm::vec3& v0, const glm::vec3& e1,
+    const glm::vec3& e2, float max_distance, float& t, float& u, float& v)
+{
+  const glm::vec3 p = glm::cross(ray.direction, e2);
+  const float det = glm::dot(e1, p);
+  if (det == 0.f) return false;
+
+  const float inverse_det = 1.f / det;
+  const glm::vec3 s = ray.origin - v0;
+  u = glm::dot(s, p) * inverse_det;
+  const glm::vec3 q = glm::cross(s, e1);
+  v = glm::dot(ray.direction, q) * inverse_det;
+  t = glm::dot(e2, q) * inverse_det;
+  return u >= 0.f && v >= 0.f && u + v <= 1.f && t >= 0.f &&
+         t < max_distance;
+}
+
+glm::vec3 Load(const float* x, const float* y, const float* z, uint32_t i)
+{
+  return glm::vec3{x[i], y[i], z[i]};
+}
+} // namespace
+
+bool IntersectTriangles(
+    const CoreVuRay& ray, const CoreVuTriangleSoA& triangles, uint32_t begin,
+    uint32_t end, CoreVuTriangleHit& hit)
+{
+  assert(
+      begin % CoreVuTriangleSoA::GROUP_SIZE == 0 &&
+      end % CoreVuTriangleSoA::GROUP_SIZE == 0 &&
+      "IntersectTriangles takes whole groups");
+  const uint32_t previous = hit.triangle;
+  uint32_t done = begin;
+#if COREVU_SIMD_X86
+  if (GetSimdLevel() >= CoreVuSimdLevel::AVX2)
+  {
+    const float packed[7]{ray.origin.x,    ray.origin.y,    ray.origin.z,
+                          ray.direction.x, ray.direction.y, ray.direction.z,
+                          ray.max_distance};
+    done = simd_detail::IntersectTrianglesAVX2(
+        packed, triangles, begin, end, hit);
+  }
+#endif
+
+  for (uint32_t i = done; i < end; ++i)
+  {
+    float t, u, v;
+    if (IntersectTriangle(
+            ray, Load(triangles.v0_x, triangles.v0_y, triangles.v0_z, i),
+            Load(triangles.e1_x, triangles.e1_y, triangles.e1_z, i),
+            Load(triangles.e2_x, triangles.e2_y, triangles.e2_z, i),
+            hit.distance, t, u, v))
+    {
+      hit = CoreVuTriangleHit{i, t, u, v};
+    }
+  }
+  return hit.triangle != previous;
+}
+
+uint32_t IntersectPacketBox(
+    const CoreVuRayPacket& packet, uint32_t active, const CoreVuAabb& box)
+{
+#if COREVU_SIMD_X86
+  if (GetSimdLevel() >= CoreVuSimdLevel::AVX2)
+  {
+    const float packed[6]{box.min.x, box.min.y, box.min.z,
+                          box.max.x, box.max.y, box.max.z};
+    return simd_detail::IntersectPacketBoxAVX2(packet, active, packed);
+  }
+#endif
+
+  uint32_t hits = 0;
+  for (uint32_t lane = 0; lane < CoreVuRayPacket::SIZE; ++lane)
+  {
+    if ((active >> lane & 1u) == 0) continue;
+
+    const glm::vec3 inverse_direction{
+        packet.inverse_x[lane], packet.inverse_y[lane],
+        packet.inverse_z[lane]};
+    float distance = 0.f;
+    if (IntersectRay(packet.get(lane), inverse_direction, box, distance))
+    {
+      hits |= 1u << lane;
+    }
+  }
+  return hits;
+}
+
+uint32_t IntersectPacketTriangles(
+    CoreVuRayPacket& packet, uint32_t active,
+    const CoreVuTriangleSoA& triangles, uint32_t begin, uint32_t end,
+    CoreVuTriangleHit* hits)
+{
+  if (active == 0) return 0;
+#if COREVU_SIMD_X86
+  if (GetSimdLevel() >= CoreVuSimdLevel::AVX2)
+  {
+    return simd_detail::IntersectPacketTrianglesAVX2(
+        packet, active, triangles, begin, end, hits);
+  }
+#endif
+
+  uint32_t hit_lanes = 0;
+  for (uint32_t lane = 0; lane < CoreVuRayPacket::SIZE; ++lane)
+  {
+    if ((active >> lane & 1u) == 0) continue;
+
+    const CoreVuRay ray = packet.get(lane);
+    for (uint32_t i = begin; i < end; ++i)
+    {
+      float t, u, v;
+      if (IntersectTriangle(
+              ray, Load(triangles.v0_x, triangles.v0_y, triangles.v0_z, i),
+              Load(triangles.e1_x, triangles.e1_y, triangles.e1_z, i),
+              Load(triangles.e2_x, triangles.e2_y, triangles.e2_z, i),
+              packet.max_distance[lane], t, u, v))
+      {
+        packet.max_distance[lane] = t;
+        hits[lane] = CoreVuTriangleHit{i, t, u, v};
+        hit_lanes |= 1u << lane;
+      }
+    }
+  }
+  return hit_lanes;
+}
+
+} // namespace corevu
@@ -0,0 +1,224 @@
+#include "corevu_ray_intersect_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+namespace
+{
+struct Vec3x8
+{
+  __m256 x;
+  __m256 y;
+  __m256 z;
+};
+
+inline __m256 Dot(const Vec3x8& a, const Vec3x8& b)
+{
+  return _mm256_add_ps(
+      _mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)),
+      _mm256_mul_ps(a.z, b.z));
+}
+
+inline Vec3x8 Cross(const Vec3x8& a, const Vec3x8& b)
+{
+  return Vec3x8{
+      _mm256_sub_ps(_mm256_mul_ps(a.y, b.z), _mm256_mul_ps(a.z, b.y)),
+      _mm256_sub_ps(_mm256_mul_ps(a.z, b.x), _mm256_mul_ps(a.x, b.z)),
+      _mm256_sub_ps(_mm256_mul_ps(a.x, b.y), _mm256_mul_ps(a.y, b.x))};
+}
+
+/* Moeller-Trumbore on 8 lanes, whatever is broadcast. Returns the lanes hit
+ * nearer than max_distance, degenerate triangles(det 0) give NaNs that fail
+ * every ordered compare. */
+inline __m256 Intersect(
+    const Vec3x8& origin, const Vec3x8& direction, const Vec3x8& v0,
+    const Vec3x8& e1, const Vec3x8& e2, __m256 max_distance, __m256& t,
+    __m256& u, __m256& v)
+{
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.f);
+
+  const Vec3x8 p = Cross(direction, e2);
+  const __m256 det = Dot(e1, p);
+  const __m256 inverse_det = _mm256_div_ps(one, det);
+  const Vec3x8 s{
+      _mm256_sub_ps(origin.x, v0.x), _mm256_sub_ps(origin.y, v0.y),
+      _mm256_sub_ps(origin.z, v0.z)};
+  u = _mm256_mul_ps(Dot(s, p), inverse_det);
+  const Vec3x8 q = Cross(s, e1);
+  v = _mm256_mul_ps(Dot(direction, q), inverse_det);
+  t = _mm256_mul_ps(Dot(e2, q), inverse_det);
+
+  __m256 mask = _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ);
+  mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+  mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+  mask = _mm256_and_ps(
+      mask, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+  mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+  return _mm256_and_ps(mask, _mm256_cmp_ps(t, max_distance, _CMP_LT_OQ));
+}
+} // namespace
+
+uint32_t IntersectTrianglesAVX2(
+    const float* ray, const CoreVuTriangleSoA& triangles, uint32_t begin,
+    uint32_t end, CoreVuTriangleHit& hit)
+{
+  const Vec3x8 origin{
+      _mm256_set1_ps(ray[0]), _mm256_set1_ps(ray[1]), _mm256_set1_ps(ray[2])};
+  const Vec3x8 direction{
+      _mm256_set1_ps(ray[3]), _mm256_set1_ps(ray[4]), _mm256_set1_ps(ray[5])};
+
+  uint32_t i = begin;
+  for (; i + 8 <= end; i += 8)
+  {
+    const Vec3x8 v0{
+        _mm256_loadu_ps(triangles.v0_x + i),
+        _mm256_loadu_ps(triangles.v0_y + i),
+        _mm256_loadu_ps(triangles.v0_z + i)};
+    const Vec3x8 e1{
+        _mm256_loadu_ps(triangles.e1_x + i),
+        _mm256_loadu_ps(triangles.e1_y + i),
+        _mm256_loadu_ps(triangles.e1_z + i)};
+    const Vec3x8 e2{
+        _mm256_loadu_ps(triangles.e2_x + i),
+        _mm256_loadu_ps(triangles.e2_y + i),
+        _mm256_loadu_ps(triangles.e2_z + i)};
+    __m256 t, u, v;
+    const __m256 mask = Intersect(
+        origin, direction, v0, e1, e2, _mm256_set1_ps(hit.distance), t, u,
+        v);
+    const auto bits = static_cast<uint32_t>(_mm256_movemask_ps(mask));
+    if (bits == 0) continue; // most groups miss
+
+    alignas(32) float ts[8];
+    alignas(32) float us[8];
+    alignas(32) float vs[8];
+    _mm256_store_ps(ts, t);
+    _mm256_store_ps(us, u);
+    _mm256_store_ps(vs, v);
+    for (uint32_t lane = 0; lane < 8; ++lane)
+    {
+      if ((bits >> lane & 1u) != 0 && ts[lane] < hit.distance)
+      {
+        hit.triangle = i + lane;
+        hit.distance = ts[lane];
+        hit.u = us[lane];
+        hit.v = vs[lane];
+      }
+    }
+  }
+  return i;
+}
+
+uint32_t IntersectPacketBoxAVX2(
+    const CoreVuRayPacket& packet, uint32_t active, const float* box)
+{
+  const __m256 origin_x = _mm256_load_ps(packet.origin_x);
+  const __m256 origin_y = _mm256_load_ps(packet.origin_y);
+  const __m256 origin_z = _mm256_load_ps(packet.origin_z);
+  const __m256 inverse_x = _mm256_load_ps(packet.inverse_x);
+  const __m256 inverse_y = _mm256_load_ps(packet.inverse_y);
+  const __m256 inverse_z = _mm256_load_ps(packet.inverse_z);
+
+  const __m256 tx0 = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_set1_ps(box[0]), origin_x), inverse_x);
+  const __m256 ty0 = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_set1_ps(box[1]), origin_y), inverse_y);
+  const __m256 tz0 = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_set1_ps(box[2]), origin_z), inverse_z);
+  const __m256 tx1 = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_set1_ps(box[3]), origin_x), inverse_x);
+  const __m256 ty1 = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_set1_ps(box[4]), origin_y), inverse_y);
+  const __m256 tz1 = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_set1_ps(box[5]), origin_z), inverse_z);
+
+  const __m256 enter = _mm256_max_ps(
+      _mm256_max_ps(_mm256_min_ps(tx0, tx1), _mm256_min_ps(ty0, ty1)),
+      _mm256_max_ps(_mm256_min_ps(tz0, tz1), _mm256_setzero_ps()));
+  const __m256 exit = _mm256_min_ps(
+      _mm256_min_ps(_mm256_max_ps(tx0, tx1), _mm256_max_ps(ty0, ty1)),
+      _mm256_min_ps(
+          _mm256_max_ps(tz0, tz1), _mm256_load_ps(packet.max_distance)));
+  const auto bits = static_cast<uint32_t>(
+      _mm256_movemask_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ)));
+  return bits & active;
+}
+
+uint32_t IntersectPacketTrianglesAVX2(
+    CoreVuRayPacket& packet, uint32_t active,
+    const CoreVuTriangleSoA& triangles, uint32_t begin, uint32_t end,
+    CoreVuTriangleHit* hits)
+{
+  const Vec3x8 origin{
+      _mm256_load_ps(packet.origin_x), _mm256_load_ps(packet.origin_y),
+      _mm256_load_ps(packet.origin_z)};
+  const Vec3x8 direction{
+      _mm256_load_ps(packet.direction_x), _mm256_load_ps(packet.direction_y),
+      _mm256_load_ps(packet.direction_z)};
+  // inactive lanes never get closer than -1
+  const __m256 active_lanes = _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+      _mm256_and_si256(
+          _mm256_set1_epi32(static_cast<int>(active)),
+          _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128)),
+      _mm256_setzero_si256()));
+  __m256 closest = _mm256_blendv_ps(
+      _mm256_set1_ps(-1.f), _mm256_load_ps(packet.max_distance),
+      active_lanes);
+  __m256 closest_u = _mm256_setzero_ps();
+  __m256 closest_v = _mm256_setzero_ps();
+  __m256i closest_triangle = _mm256_set1_epi32(-1);
+  uint32_t hit_lanes = 0;
+
+  for (uint32_t i = begin; i < end; ++i)
+  {
+    const Vec3x8 v0{
+        _mm256_set1_ps(triangles.v0_x[i]), _mm256_set1_ps(triangles.v0_y[i]),
+        _mm256_set1_ps(triangles.v0_z[i])};
+    const Vec3x8 e1{
+        _mm256_set1_ps(triangles.e1_x[i]), _mm256_set1_ps(triangles.e1_y[i]),
+        _mm256_set1_ps(triangles.e1_z[i])};
+    const Vec3x8 e2{
+        _mm256_set1_ps(triangles.e2_x[i]), _mm256_set1_ps(triangles.e2_y[i]),
+        _mm256_set1_ps(triangles.e2_z[i])};
+    __m256 t, u, v;
+    const __m256 mask =
+        Intersect(origin, direction, v0, e1, e2, closest, t, u, v);
+    const auto bits = static_cast<uint32_t>(_mm256_movemask_ps(mask));
+    if (bits == 0) continue;
+
+    hit_lanes |= bits;
+    closest = _mm256_blendv_ps(closest, t, mask);
+    closest_u = _mm256_blendv_ps(closest_u, u, mask);
+    closest_v = _mm256_blendv_ps(closest_v, v, mask);
+    closest_triangle = _mm256_castps_si256(_mm256_blendv_ps(
+        _mm256_castsi256_ps(closest_triangle),
+        _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(i))), mask));
+  }
+  if (hit_lanes == 0) return 0;
+
+  alignas(32) float ts[8];
+  alignas(32) float us[8];
+  alignas(32) float vs[8];
+  alignas(32) uint32_t indices[8];
+  _mm256_store_ps(ts, closest);
+  _mm256_store_ps(us, closest_u);
+  _mm256_store_ps(vs, closest_v);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(indices), closest_triangle);
+  for (uint32_t lane = 0; lane < 8; ++lane)
+  {
+    if ((hit_lanes >> lane & 1u) == 0) continue;
+    packet.max_distance[lane] = ts[lane];
+    hits[lane].triangle = indices[lane];
+    hits[lane].distance = ts[lane];
+    hits[lane].u = us[lane];
+    hits[lane].v = vs[lane];
+  }
+  return hit_lanes;
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
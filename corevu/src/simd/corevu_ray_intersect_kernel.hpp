@@ -0,0 +1,28 @@
+#pragma once
+
+#include <simd/corevu_ray_intersect.hpp>
+
+#include "corevu_transform_batch_kernel.hpp"
+
+// std
+#include <cstdint>
+
+namespace corevu
+{
+namespace simd_detail
+{
+/* ray: origin xyz, direction xyz, max distance. box: min xyz, max xyz. Same
+ * rules as the transform kernels, IntersectTrianglesAVX2 does whole groups and
+ * returns the index it stopped at. The packet kernels are one register wide,
+ * they always do everything. */
+uint32_t IntersectTrianglesAVX2(
+    const float* ray, const CoreVuTriangleSoA& triangles, uint32_t begin,
+    uint32_t end, CoreVuTriangleHit& hit);
+uint32_t IntersectPacketBoxAVX2(
+    const CoreVuRayPacket& packet, uint32_t active, const float* box);
+uint32_t IntersectPacketTrianglesAVX2(
+    CoreVuRayPacket& packet, uint32_t active,
+    const CoreVuTriangleSoA& triangles, uint32_t begin, uint32_t end,
+    CoreVuTriangleHit* hits);
+} // namespace simd_detail
+} // namespace corevu
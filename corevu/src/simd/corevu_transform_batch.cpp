@@ -0,0 +1,174 @@
+#include <simd/corevu_transform_batch.hpp>
+
+#include "corevu_transform_batch_kernel.hpp"
+
+// std
+#include <atomic>
+
+#if COREVU_SIMD_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace corevu
+{
+
+namespace
+{
+// same math as TransformComponent::ToMat4(), gives bit equal model matrices
+void TransformBatchScalar(
+    const CoreVuTransformSoA& transforms, size_t begin, size_t end,
+    glm::mat4* model_matrices, glm::mat3* normal_matrices)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    const float c3 = glm::cos(transforms.rotation_z[i]);
+    const float s3 = glm::sin(transforms.rotation_z[i]);
+    const float c2 = glm::cos(transforms.rotation_x[i]);
+    const float s2 = glm::sin(transforms.rotation_x[i]);
+    const float c1 = glm::cos(transforms.rotation_y[i]);
+    const float s1 = glm::sin(transforms.rotation_y[i]);
+    const glm::vec3 scale{
+        transforms.scale_x[i], transforms.scale_y[i], transforms.scale_z[i]};
+
+    const glm::vec3 rotation_x{
+        (c1 * c3 + s1 * s2 * s3), (c2 * s3), (c1 * s2 * s3 - c3 * s1)};
+    const glm::vec3 rotation_y{
+        (c3 * s1 * s2 - c1 * s3), (c2 * c3), (c1 * c3 * s2 + s1 * s3)};
+    const glm::vec3 rotation_z{(c2 * s1), (-s2), (c1 * c2)};
+
+    model_matrices[i] = glm::mat4{
+        glm::vec4{scale.x * rotation_x, 0.0f},
+        glm::vec4{scale.y * rotation_y, 0.0f},
+        glm::vec4{scale.z * rotation_z, 0.0f},
+        glm::vec4{
+            transforms.translation_x[i], transforms.translation_y[i],
+            transforms.translation_z[i], 1.0f}};
+
+    if (normal_matrices != nullptr)
+    {
+      const glm::vec3 inverse_scale = 1.0f / scale;
+      normal_matrices[i] = glm::mat3{
+          inverse_scale.x * rotation_x, inverse_scale.y * rotation_y,
+          inverse_scale.z * rotation_z};
+    }
+  }
+}
+
+CoreVuSimdLevel DetectSimdLevel()
+{
+#if COREVU_SIMD_X86 && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+
+  __cpuid(info, 1);
+  const bool sse42 = (info[2] & (1 << 20)) != 0;
+  const bool os_xsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!sse42) return CoreVuSimdLevel::Scalar;
+  if (!os_xsave || !avx || max_leaf < 7) return CoreVuSimdLevel::SSE42;
+
+  // the os has to save the wide registers on context switches
+  const unsigned long long xcr0 = _xgetbv(0);
+  const bool os_avx = (xcr0 & 0x6) == 0x6;
+  const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+  __cpuidex(info, 7, 0);
+  const bool avx2 = (info[1] & (1 << 5)) != 0;
+  const bool avx512f = (info[1] & (1 << 16)) != 0;
+  if (avx512f && os_avx512) return CoreVuSimdLevel::AVX512;
+  if (avx2 && os_avx) return CoreVuSimdLevel::AVX2;
+  return CoreVuSimdLevel::SSE42;
+#elif COREVU_SIMD_X86
+  // checks the os support(xgetbv) as well
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return CoreVuSimdLevel::AVX512;
+  if (__builtin_cpu_supports("avx2")) return CoreVuSimdLevel::AVX2;
+  if (__builtin_cpu_supports("sse4.2")) return CoreVuSimdLevel::SSE42;
+  return CoreVuSimdLevel::Scalar;
+#else
+  return CoreVuSimdLevel::Scalar;
+#endif
+}
+
+std::atomic<CoreVuSimdLevel>& SelectedLevel()
+{
+  static std::atomic<CoreVuSimdLevel> level{GetSupportedSimdLevel()};
+  return level;
+}
+} // namespace
+
+const char* ToString(CoreVuSimdLevel level)
+{
+  switch (level)
+  {
+  case CoreVuSimdLevel::Scalar:
+    return "scalar";
+  case CoreVuSimdLevel::SSE42:
+    return "SSE4.2";
+  case CoreVuSimdLevel::AVX2:
+    return "AVX2";
+  case CoreVuSimdLevel::AVX512:
+    return "AVX-512";
+  }
+  return "unknown";
+}
+
+CoreVuSimdLevel GetSupportedSimdLevel()
+{
+  static const CoreVuSimdLevel supported = DetectSimdLevel();
+  return supported;
+}
+
+CoreVuSimdLevel GetSimdLevel()
+{
+  return SelectedLevel().load(std::memory_order_relaxed);
+}
+
+void SetSimdLevel(CoreVuSimdLevel level)
+{
+  if (level > GetSupportedSimdLevel())
+  {
+    level = GetSupportedSimdLevel();
+  }
+  SelectedLevel().store(level, std::memory_order_relaxed);
+}
+
+void ComputeTransformMatrices(
+    const CoreVuTransformSoA& transforms, size_t count,
+    glm::mat4* model_matrices, glm::mat3* normal_matrices)
+{
+  static_assert(sizeof(glm::mat4) == 16 * sizeof(float));
+  static_assert(sizeof(glm::mat3) == 9 * sizeof(float));
+  if (count == 0) return;
+
+  float* models = &model_matrices[0][0][0];
+  float* normals =
+      normal_matrices != nullptr ? &normal_matrices[0][0][0] : nullptr;
+
+  size_t done = 0;
+  switch (GetSimdLevel())
+  {
+#if COREVU_SIMD_X86
+  case CoreVuSimdLevel::AVX512:
+    done = simd_detail::TransformBatchAVX512(
+        transforms, count, models, normals);
+    break;
+  case CoreVuSimdLevel::AVX2:
+    done = simd_detail::TransformBatchAVX2(
+        transforms, count, models, normals);
+    break;
+  case CoreVuSimdLevel::SSE42:
+    done = simd_detail::TransformBatchSSE42(
+        transforms, count, models, normals);
+    break;
+#endif
+  default:
+    break;
+  }
+
+  TransformBatchScalar(
+      transforms, done, count, model_matrices, normal_matrices);
+}
+
+} // namespace corevu
@@ -0,0 +1,74 @@
+#include "corevu_transform_batch_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+namespace
+{
+struct Avx2Lanes
+{
+  using Float = __m256;
+  using Int = __m256i;
+  using Mask = __m256;
+  static constexpr size_t WIDTH = 8;
+
+  static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+  static void Store(float* p, Float v) { _mm256_store_ps(p, v); }
+  static Float Set(float v) { return _mm256_set1_ps(v); }
+  static Float Add(Float a, Float b) { return _mm256_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+  static Float Div(Float a, Float b) { return _mm256_div_ps(a, b); }
+  static Float Neg(Float v) { return _mm256_xor_ps(v, _mm256_set1_ps(-0.0f)); }
+  static Float Abs(Float v)
+  {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+  }
+  static Float SignBit(Float v)
+  {
+    return _mm256_and_ps(v, _mm256_set1_ps(-0.0f));
+  }
+  // 4 lanes as SSE register, for the transposed stores
+  static __m128 Quarter(Float v, size_t quarter)
+  {
+    return quarter == 0 ? _mm256_castps256_ps128(v)
+                        : _mm256_extractf128_ps(v, 1);
+  }
+  static Float Xor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+  static Float Select(Mask m, Float a, Float b)
+  {
+    return _mm256_blendv_ps(b, a, m);
+  }
+
+  static Int SetInt(int v) { return _mm256_set1_epi32(v); }
+  static Int ToIntTruncate(Float v) { return _mm256_cvttps_epi32(v); }
+  static Float ToFloat(Int v) { return _mm256_cvtepi32_ps(v); }
+  static Int AddInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+  static Int SubInt(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+  static Int AndInt(Int a, Int b) { return _mm256_and_si256(a, b); }
+  static Int AndNotInt(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+  static Mask EqualZeroInt(Int v)
+  {
+    return _mm256_castsi256_ps(
+        _mm256_cmpeq_epi32(v, _mm256_setzero_si256()));
+  }
+  // bit 2 of every lane moved to the float sign bit
+  static Float SignFromBit2(Int v)
+  {
+    return _mm256_castsi256_ps(_mm256_slli_epi32(v, 29));
+  }
+};
+} // namespace
+
+size_t TransformBatchAVX2(
+    const CoreVuTransformSoA& transforms, size_t count, float* models,
+    float* normals)
+{
+  return TransformBatch<Avx2Lanes>(transforms, count, models, normals);
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
@@ -0,0 +1,86 @@
+#include "corevu_transform_batch_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+namespace
+{
+// AVX-512F only, float bit operations go through the integer unit since the
+// _ps versions need AVX-512DQ
+struct Avx512Lanes
+{
+  using Float = __m512;
+  using Int = __m512i;
+  using Mask = __mmask16;
+  static constexpr size_t WIDTH = 16;
+
+  static Float Load(const float* p) { return _mm512_loadu_ps(p); }
+  static void Store(float* p, Float v) { _mm512_store_ps(p, v); }
+  static Float Set(float v) { return _mm512_set1_ps(v); }
+  static Float Add(Float a, Float b) { return _mm512_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm512_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm512_mul_ps(a, b); }
+  static Float Div(Float a, Float b) { return _mm512_div_ps(a, b); }
+  static Float Neg(Float v) { return Xor(v, _mm512_set1_ps(-0.0f)); }
+  static Float Abs(Float v) { return _mm512_abs_ps(v); }
+  static Float SignBit(Float v)
+  {
+    return _mm512_castsi512_ps(_mm512_and_si512(
+        _mm512_castps_si512(v), _mm512_set1_epi32(0x80000000)));
+  }
+  // 4 lanes as SSE register, for the transposed stores
+  static __m128 Quarter(Float v, size_t quarter)
+  {
+    switch (quarter)
+    {
+    case 0:
+      return _mm512_castps512_ps128(v);
+    case 1:
+      return _mm512_extractf32x4_ps(v, 1);
+    case 2:
+      return _mm512_extractf32x4_ps(v, 2);
+    default:
+      return _mm512_extractf32x4_ps(v, 3);
+    }
+  }
+  static Float Xor(Float a, Float b)
+  {
+    return _mm512_castsi512_ps(
+        _mm512_xor_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+  }
+  static Float Select(Mask m, Float a, Float b)
+  {
+    return _mm512_mask_blend_ps(m, b, a);
+  }
+
+  static Int SetInt(int v) { return _mm512_set1_epi32(v); }
+  static Int ToIntTruncate(Float v) { return _mm512_cvttps_epi32(v); }
+  static Float ToFloat(Int v) { return _mm512_cvtepi32_ps(v); }
+  static Int AddInt(Int a, Int b) { return _mm512_add_epi32(a, b); }
+  static Int SubInt(Int a, Int b) { return _mm512_sub_epi32(a, b); }
+  static Int AndInt(Int a, Int b) { return _mm512_and_si512(a, b); }
+  static Int AndNotInt(Int a, Int b) { return _mm512_andnot_si512(a, b); }
+  static Mask EqualZeroInt(Int v)
+  {
+    return _mm512_cmpeq_epi32_mask(v, _mm512_setzero_si512());
+  }
+  // bit 2 of every lane moved to the float sign bit
+  static Float SignFromBit2(Int v)
+  {
+    return _mm512_castsi512_ps(_mm512_slli_epi32(v, 29));
+  }
+};
+} // namespace
+
+size_t TransformBatchAVX512(
+    const CoreVuTransformSoA& transforms, size_t count, float* models,
+    float* normals)
+{
+  return TransformBatch<Avx512Lanes>(transforms, count, models, normals);
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <simd/corevu_transform_batch.hpp>
+
+// std
+#include <cstddef>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || \
+    defined(__i386__)
+#define COREVU_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define COREVU_SIMD_X86 0
+#endif
+
+namespace corevu
+{
+namespace simd_detail
+{
+/* Every kernel lives in its own translation unit compiled with the flags of its
+ * instruction set. They write whole registers only and return how many objects
+ * they did, models and normals point to float[16]/float[9] per object.
+ * Nothing inline and shared(glm, std) may be used in those units, the linker
+ * could otherwise pick an AVX copy of it for the rest of the program. */
+size_t TransformBatchSSE42(
+    const CoreVuTransformSoA& transforms, size_t count, float* models,
+    float* normals);
+size_t TransformBatchAVX2(
+    const CoreVuTransformSoA& transforms, size_t count, float* models,
+    float* normals);
+size_t TransformBatchAVX512(
+    const CoreVuTransformSoA& transforms, size_t count, float* models,
+    float* normals);
+
+#if COREVU_SIMD_X86
+// file local in each kernel unit, see above
+namespace
+{
+/* Cephes single precision sin/cos, both from one range reduction.
+ * V wraps the intrinsics of one instruction set. */
+template <typename V>
+inline void SinCos(
+    typename V::Float x, typename V::Float& out_sin, typename V::Float& out_cos)
+{
+  using Float = typename V::Float;
+
+  constexpr float FOUR_OVER_PI = 1.27323954473516f;
+  // pi / 4 split into three parts for extended precision reduction
+  constexpr float DP1 = 0.78515625f;
+  constexpr float DP2 = 2.4187564849853515625e-4f;
+  constexpr float DP3 = 3.77489497744594108e-8f;
+  constexpr float SIN_P0 = -1.9515295891e-4f;
+  constexpr float SIN_P1 = 8.3321608736e-3f;
+  constexpr float SIN_P2 = -1.6666654611e-1f;
+  constexpr float COS_P0 = 2.443315711809948e-5f;
+  constexpr float COS_P1 = -1.388731625493765e-3f;
+  constexpr float COS_P2 = 4.166664568298827e-2f;
+
+  Float sin_sign = V::SignBit(x);
+  x = V::Abs(x);
+
+  // octant, rounded up to even so x lands in [-pi/4, pi/4]
+  auto octant = V::ToIntTruncate(V::Mul(x, V::Set(FOUR_OVER_PI)));
+  octant = V::AndInt(V::AddInt(octant, V::SetInt(1)), V::SetInt(~1));
+  const Float y = V::ToFloat(octant);
+
+  x = V::Sub(x, V::Mul(y, V::Set(DP1)));
+  x = V::Sub(x, V::Mul(y, V::Set(DP2)));
+  x = V::Sub(x, V::Mul(y, V::Set(DP3)));
+
+  // octants 0, 1, 4, 5 take the sin polynomial for sin
+  const auto sin_poly_mask =
+      V::EqualZeroInt(V::AndInt(octant, V::SetInt(2)));
+  sin_sign =
+      V::Xor(sin_sign, V::SignFromBit2(V::AndInt(octant, V::SetInt(4))));
+  const Float cos_sign = V::SignFromBit2(
+      V::AndNotInt(V::SubInt(octant, V::SetInt(2)), V::SetInt(4)));
+
+  const Float z = V::Mul(x, x);
+
+  Float cos_poly = V::Add(V::Mul(V::Set(COS_P0), z), V::Set(COS_P1));
+  cos_poly = V::Add(V::Mul(cos_poly, z), V::Set(COS_P2));
+  cos_poly = V::Mul(V::Mul(cos_poly, z), z);
+  cos_poly = V::Sub(cos_poly, V::Mul(z, V::Set(0.5f)));
+  cos_poly = V::Add(cos_poly, V::Set(1.0f));
+
+  Float sin_poly = V::Add(V::Mul(V::Set(SIN_P0), z), V::Set(SIN_P1));
+  sin_poly = V::Add(V::Mul(sin_poly, z), V::Set(SIN_P2));
+  sin_poly = V::Add(V::Mul(V::Mul(sin_poly, z), x), x);
+
+  out_sin = V::Xor(V::Select(sin_poly_mask, sin_poly, cos_poly), sin_sign);
+  out_cos = V::Xor(V::Select(sin_poly_mask, cos_poly, sin_poly), cos_sign);
+}
+
+/* Writes one matrix column of W objects, lanes are transposed 4 objects at a
+ * time so every object gets its column as one 4 float store.
+ *
+ *   x | a0 a1 a2 a3 |      | a0 b0 c0 d0 | -> object 0
+ *   y | b0 b1 b2 b3 |  ->  | a1 b1 c1 d1 | -> object 1
+ *   z | c0 c1 c2 c3 |      | a2 b2 c2 d2 | -> object 2
+ *   w | d0 d1 d2 d3 |      | a3 b3 c3 d3 | -> object 3
+ *
+ * Three component columns still store 4 floats, the last one spills into the
+ * next column which has to be written afterwards, unless last_column. */
+template <typename V>
+inline void StoreColumn(
+    float* out, size_t object_stride, typename V::Float x,
+    typename V::Float y, typename V::Float z, typename V::Float w,
+    bool last_column = false)
+{
+  for (size_t quarter = 0; quarter < V::WIDTH / 4; ++quarter)
+  {
+    __m128 column0 = V::Quarter(x, quarter);
+    __m128 column1 = V::Quarter(y, quarter);
+    __m128 column2 = V::Quarter(z, quarter);
+    __m128 column3 = V::Quarter(w, quarter);
+    _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+
+    float* object = out + quarter * 4 * object_stride;
+    const __m128 columns[4] = {column0, column1, column2, column3};
+    for (size_t i = 0; i < 4; ++i, object += object_stride)
+    {
+      if (last_column)
+      {
+        // x y and z only, mat3 columns are 3 floats
+        _mm_storel_pi(reinterpret_cast<__m64*>(object), columns[i]);
+        _mm_store_ss(object + 2, _mm_movehl_ps(columns[i], columns[i]));
+      }
+      else
+      {
+        _mm_storeu_ps(object, columns[i]);
+      }
+    }
+  }
+}
+
+/* Same math as TransformComponent::ToMat4(), W objects per iteration, every
+ * register lane is one object. */
+template <typename V>
+size_t TransformBatch(
+    const CoreVuTransformSoA& transforms, size_t count, float* models,
+    float* normals)
+{
+  using Float = typename V::Float;
+  constexpr size_t W = V::WIDTH;
+
+  const Float zero = V::Set(0.0f);
+  const Float one = V::Set(1.0f);
+
+  const size_t vector_count = count - count % W;
+  for (size_t i = 0; i < vector_count; i += W)
+  {
+    Float s1, c1, s2, c2, s3, c3;
+    SinCos<V>(V::Load(transforms.rotation_y + i), s1, c1);
+    SinCos<V>(V::Load(transforms.rotation_x + i), s2, c2);
+    SinCos<V>(V::Load(transforms.rotation_z + i), s3, c3);
+
+    // rotation Ry * Rx * Rz, r<column><row>
+    const Float s1s2 = V::Mul(s1, s2);
+    const Float c1s2 = V::Mul(c1, s2);
+    const Float r00 = V::Add(V::Mul(c1, c3), V::Mul(s1s2, s3));
+    const Float r01 = V::Mul(c2, s3);
+    const Float r02 = V::Sub(V::Mul(c1s2, s3), V::Mul(c3, s1));
+    const Float r10 = V::Sub(V::Mul(c3, s1s2), V::Mul(c1, s3));
+    const Float r11 = V::Mul(c2, c3);
+    const Float r12 = V::Add(V::Mul(c1s2, c3), V::Mul(s1, s3));
+    const Float r20 = V::Mul(c2, s1);
+    const Float r21 = V::Neg(s2);
+    const Float r22 = V::Mul(c1, c2);
+
+    const Float sx = V::Load(transforms.scale_x + i);
+    const Float sy = V::Load(transforms.scale_y + i);
+    const Float sz = V::Load(transforms.scale_z + i);
+
+    float* model = models + i * 16;
+    StoreColumn<V>(
+        model, 16, V::Mul(sx, r00), V::Mul(sx, r01), V::Mul(sx, r02), zero);
+    StoreColumn<V>(
+        model + 4, 16, V::Mul(sy, r10), V::Mul(sy, r11), V::Mul(sy, r12),
+        zero);
+    StoreColumn<V>(
+        model + 8, 16, V::Mul(sz, r20), V::Mul(sz, r21), V::Mul(sz, r22),
+        zero);
+    StoreColumn<V>(
+        model + 12, 16, V::Load(transforms.translation_x + i),
+        V::Load(transforms.translation_y + i),
+        V::Load(transforms.translation_z + i), one);
+
+    if (normals == nullptr) continue;
+
+    // columns in order, each one overwrites the spill of the one before
+    const Float inv_sx = V::Div(one, sx);
+    const Float inv_sy = V::Div(one, sy);
+    const Float inv_sz = V::Div(one, sz);
+    float* normal = normals + i * 9;
+    StoreColumn<V>(
+        normal, 9, V::Mul(inv_sx, r00), V::Mul(inv_sx, r01),
+        V::Mul(inv_sx, r02), zero);
+    StoreColumn<V>(
+        normal + 3, 9, V::Mul(inv_sy, r10), V::Mul(inv_sy, r11),
+        V::Mul(inv_sy, r12), zero);
+    StoreColumn<V>(
+        normal + 6, 9, V::Mul(inv_sz, r20), V::Mul(inv_sz, r21),
+        V::Mul(inv_sz, r22), zero, true);
+  }
+  return vector_count;
+}
+} // namespace
+#endif
+} // namespace simd_detail
+} // namespace corevu
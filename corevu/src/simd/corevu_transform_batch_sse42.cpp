@@ -0,0 +1,63 @@
+#include "corevu_transform_batch_kernel.hpp"
+
+#if COREVU_SIMD_X86
+
+namespace corevu
+{
+namespace simd_detail
+{
+namespace
+{
+struct Sse42Lanes
+{
+  using Float = __m128;
+  using Int = __m128i;
+  using Mask = __m128;
+  static constexpr size_t WIDTH = 4;
+
+  static Float Load(const float* p) { return _mm_loadu_ps(p); }
+  static void Store(float* p, Float v) { _mm_store_ps(p, v); }
+  static Float Set(float v) { return _mm_set1_ps(v); }
+  static Float Add(Float a, Float b) { return _mm_add_ps(a, b); }
+  static Float Sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+  static Float Mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+  static Float Div(Float a, Float b) { return _mm_div_ps(a, b); }
+  static Float Neg(Float v) { return _mm_xor_ps(v, _mm_set1_ps(-0.0f)); }
+  static Float Abs(Float v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+  static Float SignBit(Float v) { return _mm_and_ps(v, _mm_set1_ps(-0.0f)); }
+  // 4 lanes as SSE register, for the transposed stores
+  static __m128 Quarter(Float v, size_t) { return v; }
+  static Float Xor(Float a, Float b) { return _mm_xor_ps(a, b); }
+  static Float Select(Mask m, Float a, Float b)
+  {
+    return _mm_blendv_ps(b, a, m);
+  }
+
+  static Int SetInt(int v) { return _mm_set1_epi32(v); }
+  static Int ToIntTruncate(Float v) { return _mm_cvttps_epi32(v); }
+  static Float ToFloat(Int v) { return _mm_cvtepi32_ps(v); }
+  static Int AddInt(Int a, Int b) { return _mm_add_epi32(a, b); }
+  static Int SubInt(Int a, Int b) { return _mm_sub_epi32(a, b); }
+  static Int AndInt(Int a, Int b) { return _mm_and_si128(a, b); }
+  static Int AndNotInt(Int a, Int b) { return _mm_andnot_si128(a, b); }
+  static Mask EqualZeroInt(Int v)
+  {
+    return _mm_castsi128_ps(_mm_cmpeq_epi32(v, _mm_setzero_si128()));
+  }
+  // bit 2 of every lane moved to the float sign bit
+  static Float SignFromBit2(Int v)
+  {
+    return _mm_castsi128_ps(_mm_slli_epi32(v, 29));
+  }
+};
+} // namespace
+
+size_t TransformBatchSSE42(
+    const CoreVuTransformSoA& transforms, size_t count, float* models,
+    float* normals)
+{
+  return TransformBatch<Sse42Lanes>(transforms, count, models, normals);
+}
+} // namespace simd_detail
+} // namespace corevu
+#endif
@@ -0,0 +1,377 @@
+#include <spatial/corevu_aabb_tree.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+
+namespace corevu
+{
+
+namespace
+{
+// queries per job of the batch versions
+constexpr uint32_t QUERY_BATCH_SIZE = 16;
+
+template <typename Query, typename Fn>
+void RunBatch(
+    CoreVuJobSystem& job_system, std::span<const Query> queries,
+    std::vector<std::vector<CoreVuEntity>>& results, Fn&& query)
+{
+  results.resize(queries.size());
+  job_system.parallelFor(
+      static_cast<uint32_t>(queries.size()), QUERY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          auto& result = results[i];
+          result.clear();
+          query(queries[i], [&result](CoreVuEntity e) { result.push_back(e); });
+        }
+      });
+}
+} // namespace
+
+CoreVuAabbTree::ProxyId CoreVuAabbTree::createProxy(
+    const CoreVuAabb& box, CoreVuEntity entity)
+{
+  assert(!box.isEmpty() && "Proxy box is empty");
+  const ProxyId proxy = allocateNode();
+  auto& node = m_nodes[proxy];
+  node.box = box;
+  node.fat_box = Fatten(box);
+  node.entity = entity;
+  node.height = 0;
+  insertLeaf(proxy);
+  m_proxy_count++;
+  return proxy;
+}
+
+void CoreVuAabbTree::destroyProxy(ProxyId proxy)
+{
+  assert(m_nodes[proxy].isLeaf() && "Not a proxy");
+  removeLeaf(proxy);
+  freeNode(proxy);
+  m_proxy_count--;
+}
+
+bool CoreVuAabbTree::moveProxy(ProxyId proxy, const CoreVuAabb& box)
+{
+  auto& node = m_nodes[proxy];
+  assert(node.isLeaf() && "Not a proxy");
+  node.box = box;
+
+  const CoreVuAabb fat_box = Fatten(box);
+  if (node.fat_box.contains(box))
+  {
+    // a shrunk entity gets a tighter fat box, otherwise it never would
+    const CoreVuAabb huge_box = CoreVuAabb::FromCenterExtents(
+        fat_box.getCenter(), fat_box.getExtents() * 2.f);
+    if (huge_box.contains(node.fat_box)) return false;
+  }
+
+  removeLeaf(proxy);
+  m_nodes[proxy].fat_box = fat_box;
+  insertLeaf(proxy);
+  return true;
+}
+
+void CoreVuAabbTree::clear()
+{
+  m_nodes.clear();
+  m_root = NULL_PROXY;
+  m_free_list = NULL_PROXY;
+  m_proxy_count = 0;
+}
+
+CoreVuRayHit CoreVuAabbTree::raycastClosest(const CoreVuRay& ray) const
+{
+  CoreVuRayHit hit{};
+  raycast(
+      ray,
+      [&hit](CoreVuEntity entity, float distance)
+      {
+        hit = CoreVuRayHit{entity, distance};
+        return distance;
+      });
+  return hit;
+}
+
+void CoreVuAabbTree::queryAabbs(
+    CoreVuJobSystem& job_system, std::span<const CoreVuAabb> boxes,
+    std::vector<std::vector<CoreVuEntity>>& results) const
+{
+  ZoneScoped;
+  RunBatch(
+      job_system, boxes, results,
+      [this](const CoreVuAabb& box, auto&& fn) { queryAabb(box, fn); });
+}
+
+void CoreVuAabbTree::querySpheres(
+    CoreVuJobSystem& job_system, std::span<const CoreVuSphere> spheres,
+    std::vector<std::vector<CoreVuEntity>>& results) const
+{
+  ZoneScoped;
+  RunBatch(
+      job_system, spheres, results,
+      [this](const CoreVuSphere& sphere, auto&& fn)
+      { querySphere(sphere, fn); });
+}
+
+void CoreVuAabbTree::queryFrustums(
+    CoreVuJobSystem& job_system, std::span<const CoreVuFrustum> frustums,
+    std::vector<std::vector<CoreVuEntity>>& results) const
+{
+  ZoneScoped;
+  RunBatch(
+      job_system, frustums, results,
+      [this](const CoreVuFrustum& frustum, auto&& fn)
+      { queryFrustum(frustum, fn); });
+}
+
+void CoreVuAabbTree::raycastClosest(
+    CoreVuJobSystem& job_system, std::span<const CoreVuRay> rays,
+    std::span<CoreVuRayHit> hits) const
+{
+  ZoneScoped;
+  assert(hits.size() >= rays.size() && "Not enough room for the hits");
+  job_system.parallelFor(
+      static_cast<uint32_t>(rays.size()), QUERY_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          hits[i] = raycastClosest(rays[i]);
+        }
+      });
+}
+
+bool CoreVuAabbTree::validate() const
+{
+  if (m_root == NULL_PROXY) return m_proxy_count == 0;
+  if (m_nodes[m_root].parent != NULL_PROXY) return false;
+  return validateSubtree(m_root, NULL_PROXY) >= 0;
+}
+
+CoreVuAabb CoreVuAabbTree::Fatten(const CoreVuAabb& box)
+{
+  const glm::vec3 margin =
+      (box.max - box.min) * FAT_MARGIN_RATIO + glm::vec3{MIN_FAT_MARGIN};
+  return CoreVuAabb{box.min - margin, box.max + margin};
+}
+
+CoreVuAabbTree::ProxyId CoreVuAabbTree::allocateNode()
+{
+  if (m_free_list == NULL_PROXY)
+  {
+    m_nodes.emplace_back();
+    return static_cast<ProxyId>(m_nodes.size() - 1);
+  }
+
+  const ProxyId node = m_free_list;
+  m_free_list = m_nodes[node].parent;
+  m_nodes[node] = Node{};
+  return node;
+}
+
+void CoreVuAabbTree::freeNode(ProxyId node)
+{
+  m_nodes[node].parent = m_free_list;
+  m_nodes[node].height = -1;
+  m_free_list = node;
+}
+
+void CoreVuAabbTree::insertLeaf(ProxyId leaf)
+{
+  if (m_root == NULL_PROXY)
+  {
+    m_root = leaf;
+    m_nodes[leaf].parent = NULL_PROXY;
+    return;
+  }
+
+  /* Branch and bound down the tree: making leaf a sibling of node costs the
+   * area of the new parent plus the growth of all ancestors(inheritance). */
+  const CoreVuAabb leaf_box = m_nodes[leaf].fat_box;
+  ProxyId index = m_root;
+  while (!m_nodes[index].isLeaf())
+  {
+    const Node& node = m_nodes[index];
+    const float area = node.fat_box.getPerimeter();
+    const float combined_area = Union(node.fat_box, leaf_box).getPerimeter();
+
+    const float cost = 2.f * combined_area;
+    const float inheritance_cost = 2.f * (combined_area - area);
+
+    const auto descend_cost = [&](ProxyId child)
+    {
+      const CoreVuAabb& child_box = m_nodes[child].fat_box;
+      const float new_area = Union(child_box, leaf_box).getPerimeter();
+      return (m_nodes[child].isLeaf() ? new_area
+                                      : new_area - child_box.getPerimeter()) +
+             inheritance_cost;
+    };
+    const float cost1 = descend_cost(node.child1);
+    const float cost2 = descend_cost(node.child2);
+
+    if (cost < cost1 && cost < cost2) break;
+    index = cost1 < cost2 ? node.child1 : node.child2;
+  }
+
+  const ProxyId sibling = index;
+  const ProxyId old_parent = m_nodes[sibling].parent;
+  const ProxyId new_parent = allocateNode();
+  {
+    auto& parent = m_nodes[new_parent];
+    parent.parent = old_parent;
+    parent.fat_box = Union(leaf_box, m_nodes[sibling].fat_box);
+    parent.height = m_nodes[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+  }
+
+  if (old_parent != NULL_PROXY)
+  {
+    auto& grand_parent = m_nodes[old_parent];
+    (grand_parent.child1 == sibling ? grand_parent.child1
+                                    : grand_parent.child2) = new_parent;
+  }
+  else
+  {
+    m_root = new_parent;
+  }
+  m_nodes[sibling].parent = new_parent;
+  m_nodes[leaf].parent = new_parent;
+
+  refitUpwards(m_nodes[leaf].parent);
+}
+
+void CoreVuAabbTree::removeLeaf(ProxyId leaf)
+{
+  if (leaf == m_root)
+  {
+    m_root = NULL_PROXY;
+    return;
+  }
+
+  const ProxyId parent = m_nodes[leaf].parent;
+  const ProxyId grand_parent = m_nodes[parent].parent;
+  const ProxyId sibling = m_nodes[parent].child1 == leaf
+                              ? m_nodes[parent].child2
+                              : m_nodes[parent].child1;
+
+  // the sibling takes the place of the parent
+  if (grand_parent != NULL_PROXY)
+  {
+    auto& grand = m_nodes[grand_parent];
+    (grand.child1 == parent ? grand.child1 : grand.child2) = sibling;
+    m_nodes[sibling].parent = grand_parent;
+    freeNode(parent);
+    refitUpwards(grand_parent);
+  }
+  else
+  {
+    m_root = sibling;
+    m_nodes[sibling].parent = NULL_PROXY;
+    freeNode(parent);
+  }
+}
+
+void CoreVuAabbTree::refitUpwards(ProxyId index)
+{
+  while (index != NULL_PROXY)
+  {
+    index = balance(index);
+
+    auto& node = m_nodes[index];
+    const auto& child1 = m_nodes[node.child1];
+    const auto& child2 = m_nodes[node.child2];
+    node.height = 1 + std::max(child1.height, child2.height);
+    node.fat_box = Union(child1.fat_box, child2.fat_box);
+
+    index = node.parent;
+  }
+}
+
+/* AVL rotation at a, if one child is more than one level higher than the
+ * other, the higher child(c) moves up and a takes its lower child:
+ *
+ *        a                c
+ *      /   \            /   \
+ *     b     c    ->    a     f      (g lower than f)
+ *          / \        / \
+ *         f   g      b   g
+ *
+ * Returns the node now at the position of a. */
+CoreVuAabbTree::ProxyId CoreVuAabbTree::balance(ProxyId ia)
+{
+  auto& a = m_nodes[ia];
+  if (a.isLeaf() || a.height < 2) return ia;
+
+  const ProxyId ib = a.child1;
+  const ProxyId ic = a.child2;
+  const int32_t difference = m_nodes[ic].height - m_nodes[ib].height;
+  if (difference >= -1 && difference <= 1) return ia;
+
+  // the higher child moves up
+  const ProxyId iup = difference > 1 ? ic : ib;
+  const ProxyId ilow = difference > 1 ? ib : ic;
+  auto& up = m_nodes[iup];
+  const ProxyId ifirst = up.child1;
+  const ProxyId isecond = up.child2;
+  // the higher grandchild stays with up, the lower one goes to a
+  const bool keep_first = m_nodes[ifirst].height > m_nodes[isecond].height;
+  const ProxyId ikeep = keep_first ? ifirst : isecond;
+  const ProxyId igive = keep_first ? isecond : ifirst;
+
+  up.child1 = ia;
+  up.child2 = ikeep;
+  up.parent = a.parent;
+  a.parent = iup;
+  if (up.parent != NULL_PROXY)
+  {
+    auto& parent = m_nodes[up.parent];
+    (parent.child1 == ia ? parent.child1 : parent.child2) = iup;
+  }
+  else
+  {
+    m_root = iup;
+  }
+
+  (difference > 1 ? a.child2 : a.child1) = igive;
+  m_nodes[igive].parent = ia;
+
+  a.fat_box = Union(m_nodes[ilow].fat_box, m_nodes[igive].fat_box);
+  a.height = 1 + std::max(m_nodes[ilow].height, m_nodes[igive].height);
+  up.fat_box = Union(a.fat_box, m_nodes[ikeep].fat_box);
+  up.height = 1 + std::max(a.height, m_nodes[ikeep].height);
+  return iup;
+}
+
+int32_t CoreVuAabbTree::validateSubtree(ProxyId index, ProxyId parent) const
+{
+  const Node& node = m_nodes[index];
+  if (node.parent != parent) return -1;
+  if (node.isLeaf())
+  {
+    return node.height == 0 && node.fat_box.contains(node.box) ? 0 : -1;
+  }
+
+  const int32_t height1 = validateSubtree(node.child1, index);
+  const int32_t height2 = validateSubtree(node.child2, index);
+  if (height1 < 0 || height2 < 0) return -1;
+
+  const CoreVuAabb box =
+      Union(m_nodes[node.child1].fat_box, m_nodes[node.child2].fat_box);
+  const int32_t height = 1 + std::max(height1, height2);
+  if (node.height != height || box.min != node.fat_box.min ||
+      box.max != node.fat_box.max)
+  {
+    return -1;
+  }
+  return height;
+}
+
+} // namespace corevu
@@ -0,0 +1,278 @@
+#include "systems/culling_system.hpp"
+
+#include <simd/corevu_frustum_cull.hpp>
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+namespace corevu
+{
+
+CullingSystem::CullingSystem(uint32_t thread_count) : m_scratch(thread_count)
+{
+}
+
+void CullingSystem::update(FrameInfo& frame_info)
+{
+  ZoneScoped;
+  auto& world = frame_info.world;
+  const auto& camera = frame_info.camera;
+  m_frustum = camera.getFrustum();
+  m_eye = camera.getPosition();
+  m_projection_scale = std::abs(camera.getProjection()[1][1]);
+  // w stays 1 under an orthographic projection, sizes don't shrink
+  m_perspective = camera.getProjection()[2][3] != 0.f;
+
+  m_chunks.clear();
+  world.query<const TransformComponent, const ModelComponent>()
+      .without<TextureComponent>()
+      .eachChunk(
+          [this](uint32_t count, const CoreVuEntity* entities,
+                 const TransformComponent* transforms,
+                 const ModelComponent* models)
+          {
+            m_chunks.push_back(
+                ChunkWork{count, entities, transforms, models, false});
+          });
+  world
+      .query<
+          const TransformComponent, const ModelComponent,
+          const TextureComponent>()
+      .eachChunk(
+          [this](uint32_t count, const CoreVuEntity* entities,
+                 const TransformComponent* transforms,
+                 const ModelComponent* models, const TextureComponent*)
+          {
+            m_chunks.push_back(
+                ChunkWork{count, entities, transforms, models, true});
+          });
+
+  if (m_chunk_visible.size() < m_chunks.size())
+  {
+    m_chunk_visible.resize(m_chunks.size());
+  }
+  m_chunk_counts.assign(m_chunks.size(), ChunkCounts{});
+
+  // room for every entity index the chunk jobs write
+  uint32_t index_end = 0;
+  for (const auto& chunk : m_chunks)
+  {
+    for (uint32_t i = 0; i < chunk.count; ++i)
+    {
+      index_end = std::max(index_end, GetEntityIndex(chunk.entities[i]) + 1);
+    }
+  }
+  if (m_entities.size() < index_end)
+  {
+    m_entities.resize(index_end, EntityState{0, 0});
+  }
+
+  m_stats = CoreVuCullStats{};
+  rasterizeOccluders(frame_info);
+
+  frame_info.job_system.parallelFor(
+      static_cast<uint32_t>(m_chunks.size()), 1,
+      [&](uint32_t begin, uint32_t end)
+      {
+        auto& scratch = m_scratch[frame_info.job_system.getThreadIndex()];
+        for (uint32_t i = begin; i < end; ++i)
+        {
+          cullChunk(
+              m_chunks[i], scratch, m_chunk_visible[i], m_chunk_counts[i]);
+        }
+      });
+
+  m_visible.clear();
+  m_visible_textured.clear();
+  for (size_t i = 0; i < m_chunks.size(); ++i)
+  {
+    auto& out = m_chunks[i].textured ? m_visible_textured : m_visible;
+    out.insert(out.end(), m_chunk_visible[i].begin(), m_chunk_visible[i].end());
+    m_stats.tested += m_chunks[i].count;
+    m_stats.small += m_chunk_counts[i].small;
+    m_stats.occluded += m_chunk_counts[i].occluded;
+    for (uint32_t lod = 0; lod < CoreVuModel::MAX_LODS; ++lod)
+    {
+      m_stats.lods[lod] += m_chunk_counts[i].lods[lod];
+    }
+  }
+  m_stats.drawn =
+      static_cast<uint32_t>(m_visible.size() + m_visible_textured.size());
+  m_stats.culled =
+      m_stats.tested - m_stats.drawn - m_stats.small - m_stats.occluded;
+
+  m_frames++;
+  m_total_drawn += m_stats.drawn;
+  m_total_culled += m_stats.culled;
+  m_total_occluded += m_stats.occluded;
+  m_total_small += m_stats.small;
+  TracyPlot("drawn", static_cast<int64_t>(m_stats.drawn));
+  TracyPlot("culled", static_cast<int64_t>(m_stats.culled));
+  TracyPlot("occluded", static_cast<int64_t>(m_stats.occluded));
+  TracyPlot("too small", static_cast<int64_t>(m_stats.small));
+}
+
+void CullingSystem::rasterizeOccluders(FrameInfo& frame_info)
+{
+  ZoneScoped;
+  m_occlusion_active = false;
+  if (!m_occlusion_enabled) return;
+
+  const glm::vec3 eye = frame_info.camera.getPosition();
+  m_occluders.clear();
+  frame_info.world.query<const TransformComponent, const OccluderComponent>()
+      .each(
+          [&](CoreVuEntity entity, const TransformComponent& transform,
+              const OccluderComponent& occluder)
+          {
+            if (occluder.mesh == nullptr) return;
+            const uint32_t index = GetEntityIndex(entity);
+            if (index < m_entities.size() && m_entities[index].hidden != 0)
+            {
+              // behind other occluders last frame
+              return;
+            }
+            const glm::mat4& world = transform.GetWorldMatrix();
+            const CoreVuAabb box =
+                occluder.mesh->getBounds().transformed(world);
+            if (!Intersects(m_frustum, box)) return;
+
+            const float radius = glm::length(box.getExtents());
+            const float distance = glm::length(box.getCenter() - eye);
+            m_occluders.push_back(OccluderWork{
+                occluder.mesh.get(), &world,
+                radius / std::max(distance, 1e-3f)});
+          });
+  if (m_occluders.empty()) return;
+
+  std::sort(
+      m_occluders.begin(), m_occluders.end(),
+      [](const OccluderWork& a, const OccluderWork& b)
+      { return a.screen_size > b.screen_size; });
+
+  m_occlusion.begin(
+      frame_info.camera.getProjection() * frame_info.camera.getView());
+  for (const auto& occluder : m_occluders)
+  {
+    if (!m_occlusion.addOccluder(*occluder.mesh, *occluder.world)) break;
+    m_stats.occluders++;
+  }
+  m_stats.occluder_triangles = m_occlusion.getTriangleCount();
+  if (m_stats.occluder_triangles == 0) return;
+
+  m_occlusion.rasterize(frame_info.job_system);
+  m_occlusion_active = true;
+}
+
+void CullingSystem::cullChunk(
+    const ChunkWork& chunk, ThreadScratch& scratch,
+    std::vector<CoreVuDrawItem>& visible, ChunkCounts& counts)
+{
+  scratch.center_x.resize(chunk.count);
+  scratch.center_y.resize(chunk.count);
+  scratch.center_z.resize(chunk.count);
+  scratch.radius.resize(chunk.count);
+  scratch.indices.resize(chunk.count);
+
+  for (uint32_t i = 0; i < chunk.count; ++i)
+  {
+    const auto& model = chunk.models[i].model;
+    if (model == nullptr)
+    {
+      // nothing to draw, never visible
+      scratch.center_x[i] = scratch.center_y[i] = scratch.center_z[i] = 0.f;
+      scratch.radius[i] = std::numeric_limits<float>::lowest();
+      continue;
+    }
+
+    const CoreVuSphere& sphere = model->GetBoundingSphere();
+    const glm::mat4& world = chunk.transforms[i].GetWorldMatrix();
+    const glm::vec3 center = glm::vec3{world * glm::vec4{sphere.center, 1.f}};
+    const float scale = std::sqrt(std::max(
+        {glm::dot(world[0], world[0]), glm::dot(world[1], world[1]),
+         glm::dot(world[2], world[2])}));
+    scratch.center_x[i] = center.x;
+    scratch.center_y[i] = center.y;
+    scratch.center_z[i] = center.z;
+    scratch.radius[i] = sphere.radius * scale;
+  }
+
+  const CoreVuSphereSoA spheres{
+      scratch.center_x.data(), scratch.center_y.data(),
+      scratch.center_z.data(), scratch.radius.data()};
+  const size_t visible_count =
+      CullSpheres(m_frustum, spheres, chunk.count, scratch.indices.data());
+
+  for (uint32_t i = 0; i < chunk.count; ++i)
+  {
+    m_entities[GetEntityIndex(chunk.entities[i])].hidden = 0;
+  }
+
+  visible.clear();
+  for (size_t i = 0; i < visible_count; ++i)
+  {
+    const uint32_t index = scratch.indices[i];
+    const CoreVuModel& model = *chunk.models[index].model;
+    EntityState& state = m_entities[GetEntityIndex(chunk.entities[index])];
+
+    // projected size, the camera inside the sphere sees it full size
+    const glm::vec3 center{
+        scratch.center_x[index], scratch.center_y[index],
+        scratch.center_z[index]};
+    const float radius = scratch.radius[index];
+    const float distance = glm::length(center - m_eye);
+    uint32_t lod = 0;
+    if (!m_perspective || distance > radius)
+    {
+      const float ndc_per_unit =
+          m_projection_scale / (m_perspective ? distance : 1.f);
+      if (radius * ndc_per_unit < m_min_screen_size)
+      {
+        counts.small++;
+        continue;
+      }
+      // model units to world units(the sphere radius holds the scale)
+      const float model_radius = model.GetBoundingSphere().radius;
+      const float scale = model_radius > 0.f ? radius / model_radius : 1.f;
+      lod = model.SelectLod(
+          .5f * ndc_per_unit * scale, m_lod_error, LOD_HYSTERESIS,
+          state.lod);
+    }
+
+    if (m_occlusion_active)
+    {
+      const CoreVuAabb box = model.GetBounds().transformed(
+          chunk.transforms[index].GetWorldMatrix());
+      if (!m_occlusion.isVisible(box))
+      {
+        state.hidden = 1;
+        counts.occluded++;
+        continue;
+      }
+    }
+    state.lod = static_cast<uint8_t>(lod);
+    counts.lods[lod]++;
+    visible.push_back(CoreVuDrawItem{chunk.entities[index], lod});
+  }
+}
+
+void CullingSystem::printReport(std::ostream& out) const
+{
+  const double frames = m_frames > 0 ? static_cast<double>(m_frames) : 1.0;
+  char line[128];
+  std::snprintf(
+      line, sizeof(line),
+      "Culling report: %llu frames, avg drawn %.1f, avg culled %.1f, avg "
+      "too small %.1f, avg occluded %.1f\n",
+      static_cast<unsigned long long>(m_frames), m_total_drawn / frames,
+      m_total_culled / frames, m_total_small / frames,
+      m_total_occluded / frames);
+  out << line;
+}
+
+} // namespace corevu
@@ -0,0 +1,59 @@
+#include "systems/gravity_system.hpp"
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <cassert>
+
+namespace corevu
+{
+
+void GravityPhysicsSystem::update(FrameInfo& frame_info, uint32_t substeps)
+{
+  ZoneScoped;
+  assert(substeps > 0 && "Gravity needs at least one substep");
+  auto query =
+      frame_info.world.query<TransformComponent, RigidBody2dComponent>();
+
+  m_bodies.clear();
+  query.eachChunk(
+      [this](uint32_t count, const CoreVuEntity*,
+             TransformComponent* transforms, RigidBody2dComponent* bodies)
+      {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+          const glm::vec3& translation = transforms[i].GetTranslation();
+          m_bodies.add(
+              translation.x, translation.y, bodies[i].velocity.x,
+              bodies[i].velocity.y, bodies[i].mass);
+        }
+      });
+  if (m_bodies.size() == 0) return;
+
+  const float dt = frame_info.frame_time / substeps;
+  for (uint32_t i = 0; i < substeps; ++i)
+  {
+    m_solver.step(m_bodies, dt, frame_info.job_system);
+  }
+
+  // same chunks in the same order, nothing changed the world in between
+  size_t body = 0;
+  query.eachChunk(
+      [this, &body](
+          uint32_t count, const CoreVuEntity*, TransformComponent* transforms,
+          RigidBody2dComponent* bodies)
+      {
+        for (uint32_t i = 0; i < count; ++i, ++body)
+        {
+          glm::vec3 translation = transforms[i].GetTranslation();
+          translation.x = m_bodies.position_x[body];
+          translation.y = m_bodies.position_y[body];
+          transforms[i].SetTranslation(translation);
+          bodies[i].velocity = {
+              m_bodies.velocity_x[body], m_bodies.velocity_y[body]};
+        }
+      });
+}
+
+} // namespace corevu
@@ -0,0 +1,299 @@
+#include "systems/particle_system.hpp"
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+using namespace corevu;
+
+namespace
+{
+struct ParticleComputePushConstants
+{
+  uint32_t count;
+  float dt;
+  float strength;
+  float softening2;
+};
+
+struct ParticlePushConstants
+{
+  float size;
+};
+} // namespace
+
+GpuParticleSystem::GpuParticleSystem(
+    CoreVuDevice& device, VkRenderPass render_pass,
+    VkDescriptorSetLayout global_descriptor_set_layout,
+    const std::vector<GpuParticle>& particles)
+  : m_corevu_device{device},
+    m_particle_count{static_cast<uint32_t>(particles.size())}
+{
+  assert(m_particle_count > 0 && "GpuParticleSystem without particles");
+  if (m_corevu_device.properties.limits.maxComputeWorkGroupInvocations <
+      WORKGROUP_SIZE)
+  {
+    throw std::runtime_error(
+        "FAILURE::particle workgroups too large for the device");
+  }
+
+  createBuffers(particles);
+  createDescriptorSets();
+  createComputePipeline();
+  if (render_pass != VK_NULL_HANDLE)
+  {
+    createPipelineLayout(global_descriptor_set_layout);
+    createPipeline(render_pass);
+  }
+}
+
+GpuParticleSystem::~GpuParticleSystem()
+{
+  vkDestroyPipelineLayout(
+      m_corevu_device.device(), m_compute_pipeline_layout, nullptr);
+  if (m_pipeline_layout != VK_NULL_HANDLE)
+  {
+    vkDestroyPipelineLayout(
+        m_corevu_device.device(), m_pipeline_layout, nullptr);
+  }
+}
+
+void GpuParticleSystem::createBuffers(const std::vector<GpuParticle>& particles)
+{
+  CoreVuBuffer staging_buffer{
+      m_corevu_device, sizeof(GpuParticle), m_particle_count,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+  staging_buffer.map();
+  staging_buffer.writeToBuffer((void*)particles.data());
+
+  for (auto& buffer : m_particle_buffers)
+  {
+    buffer = std::make_unique<CoreVuBuffer>(
+        m_corevu_device, sizeof(GpuParticle), m_particle_count,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+
+  // the state starts in A, binding 1 of set 1
+  m_corevu_device.copyBuffer(
+      staging_buffer.getBuffer(), m_particle_buffers[0]->getBuffer(),
+      staging_buffer.getBufferSize());
+}
+
+void GpuParticleSystem::createDescriptorSets()
+{
+  m_descriptor_pool =
+      CoreVuDescriptorPool::Builder(m_corevu_device)
+          .setMaxSets(2)
+          .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4)
+          .build();
+  m_descriptor_set_layout =
+      CoreVuDescriptorSetLayout::Builder(m_corevu_device)
+          .addBinding(
+              0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+              VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT)
+          .addBinding(
+              1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+              VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT)
+          .build();
+
+  for (uint32_t i = 0; i < 2; ++i)
+  {
+    auto input_info = m_particle_buffers[i]->descriptorInfo();
+    auto output_info = m_particle_buffers[i ^ 1u]->descriptorInfo();
+    if (!CoreVuDescriptorWriter(*m_descriptor_set_layout, *m_descriptor_pool)
+             .writeBuffer(0, &input_info)
+             .writeBuffer(1, &output_info)
+             .build(m_descriptor_sets[i]))
+    {
+      throw std::runtime_error("FAILURE::can't allocate particle descriptors");
+    }
+  }
+}
+
+void GpuParticleSystem::createComputePipeline()
+{
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(ParticleComputePushConstants);
+
+  const VkDescriptorSetLayout descriptor_set_layout =
+      m_descriptor_set_layout->getDescriptorSetLayout();
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info{};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount = 1;
+  pipeline_layout_info.pSetLayouts = &descriptor_set_layout;
+  pipeline_layout_info.pushConstantRangeCount = 1;
+  pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+  if (vkCreatePipelineLayout(
+          m_corevu_device.device(), &pipeline_layout_info, nullptr,
+          &m_compute_pipeline_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("FAILURE::can't create pipeline layout!");
+  }
+
+  m_compute_pipeline = std::make_unique<CoreVuComputePipeline>(
+      m_corevu_device, m_compute_pipeline_layout,
+      "C:/workspace/CoreVu/corevu/shaders/particle_nbody.comp.spv");
+}
+
+void GpuParticleSystem::createPipelineLayout(
+    VkDescriptorSetLayout global_descriptor_set_layout)
+{
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(ParticlePushConstants);
+
+  // global ubo at set 0 like the other render systems, particles at set 1
+  std::vector<VkDescriptorSetLayout> descriptor_set_layouts = {
+      global_descriptor_set_layout,
+      m_descriptor_set_layout->getDescriptorSetLayout()};
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info{};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount =
+      static_cast<uint32_t>(descriptor_set_layouts.size());
+  pipeline_layout_info.pSetLayouts = descriptor_set_layouts.data();
+  pipeline_layout_info.pushConstantRangeCount = 1;
+  pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+  if (vkCreatePipelineLayout(
+          m_corevu_device.device(), &pipeline_layout_info, nullptr,
+          &m_pipeline_layout) != VK_SUCCESS)
+  {
+    throw std::runtime_error("FAILURE::can't create pipeline layout!");
+  }
+}
+
+void GpuParticleSystem::createPipeline(VkRenderPass render_pass)
+{
+  assert(
+      m_pipeline_layout != nullptr &&
+      "Cannot create pipeline before pipeline layout");
+
+  PipelineConfigInfo pipeline_config{};
+  CoreVuPipeline::DefaultPipelineConfigInfo(pipeline_config);
+  CoreVuPipeline::EnableAlphaBlending(pipeline_config);
+  // particles are read from the storage buffer, no vertex attributes
+  pipeline_config.binding_descriptions.clear();
+  pipeline_config.attribute_descriptions.clear();
+  pipeline_config.renderPass = render_pass;
+  pipeline_config.pipelineLayout = m_pipeline_layout;
+  m_corevu_pipeline = std::make_unique<CoreVuPipeline>(
+      m_corevu_device, pipeline_config,
+      "C:/workspace/CoreVu/corevu/shaders/particle.vert.spv",
+      "C:/workspace/CoreVu/corevu/shaders/particle.frag.spv");
+}
+
+void GpuParticleSystem::simulate(VkCommandBuffer command_buffer, float dt)
+{
+  ZoneScoped;
+  const uint32_t set = m_current_set ^ 1u;
+
+  /* The step writes the buffer the draw of the frame before(or the step
+   * before that) reads. Write after read needs no memory barrier, only the
+   * execution order. */
+  vkCmdPipelineBarrier(
+      command_buffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0,
+      nullptr);
+
+  m_compute_pipeline->Bind(command_buffer);
+  vkCmdBindDescriptorSets(
+      command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+      m_compute_pipeline_layout, 0, 1, &m_descriptor_sets[set], 0, nullptr);
+
+  ParticleComputePushConstants push_constants{};
+  push_constants.count = m_particle_count;
+  push_constants.dt = dt;
+  push_constants.strength = m_strength;
+  push_constants.softening2 = m_softening * m_softening;
+  vkCmdPushConstants(
+      command_buffer, m_compute_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+      0, sizeof(ParticleComputePushConstants), &push_constants);
+
+  vkCmdDispatch(
+      command_buffer,
+      (m_particle_count + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+  // the written state is read by the draw, the next step and download()
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask =
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+  vkCmdPipelineBarrier(
+      command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+          VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+  m_current_set = set;
+}
+
+void GpuParticleSystem::render(FrameInfo& frame_info)
+{
+  ZoneScoped;
+  assert(
+      m_corevu_pipeline != nullptr &&
+      "GpuParticleSystem::render without a render pass");
+
+  m_corevu_pipeline->Bind(frame_info.command_buffer);
+
+  const std::array<VkDescriptorSet, 2> descriptor_sets = {
+      frame_info.global_descriptor_set, m_descriptor_sets[m_current_set]};
+  vkCmdBindDescriptorSets(
+      frame_info.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+      m_pipeline_layout, 0, static_cast<uint32_t>(descriptor_sets.size()),
+      descriptor_sets.data(), 0, nullptr);
+
+  ParticlePushConstants push_constants{};
+  push_constants.size = m_particle_size;
+  vkCmdPushConstants(
+      frame_info.command_buffer, m_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT,
+      0, sizeof(ParticlePushConstants), &push_constants);
+
+  // one billboard per instance
+  vkCmdDraw(frame_info.command_buffer, 6, m_particle_count, 0, 0);
+}
+
+void GpuParticleSystem::download(std::vector<GpuParticle>& particles)
+{
+  ZoneScoped;
+  CoreVuBuffer staging_buffer{
+      m_corevu_device, sizeof(GpuParticle), m_particle_count,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+
+  // binding 1 of the current set is buffer A for set 1, B for set 0
+  VkCommandBuffer command_buffer = m_corevu_device.beginSingleTimeCommands();
+  VkBufferCopy copy_region{};
+  copy_region.size = staging_buffer.getBufferSize();
+  vkCmdCopyBuffer(
+      command_buffer, m_particle_buffers[m_current_set ^ 1u]->getBuffer(),
+      staging_buffer.getBuffer(), 1, &copy_region);
+
+  VkMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  vkCmdPipelineBarrier(
+      command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+  m_corevu_device.endSingleTimeCommands(command_buffer); // waits idle
+
+  staging_buffer.map();
+  const auto* mapped =
+      static_cast<const GpuParticle*>(staging_buffer.getMappedMemory());
+  particles.assign(mapped, mapped + m_particle_count);
+}
@@ -7,8 +7,8 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
-#include <map>
 
 using namespace corevu;
 
@@ -97,59 +97,111 @@ void PointLightSystem::update(FrameInfo& frame_info, GlobalUbo& global_ubo)
   auto rotation = glm::rotate(
       glm::mat4(1.f), frame_info.frame_time, glm::vec3{0.f, -1.f, 0.f}); // another rotation x instead y
 
-  int light_index = 0;
-  for (auto& [_, object] : frame_info.game_objects)
+  auto& world = frame_info.world;
+  const ChangeVersion since = m_change_version;
+  m_change_version = world.newChangeVersion();
+
+  // upd positions, every chunk is independent
+  world.query<TransformComponent, const PointLightComponent>()
+      .eachChunkParallel(
+          frame_info.job_system,
+          [&rotation](
+              uint32_t count, const CoreVuEntity*,
+              TransformComponent* transforms, const PointLightComponent*)
   {
-    if (!object.point_light)
+    for (uint32_t i = 0; i < count; ++i)
     {
-      continue;
+      transforms[i].SetTranslation(glm::vec3{
+          rotation * glm::vec4{transforms[i].GetTranslation(), 1.f}});
     }
-    assert(
-        light_index < MAX_LIGHTS && "PointLightSystem::update too many lights");
-    // if (light_index >= MAX_LIGHTS)
-    // {
-    //   std::cerr << "WARNING::too many point lights, skipping the rest"
-    //             << std::endl;
-    //   break;
-    // }
-
-    // upd position
-    object.transform.translation =
-        glm::vec3{rotation * glm::vec4{object.transform.translation, 1.f}};
-
-    global_ubo.point_lights[light_index].position =
-        glm::vec4{object.transform.translation, 1.f};
-    global_ubo.point_lights[light_index].color =
-        glm::vec4{object.color, object.point_light->intensity};
-    // global_ubo.point_lights[light_index].color.w =
-    //     object.point_light->range; // range
-    light_index++;
+  });
+
+  // the light table is only refilled if a light moved, changed or got
+  // removed since the last update, otherwise last frame's one is reused
+  auto lights =
+      world.query<const TransformComponent, const PointLightComponent>();
+  bool changed = lights.count() != static_cast<size_t>(m_light_count);
+  auto changed_lights = lights;
+  changed_lights.changedSince<TransformComponent, PointLightComponent>(since)
+      .eachChunk(
+          [&changed](
+              uint32_t, const CoreVuEntity*, const TransformComponent*,
+              const PointLightComponent*) { changed = true; });
+
+  if (changed)
+  {
+    // fill in query order. Lights are never parented, the local translation
+    // is their world position and it is up to date before TransformSystem ran
+    int light_index = 0;
+    lights.each(
+        [&](CoreVuEntity, const TransformComponent& transform,
+            const PointLightComponent& light)
+    {
+      assert(
+          light_index < MAX_LIGHTS &&
+          "PointLightSystem::update too many lights");
+      // if (light_index >= MAX_LIGHTS)
+      // {
+      //   std::cerr << "WARNING::too many point lights, skipping the rest"
+      //             << std::endl;
+      //   break;
+      // }
+
+      m_lights[light_index].position =
+          glm::vec4{transform.GetTranslation(), 1.f};
+      m_lights[light_index].color = glm::vec4{light.color, light.intensity};
+      // m_lights[light_index].color.w = light.range; // range
+      light_index++;
+    });
+    m_light_count = light_index;
   }
 
-  global_ubo.point_light_count = light_index;
+  std::copy_n(m_lights.begin(), m_light_count, global_ubo.point_lights);
+  global_ubo.point_light_count = m_light_count;
 }
 
-void PointLightSystem::render(FrameInfo& frame_info)
+void PointLightSystem::extractLights(
+    FrameInfo& frame_info, CoreVuLightList& lights)
 {
-  // sort lights for transparancy handling
-  std::map<float, CoreVuGameObject::CoreVuUid> sorted;
-  for (const auto& [uid, object] : frame_info.game_objects)
+  // billboards are transparent, back to front. Lights at the same distance
+  // get the same key and stay in query order
+  m_queue.clear();
+  const glm::vec3 camera_position = frame_info.camera.getPosition();
+  auto query =
+      frame_info.world
+          .query<const TransformComponent, const PointLightComponent>();
+  query.each(
+      [&](CoreVuEntity entity, const TransformComponent& transform,
+          const PointLightComponent&)
   {
-    if (!object.point_light)
-    {
-      continue;
-    }
-
-    const auto& position = object.transform.translation;
-    const auto& camera_position = frame_info.camera.getPosition();
-    const auto offset_vec = position - camera_position;
-    const auto distSquared = glm::dot(offset_vec, offset_vec);
-    sorted[distSquared] = uid;
+    const glm::vec3 position{transform.GetRenderMatrix()[3]};
+    const float depth = glm::distance(position, camera_position);
+    m_queue.push(MakeTransparentDrawKey(0, 0, 0, 0, depth), entity);
+  });
+  m_queue.sort(frame_info.job_system);
+
+  lights.clear();
+  for (const CoreVuRenderItem& item : m_queue.getItems())
+  {
+    const CoreVuEntity entity = item.payload;
+    const auto& transform =
+        *frame_info.world.getComponent<const TransformComponent>(entity);
+    const auto& light =
+        *frame_info.world.getComponent<const PointLightComponent>(entity);
+    // lights are roots, the translation of the render matrix is where the
+    // interpolated light is
+    lights.push(
+        transform.GetRenderMatrix()[3], glm::vec4{light.color, light.intensity},
+        transform.GetScale().x);
   }
+}
 
+void PointLightSystem::render(
+    const CoreVuRenderContext& context, const CoreVuLightList& lights)
+{
   /* NOTE: for different shaders we would require to have different pipeleines,
    * WARN: not to rebind them often because it's expensive. */
-  m_corevu_pipeline->Bind(frame_info.command_buffer);
+  m_corevu_pipeline->Bind(context.command_buffer);
 
   /* NOTE:
     Descriptor sets are bound in consequent order, which means that if we want
@@ -158,37 +210,33 @@ void PointLightSystem::render(FrameInfo& frame_info)
     list. And others in the order of their usage.
    */
   vkCmdBindDescriptorSets(
-      frame_info.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-      m_pipeline_layout, 0, 1, &frame_info.global_descriptor_set, 0,
+      context.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+      m_pipeline_layout, 0, 1, &context.global_descriptor_set, 0,
       nullptr); // Bind the global descriptor set once to be used for all
                 // objects.
 
-  // iterate through sorted lights in reverse order
-  for (auto it = sorted.rbegin(); it != sorted.rend(); it++)
+  for (size_t i = 0; i < lights.size(); ++i)
   {
-    const auto& object = frame_info.game_objects.at(it->second);
-
     PointLightPushConstants push_constants{};
-    push_constants.color =
-        glm::vec4{object.color, object.point_light->intensity};
-    push_constants.position = glm::vec4{object.transform.translation, 1.f};
-    push_constants.range = object.transform.scale.x;
+    push_constants.color = lights.colors[i];
+    push_constants.position = lights.positions[i];
+    push_constants.range = lights.ranges[i];
 
     vkCmdPushConstants(
-        frame_info.command_buffer, m_pipeline_layout,
+        context.command_buffer, m_pipeline_layout,
         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
         sizeof(PointLightPushConstants), &push_constants);
 
     // TODO for other shapes
     //  if (object.model)
     //  {
-    //    object.model->Bind(frame_info.command_buffer);
-    //    object.model->Draw(frame_info.command_buffer);
+    //    object.model->Bind(context.command_buffer);
+    //    object.model->Draw(context.command_buffer);
     //  }
     //  else
     {
       // draw a billboard
-      vkCmdDraw(frame_info.command_buffer, 6, 1, 0, 0);
+      vkCmdDraw(context.command_buffer, 6, 1, 0, 0);
     }
   }
 }
@@ -89,11 +89,50 @@ void RenderSystem::createPipeline(VkRenderPass render_pass)
       "C:/workspace/CoreVu/corevu/shaders/simple_shader.frag.spv");
 }
 
-void RenderSystem::renderGameObjects(FrameInfo& frame_info)
+void RenderSystem::extractDraws(
+    FrameInfo& frame_info, std::span<const CoreVuDrawItem> visible,
+    CoreVuDrawList& draws)
+{
+  // textured meshes are handled by TextureRenderSystem. Draws sorted by model
+  // bind every model once, front to back inside a model
+  const glm::vec3 camera_position = frame_info.camera.getPosition();
+  m_queue.clear();
+  for (uint32_t i = 0; i < visible.size(); ++i)
+  {
+    const auto& transform =
+        *frame_info.world.getComponent<const TransformComponent>(
+            visible[i].entity);
+    const auto& mesh =
+        *frame_info.world.getComponent<const ModelComponent>(visible[i].entity);
+    const glm::vec3 position{transform.GetRenderMatrix()[3]};
+    const float depth = glm::distance(position, camera_position);
+    m_queue.push(
+        MakeOpaqueDrawKey(
+            0, 0, HashDrawResource(mesh.model.get()), visible[i].lod, depth),
+        i);
+  }
+  m_queue.sort(frame_info.job_system);
+
+  draws.clear();
+  for (const CoreVuRenderItem& queued : m_queue.getItems())
+  {
+    const CoreVuDrawItem& item = visible[queued.payload];
+    const auto& transform =
+        *frame_info.world.getComponent<const TransformComponent>(item.entity);
+    const auto& mesh =
+        *frame_info.world.getComponent<const ModelComponent>(item.entity);
+    draws.push(
+        transform.GetRenderMatrix(), transform.GetNormalMatrix(),
+        mesh.model.get(), nullptr, item.lod);
+  }
+}
+
+void RenderSystem::renderGameObjects(
+    const CoreVuRenderContext& context, const CoreVuDrawList& draws)
 {
   /* NOTE: for different shaders we would require to have different pipeleines,
    * WARN: not to rebind them often because it's expensive. */
-  m_corevu_pipeline->Bind(frame_info.command_buffer);
+  m_corevu_pipeline->Bind(context.command_buffer);
 
   /* NOTE:
     Descriptor sets are bound in consequent order, which means that if we want
@@ -102,20 +141,14 @@ void RenderSystem::renderGameObjects(FrameInfo& frame_info)
     list. And others in the order of their usage.
    */
   vkCmdBindDescriptorSets(
-      frame_info.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-      m_pipeline_layout, 0, 1, &frame_info.global_descriptor_set, 0,
+      context.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+      m_pipeline_layout, 0, 1, &context.global_descriptor_set, 0,
       nullptr); // Bind the global descriptor set once to be used for all
                 // objects.
 
-  for (auto& obj_elem : frame_info.game_objects)
+  CoreVuModel* bound_model = nullptr;
+  for (size_t i = 0; i < draws.size(); ++i)
   {
-    auto& obj = obj_elem.second;
-
-    if (!obj.model || obj.diffuse_map)
-    {
-      continue;
-    }
-
     // TEST ROTATION FOR ALL GAME OBJECTS(TODO remove)
     // obj.transform.rotation.y =
     //     glm::mod(obj.transform.rotation.y + 0.01f, glm::two_pi<float>());
@@ -125,15 +158,20 @@ void RenderSystem::renderGameObjects(FrameInfo& frame_info)
     //     glm::mod(obj.transform.rotation.z + 0.0001f, glm::two_pi<float>());
 
     SimplePushConstantData push{};
-    push.normal_matrix = obj.transform.GetNormalMatrix();
-    push.model_matrix = obj.transform.ToMat4();
+    push.normal_matrix = draws.normal_matrices[i];
+    push.model_matrix = draws.model_matrices[i];
 
     vkCmdPushConstants(
-        frame_info.command_buffer, m_pipeline_layout,
+        context.command_buffer, m_pipeline_layout,
         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT, 0,
         sizeof(SimplePushConstantData), &push);
 
-    obj.model->Bind(frame_info.command_buffer);
-    obj.model->Draw(frame_info.command_buffer);
+    // hashes of two models can collide, the pointer decides
+    if (draws.models[i] != bound_model)
+    {
+      bound_model = draws.models[i];
+      bound_model->Bind(context.command_buffer);
+    }
+    bound_model->Draw(context.command_buffer, draws.lods[i]);
   }
 }
@@ -0,0 +1,276 @@
+#include "systems/spatial_index_system.hpp"
+
+// libs
+#include <Tracy.hpp>
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace corevu
+{
+namespace
+{
+// the ray in model space, distances along it stay the same
+CoreVuRay ToModelSpace(const glm::mat4& to_model, const CoreVuRay& ray)
+{
+  return CoreVuRay{
+      glm::vec3{to_model * glm::vec4{ray.origin, 1.f}},
+      glm::mat3{to_model} * ray.direction, ray.max_distance};
+}
+
+const CoreVuModel* GetModel(
+    const CoreVuWorld& world, CoreVuEntity entity,
+    const TransformComponent*& transform)
+{
+  transform = world.getComponent<const TransformComponent>(entity);
+  const auto* model = world.getComponent<const ModelComponent>(entity);
+  if (transform == nullptr || model == nullptr) return nullptr;
+  return model->model.get();
+}
+} // namespace
+
+void SpatialIndexSystem::update(FrameInfo& frame_info)
+{
+  ZoneScoped;
+  auto& world = frame_info.world;
+
+  if (world.getRemovalCount() != m_removal_count)
+  {
+    m_removal_count = world.getRemovalCount();
+    removeGone(world);
+  }
+
+  const ChangeVersion since = m_change_version;
+  m_change_version = world.newChangeVersion();
+  world.query<const TransformComponent, const ModelComponent>()
+      .changedSince<TransformComponent, ModelComponent>(since)
+      .each(
+          [&](CoreVuEntity entity, const TransformComponent& transform,
+              const ModelComponent& model)
+          {
+            const uint32_t index = GetEntityIndex(entity);
+            if (index >= m_entries.size())
+            {
+              m_entries.resize(index + 1);
+            }
+            auto& entry = m_entries[index];
+            if (entry.proxy != CoreVuAabbTree::NULL_PROXY &&
+                entry.entity != entity)
+            {
+              // index reused since the last update
+              m_tree.destroyProxy(entry.proxy);
+              entry = Entry{};
+            }
+
+            if (model.model == nullptr || model.model->GetBounds().isEmpty())
+            {
+              if (entry.proxy != CoreVuAabbTree::NULL_PROXY)
+              {
+                m_tree.destroyProxy(entry.proxy);
+                entry = Entry{};
+              }
+              return;
+            }
+
+            const CoreVuAabb box = model.model->GetBounds().transformed(
+                transform.GetWorldMatrix());
+            if (entry.proxy == CoreVuAabbTree::NULL_PROXY)
+            {
+              entry = Entry{entity, m_tree.createProxy(box, entity)};
+            }
+            else
+            {
+              m_tree.moveProxy(entry.proxy, box);
+            }
+          });
+}
+
+void SpatialIndexSystem::removeGone(const CoreVuWorld& world)
+{
+  ZoneScoped;
+  for (auto& entry : m_entries)
+  {
+    if (entry.proxy == CoreVuAabbTree::NULL_PROXY) continue;
+
+    if (!world.isAlive(entry.entity) ||
+        !world.hasComponent<TransformComponent>(entry.entity) ||
+        !world.hasComponent<ModelComponent>(entry.entity))
+    {
+      m_tree.destroyProxy(entry.proxy);
+      entry = Entry{};
+    }
+  }
+}
+
+CoreVuPickHit SpatialIndexSystem::raycast(
+    const CoreVuWorld& world, const CoreVuRay& ray) const
+{
+  ZoneScoped;
+  CoreVuPickHit closest{};
+  closest.distance = ray.max_distance;
+  m_tree.raycast(
+      ray,
+      [&](CoreVuEntity entity, float box_distance)
+      {
+        const TransformComponent* transform = nullptr;
+        const CoreVuModel* model = GetModel(world, entity, transform);
+        if (model == nullptr || box_distance >= closest.distance)
+        {
+          return closest.distance;
+        }
+
+        const CoreVuMeshBvh* bvh = model->GetBvh();
+        if (bvh == nullptr)
+        {
+          closest = CoreVuPickHit{entity, box_distance};
+          return closest.distance;
+        }
+
+        CoreVuRay local = ToModelSpace(
+            glm::inverse(transform->GetWorldMatrix()), ray);
+        local.max_distance = closest.distance;
+        const CoreVuMeshHit hit = bvh->raycast(local);
+        if (hit.isHit())
+        {
+          closest = CoreVuPickHit{
+              entity, hit.distance, hit.triangle, hit.barycentric};
+        }
+        return closest.distance;
+      });
+  return closest;
+}
+
+void SpatialIndexSystem::raycast(
+    const CoreVuWorld& world, CoreVuJobSystem& job_system,
+    std::span<const CoreVuRay> rays, std::span<CoreVuPickHit> hits) const
+{
+  ZoneScoped;
+  assert(hits.size() >= rays.size() && "Need a hit per ray");
+  constexpr uint32_t SIZE = CoreVuRayPacket::SIZE;
+  const auto ray_count = static_cast<uint32_t>(rays.size());
+  const uint32_t packet_count = (ray_count + SIZE - 1) / SIZE;
+  job_system.parallelFor(
+      packet_count, PACKET_BATCH_SIZE,
+      [&](uint32_t begin, uint32_t end)
+      {
+        for (uint32_t packet = begin; packet < end; ++packet)
+        {
+          const uint32_t first = packet * SIZE;
+          const uint32_t count = std::min(SIZE, ray_count - first);
+          raycastPacket(
+              world, rays.subspan(first, count), hits.subspan(first, count));
+        }
+      });
+}
+
+void SpatialIndexSystem::raycastPacket(
+    const CoreVuWorld& world, std::span<const CoreVuRay> rays,
+    std::span<CoreVuPickHit> hits) const
+{
+  constexpr uint32_t SIZE = CoreVuRayPacket::SIZE;
+
+  // entities any ray of the packet enters, with the lanes that do
+  struct Candidate
+  {
+    CoreVuEntity entity;
+    uint32_t lanes;
+    float distance; // nearest box entry of all lanes
+    std::array<float, SIZE> box_distances;
+  };
+  std::array<Candidate, MAX_PACKET_CANDIDATES> candidates;
+  uint32_t candidate_count = 0;
+  bool overflow = false;
+  for (uint32_t lane = 0; lane < rays.size() && !overflow; ++lane)
+  {
+    hits[lane] = CoreVuPickHit{};
+    hits[lane].distance = rays[lane].max_distance;
+    m_tree.raycast(
+        rays[lane],
+        [&](CoreVuEntity entity, float distance)
+        {
+          auto candidate = std::find_if(
+              candidates.begin(), candidates.begin() + candidate_count,
+              [&](const Candidate& c) { return c.entity == entity; });
+          if (candidate == candidates.begin() + candidate_count)
+          {
+            if (candidate_count == MAX_PACKET_CANDIDATES)
+            {
+              overflow = true;
+              return 0.f;
+            }
+            *candidate = Candidate{entity, 0, distance, {}};
+            candidate_count++;
+          }
+          candidate->lanes |= 1u << lane;
+          candidate->distance = std::min(candidate->distance, distance);
+          candidate->box_distances[lane] = distance;
+          return rays[lane].max_distance;
+        });
+  }
+  if (overflow)
+  {
+    for (uint32_t lane = 0; lane < rays.size(); ++lane)
+    {
+      hits[lane] = raycast(world, rays[lane]);
+    }
+    return;
+  }
+
+  // near entities first, their hits cut the rays short for the far ones
+  std::sort(
+      candidates.begin(), candidates.begin() + candidate_count,
+      [](const Candidate& a, const Candidate& b)
+      { return a.distance < b.distance; });
+  for (uint32_t i = 0; i < candidate_count; ++i)
+  {
+    const Candidate& candidate = candidates[i];
+    const TransformComponent* transform = nullptr;
+    const CoreVuModel* model = GetModel(world, candidate.entity, transform);
+    if (model == nullptr) continue;
+
+    uint32_t active = 0;
+    for (uint32_t lane = 0; lane < rays.size(); ++lane)
+    {
+      if ((candidate.lanes >> lane & 1u) != 0 &&
+          candidate.box_distances[lane] < hits[lane].distance)
+      {
+        active |= 1u << lane;
+      }
+    }
+    if (active == 0) continue;
+
+    const CoreVuMeshBvh* bvh = model->GetBvh();
+    if (bvh == nullptr)
+    {
+      for (uint32_t lane = 0; lane < rays.size(); ++lane)
+      {
+        if ((active >> lane & 1u) == 0) continue;
+        hits[lane] =
+            CoreVuPickHit{candidate.entity, candidate.box_distances[lane]};
+      }
+      continue;
+    }
+
+    const glm::mat4 to_model = glm::inverse(transform->GetWorldMatrix());
+    CoreVuRayPacket packet{};
+    for (uint32_t lane = 0; lane < rays.size(); ++lane)
+    {
+      if ((active >> lane & 1u) == 0) continue;
+      CoreVuRay local = ToModelSpace(to_model, rays[lane]);
+      local.max_distance = hits[lane].distance;
+      packet.set(lane, local);
+    }
+    std::array<CoreVuMeshHit, SIZE> mesh_hits;
+    const uint32_t hit_lanes = bvh->raycast(packet, active, mesh_hits.data());
+    for (uint32_t lane = 0; lane < rays.size(); ++lane)
+    {
+      if ((hit_lanes >> lane & 1u) == 0) continue;
+      const CoreVuMeshHit& hit = mesh_hits[lane];
+      hits[lane] = CoreVuPickHit{
+          candidate.entity, hit.distance, hit.triangle, hit.barycentric};
+    }
+  }
+}
+} // namespace corevu
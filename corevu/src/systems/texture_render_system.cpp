@@ -27,6 +27,11 @@ TextureRenderSystem::TextureRenderSystem(
 {
   createPipelineLayout(globalSetLayout);
   createPipeline(renderPass);
+  m_texture_pool =
+      CoreVuDescriptorPool::Builder(m_device)
+          .setMaxSets(MAX_TEXTURES)
+          .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_TEXTURES)
+          .build();
 }
 
 TextureRenderSystem::~TextureRenderSystem()
@@ -83,49 +88,108 @@ void TextureRenderSystem::createPipeline(VkRenderPass renderPass)
       "C:/workspace/CoreVu/corevu/shaders/texture_shader.frag.spv");
 }
 
-void TextureRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+VkDescriptorSet TextureRenderSystem::getTextureSet(CoreVuTexture& texture)
 {
-  m_pipeline->Bind(frameInfo.command_buffer);
+  // written once per texture, not once per frame
+  auto found = m_texture_sets.find(&texture);
+  if (found != m_texture_sets.end())
+  {
+    return found->second;
+  }
+
+  auto imageInfo = texture.getImageInfo();
+  VkDescriptorSet set;
+  if (!CoreVuDescriptorWriter(*m_render_system_layout, *m_texture_pool)
+           .writeImage(0, &imageInfo)
+           .build(set))
+  {
+    throw std::runtime_error("FAILURE::out of texture descriptor sets!");
+  }
+  m_texture_sets.emplace(&texture, set);
+  return set;
+}
+
+void TextureRenderSystem::extractDraws(
+    FrameInfo& frameInfo, std::span<const CoreVuDrawItem> visible,
+    CoreVuDrawList& draws)
+{
+  // sorted by texture then model: one descriptor set per texture instead of
+  // one per draw, each model bound once per texture
+  const auto& world = frameInfo.world;
+  const glm::vec3 camera_position = frameInfo.camera.getPosition();
+  m_queue.clear();
+  for (uint32_t i = 0; i < visible.size(); ++i)
+  {
+    const CoreVuEntity entity = visible[i].entity;
+    const auto& transform =
+        *world.getComponent<const TransformComponent>(entity);
+    const auto& mesh = *world.getComponent<const ModelComponent>(entity);
+    const auto& texture = *world.getComponent<const TextureComponent>(entity);
+    const glm::vec3 position{transform.GetRenderMatrix()[3]};
+    m_queue.push(
+        MakeOpaqueDrawKey(
+            0, HashDrawResource(texture.diffuse_map.get()),
+            HashDrawResource(mesh.model.get()), visible[i].lod,
+            glm::distance(position, camera_position)),
+        i);
+  }
+  m_queue.sort(frameInfo.job_system);
+
+  draws.clear();
+  for (const CoreVuRenderItem& queued : m_queue.getItems())
+  {
+    const CoreVuDrawItem& item = visible[queued.payload];
+    const auto& transform =
+        *world.getComponent<const TransformComponent>(item.entity);
+    const auto& mesh = *world.getComponent<const ModelComponent>(item.entity);
+    const auto& texture =
+        *world.getComponent<const TextureComponent>(item.entity);
+    draws.push(
+        transform.GetRenderMatrix(), transform.GetNormalMatrix(),
+        mesh.model.get(), texture.diffuse_map.get(), item.lod);
+  }
+}
+
+void TextureRenderSystem::renderGameObjects(
+    const CoreVuRenderContext& context, const CoreVuDrawList& draws)
+{
+  m_pipeline->Bind(context.command_buffer);
 
   vkCmdBindDescriptorSets(
-      frameInfo.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-      m_pipeline_layout, 0, 1, &frameInfo.global_descriptor_set, 0, nullptr);
+      context.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+      m_pipeline_layout, 0, 1, &context.global_descriptor_set, 0, nullptr);
 
-  for (auto& kv : frameInfo.game_objects)
+  CoreVuTexture* bound_texture = nullptr;
+  CoreVuModel* bound_model = nullptr;
+  for (size_t i = 0; i < draws.size(); ++i)
   {
-    auto& obj = kv.second;
-
-    // skip objects that don't have both a model and texture
-    if (obj.model == nullptr || obj.diffuse_map == nullptr)
-      continue;
-
-    // writing descriptor set each frame can slow performance
-    // would be more efficient to implement some sort of caching
-    auto imageInfo = obj.diffuse_map->getImageInfo();
-    VkDescriptorSet descriptorSet1;
-    CoreVuDescriptorWriter(
-        *m_render_system_layout, frameInfo.frame_descriptor_pool)
-        .writeImage(0, &imageInfo)
-        .build(descriptorSet1);
-
-    vkCmdBindDescriptorSets(
-        frameInfo.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_pipeline_layout,
-        1, // first set
-        1, // set count
-        &descriptorSet1, 0, nullptr);
+    if (draws.textures[i] != bound_texture)
+    {
+      bound_texture = draws.textures[i];
+      VkDescriptorSet descriptorSet1 = getTextureSet(*bound_texture);
+      vkCmdBindDescriptorSets(
+          context.command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+          m_pipeline_layout,
+          1, // first set
+          1, // set count
+          &descriptorSet1, 0, nullptr);
+    }
 
     TexturePushConstantData push{};
-    push.modelMatrix = obj.transform.ToMat4();
-    push.normalMatrix = obj.transform.GetNormalMatrix();
+    push.modelMatrix = draws.model_matrices[i];
+    push.normalMatrix = draws.normal_matrices[i];
 
     vkCmdPushConstants(
-        frameInfo.command_buffer, m_pipeline_layout,
+        context.command_buffer, m_pipeline_layout,
         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
         sizeof(TexturePushConstantData), &push);
 
-    obj.model->Bind(frameInfo.command_buffer);
-    obj.model->Draw(frameInfo.command_buffer);
+    if (draws.models[i] != bound_model)
+    {
+      bound_model = draws.models[i];
+      bound_model->Bind(context.command_buffer);
+    }
+    bound_model->Draw(context.command_buffer, draws.lods[i]);
   }
 }
 
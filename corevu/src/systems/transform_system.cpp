@@ -0,0 +1,346 @@
+#include "systems/transform_system.hpp"
+
+#include <simd/corevu_transform_batch.hpp>
+
+// libs
+#include <Tracy.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// std
+#include <cassert>
+#include <cmath>
+
+namespace corevu
+{
+
+namespace
+{
+constexpr uint32_t CHILDREN_BATCH_SIZE = 256;
+// dirty transforms gathered for one call of the batch kernel
+constexpr uint32_t DIRTY_BATCH_SIZE = 64;
+// largest cosine between two axes of a matrix that still counts as unsheared
+constexpr float MAX_SHEAR_COS = 1e-3f;
+
+struct Trs
+{
+  glm::vec3 translation;
+  glm::quat rotation;
+  glm::vec3 scale;
+};
+
+// false for sheared matrices(non uniform scale under a rotated child)
+bool Decompose(const glm::mat4& matrix, Trs& trs)
+{
+  glm::mat3 axes{matrix};
+  for (int i = 0; i < 3; ++i)
+  {
+    trs.scale[i] = glm::length(axes[i]);
+    if (trs.scale[i] <= 0.f) return false;
+    axes[i] /= trs.scale[i];
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    if (std::abs(glm::dot(axes[i], axes[(i + 1) % 3])) > MAX_SHEAR_COS)
+    {
+      return false;
+    }
+  }
+  // a mirroring matrix keeps the mirror in the scale, rotations can't hold it
+  if (glm::determinant(axes) < 0.f)
+  {
+    trs.scale.x = -trs.scale.x;
+    axes[0] = -axes[0];
+  }
+  trs.translation = glm::vec3{matrix[3]};
+  trs.rotation = glm::quat_cast(axes);
+  return true;
+}
+
+/* Translation and scale blend linearly, the rotation along the shorter arc
+ * (slerp), so it keeps its length and turns at a constant rate. Sheared
+ * matrices fall back to blending per element. */
+glm::mat4 Interpolate(const glm::mat4& from, const glm::mat4& to, float alpha)
+{
+  Trs a{};
+  Trs b{};
+  if (!Decompose(from, a) || !Decompose(to, b))
+  {
+    return from + (to - from) * alpha;
+  }
+  const glm::vec3 scale = glm::mix(a.scale, b.scale, alpha);
+  glm::mat4 matrix = glm::mat4_cast(glm::slerp(a.rotation, b.rotation, alpha));
+  for (int i = 0; i < 3; ++i)
+  {
+    matrix[i] *= scale[i];
+  }
+  matrix[3] = glm::vec4{glm::mix(a.translation, b.translation, alpha), 1.f};
+  return matrix;
+}
+
+/* The render matrix is derived per rendered frame and no system tracks it,
+ * writing it must not stamp a change version: every transform interpolated
+ * would look moved to changedSince() queries(spatial index, culling) in every
+ * frame, also between simulation steps. */
+glm::mat4& RenderMatrix(const TransformComponent& transform)
+{
+  return const_cast<glm::mat4&>(transform.GetRenderMatrix());
+}
+} // namespace
+
+void TransformSystem::setParent(
+    CoreVuWorld& world, CoreVuEntity child, CoreVuEntity parent)
+{
+  auto* transform = world.getComponent<TransformComponent>(child);
+  assert(transform != nullptr && "Child has no TransformComponent");
+
+  if (parent != NULL_ENTITY)
+  {
+    assert(
+        world.getComponent<const TransformComponent>(parent) != nullptr &&
+        "Parent has no TransformComponent");
+    for (CoreVuEntity ancestor = parent; ancestor != NULL_ENTITY;
+         ancestor =
+             world.getComponent<const TransformComponent>(ancestor)->m_parent)
+    {
+      assert(ancestor != child && "Transform hierarchy cycle");
+    }
+  }
+
+  transform->m_parent = parent;
+  transform->m_dirty = true;
+  m_hierarchy_dirty.store(true, std::memory_order_relaxed);
+}
+
+void TransformSystem::rebuildLevels(
+    CoreVuWorld& world, ChangeVersion version)
+{
+  for (auto& level : m_levels)
+  {
+    level.clear();
+  }
+
+  world.query<const TransformComponent>().each(
+      [&](CoreVuEntity entity, const TransformComponent& transform)
+      {
+        if (transform.m_parent == NULL_ENTITY) return;
+
+        // depth by walking up, destroyed parents make the child a root
+        size_t depth = 0;
+        CoreVuEntity ancestor = entity;
+        while (ancestor != NULL_ENTITY)
+        {
+          auto* current =
+              world.getComponent<const TransformComponent>(ancestor);
+          if (current->m_parent != NULL_ENTITY &&
+              !world.isAlive(current->m_parent))
+          {
+            auto* orphan =
+                world.getComponent<TransformComponent>(ancestor, version);
+            orphan->m_parent = NULL_ENTITY;
+            orphan->m_dirty = true;
+          }
+          ancestor = current->m_parent;
+          depth++;
+        }
+
+        if (depth > 1)
+        {
+          if (m_levels.size() < depth - 1)
+          {
+            m_levels.resize(depth - 1);
+          }
+          m_levels[depth - 2].push_back(entity);
+        }
+      });
+
+  m_hierarchy_dirty.store(false, std::memory_order_relaxed);
+}
+
+void TransformSystem::StoreWorldMatrix(
+    TransformComponent& transform, const glm::mat4& world_matrix,
+    uint32_t update_index)
+{
+  // the first matrix has no previous one to blend from
+  transform.m_previous_world_matrix =
+      transform.m_world_update == 0 ? world_matrix : transform.m_world_matrix;
+  transform.m_world_matrix = world_matrix;
+  transform.m_render_matrix = world_matrix;
+  transform.m_world_update = update_index;
+}
+
+void TransformSystem::update(FrameInfo& frame_info)
+{
+  ZoneScoped;
+
+  auto& world = frame_info.world;
+  auto& job_system = frame_info.job_system;
+
+  // only chunks somebody wrote transforms to since the last update can hold
+  // dirty ones, writes of this update are stamped with its own version
+  const ChangeVersion since = m_change_version;
+  m_change_version = world.newChangeVersion();
+  const ChangeVersion version = m_change_version;
+
+  if (m_hierarchy_dirty.load(std::memory_order_relaxed))
+  {
+    rebuildLevels(world, version);
+  }
+
+  // whatever the last update moved and this one does not stays where the
+  // last step put it
+  m_moved.resize(job_system.getThreadCount());
+  for (auto& moved : m_moved)
+  {
+    for (const CoreVuEntity entity : moved)
+    {
+      if (!world.isAlive(entity)) continue;
+      const auto& transform =
+          *world.getComponent<const TransformComponent>(entity);
+      RenderMatrix(transform) = transform.GetWorldMatrix();
+    }
+    moved.clear();
+  }
+
+  const uint32_t update_index = ++m_update_index;
+
+  world.query<TransformComponent>()
+      .changedSince<TransformComponent>(since)
+      .writeVersion(version)
+      .eachChunkParallel(
+          job_system,
+          [this, &job_system, update_index](
+              uint32_t count, const CoreVuEntity* entities,
+              TransformComponent* transforms)
+  {
+    auto& moved = m_moved[job_system.getThreadIndex()];
+    // dirty ones are copied to SoA streams and go through the simd kernel
+    float streams[9][DIRTY_BATCH_SIZE];
+    TransformComponent* dirty[DIRTY_BATCH_SIZE];
+    CoreVuEntity dirty_entities[DIRTY_BATCH_SIZE];
+    glm::mat4 models[DIRTY_BATCH_SIZE];
+    glm::mat3 normals[DIRTY_BATCH_SIZE];
+    uint32_t dirty_count = 0;
+
+    auto flush = [&]()
+    {
+      const CoreVuTransformSoA soa{
+          streams[0], streams[1], streams[2], streams[3], streams[4],
+          streams[5], streams[6], streams[7], streams[8]};
+      ComputeTransformMatrices(soa, dirty_count, models, normals);
+
+      for (uint32_t i = 0; i < dirty_count; ++i)
+      {
+        auto& transform = *dirty[i];
+        transform.m_local_matrix = models[i];
+        transform.m_local_update = update_index;
+        transform.m_dirty = false;
+
+        if (transform.m_parent == NULL_ENTITY)
+        {
+          StoreWorldMatrix(transform, models[i], update_index);
+          transform.m_normal_matrix = normals[i];
+          moved.push_back(dirty_entities[i]);
+        }
+      }
+      dirty_count = 0;
+    };
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      auto& transform = transforms[i];
+      if (!transform.m_dirty) continue;
+
+      streams[0][dirty_count] = transform.m_translation.x;
+      streams[1][dirty_count] = transform.m_translation.y;
+      streams[2][dirty_count] = transform.m_translation.z;
+      streams[3][dirty_count] = transform.m_rotation.x;
+      streams[4][dirty_count] = transform.m_rotation.y;
+      streams[5][dirty_count] = transform.m_rotation.z;
+      streams[6][dirty_count] = transform.m_scale.x;
+      streams[7][dirty_count] = transform.m_scale.y;
+      streams[8][dirty_count] = transform.m_scale.z;
+      dirty_entities[dirty_count] = entities[i];
+      dirty[dirty_count++] = &transform;
+
+      if (dirty_count == DIRTY_BATCH_SIZE)
+      {
+        flush();
+      }
+    }
+    if (dirty_count > 0)
+    {
+      flush();
+    }
+  });
+
+  for (const auto& level : m_levels)
+  {
+    job_system.parallelFor(
+        static_cast<uint32_t>(level.size()), CHILDREN_BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            const CoreVuEntity entity = level[i];
+            if (!world.isAlive(entity)) continue;
+
+            // read only until it is known to move, so still children leave
+            // their chunk unstamped
+            const auto& current =
+                *world.getComponent<const TransformComponent>(entity);
+            if (current.m_parent == NULL_ENTITY ||
+                !world.isAlive(current.m_parent))
+            {
+              // parent got destroyed, fixed up by the next rebuild
+              m_hierarchy_dirty.store(true, std::memory_order_relaxed);
+              continue;
+            }
+
+            const auto& parent = *world.getComponent<const TransformComponent>(
+                current.m_parent);
+            if (current.m_local_update != update_index &&
+                parent.m_world_update != update_index)
+            {
+              continue;
+            }
+
+            auto& transform =
+                *world.getComponent<TransformComponent>(entity, version);
+            StoreWorldMatrix(
+                transform, parent.m_world_matrix * transform.m_local_matrix,
+                update_index);
+            transform.m_normal_matrix =
+                glm::inverseTranspose(glm::mat3{transform.m_world_matrix});
+            m_moved[job_system.getThreadIndex()].push_back(entity);
+          }
+        });
+  }
+}
+
+void TransformSystem::interpolate(FrameInfo& frame_info, float alpha)
+{
+  ZoneScoped;
+
+  auto& world = frame_info.world;
+  for (const auto& moved : m_moved)
+  {
+    frame_info.job_system.parallelFor(
+        static_cast<uint32_t>(moved.size()), CHILDREN_BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            if (!world.isAlive(moved[i])) continue;
+
+            const auto& transform =
+                *world.getComponent<const TransformComponent>(moved[i]);
+            RenderMatrix(transform) = Interpolate(
+                transform.m_previous_world_matrix, transform.m_world_matrix,
+                alpha);
+          }
+        });
+  }
+}
+
+} // namespace corevu
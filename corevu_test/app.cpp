@@ -3,8 +3,13 @@
 #include <corevu/include/systems/render_system.hpp>
 #include <corevu/include/systems/point_light_system.hpp>
 #include <corevu/include/systems/texture_render_system.hpp>
+#include <corevu/include/systems/transform_system.hpp>
 #include <corevu/include/corevu_camera.hpp>
 #include <corevu/include/corevu_buffer.hpp>
+#include <corevu/include/debug/corevu_alloc_tracker.hpp>
+#include <corevu/include/render/corevu_render_thread.hpp>
+#include <corevu/include/scene/corevu_scene.hpp>
+#include <corevu/include/scene/corevu_static_batcher.hpp>
 
 #include <corevu/include/corevu_frame_info.hpp> // to re-think, because the uniform description shouldn't be part of the engine
 
@@ -18,16 +23,18 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <chrono>
-#include <thread>
+#include <filesystem>
 
 using namespace corevutest;
 
 const int FPS = 60;
-const std::chrono::milliseconds FRAME_DURATION(1000 / FPS);
+const char* SCENE_PATH = "sample.cvscene";
 
-SampleApp::SampleApp()
+SampleApp::SampleApp(uint64_t frame_limit, bool check_allocations)
+  : m_frame_limit{frame_limit}, m_check_allocations{check_allocations}
 {
   m_global_descriptor_pool =
       corevu::CoreVuDescriptorPool::Builder(m_corevu_device)
@@ -103,17 +110,135 @@ void SampleApp::run()
       m_corevu_device, m_renderer.GetSwapchainRenderpass(),
       global_descriptor_set_layout->getDescriptorSetLayout()};
 
+  // simulation systems run once per fixed step, frame systems once per frame,
+  // ordering comes from the declared component access
+  corevu::GlobalUbo ubo{};
+  m_step_scheduler.addSystem(
+      "point_light_update",
+      corevu::CoreVuSystemAccess{}
+          .write<corevu::TransformComponent, corevu::GlobalUboResource>()
+          .read<corevu::PointLightComponent>(),
+      [&](corevu::FrameInfo& frame_info)
+      { point_light_system.update(frame_info, ubo); });
+  m_step_scheduler.addSystem(
+      "transform_update",
+      corevu::CoreVuSystemAccess{}.write<corevu::TransformComponent>(),
+      [&](corevu::FrameInfo& frame_info)
+      { m_transform_system.update(frame_info); });
+
+  m_scheduler.addSystem(
+      "transform_interpolate",
+      corevu::CoreVuSystemAccess{}.write<corevu::TransformComponent>(),
+      [&](corevu::FrameInfo& frame_info)
+      {
+        m_transform_system.interpolate(frame_info, m_frame_loop.getAlpha());
+      });
+  m_scheduler.addSystem(
+      "spatial_index",
+      corevu::CoreVuSystemAccess{}
+          .read<corevu::TransformComponent, corevu::ModelComponent>()
+          .write<corevu::SpatialIndexResource>(),
+      [&](corevu::FrameInfo& frame_info)
+      { m_spatial_index.update(frame_info); });
+  m_scheduler.addSystem(
+      "culling",
+      corevu::CoreVuSystemAccess{}
+          .read<
+              corevu::TransformComponent, corevu::ModelComponent,
+              corevu::TextureComponent, corevu::OccluderComponent>()
+          .write<corevu::VisibilityResource>(),
+      [&](corevu::FrameInfo& frame_info)
+      { m_culling_system.update(frame_info); });
+  // the render systems copy what recording needs into the packet of the
+  // frame, the render thread records it while the next frame runs
+  corevu::CoreVuFramePacket* packet = nullptr;
+  m_scheduler.addSystem(
+      "texture_extract",
+      corevu::CoreVuSystemAccess{}
+          .read<
+              corevu::TransformComponent, corevu::ModelComponent,
+              corevu::TextureComponent, corevu::VisibilityResource>()
+          .write<corevu::FramePacketResource>(),
+      [&](corevu::FrameInfo& frame_info)
+      {
+        texture_render_system.extractDraws(
+            frame_info, m_culling_system.getVisibleTextured(),
+            packet->textured);
+      });
+  m_scheduler.addSystem(
+      "render_extract",
+      corevu::CoreVuSystemAccess{}
+          .read<
+              corevu::TransformComponent, corevu::ModelComponent,
+              corevu::VisibilityResource>()
+          .write<corevu::FramePacketResource>(),
+      [&](corevu::FrameInfo& frame_info)
+      {
+        render_system.extractDraws(
+            frame_info, m_culling_system.getVisible(), packet->meshes);
+      });
+  m_scheduler.addSystem(
+      "point_light_extract",
+      corevu::CoreVuSystemAccess{}
+          .read<corevu::TransformComponent, corevu::PointLightComponent>()
+          .write<corevu::FramePacketResource>(),
+      [&](corevu::FrameInfo& frame_info)
+      { point_light_system.extractLights(frame_info, packet->lights); });
+
+  // owns the frames in flight: command buffers, frame pools and uniform
+  // buffers are only touched here. Oredered by transparency
+  const auto recordFrame = [&](const corevu::CoreVuFramePacket& frame)
+  {
+    auto command_buffer = m_renderer.BeginFrame();
+    if (!command_buffer)
+    {
+      return; // swap chain recreated, the frame is dropped
+    }
+    const int frame_index = m_renderer.GetFrameIndex();
+    m_frame_pools[frame_index]->resetPool();
+    uniform_buffers[frame_index]->writeToBuffer(&frame.ubo);
+    uniform_buffers[frame_index]->flush();
+
+    const corevu::CoreVuRenderContext context{
+        .frame_index = frame_index,
+        .command_buffer = command_buffer,
+        .global_descriptor_set = global_descriptor_sets[frame_index],
+        .frame_descriptor_pool = *m_frame_pools[frame_index]};
+    m_renderer.BeginSwapChainRenderPass(command_buffer);
+    texture_render_system.renderGameObjects(context, frame.textured);
+    render_system.renderGameObjects(context, frame.meshes);
+    point_light_system.render(context, frame.lights);
+    m_renderer.EndSwapChainRenderPass(command_buffer);
+    m_renderer.EndFrame();
+  };
+  // after the warm-up frames are checked on the render thread too
+  corevu::CoreVuRenderThread render_thread{
+      [&](const corevu::CoreVuFramePacket& frame)
+      {
+        corevu::CoreVuAllocScope scope{"render_thread"};
+        const bool steady = frame.frame >= warmup_frames;
+        if (steady) corevu::CoreVuAllocTracker::beginFrame();
+        recordFrame(frame);
+        if (steady) corevu::CoreVuAllocTracker::endFrame();
+      },
+      threaded_rendering};
+
   corevu::CoreVuCamera camera{};
   // camera.setViewDirection(glm::vec3(0.f), glm::vec3(0.5f, 0.f, 1.f));
   // camera.setViewTarget(glm::vec3(1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
 
-  auto viewer_object = corevu::CoreVuGameObject::Create();
-  viewer_object.transform.translation = {0.f, 0.f, -2.5f};
+  // camera position is preserved in the viewer entity
+  const auto viewer_entity = m_world.createEntity(
+      corevu::TransformComponent{{0.f, 0.f, -2.5f}});
   corevu::KeyboardMovementController keyboard_camera_controller{};
 
-  auto frame_start = std::chrono::steady_clock::now();
-  auto current_time = frame_start;
-  while (!m_corevu_window.shouldClose())
+  auto current_time = std::chrono::steady_clock::now();
+  m_frame_loop.reset(); // loading the scene is not simulated time
+  m_frame_loop.setRenderRate(FPS);
+  bool was_clicked = false;
+  uint64_t frame = 0;
+  while (!m_corevu_window.shouldClose() &&
+         (m_frame_limit == 0 || frame < m_frame_limit))
   {
     ZoneScoped;
 
@@ -128,11 +253,11 @@ void SampleApp::run()
             .count();
     current_time = now;
 
+    auto& viewer =
+        *m_world.getComponent<corevu::TransformComponent>(viewer_entity);
     keyboard_camera_controller.moveInPlaneXZ(
-        m_corevu_window.GetGLFWwindow(), dt_sec,
-        viewer_object); // camera position preserve in viewerobj.
-    camera.setViewYXZ(
-        viewer_object.transform.translation, viewer_object.transform.rotation);
+        m_corevu_window.GetGLFWwindow(), dt_sec, viewer);
+    camera.setViewYXZ(viewer.GetTranslation(), viewer.GetRotation());
 
     // NOTE compensate stretching of Vulkan viewport to swapchain
     // renderbuffersize with aspect_ratio in projection matrix
@@ -142,53 +267,128 @@ void SampleApp::run()
     camera.setPerspectiveProjection(
         glm::radians(50.f), aspect_ratio, 0.1f, 100.f);
 
-    if (auto command_buffer = m_renderer.BeginFrame())
+    // everything up to the hand over belongs to the frame, it must not
+    // allocate once warmed up
+    const bool steady = frame++ >= warmup_frames;
+    if (steady) corevu::CoreVuAllocTracker::beginFrame();
+
+    // blocks while the render thread is a packet behind
+    packet = &render_thread.beginPacket();
+    packet->clear();
+    packet->frame_time = dt_sec;
+    // recording is the render thread's, the systems only extract
+    corevu::FrameInfo frame_info{
+        .frame_index = -1,
+        .frame_time = dt_sec,
+        .command_buffer = VK_NULL_HANDLE,
+        .camera = camera,
+        .global_descriptor_set = VK_NULL_HANDLE,
+        .frame_descriptor_pool = nullptr,
+        .world = m_world,
+        .job_system = m_job_system,
+        .event_bus = m_event_bus};
+
+    // simulation first, with the time that passed since the last frame
+    const uint32_t steps = m_frame_loop.beginFrame();
+    corevu::FrameInfo step_info = frame_info;
+    step_info.frame_time = m_frame_loop.getStep();
+    for (uint32_t step = 0; step < steps; ++step)
     {
-      const int frame_index = m_renderer.GetFrameIndex();
-      m_frame_pools[frame_index]->resetPool();
-      corevu::FrameInfo frame_info{
-          .frame_index = frame_index,
-          .frame_time = dt_sec,
-          .command_buffer = command_buffer,
-          .camera = camera,
-          .global_descriptor_set = global_descriptor_sets[frame_index],
-          .frame_descriptor_pool = *m_frame_pools[frame_index],
-          .game_objects = m_game_objects};
-
-      // update
-      corevu::GlobalUbo ubo{};
-      ubo.projection_matrix = camera.getProjection();
-      ubo.view_matrix = camera.getView();
-      ubo.inverse_view_matrix = camera.getInverseView();
-      point_light_system.update(
-          frame_info, ubo); // before writing to ubo buffers below
-      uniform_buffers[frame_index]->writeToBuffer(&ubo);
-      uniform_buffers[frame_index]->flush();
-
-      // render
-      m_renderer.BeginSwapChainRenderPass(command_buffer);
-
-      // oredered by transparency
-      texture_render_system.renderGameObjects(frame_info);
-      render_system.renderGameObjects(frame_info);
-      point_light_system.render(frame_info);
-
-      m_renderer.EndSwapChainRenderPass(command_buffer);
-      m_renderer.EndFrame();
+      m_step_scheduler.run(step_info);
     }
-    const auto frame_finish = std::chrono::steady_clock::now();
-    const std::chrono::duration<double, std::milli> frame_time =
-        frame_finish - frame_start;
-    if (frame_time < FRAME_DURATION)
+
+    // the lights in the ubo are kept from the last step
+    ubo.projection_matrix = camera.getProjection();
+    ubo.view_matrix = camera.getView();
+    ubo.inverse_view_matrix = camera.getInverseView();
+    packet->ubo = ubo;
+
+    // interpolate and extract, then hand the frame over
+    m_scheduler.run(frame_info);
+    render_thread.submitPacket();
+    if (steady) corevu::CoreVuAllocTracker::endFrame();
+
+    // the spatial index is up to date and nothing writes the world now
+    const bool clicked =
+        glfwGetMouseButton(
+            m_corevu_window.GetGLFWwindow(), GLFW_MOUSE_BUTTON_LEFT) ==
+        GLFW_PRESS;
+    if (clicked && !was_clicked)
     {
-      std::this_thread::sleep_for(FRAME_DURATION - frame_time);
+      pickUnderCursor(camera);
     }
-    frame_start = std::chrono::steady_clock::now();
+    was_clicked = clicked;
+    m_frame_loop.waitForRenderSlot();
 
     FrameMark;
   }
 
+  render_thread.flush();
   vkDeviceWaitIdle(m_corevu_device.device());
+
+  m_step_scheduler.printReport(std::cout);
+  m_scheduler.printReport(std::cout);
+  std::cout << "dropped simulation steps: " << m_frame_loop.getDroppedSteps()
+            << std::endl;
+  const auto& render_stats = render_thread.getStats();
+  const double frames =
+      static_cast<double>(std::max<uint64_t>(render_stats.frames, 1));
+  std::cout << "render thread: " << (threaded_rendering ? "on" : "off")
+            << ", frames: " << render_stats.frames
+            << ", record ms/frame: " << render_stats.record_ms / frames
+            << ", main stall ms/frame: " << render_stats.stall_ms / frames
+            << ", render idle ms/frame: " << render_stats.idle_ms / frames
+            << std::endl;
+  m_culling_system.printReport(std::cout);
+  corevu::CoreVuAllocTracker::report(std::cout);
+
+  if (!m_check_allocations)
+  {
+    return;
+  }
+  if (!corevu::CoreVuAllocTracker::ENABLED)
+  {
+    throw std::runtime_error(
+        "FAILURE::allocation check needs COREVU_TRACK_ALLOCATIONS!");
+  }
+  if (corevu::CoreVuAllocTracker::getAllocationCount() > 0)
+  {
+    throw std::runtime_error(
+        "FAILURE::steady state frames allocated, see the report!");
+  }
+}
+
+void SampleApp::pickUnderCursor(const corevu::CoreVuCamera& camera)
+{
+  ZoneScoped;
+  GLFWwindow* window = m_corevu_window.GetGLFWwindow();
+  double x = 0.0;
+  double y = 0.0;
+  int width = 0;
+  int height = 0;
+  glfwGetCursorPos(window, &x, &y);
+  glfwGetWindowSize(window, &width, &height);
+  if (width == 0 || height == 0)
+  {
+    return; // minimized
+  }
+
+  const glm::vec2 ndc{
+      static_cast<float>(2.0 * x / width - 1.0),
+      static_cast<float>(2.0 * y / height - 1.0)};
+  const corevu::CoreVuPickHit hit =
+      m_spatial_index.raycast(m_world, camera.getRay(ndc));
+  if (!hit.isHit())
+  {
+    std::cout << "picked nothing" << std::endl;
+    return;
+  }
+  std::cout << "picked entity " << corevu::GetEntityIndex(hit.entity);
+  if (hit.triangle != corevu::CoreVuMeshHit::NO_TRIANGLE)
+  {
+    std::cout << ", triangle " << hit.triangle;
+  }
+  std::cout << ", at " << hit.distance << " of the view depth" << std::endl;
 }
 
 // temporary helper function, creates a 1x1x1 cube centered at offset
@@ -246,86 +446,113 @@ std::shared_ptr<corevu::CoreVuModel> createCubeModel(
   return std::make_shared<corevu::CoreVuModel>(device, builder);
 }
 
+// temporary helper function, creates a point light entity. The range is kept
+// in transform.scale.x, the point light shader uses it as billboard radius
+corevu::CoreVuEntity createPointLight(
+    corevu::CoreVuWorld& world, glm::vec3 position, float intensity = 10.f,
+    float range = 0.1f, glm::vec3 color = glm::vec3{1.f})
+{
+  corevu::TransformComponent transform{position};
+  transform.SetScale({range, 1.f, 1.f});
+  return world.createEntity(
+      transform, corevu::PointLightComponent{color, intensity});
+}
+
 void SampleApp::loadGameObjects()
+{
+  // the scene is built once and loaded from its binary file afterwards
+  if (std::filesystem::exists(SCENE_PATH))
+  {
+    corevu::CoreVuScene::Load(
+        SCENE_PATH, m_world, m_transform_system, &m_assets);
+  }
+  else
+  {
+    buildScene();
+    corevu::CoreVuScene::Save(m_world, SCENE_PATH, &m_assets);
+  }
+
+  // after saving, batches are not part of the scene file
+  if (static_batching)
+  {
+    corevu::CoreVuStaticBatcher batcher{
+        m_corevu_device, m_assets, &m_job_system};
+    const corevu::CoreVuStaticBatchStats stats = batcher.build(m_world);
+    std::cout << "Static batches:" << stats.batches
+              << " objects:" << stats.objects << " skipped:" << stats.skipped
+              << " triangles:" << stats.triangles << std::endl;
+  }
+}
+
+void SampleApp::buildScene()
 {
   // 3d solution
 
   // First object
   {
-    auto model = corevu::CoreVuModel::CreateModelFromPath(
-        m_corevu_device,
+    auto model = m_assets.getModel(
         "C:\\workspace\\CoreVu\\assets\\models\\smooth_vase.obj");
     // createCubeModel(m_corevu_device, {.0f, .0f, .0f});
-    auto object = corevu::CoreVuGameObject::Create();
-    object.model = model;
-    object.transform.translation = {
-        1.0f, .5f, 0}; // z 2.5 for perspective, 0.5f for othographic (look in
-                       // +z direction)
-    object.transform.scale = {2.5f, 1.5f, 2.5f};
-
-    const auto obj_id = object.GetUid();
-    m_game_objects.emplace(obj_id, std::move(object));
+    corevu::TransformComponent transform{};
+    transform.SetTranslation(
+        {1.0f, .5f, 0}); // z 2.5 for perspective, 0.5f for othographic (look
+                         // in +z direction)
+    transform.SetScale({2.5f, 1.5f, 2.5f});
+
+    m_world.createEntity(
+        transform, corevu::ModelComponent{model}, corevu::StaticComponent{});
   }
 
   // Second object
   {
-    auto model = corevu::CoreVuModel::CreateModelFromPath(
-        m_corevu_device,
+    auto model = m_assets.getModel(
         "C:\\workspace\\CoreVu\\assets\\models\\flat_vase.obj");
     // createCubeModel(m_corevu_device, {.0f, .0f, .0f});
-    auto object = corevu::CoreVuGameObject::Create();
-    object.model = model;
-    object.transform.translation = {
-        -1.0f, .5f, 0}; // z 2.5 for perspective, 0.5f for othographic (look in
-                        // +z direction)
-    object.transform.scale = {2.5f, 1.5f, 2.5f};
-
-    const auto obj_id = object.GetUid();
-    m_game_objects.emplace(obj_id, std::move(object));
+    corevu::TransformComponent transform{};
+    transform.SetTranslation(
+        {-1.0f, .5f, 0}); // z 2.5 for perspective, 0.5f for othographic (look
+                          // in +z direction)
+    transform.SetScale({2.5f, 1.5f, 2.5f});
+
+    m_world.createEntity(
+        transform, corevu::ModelComponent{model}, corevu::StaticComponent{});
   }
 
   // Third object
   {
-    auto model = corevu::CoreVuModel::CreateModelFromPath(
-        m_corevu_device,
+    auto model = m_assets.getModel(
         "C:\\workspace\\CoreVu\\assets\\models\\colored_cube.obj");
     // createCubeModel(m_corevu_device, {.0f, .0f, .0f});
-    auto object = corevu::CoreVuGameObject::Create();
-    object.model = model;
-    object.transform.translation = {
-        0.0f, .0f, 0}; // z 2.5 for perspective, 0.5f for othographic (look in
-                       // +z direction)
-    object.transform.scale = {.25f, .25f, .25f};
-    object.transform.rotation = {
-        .13f * glm::two_pi<float>(), .13f * glm::two_pi<float>(), 0.f};
-
-    const auto obj_id = object.GetUid();
-    m_game_objects.emplace(obj_id, std::move(object));
+    corevu::TransformComponent transform{};
+    transform.SetTranslation(
+        {0.0f, .0f, 0}); // z 2.5 for perspective, 0.5f for othographic (look
+                         // in +z direction)
+    transform.SetScale({.25f, .25f, .25f});
+    transform.SetRotation(
+        {.13f * glm::two_pi<float>(), .13f * glm::two_pi<float>(), 0.f});
+
+    m_world.createEntity(
+        transform, corevu::ModelComponent{model}, corevu::StaticComponent{});
   }
 
   // Floor object
   {
-    auto model = corevu::CoreVuModel::CreateModelFromPath(
-        m_corevu_device, "C:\\workspace\\CoreVu\\assets\\models\\quad.obj");
-    auto texture = corevu::CoreVuTexture::createTextureFromPath(
-        m_corevu_device, "C:\\workspace\\CoreVu\\assets\\textures\\missing.png");
-    auto object = corevu::CoreVuGameObject::Create();
-    object.model = model;
-    object.diffuse_map = texture;
-    object.transform.translation = {0.0f, .5f, 0};
-    object.transform.scale = {3.f, 1.f, 3.f};
-
-    const auto obj_id = object.GetUid();
-    m_game_objects.emplace(obj_id, std::move(object));
+    auto model =
+        m_assets.getModel("C:\\workspace\\CoreVu\\assets\\models\\quad.obj");
+    auto texture = m_assets.getTexture(
+        "C:\\workspace\\CoreVu\\assets\\textures\\missing.png");
+    corevu::TransformComponent transform{};
+    transform.SetTranslation({0.0f, .5f, 0});
+    transform.SetScale({3.f, 1.f, 3.f});
+
+    m_world.createEntity(
+        transform, corevu::ModelComponent{model},
+        corevu::TextureComponent{texture}, corevu::StaticComponent{});
   }
 
   // Point light object 1
   {
-    auto object = corevu::CoreVuGameObject::CreateAsPointLight(0.2f);
-    object.transform.translation = {0.0f, -1.0f, 0.0f};
-
-    const auto obj_id = object.GetUid();
-    m_game_objects.emplace(obj_id, std::move(object));
+    createPointLight(m_world, {0.0f, -1.0f, 0.0f}, 0.2f);
   }
 
   // Multi-point light generation
@@ -336,16 +563,12 @@ void SampleApp::loadGameObjects()
     };
     for (size_t i = 0; i < light_colors.size(); i++)
     {
-      auto object = corevu::CoreVuGameObject::CreateAsPointLight(
-          0.2f, (i + 1) * 0.1f, light_colors[i]);
       auto rotation = glm::rotate(
           glm::mat4(1.f), (i * glm::two_pi<float>()) / light_colors.size(),
           glm::vec3{0.f, -1.f, 0.f});
-      object.transform.translation =
-          glm::vec3{rotation * glm::vec4{-1.f, -1.f, -1.f, 1.f}};
-
-      const auto obj_id = object.GetUid();
-      m_game_objects.emplace(obj_id, std::move(object));
+      createPointLight(
+          m_world, glm::vec3{rotation * glm::vec4{-1.f, -1.f, -1.f, 1.f}},
+          0.2f, (i + 1) * 0.1f, light_colors[i]);
     }
   }
 
@@ -1,12 +1,21 @@
 #pragma once
 
+#include <corevu/include/corevu_camera.hpp>
 #include <corevu/include/corevu_device.hpp>
-#include <corevu/include/corevu_gameobject.hpp>
+#include <corevu/include/corevu_frame_loop.hpp>
+#include <corevu/include/corevu_components.hpp>
 #include <corevu/include/corevu_window.hpp>
 #include <corevu/include/corevu_descriptors.hpp>
+#include <corevu/include/ecs/corevu_scheduler.hpp>
+#include <corevu/include/ecs/corevu_world.hpp>
+#include <corevu/include/scene/corevu_asset_cache.hpp>
+#include <corevu/include/systems/culling_system.hpp>
+#include <corevu/include/systems/spatial_index_system.hpp>
+#include <corevu/include/systems/transform_system.hpp>
 #include "renderer.hpp"
 
 // std
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
@@ -20,8 +29,20 @@ class SampleApp
 public:
   static constexpr int width = 800;
   static constexpr int height = 600;
+  static constexpr float simulation_rate = 60.f; // fixed steps per second
+  // records frames on a thread of their own, see CoreVuRenderThread
+  static constexpr bool threaded_rendering = true;
 
-  SampleApp();
+  // merges the static meshes of the scene into batches after loading it,
+  // see CoreVuStaticBatcher
+  static constexpr bool static_batching = true;
+
+  // frames allowed to allocate before the steady state is checked
+  static constexpr uint64_t warmup_frames = 120;
+
+  // frame_limit 0 runs until the window closes, check_allocations throws if
+  // a frame after the warm-up allocated(see CoreVuAllocTracker)
+  explicit SampleApp(uint64_t frame_limit = 0, bool check_allocations = false);
   ~SampleApp();
   SampleApp(const SampleApp&) = delete;
   SampleApp& operator=(const SampleApp&) = delete;
@@ -30,8 +51,14 @@ public:
 
 private:
   void loadGameObjects();
+  void buildScene();
+  // prints the entity under the cursor
+  void pickUnderCursor(const corevu::CoreVuCamera& camera);
 
 private:
+  uint64_t m_frame_limit;
+  bool m_check_allocations;
+
   corevu::CoreVuWindow m_corevu_window{width, height, "Hello CoreVu!"};
   corevu::CoreVuDevice m_corevu_device{m_corevu_window};
   SampleRenderer m_renderer{m_corevu_window, m_corevu_device};
@@ -39,7 +66,20 @@ private:
   std::unique_ptr<corevu::CoreVuDescriptorPool> m_global_descriptor_pool{};
   std::vector<std::unique_ptr<corevu::CoreVuDescriptorPool>> m_frame_pools;
 
-  // also could draw the model itself std::unique_ptr<corevu::CoreVuModel>
-  corevu::CoreVuGameObject::ObjectContainer m_game_objects;
+  corevu::CoreVuWorld m_world;
+  // one hardware thread less for the render thread
+  corevu::CoreVuJobSystem m_job_system{
+      threaded_rendering
+          ? std::max(1u, corevu::CoreVuJobSystem::DefaultThreadCount() - 1)
+          : corevu::CoreVuJobSystem::DefaultThreadCount()};
+  corevu::CoreVuEventBus m_event_bus{m_job_system};
+  // models keep a BVH for picking
+  corevu::CoreVuAssetCache m_assets{m_corevu_device, &m_job_system};
+  corevu::CoreVuFrameLoop m_frame_loop{1.f / simulation_rate};
+  corevu::CoreVuScheduler m_step_scheduler{m_job_system};
+  corevu::CoreVuScheduler m_scheduler{m_job_system};
+  corevu::TransformSystem m_transform_system{};
+  corevu::SpatialIndexSystem m_spatial_index{};
+  corevu::CullingSystem m_culling_system{m_job_system.getThreadCount()};
 };
 } // namespace corevutest
\ No newline at end of file
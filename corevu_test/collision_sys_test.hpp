@@ -0,0 +1,263 @@
+#pragma once
+
+#include <corevu/include/events/corevu_event_bus.hpp>
+#include <corevu/include/events/corevu_events.hpp>
+#include <corevu/include/geometry/corevu_bounds.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/physics/corevu_broadphase.hpp>
+#include <corevu/include/simd/corevu_transform_batch.hpp>
+
+#include <glm/glm.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Broadphase on 10k and 100k 2d bodies(boxes of 0.5..2 units, thin in z) in a
+square sized for about one overlap per body, moving at up to 2 units per
+second and bouncing off the walls.
+  check: pairs of both modes after a few frames, against all pairs at 10k and
+against each other at 100k, and the CollisionEvents published for them,
+throws FAILURE:: if they are wrong.
+  frames: 60 frames of moving all bodies and finding the pairs, per mode on
+one and all threads, sweep and prune also with the scalar overlap test. The
+first frame is not measured, it sorts from scratch.
+*/
+class CollisionSysTest
+{
+public:
+  void run()
+  {
+    std::printf("simd: %s\n", corevu::ToString(corevu::GetSimdLevel()));
+    for (const uint32_t count : COUNTS)
+    {
+      if (!check(count))
+      {
+        throw std::runtime_error(
+            "FAILURE::broadphase pairs are wrong at " + std::to_string(count) +
+            " bodies");
+      }
+    }
+
+    std::printf(
+        "\n%8s %14s %8s %10s %10s %10s %12s\n", "bodies", "mode", "threads",
+        "ms/frame", "pairs", "swaps", "tests");
+    for (const uint32_t count : COUNTS)
+    {
+      const uint32_t all = corevu::CoreVuJobSystem::DefaultThreadCount();
+      frames(count, corevu::CoreVuBroadphaseMode::SweepAndPrune, 1);
+      frames(count, corevu::CoreVuBroadphaseMode::SweepAndPrune, all);
+      frames(count, corevu::CoreVuBroadphaseMode::SpatialHash, 1);
+      frames(count, corevu::CoreVuBroadphaseMode::SpatialHash, all);
+
+      const auto level = corevu::GetSimdLevel();
+      corevu::SetSimdLevel(corevu::CoreVuSimdLevel::Scalar);
+      frames(count, corevu::CoreVuBroadphaseMode::SweepAndPrune, all, "scalar");
+      corevu::SetSimdLevel(level);
+    }
+  }
+
+private:
+  static constexpr uint32_t COUNTS[] = {10'000, 100'000};
+  static constexpr uint32_t FRAMES = 60;
+  static constexpr float DT = 1.f / 60.f;
+  static constexpr float MAX_SPEED = 2.f;
+  // body area per body, about 4x the mean box area
+  static constexpr float AREA_PER_BODY = 6.f;
+
+  struct Body
+  {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    glm::vec2 extents;
+  };
+
+  struct Scene
+  {
+    float half_size;
+    std::vector<Body> bodies;
+  };
+
+  static Scene MakeScene(uint32_t count)
+  {
+    Scene scene{};
+    scene.half_size = 0.5f * std::sqrt(AREA_PER_BODY * count);
+    std::mt19937 random{17};
+    std::uniform_real_distribution<float> position{
+        -scene.half_size, scene.half_size};
+    std::uniform_real_distribution<float> velocity{-MAX_SPEED, MAX_SPEED};
+    std::uniform_real_distribution<float> extent{0.25f, 1.f};
+    scene.bodies.resize(count);
+    for (auto& body : scene.bodies)
+    {
+      body.position = {position(random), position(random)};
+      body.velocity = {velocity(random), velocity(random)};
+      body.extents = {extent(random), extent(random)};
+    }
+    return scene;
+  }
+
+  static corevu::CoreVuAabb Box(const Body& body)
+  {
+    return corevu::CoreVuAabb::FromCenterExtents(
+        glm::vec3{body.position, 0.f}, glm::vec3{body.extents, 0.1f});
+  }
+
+  static void Move(Scene& scene)
+  {
+    for (auto& body : scene.bodies)
+    {
+      body.position += body.velocity * DT;
+      for (int axis = 0; axis < 2; ++axis)
+      {
+        if (std::abs(body.position[axis]) > scene.half_size)
+        {
+          body.velocity[axis] = -body.velocity[axis];
+        }
+      }
+    }
+  }
+
+  static void Update(Scene& scene, corevu::CoreVuBroadphase& broadphase)
+  {
+    for (uint32_t i = 0; i < scene.bodies.size(); ++i)
+    {
+      broadphase.moveProxy(i, Box(scene.bodies[i]));
+    }
+  }
+
+  static void Build(const Scene& scene, corevu::CoreVuBroadphase& broadphase)
+  {
+    for (uint32_t i = 0; i < scene.bodies.size(); ++i)
+    {
+      broadphase.createProxy(Box(scene.bodies[i]), i);
+    }
+  }
+
+  static std::vector<std::pair<uint32_t, uint32_t>> Sorted(
+      const std::vector<corevu::CoreVuBroadphasePair>& pairs)
+  {
+    std::vector<std::pair<uint32_t, uint32_t>> sorted;
+    sorted.reserve(pairs.size());
+    for (const auto& pair : pairs)
+    {
+      sorted.emplace_back(pair.a, pair.b);
+    }
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+  }
+
+  bool check(uint32_t count)
+  {
+    Scene scene = MakeScene(count);
+    corevu::CoreVuJobSystem job_system{};
+    corevu::CoreVuBroadphase sweep{corevu::CoreVuBroadphaseMode::SweepAndPrune};
+    corevu::CoreVuBroadphase hash{corevu::CoreVuBroadphaseMode::SpatialHash};
+    Build(scene, sweep);
+    Build(scene, hash);
+    for (int frame = 0; frame < 10; ++frame)
+    {
+      Move(scene);
+      Update(scene, sweep);
+      Update(scene, hash);
+      sweep.findPairs(job_system);
+      hash.findPairs(job_system);
+    }
+
+    const auto sweep_pairs = Sorted(sweep.getPairs());
+    const auto hash_pairs = Sorted(hash.getPairs());
+    bool ok = sweep_pairs == hash_pairs;
+    const bool brute_force = count <= 10'000;
+    if (brute_force)
+    {
+      std::vector<std::pair<uint32_t, uint32_t>> expected;
+      for (uint32_t a = 0; a < count; ++a)
+      {
+        const auto box = Box(scene.bodies[a]);
+        for (uint32_t b = a + 1; b < count; ++b)
+        {
+          if (corevu::Intersects(box, Box(scene.bodies[b])))
+          {
+            expected.emplace_back(a, b);
+          }
+        }
+      }
+      ok = ok && sweep_pairs == expected;
+    }
+    ok = ok && checkEvents(job_system, sweep, sweep_pairs);
+    std::printf(
+        "check %6u bodies: %zu pairs, %s\n", count, sweep_pairs.size(),
+        brute_force ? "both modes match all pairs" : "modes match");
+    return ok;
+  }
+
+  // entities are the body indices, the events name the same pairs
+  static bool checkEvents(
+      corevu::CoreVuJobSystem& job_system,
+      const corevu::CoreVuBroadphase& broadphase,
+      const std::vector<std::pair<uint32_t, uint32_t>>& pairs)
+  {
+    corevu::CoreVuEventBus event_bus{job_system};
+    std::vector<std::pair<uint32_t, uint32_t>> collisions;
+    event_bus.subscribe<corevu::CollisionEvent>(
+        [&](std::span<const corevu::CollisionEvent> events)
+        {
+          for (const auto& event : events)
+          {
+            collisions.emplace_back(event.a, event.b);
+          }
+        });
+    broadphase.publishPairs(event_bus);
+    event_bus.dispatch();
+    std::sort(collisions.begin(), collisions.end());
+    return collisions == pairs;
+  }
+
+  void frames(
+      uint32_t count, corevu::CoreVuBroadphaseMode mode, uint32_t threads,
+      const char* note = "")
+  {
+    corevu::CoreVuJobSystem job_system{threads};
+    Scene scene = MakeScene(count);
+    corevu::CoreVuBroadphase broadphase{mode};
+    Build(scene, broadphase);
+    broadphase.findPairs(job_system);
+
+    double ms = 0.0;
+    size_t pairs = 0;
+    uint64_t swaps = 0;
+    uint64_t tests = 0;
+    for (uint32_t frame = 0; frame < FRAMES; ++frame)
+    {
+      Move(scene);
+      ms += Measure(
+          [&]
+          {
+            Update(scene, broadphase);
+            broadphase.findPairs(job_system);
+          });
+      pairs += broadphase.getPairs().size();
+      swaps += broadphase.getStats().swaps;
+      tests += broadphase.getStats().tests;
+    }
+
+    std::printf(
+        "%8u %14s %8u %10.3f %10zu %10llu %12llu %s\n", count,
+        mode == corevu::CoreVuBroadphaseMode::SweepAndPrune ? "sweep&prune"
+                                                            : "spatial hash",
+        job_system.getThreadCount(), ms / FRAMES, pairs / FRAMES,
+        static_cast<unsigned long long>(swaps / FRAMES),
+        static_cast<unsigned long long>(tests / FRAMES), note);
+  }
+};
+} // namespace corevutest
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <corevu/include/ecs/corevu_entity_allocator.hpp>
+#include <corevu/include/ecs/corevu_entity_commands.hpp>
+#include <corevu/include/ecs/corevu_world.hpp>
+#include <corevu/include/events/corevu_event_bus.hpp>
+#include <corevu/include/events/corevu_events.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Entity ids and command buffers.
+  allocator: freed indices come back with the next generation, ids reserved
+from many jobs at once are unique and flush() commits them.
+  commands: entities created in one thread's buffer and changed from another
+one in the same frame, buffers are applied in thread order but every entity
+of every buffer has to exist before the first change is played back.
+  bulk: parallel jobs creating entities and adding components to the ones of
+other jobs, all of them have to arrive.
+  events: applying with an event bus publishes a spawn per created and a
+despawn per destroyed entity.
+
+Prints FAILURE:: and throws at the first check that fails.
+*/
+class EcsSysTest
+{
+public:
+  void run()
+  {
+    std::cout << "ECS allocator and command buffers\n";
+    if (!checkAllocator() || !checkCrossBufferCommands() ||
+        !checkBulkCommands() || !checkEvents())
+    {
+      throw std::runtime_error("FAILURE::ECS checks failed");
+    }
+    std::cout << "ECS checks passed\n";
+  }
+
+private:
+  static constexpr uint32_t RESERVE_COUNT = 20'000;
+  static constexpr uint32_t BULK_COUNT = 10'000;
+
+  struct HealthComponent
+  {
+    int value{0};
+  };
+
+  struct ArmorComponent
+  {
+    int value{0};
+  };
+
+  static bool Expect(bool condition, const char* message)
+  {
+    if (!condition)
+    {
+      std::cout << "FAILURE::" << message << "\n";
+    }
+    return condition;
+  }
+
+  bool checkAllocator()
+  {
+    corevu::CoreVuEntityAllocator allocator{};
+    const corevu::CoreVuEntity first = allocator.allocate();
+    const corevu::CoreVuEntity second = allocator.allocate();
+    if (!Expect(first != second, "allocator handed out an id twice"))
+    {
+      return false;
+    }
+
+    allocator.free(first);
+    const corevu::CoreVuEntity recycled = allocator.allocate();
+    if (!Expect(
+            corevu::GetEntityIndex(recycled) ==
+                    corevu::GetEntityIndex(first) &&
+                recycled != first,
+            "freed index not recycled with a new generation"))
+    {
+      return false;
+    }
+
+    // half of the reservations pop the free list, the rest are new indices
+    std::vector<corevu::CoreVuEntity> freed;
+    for (uint32_t i = 0; i < RESERVE_COUNT / 2; ++i)
+    {
+      freed.push_back(allocator.allocate());
+    }
+    for (auto entity : freed)
+    {
+      allocator.free(entity);
+    }
+    allocator.flush();
+    const uint32_t index_count = allocator.getIndexCount();
+
+    corevu::CoreVuJobSystem job_system{
+        std::max(4u, corevu::CoreVuJobSystem::DefaultThreadCount())};
+    std::vector<corevu::CoreVuEntity> reserved(RESERVE_COUNT);
+    job_system.parallelFor(
+        RESERVE_COUNT, 64,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            reserved[i] = allocator.reserve();
+          }
+        });
+    allocator.flush();
+
+    std::unordered_set<corevu::CoreVuEntity> unique(
+        reserved.begin(), reserved.end());
+    if (!Expect(
+            unique.size() == RESERVE_COUNT, "parallel reserve gave duplicates"))
+    {
+      return false;
+    }
+    if (!Expect(
+            allocator.getIndexCount() ==
+                index_count + RESERVE_COUNT - freed.size(),
+            "flush committed a wrong number of new indices"))
+    {
+      return false;
+    }
+    for (auto entity : freed)
+    {
+      // every freed index is reserved again, with the next generation
+      if (!Expect(
+              unique.count(entity) == 0,
+              "reserve returned a stale generation"))
+      {
+        return false;
+      }
+    }
+    return Expect(
+        unique.count(allocator.allocate()) == 0,
+        "allocate after flush reused a reserved id");
+  }
+
+  /* A worker records the create, the main thread(buffer 0, applied first)
+   * adds a component to the new entity. The main thread spins instead of
+   * waiting so the job can't run on it. */
+  bool checkCrossBufferCommands()
+  {
+    corevu::CoreVuJobSystem job_system{2};
+    corevu::CoreVuEntityCommands commands{job_system};
+    corevu::CoreVuWorld world{};
+
+    std::atomic<bool> created{false};
+    corevu::CoreVuEntity entity{};
+    uint32_t thread_index = 0;
+    corevu::CoreVuJobCounter counter;
+    job_system.run(
+        [&]
+        {
+          entity = commands.get().createEntity(world, HealthComponent{7});
+          thread_index = job_system.getThreadIndex();
+          created.store(true, std::memory_order_release);
+        },
+        &counter);
+    while (!created.load(std::memory_order_acquire))
+    {
+      std::this_thread::yield();
+    }
+    job_system.wait(counter);
+    if (!Expect(thread_index != 0, "create job ran on the main thread"))
+    {
+      return false;
+    }
+
+    auto& main_buffer = commands.get();
+    main_buffer.addComponent(entity, ArmorComponent{3});
+    main_buffer.removeComponent<HealthComponent>(entity);
+    commands.apply(world);
+
+    if (!Expect(world.isAlive(entity), "entity of a worker buffer lost"))
+    {
+      return false;
+    }
+    const auto* armor = world.getComponent<const ArmorComponent>(entity);
+    return Expect(
+               armor != nullptr && armor->value == 3,
+               "component added from another buffer dropped") &&
+           Expect(
+               !world.hasComponent<HealthComponent>(entity),
+               "component removed from another buffer kept");
+  }
+
+  /* Every job creates its entities, then adds armor to the entities created
+   * by the previous batch, whichever thread recorded them. */
+  bool checkBulkCommands()
+  {
+    corevu::CoreVuJobSystem job_system{
+        std::max(4u, corevu::CoreVuJobSystem::DefaultThreadCount())};
+    corevu::CoreVuEntityCommands commands{job_system};
+    corevu::CoreVuWorld world{};
+
+    constexpr uint32_t BATCH = 100;
+    std::vector<corevu::CoreVuEntity> entities(BULK_COUNT);
+    job_system.parallelFor(
+        BULK_COUNT, BATCH,
+        [&](uint32_t begin, uint32_t end)
+        {
+          auto& buffer = commands.get();
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            entities[i] = buffer.createEntity(
+                world, HealthComponent{static_cast<int>(i)});
+          }
+        });
+    job_system.parallelFor(
+        BULK_COUNT, BATCH,
+        [&](uint32_t begin, uint32_t end)
+        {
+          auto& buffer = commands.get();
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            const uint32_t other = (i + BATCH) % BULK_COUNT;
+            buffer.addComponent(
+                entities[other], ArmorComponent{static_cast<int>(other)});
+          }
+        });
+    commands.apply(world);
+
+    if (!Expect(
+            world.getEntityCount() == BULK_COUNT, "bulk entities missing"))
+    {
+      return false;
+    }
+    for (uint32_t i = 0; i < BULK_COUNT; ++i)
+    {
+      const auto* health =
+          world.getComponent<const HealthComponent>(entities[i]);
+      const auto* armor = world.getComponent<const ArmorComponent>(entities[i]);
+      if (!Expect(
+              health != nullptr && health->value == static_cast<int>(i) &&
+                  armor != nullptr && armor->value == static_cast<int>(i),
+              "bulk components lost"))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /* Destroying an entity twice or one that was never created publishes a
+   * single despawn, only commands that changed the world do. */
+  bool checkEvents()
+  {
+    corevu::CoreVuJobSystem job_system{2};
+    corevu::CoreVuEntityCommands commands{job_system};
+    corevu::CoreVuEventBus event_bus{job_system};
+    corevu::CoreVuWorld world{};
+
+    std::vector<corevu::CoreVuEntity> spawned;
+    std::vector<corevu::CoreVuEntity> despawned;
+    event_bus.subscribe<corevu::EntitySpawnedEvent>(
+        [&](std::span<const corevu::EntitySpawnedEvent> events)
+        {
+          for (const auto& event : events)
+          {
+            spawned.push_back(event.entity);
+          }
+        });
+    event_bus.subscribe<corevu::EntityDespawnedEvent>(
+        [&](std::span<const corevu::EntityDespawnedEvent> events)
+        {
+          for (const auto& event : events)
+          {
+            despawned.push_back(event.entity);
+          }
+        });
+
+    auto& buffer = commands.get();
+    const auto kept = buffer.createEntity(world, HealthComponent{1});
+    const auto gone = buffer.createEntity(world, HealthComponent{2});
+    buffer.destroyEntity(gone);
+    buffer.destroyEntity(gone);
+    commands.apply(world, &event_bus);
+    event_bus.dispatch();
+
+    const std::vector<corevu::CoreVuEntity> expected_spawned{kept, gone};
+    const std::vector<corevu::CoreVuEntity> expected_despawned{gone};
+    if (!Expect(
+            spawned == expected_spawned && despawned == expected_despawned,
+            "spawn or despawn events wrong"))
+    {
+      return false;
+    }
+
+    // an entity destroyed directly, no command, no event
+    world.destroyEntity(kept);
+    buffer.destroyEntity(kept);
+    commands.apply(world, &event_bus);
+    event_bus.dispatch();
+    return Expect(
+        despawned.size() == 1, "despawn published for a dead entity");
+  }
+};
+} // namespace corevutest
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <corevu/include/events/corevu_event_bus.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Event bus throughput from 1 to N threads. Each frame 1M small events are
+published from a parallelFor, then dispatched to two subscribers.
+  bus: CoreVuEventBus, every thread appends to its own buffer.
+  mutex: the same events pushed into one std::vector behind a mutex, the way
+shared state between systems serializes.
+
+Prints the best of a few frames, the first frame checks that every event
+arrived exactly once(sum of the payloads) and throws FAILURE:: if not.
+*/
+class EventSysTest
+{
+public:
+  void run()
+  {
+    const uint32_t max_threads = corevu::CoreVuJobSystem::DefaultThreadCount();
+    std::cout << "Event bus, hardware threads: " << max_threads << "\n";
+    std::printf(
+        "%8s %14s %14s %14s\n", "threads", "bus publish", "bus dispatch",
+        "mutex publish");
+
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+      corevu::CoreVuJobSystem job_system{threads};
+      corevu::CoreVuEventBus bus{job_system};
+
+      uint64_t delivered_sum = 0;
+      uint64_t delivered_count = 0;
+      bus.subscribe<HitEvent>(
+          [&](std::span<const HitEvent> events)
+          {
+            for (const auto& event : events)
+            {
+              delivered_sum += event.damage;
+            }
+          });
+      bus.subscribe<HitEvent>([&](std::span<const HitEvent> events)
+                              { delivered_count += events.size(); });
+
+      double publish_ms = 1e30;
+      double dispatch_ms = 1e30;
+      double mutex_ms = 1e30;
+      for (int frame = 0; frame < FRAMES; ++frame)
+      {
+        delivered_sum = 0;
+        delivered_count = 0;
+        publish_ms = std::min(
+            publish_ms, Measure([&] { publishBus(job_system, bus); }));
+        dispatch_ms = std::min(dispatch_ms, Measure([&] { bus.dispatch(); }));
+        mutex_ms = std::min(
+            mutex_ms, Measure([&] { publishMutex(job_system); }));
+
+        if (frame == 0 && (delivered_count != EVENT_COUNT ||
+                           delivered_sum != expectedSum()))
+        {
+          throw std::runtime_error("FAILURE::events lost or duplicated");
+        }
+      }
+      std::printf(
+          "%8u %11.2f ms %11.2f ms %11.2f ms\n", threads, publish_ms,
+          dispatch_ms, mutex_ms);
+    }
+  }
+
+private:
+  struct HitEvent
+  {
+    uint32_t target;
+    uint32_t damage;
+  };
+
+  static constexpr uint32_t EVENT_COUNT = 1'000'000;
+  static constexpr uint32_t BATCH_SIZE = 4096;
+  static constexpr int FRAMES = 8;
+
+  static uint64_t expectedSum()
+  {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < EVENT_COUNT; ++i)
+    {
+      sum += i % 100;
+    }
+    return sum;
+  }
+
+  void publishBus(
+      corevu::CoreVuJobSystem& job_system, corevu::CoreVuEventBus& bus)
+  {
+    job_system.parallelFor(
+        EVENT_COUNT, BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            bus.publish(HitEvent{i, i % 100});
+          }
+        });
+  }
+
+  void publishMutex(corevu::CoreVuJobSystem& job_system)
+  {
+    m_shared_events.clear();
+    job_system.parallelFor(
+        EVENT_COUNT, BATCH_SIZE,
+        [&](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            std::lock_guard<std::mutex> lock{m_shared_mutex};
+            m_shared_events.push_back(HitEvent{i, i % 100});
+          }
+        });
+  }
+
+  std::mutex m_shared_mutex;
+  std::vector<HitEvent> m_shared_events;
+};
+} // namespace corevutest
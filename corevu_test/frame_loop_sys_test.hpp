@@ -0,0 +1,236 @@
+#pragma once
+
+#include <corevu/include/corevu_camera.hpp>
+#include <corevu/include/corevu_components.hpp>
+#include <corevu/include/corevu_frame_info.hpp>
+#include <corevu/include/corevu_frame_loop.hpp>
+#include <corevu/include/ecs/corevu_world.hpp>
+#include <corevu/include/events/corevu_event_bus.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/systems/transform_system.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+
+namespace corevutest
+{
+/** NOTE
+* Fixed step frame loop and transform interpolation, no window or device.
+  advance: frame times go through CoreVuFrameLoop::advance(), steps and alpha
+follow the accumulator, long frames are clamped and capped at max_steps, the
+number of steps only depends on the total time, not on how it was split.
+  interpolate: a transform moved, turned and scaled between two updates is
+blended as TRS, the rotation keeps its length and turns by half the angle at
+alpha 0.5. Neither an update moving nothing nor interpolating stamps a
+change version, sheared world matrices still end up exactly at both steps.
+
+Prints FAILURE:: and throws at the first check that fails.
+*/
+class FrameLoopSysTest
+{
+public:
+  void run()
+  {
+    if (!checkAdvance() || !checkInterpolation())
+    {
+      throw std::runtime_error("FAILURE::frame loop checks failed");
+    }
+    std::cout << "Frame loop checks passed\n";
+  }
+
+private:
+  // powers of two, the accumulator sums them exactly
+  static constexpr float STEP = 1.f / 64.f;
+  static constexpr float EPSILON = 1e-4f;
+
+  static bool Expect(bool condition, const char* message)
+  {
+    if (!condition)
+    {
+      std::cout << "FAILURE::" << message << "\n";
+    }
+    return condition;
+  }
+
+  static bool Near(float a, float b)
+  {
+    return std::abs(a - b) <= EPSILON;
+  }
+
+  static bool Near(const glm::mat4& a, const glm::mat4& b)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      for (int row = 0; row < 4; ++row)
+      {
+        if (!Near(a[column][row], b[column][row])) return false;
+      }
+    }
+    return true;
+  }
+
+  static float Angle(const glm::vec3& a, const glm::vec3& b)
+  {
+    const float cos = glm::dot(glm::normalize(a), glm::normalize(b));
+    return std::acos(std::fmin(std::fmax(cos, -1.f), 1.f));
+  }
+
+  bool checkAdvance()
+  {
+    corevu::CoreVuFrameLoop loop{STEP, 5};
+    if (!Expect(loop.advance(1.5f * STEP) == 1, "1.5 steps ran wrong") ||
+        !Expect(Near(loop.getAlpha(), .5f), "alpha of half a step") ||
+        !Expect(loop.advance(.5f * STEP) == 1, "rest not carried over") ||
+        !Expect(Near(loop.getAlpha(), 0.f), "alpha after a full step") ||
+        !Expect(loop.advance(-1.f) == 0, "negative frame time ran steps") ||
+        !Expect(loop.getFrameTime() == 0.f, "negative frame time kept"))
+    {
+      return false;
+    }
+
+    // a hitch: clamped to MAX_FRAME_TIME, 16 steps owed, 5 run, 11 dropped
+    const uint32_t steps = loop.advance(10.f);
+    if (!Expect(
+            loop.getFrameTime() == corevu::CoreVuFrameLoop::MAX_FRAME_TIME,
+            "frame time not clamped") ||
+        !Expect(steps == 5, "steps not capped at max_steps") ||
+        !Expect(loop.getDroppedSteps() == 11, "dropped steps miscounted") ||
+        !Expect(Near(loop.getAlpha(), 0.f), "fraction lost with the hitch"))
+    {
+      return false;
+    }
+
+    // the same 3 seconds in uneven frames and in frames of one step
+    const float frames[] = {
+        1.f / 32.f, 1.f / 128.f, 3.f / 64.f, 1.f / 256.f, 5.f / 256.f};
+    corevu::CoreVuFrameLoop uneven{STEP, 5};
+    corevu::CoreVuFrameLoop even{STEP, 5};
+    uint64_t uneven_steps = 0;
+    uint64_t even_steps = 0;
+    double time = 0.0;
+    for (uint32_t frame = 0; time < 3.0; ++frame)
+    {
+      const float elapsed = frames[frame % std::size(frames)];
+      uneven_steps += uneven.advance(elapsed);
+      time += elapsed;
+    }
+    const auto total = static_cast<uint64_t>(time / STEP);
+    for (uint64_t i = 0; i < total; ++i)
+    {
+      even_steps += even.advance(STEP);
+    }
+    return Expect(
+               uneven_steps == total && even_steps == total,
+               "step count depends on the frame times") &&
+           Expect(
+               Near(uneven.getAlpha(), static_cast<float>(time / STEP - total)),
+               "alpha is not the rest of the accumulator");
+  }
+
+  bool checkInterpolation()
+  {
+    corevu::CoreVuJobSystem job_system{1};
+    corevu::CoreVuEventBus event_bus{job_system};
+    corevu::CoreVuCamera camera{};
+    corevu::CoreVuWorld world{};
+    corevu::FrameInfo frame_info{
+        .frame_index = -1,
+        .frame_time = STEP,
+        .command_buffer = VK_NULL_HANDLE,
+        .camera = camera,
+        .global_descriptor_set = VK_NULL_HANDLE,
+        .frame_descriptor_pool = nullptr,
+        .world = world,
+        .job_system = job_system,
+        .event_bus = event_bus};
+    corevu::TransformSystem transforms{};
+
+    const float quarter_turn = 1.57079633f;
+    const auto entity = world.createEntity(corevu::TransformComponent{});
+    // child of a non uniformly scaled parent, turned: a sheared world matrix
+    const auto parent = world.createEntity(corevu::TransformComponent{
+        glm::vec3{0.f}, glm::vec3{0.f}, glm::vec3{2.f, 1.f, 1.f}});
+    const auto child = world.createEntity(corevu::TransformComponent{
+        glm::vec3{0.f}, glm::vec3{0.f, 0.f, .5f * quarter_turn}});
+    transforms.setParent(world, child, parent);
+    transforms.update(frame_info);
+
+    // nothing moved, the child pass must not stamp the chunk of a still child
+    const corevu::ChangeVersion still = world.newChangeVersion();
+    transforms.update(frame_info);
+    uint32_t stamped = 0;
+    world.query<const corevu::TransformComponent>()
+        .changedSince<corevu::TransformComponent>(still)
+        .each([&](corevu::CoreVuEntity, const corevu::TransformComponent&)
+              { stamped++; });
+    if (!Expect(stamped == 0, "update stamped transforms that did not move"))
+    {
+      return false;
+    }
+
+    auto* transform = world.getComponent<corevu::TransformComponent>(entity);
+    transform->SetTranslation({2.f, 0.f, 0.f});
+    transform->SetRotation({0.f, 0.f, quarter_turn});
+    transform->SetScale({3.f, 1.f, 1.f});
+    world.getComponent<corevu::TransformComponent>(child)->SetTranslation(
+        {0.f, 1.f, 0.f});
+    const glm::mat4 previous = transform->GetWorldMatrix();
+    const glm::mat4 previous_child =
+        world.getComponent<const corevu::TransformComponent>(child)
+            ->GetWorldMatrix();
+    transforms.update(frame_info);
+
+    const auto& moved =
+        *world.getComponent<const corevu::TransformComponent>(entity);
+    const auto& sheared =
+        *world.getComponent<const corevu::TransformComponent>(child);
+    const glm::mat4 current = moved.GetWorldMatrix();
+
+    // nothing may look changed to a system running after the interpolation
+    const corevu::ChangeVersion since = world.newChangeVersion();
+    transforms.interpolate(frame_info, .5f);
+    uint32_t changed = 0;
+    world.query<const corevu::TransformComponent>()
+        .changedSince<corevu::TransformComponent>(since)
+        .each([&](corevu::CoreVuEntity, const corevu::TransformComponent&)
+              { changed++; });
+    if (!Expect(changed == 0, "interpolate stamped a change version"))
+    {
+      return false;
+    }
+
+    const glm::mat4& half = moved.GetRenderMatrix();
+    const glm::vec3 axis_x{half[0]};
+    const glm::vec3 axis_y{half[1]};
+    if (!Expect(
+            Near(half[3][0], 1.f) && Near(half[3][1], 0.f),
+            "translation not halfway") ||
+        !Expect(
+            Near(glm::length(axis_x), 2.f) && Near(glm::length(axis_y), 1.f),
+            "rotation shrank or scale not halfway") ||
+        !Expect(
+            Near(Angle(axis_x, previous[0]), .5f * quarter_turn) &&
+                Near(Angle(axis_x, current[0]), .5f * quarter_turn),
+            "rotation not halfway along the arc") ||
+        !Expect(
+            Near(glm::dot(axis_x, axis_y), 0.f), "render axes not orthogonal"))
+    {
+      return false;
+    }
+
+    transforms.interpolate(frame_info, 0.f);
+    const bool at_previous = Near(moved.GetRenderMatrix(), previous) &&
+                             Near(sheared.GetRenderMatrix(), previous_child);
+    transforms.interpolate(frame_info, 1.f);
+    const bool at_current =
+        Near(moved.GetRenderMatrix(), current) &&
+        Near(sheared.GetRenderMatrix(), sheared.GetWorldMatrix());
+    return Expect(at_previous, "alpha 0 is not the previous step") &&
+           Expect(at_current, "alpha 1 is not the last step");
+  }
+};
+} // namespace corevutest
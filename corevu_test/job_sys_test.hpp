@@ -0,0 +1,230 @@
+#pragma once
+
+#include <corevu/include/corevu_components.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Scaling of the work stealing job system from 1 to N threads.
+  transforms: parallelFor over TRS -> mat4 of 1M transforms, memory heavy and
+embarrassingly parallel, shows the ideal case.
+  small jobs: rounds of 2048 jobs doing almost nothing, shows the overhead of
+starting, stealing and finishing jobs.
+  dependencies: chains of runAfter() continuations, each link waits for the
+previous one, shows latency of waking up parked jobs.
+
+Every workload is repeated a few times and the best run is printed, the first
+run also checks the result against the single threaded one. A failed check
+throws FAILURE::.
+*/
+class JobSysTest
+{
+public:
+  void run()
+  {
+    if (!checkJobOverflow())
+    {
+      throw std::runtime_error("FAILURE::job overflow check failed");
+    }
+
+    const uint32_t max_threads = corevu::CoreVuJobSystem::DefaultThreadCount();
+    std::cout << "Job system scaling, hardware threads: " << max_threads
+              << "\n";
+    std::printf(
+        "%8s %16s %10s %16s %10s %16s %10s\n", "threads", "transforms ms",
+        "speedup", "small jobs ms", "speedup", "dependencies ms", "speedup");
+
+    prepareTransforms();
+
+    double base_transforms = 0.0;
+    double base_small_jobs = 0.0;
+    double base_dependencies = 0.0;
+    for (uint32_t threads = 1; threads <= max_threads; ++threads)
+    {
+      corevu::CoreVuJobSystem job_system{threads};
+
+      const double transforms =
+          MeasureBest([&] { runTransforms(job_system); }, REPEATS);
+      const double small_jobs =
+          MeasureBest([&] { runSmallJobs(job_system); }, REPEATS);
+      const double dependencies =
+          MeasureBest([&] { runDependencies(job_system); }, REPEATS);
+      if (!checkTransforms())
+      {
+        throw std::runtime_error("FAILURE::transform results differ");
+      }
+
+      if (threads == 1)
+      {
+        base_transforms = transforms;
+        base_small_jobs = small_jobs;
+        base_dependencies = dependencies;
+      }
+      std::printf(
+          "%8u %16.3f %10.2f %16.3f %10.2f %16.3f %10.2f\n", threads,
+          transforms, base_transforms / transforms, small_jobs,
+          base_small_jobs / small_jobs, dependencies,
+          base_dependencies / dependencies);
+    }
+  }
+
+private:
+  static constexpr uint32_t TRANSFORM_COUNT = 1'000'000;
+  static constexpr uint32_t TRANSFORM_BATCH = 1024;
+  static constexpr uint32_t SMALL_JOB_ROUNDS = 50;
+  static constexpr uint32_t SMALL_JOBS_PER_ROUND = 2048;
+  static constexpr uint32_t CHAIN_COUNT = 64;
+  static constexpr uint32_t CHAIN_LENGTH = 32;
+  static constexpr int REPEATS = 5;
+
+  void prepareTransforms()
+  {
+    m_transforms.resize(TRANSFORM_COUNT);
+    m_matrices.resize(TRANSFORM_COUNT);
+    m_reference.resize(TRANSFORM_COUNT);
+    for (uint32_t i = 0; i < TRANSFORM_COUNT; ++i)
+    {
+      m_transforms[i] = corevu::TransformComponent{
+          {i * .01f, i * .02f, i * .03f},
+          {i * .001f, i * .002f, i * .003f},
+          {1.f + i * .0001f, 1.f, 2.f}};
+      m_reference[i] = m_transforms[i].ToMat4();
+    }
+  }
+
+  void runTransforms(corevu::CoreVuJobSystem& job_system)
+  {
+    job_system.parallelFor(
+        TRANSFORM_COUNT, TRANSFORM_BATCH,
+        [this](uint32_t begin, uint32_t end)
+        {
+          for (uint32_t i = begin; i < end; ++i)
+          {
+            m_matrices[i] = m_transforms[i].ToMat4();
+          }
+        });
+  }
+
+  bool checkTransforms() const
+  {
+    return std::equal(
+        m_matrices.begin(), m_matrices.end(), m_reference.begin());
+  }
+
+  void runSmallJobs(corevu::CoreVuJobSystem& job_system)
+  {
+    std::atomic<uint32_t> executed{0};
+    for (uint32_t round = 0; round < SMALL_JOB_ROUNDS; ++round)
+    {
+      corevu::CoreVuJobCounter counter;
+      for (uint32_t i = 0; i < SMALL_JOBS_PER_ROUND; ++i)
+      {
+        job_system.run(
+            [&executed] { executed.fetch_add(1, std::memory_order_relaxed); },
+            &counter);
+      }
+      job_system.wait(counter);
+    }
+    if (executed.load() != SMALL_JOB_ROUNDS * SMALL_JOBS_PER_ROUND)
+    {
+      std::cout << "FAILURE::lost small jobs\n";
+    }
+  }
+
+  void runDependencies(corevu::CoreVuJobSystem& job_system)
+  {
+    // every chain is a list of counters, link i runs after link i - 1
+    std::vector<corevu::CoreVuJobCounter> links(CHAIN_COUNT * CHAIN_LENGTH);
+    std::vector<uint32_t> values(CHAIN_COUNT, 0);
+
+    for (uint32_t chain = 0; chain < CHAIN_COUNT; ++chain)
+    {
+      auto* first = &links[chain * CHAIN_LENGTH];
+      uint32_t* value = &values[chain];
+      job_system.run([value] { *value = 1; }, first);
+      for (uint32_t i = 1; i < CHAIN_LENGTH; ++i)
+      {
+        job_system.runAfter(
+            first[i - 1], [value] { *value = *value * 2 % 1000003; },
+            &first[i]);
+      }
+    }
+    for (uint32_t chain = 0; chain < CHAIN_COUNT; ++chain)
+    {
+      job_system.wait(links[chain * CHAIN_LENGTH + CHAIN_LENGTH - 1]);
+    }
+    // earlier links are done too, still wait before destroying them
+    for (auto& link : links)
+    {
+      job_system.wait(link);
+    }
+
+    const uint32_t expected = (1u << (CHAIN_LENGTH - 1)) % 1000003;
+    for (uint32_t value : values)
+    {
+      if (value != expected)
+      {
+        throw std::runtime_error("FAILURE::dependency chain out of order");
+      }
+    }
+  }
+
+  /* More jobs in flight than a thread has ring slots and deque entries,
+   * started from the main thread and from inside a job. The starting thread
+   * has to work jobs off until slots free up, no job may be overwritten. */
+  bool checkJobOverflow()
+  {
+    constexpr uint32_t JOB_COUNT =
+        3 * corevu::CoreVuJobSystem::MAX_JOBS_PER_THREAD + 17;
+    constexpr uint64_t EXPECTED = uint64_t{JOB_COUNT} * (JOB_COUNT - 1) / 2;
+    // stealing needs more than one thread, even on a single core
+    const uint32_t many =
+        std::max(4u, corevu::CoreVuJobSystem::DefaultThreadCount());
+    for (uint32_t threads : {1u, many})
+    {
+      corevu::CoreVuJobSystem job_system{threads};
+      std::atomic<uint64_t> sum{0};
+      const auto start_all = [&]
+      {
+        corevu::CoreVuJobCounter counter;
+        for (uint32_t i = 0; i < JOB_COUNT; ++i)
+        {
+          job_system.run(
+              [&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); },
+              &counter);
+        }
+        job_system.wait(counter);
+      };
+
+      start_all();
+      const uint64_t from_main = sum.exchange(0);
+      corevu::CoreVuJobCounter outer;
+      job_system.run(start_all, &outer);
+      job_system.wait(outer);
+      if (from_main != EXPECTED || sum.load() != EXPECTED)
+      {
+        std::cout << "FAILURE::jobs lost past the ring size, " << threads
+                  << " threads, sums " << from_main << " " << sum.load()
+                  << " expected " << EXPECTED << "\n";
+        return false;
+      }
+    }
+    std::cout << "job overflow: " << JOB_COUNT << " jobs in flight ok\n";
+    return true;
+  }
+
+  std::vector<corevu::TransformComponent> m_transforms;
+  std::vector<glm::mat4> m_matrices;
+  std::vector<glm::mat4> m_reference;
+};
+} // namespace corevutest
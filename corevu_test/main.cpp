@@ -1,6 +1,21 @@
 #include "app.hpp"
+#include "collision_sys_test.hpp"
+#include "ecs_sys_test.hpp"
+#include "event_sys_test.hpp"
+#include "frame_loop_sys_test.hpp"
 #include "gravity_system_test.hpp"
+#include "job_sys_test.hpp"
 #include "mem_sys_test.hpp"
+#include "nbody_sys_test.hpp"
+#include "occlusion_sys_test.hpp"
+#include "particle_sys_test.hpp"
+#include "raycast_sys_test.hpp"
+#include "render_queue_sys_test.hpp"
+#include "scene_sys_test.hpp"
+#include "simplify_sys_test.hpp"
+#include "simd_sys_test.hpp"
+#include "spatial_sys_test.hpp"
+#include "static_batch_sys_test.hpp"
 
 #include <iostream>
 
@@ -28,7 +43,14 @@ int main(int, char**)
   std::string in_code{0};
   std::cin >> in_code;
 
-  if (in_code.find("ren") != std::string::npos)
+  if (in_code.find("alloc") != std::string::npos)
+  {
+    // renders a few seconds and fails if a warmed up frame allocated
+    constexpr uint64_t ALLOC_CHECK_FRAMES = 600;
+    corevutest::SampleApp app{ALLOC_CHECK_FRAMES, true};
+    return run(app);
+  }
+  else if (in_code.find("ren") != std::string::npos)
   {
     corevutest::SampleApp app{};
     return run(app);
@@ -43,6 +65,81 @@ int main(int, char**)
     corevutest::MemSysTest app{};
     return run(app);
   }
+  else if (in_code.find("job") != std::string::npos)
+  {
+    corevutest::JobSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("loop") != std::string::npos)
+  {
+    corevutest::FrameLoopSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("simpl") != std::string::npos)
+  {
+    corevutest::SimplifySysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("simd") != std::string::npos)
+  {
+    corevutest::SimdSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("ecs") != std::string::npos)
+  {
+    corevutest::EcsSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("event") != std::string::npos)
+  {
+    corevutest::EventSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("scene") != std::string::npos)
+  {
+    corevutest::SceneSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("batch") != std::string::npos)
+  {
+    corevutest::StaticBatchSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("spatial") != std::string::npos)
+  {
+    corevutest::SpatialSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("occlu") != std::string::npos)
+  {
+    corevutest::OcclusionSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("nbody") != std::string::npos)
+  {
+    corevutest::NBodySysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("particle") != std::string::npos)
+  {
+    corevutest::ParticleSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("colli") != std::string::npos)
+  {
+    corevutest::CollisionSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("queue") != std::string::npos)
+  {
+    corevutest::RenderQueueSysTest app{};
+    return run(app);
+  }
+  else if (in_code.find("ray") != std::string::npos)
+  {
+    corevutest::RaycastSysTest app{};
+    return run(app);
+  }
 
   std::cout << "No valid command\n";
   return EXIT_FAILURE;
@@ -3,12 +3,21 @@
 #include <coremem/include/MemoryManager.hpp>
 #include <coremem/include/ChunkMemoryManager.hpp>
 
+#include <coremem/include/AffixAllocator.hpp>
+#include <coremem/include/AlignedMemory.hpp>
+#include <coremem/include/BucketizerAllocator.hpp>
+#include <coremem/include/FallbackAllocator.hpp>
+#include <coremem/include/SegregatorAllocator.hpp>
+#include <coremem/include/SystemAllocator.hpp>
+
 #include <coremem/include/LinearAllocator.hpp>
 #include <coremem/include/StackAllocator.hpp>
 #include <coremem/include/PoolAllocator.hpp>
 
 #include <iostream>
 #include <chrono>
+#include <cstring>
+#include <stdexcept>
 
 #include <vector>
 #include <array>
@@ -194,7 +203,261 @@ public:
       mm.Free(v1);
     }
 
+    if (!checkAlignedMemory() || !checkComposedAllocators())
+    {
+      throw std::runtime_error("FAILURE::allocator checks failed");
+    }
+
     std::cout << "end" << std::endl;
   }
+
+private:
+  static bool Expect(bool condition, const char* what)
+  {
+    if (!condition) std::cout << "FAILURE::" << what << "\n";
+    return condition;
+  }
+
+  static bool IsAligned(const void* p, size_t alignment)
+  {
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+  }
+
+  /* AlignedAlloc/AlignedBuffer up to page alignment, cache line padding of
+   * per thread blocks and the stream layout of SoA arrays. */
+  bool checkAlignedMemory()
+  {
+    bool ok = true;
+    for (size_t alignment : {size_t{8}, size_t{16}, coremem::CACHE_LINE_SIZE,
+                             size_t{256}, coremem::PAGE_SIZE})
+    {
+      for (size_t size : {size_t{1}, size_t{100}, 3 * coremem::PAGE_SIZE})
+      {
+        void* p = coremem::AlignedAlloc(size, alignment);
+        ok &= Expect(p != nullptr, "AlignedAlloc returned nullptr");
+        if (p == nullptr) continue;
+        ok &= Expect(IsAligned(p, alignment), "AlignedAlloc misaligned");
+        std::memset(p, 0xAB, size); // whole block is writable
+        coremem::AlignedFree(p);
+      }
+    }
+
+    // page aligned staging block, ownership moves with the buffer
+    coremem::AlignedBuffer page{2 * coremem::PAGE_SIZE, coremem::PAGE_SIZE};
+    ok &= Expect(
+        IsAligned(page.GetMemory(), coremem::PAGE_SIZE),
+        "AlignedBuffer not page aligned");
+    void* const page_memory = page.GetMemory();
+    coremem::AlignedBuffer moved{std::move(page)};
+    ok &= Expect(
+        moved.GetMemory() == page_memory &&
+            moved.GetMemorySize() == 2 * coremem::PAGE_SIZE &&
+            page.GetMemory() == nullptr && page.GetMemorySize() == 0,
+        "AlignedBuffer move did not transfer the block");
+
+    // per thread data never shares a cache line
+    static_assert(
+        sizeof(coremem::CacheLinePadded<uint32_t>) ==
+            coremem::CACHE_LINE_SIZE &&
+        alignof(coremem::CacheLinePadded<uint32_t>) ==
+            coremem::CACHE_LINE_SIZE);
+    std::vector<coremem::CacheLinePadded<uint32_t>> counters(4);
+    ok &= Expect(
+        IsAligned(&counters[0], coremem::CACHE_LINE_SIZE) &&
+            reinterpret_cast<uintptr_t>(&counters[1]) -
+                    reinterpret_cast<uintptr_t>(&counters[0]) ==
+                coremem::CACHE_LINE_SIZE,
+        "CacheLinePadded counters share a cache line");
+    ok &= Expect(
+        coremem::PaddedBlockSize(100) == 128 &&
+            coremem::PaddedBlockSize(128) == 128 &&
+            coremem::GetThreadBlock(moved.GetMemory(), 128, 3) ==
+                static_cast<uint8_t*>(moved.GetMemory()) + 384,
+        "per thread block layout");
+
+    /* 10 elements of float, double, uint8_t:
+     *   cache line: floats 0..40, doubles 64..144, bytes 192..202 -> 256
+     *   page:       0, 4096, 8192 -> 12288 */
+    using Layout = coremem::SoALayout<float, double, uint8_t>;
+    ok &= Expect(
+        Layout::StreamOffset(0, 10) == 0 && Layout::StreamOffset(1, 10) == 64 &&
+            Layout::StreamOffset(2, 10) == 192 &&
+            Layout::MemorySize(10) == 256,
+        "SoA layout, cache line alignment");
+    ok &= Expect(
+        Layout::StreamOffset(1, 10, coremem::PAGE_SIZE) ==
+                coremem::PAGE_SIZE &&
+            Layout::StreamOffset(2, 10, coremem::PAGE_SIZE) ==
+                2 * coremem::PAGE_SIZE &&
+            Layout::MemorySize(10, coremem::PAGE_SIZE) ==
+                3 * coremem::PAGE_SIZE,
+        "SoA layout, page alignment");
+
+    ok &= checkSoAArray<float, double, uint8_t>(1000);
+    ok &= checkSoAArray<uint8_t, uint64_t, uint16_t>(13);
+
+    // from an allocator whose next free byte is not aligned
+    coremem::AlignedBuffer arena{64 * 1024};
+    coremem::LinearAllocator linear{arena.GetMemorySize(), arena.GetMemory()};
+    linear.allocate(1, 1);
+    using Particles = coremem::SoAArray<float, float, uint32_t>;
+    Particles particles = Particles::Allocate(linear, 100);
+    ok &= Expect(
+        IsAligned(particles.GetMemory(), coremem::CACHE_LINE_SIZE) &&
+            IsAligned(particles.Stream<2>(), coremem::CACHE_LINE_SIZE) &&
+            linear.owns(particles.Stream<2>() + 99),
+        "SoAArray::Allocate misaligned");
+    linear.clear();
+
+    if (ok) std::cout << "aligned memory: ok\n";
+    return ok;
+  }
+
+  /* Frees have to find the allocator a block came from without its size, also
+   * when a SystemAllocator(owning any address) is part of the chain:
+   *
+   *   segregator(256) -> small: fallback -> buckets 16..64, overflow: system
+   *                   -> large: buckets 512..4096
+   */
+  bool checkComposedAllocators()
+  {
+    bool ok = true;
+    coremem::AlignedBuffer small_memory{4 * 1024};
+    coremem::AlignedBuffer large_memory{512 * 1024};
+    coremem::SystemAllocator system;
+    {
+      coremem::BucketizerAllocator small_buckets{
+          small_memory.GetMemorySize(), small_memory.GetMemory(), 16, 64, 16};
+      coremem::BucketizerAllocator large_buckets{
+          large_memory.GetMemorySize(), large_memory.GetMemory(), 512, 4096,
+          512};
+      coremem::FallbackAllocator small{small_buckets, system};
+      coremem::SegregatorAllocator root{256, small, large_buckets};
+      ok &= Expect(
+          !small.hasExactOwnership() && !root.hasExactOwnership(),
+          "a chain with a system allocator claims exact ownership");
+
+      // more small blocks than the buckets hold, some overflow to the system
+      std::vector<void*> blocks;
+      for (size_t i = 0; i < 200; ++i)
+      {
+        const size_t size = i % 3 == 0 ? 300 + i * 17 : 24;
+        void* p = root.allocate(size, alignof(std::max_align_t));
+        ok &= Expect(p != nullptr, "composed allocation failed");
+        if (p == nullptr) break;
+        std::memset(p, 0xCD, size);
+        blocks.push_back(p);
+      }
+      ok &= Expect(
+          system.GetAllocationCount() > 0 &&
+              small_buckets.GetAllocationCount() > 0 &&
+              large_buckets.GetAllocationCount() > 0,
+          "composed allocator did not use every stage");
+
+      // interleaved, so every stage sees frees of the others' neighbours
+      for (size_t i = 0; i < blocks.size(); i += 2) root.free(blocks[i]);
+      for (size_t i = 1; i < blocks.size(); i += 2) root.free(blocks[i]);
+      ok &= Expect(
+          root.GetAllocationCount() == 0 &&
+              small_buckets.GetAllocationCount() == 0 &&
+              large_buckets.GetAllocationCount() == 0 &&
+              system.GetAllocationCount() == 0,
+          "composed frees reached the wrong allocator");
+
+      // exact small side, the system takes the rest
+      coremem::SegregatorAllocator by_small{64, small_buckets, system};
+      void* a = by_small.allocate(32, 8);
+      void* b = by_small.allocate(5000, 8);
+      by_small.free(b);
+      by_small.free(a);
+      ok &= Expect(
+          small_buckets.GetAllocationCount() == 0 &&
+              system.GetAllocationCount() == 0,
+          "segregator with an exact small side misrouted a free");
+    }
+
+    // frame arena with a system overflow, cleared as a whole once per frame
+    {
+      coremem::LinearAllocator arena{
+          small_memory.GetMemorySize(), small_memory.GetMemory()};
+      coremem::FallbackAllocator frame{arena, system};
+      std::vector<void*> overflow;
+      for (size_t i = 0; i < 8; ++i)
+      {
+        void* p = frame.allocate(1024, 16);
+        if (!arena.owns(p)) overflow.push_back(p);
+      }
+      frame.clear();
+      ok &= Expect(
+          !overflow.empty() && arena.GetAllocationCount() == 0 &&
+              arena.GetUsedMemory() == 0 &&
+              system.GetAllocationCount() == overflow.size() &&
+              frame.GetAllocationCount() == overflow.size(),
+          "fallback clear lost track of the system blocks");
+      ok &= Expect(
+          frame.allocate(1024, 16) == small_memory.GetMemory(),
+          "fallback clear did not reset the arena");
+      for (void* p : overflow) frame.free(p);
+      ok &= Expect(
+          system.GetAllocationCount() == 0 && frame.GetAllocationCount() == 1,
+          "system blocks not freed through the cleared fallback");
+      frame.clear();
+    }
+
+    // prefix, header and suffix canary around each block
+    coremem::AffixAllocator affix{system, 8, 16};
+    auto* block = static_cast<uint8_t*>(affix.allocate(40, 64));
+    ok &= Expect(IsAligned(block, 64), "affix block misaligned");
+    *static_cast<uint64_t*>(affix.GetPrefix(block)) = 42;
+    std::memset(block, 0, 40);
+    ok &= Expect(affix.CheckCanaries(block), "affix canary broken too early");
+    block[40] = 0; // one byte past the block
+    ok &= Expect(!affix.CheckCanaries(block), "affix overrun not detected");
+    block[40] = coremem::AffixAllocator::SUFFIX_PATTERN;
+    ok &= Expect(
+        *static_cast<uint64_t*>(affix.GetPrefix(block)) == 42,
+        "affix prefix overwritten");
+    affix.free(block);
+    ok &= Expect(system.GetAllocationCount() == 0, "affix block leaked");
+
+    if (ok) std::cout << "composed allocators: ok\n";
+    return ok;
+  }
+
+  // every stream aligned, streams don't overlap
+  template <typename A, typename B, typename C>
+  static bool checkSoAArray(size_t capacity)
+  {
+    using Array = coremem::SoAArray<A, B, C>;
+    coremem::AlignedBuffer memory{Array::Layout::MemorySize(capacity)};
+    Array array{memory.GetMemory(), capacity};
+    bool ok = Expect(
+        IsAligned(array.template Stream<0>(), coremem::CACHE_LINE_SIZE) &&
+            IsAligned(array.template Stream<1>(), coremem::CACHE_LINE_SIZE) &&
+            IsAligned(array.template Stream<2>(), coremem::CACHE_LINE_SIZE),
+        "SoA stream misaligned");
+
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      array.template Stream<0>()[i] = static_cast<A>(i % 100 + 1);
+      array.template Stream<1>()[i] = static_cast<B>(i % 100 + 101);
+      array.template Stream<2>()[i] = static_cast<C>(i % 50 + 201);
+    }
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      ok &= Expect(
+          array.template Stream<0>()[i] == static_cast<A>(i % 100 + 1) &&
+              array.template Stream<1>()[i] == static_cast<B>(i % 100 + 101) &&
+              array.template Stream<2>()[i] == static_cast<C>(i % 50 + 201),
+          "SoA streams overlap");
+      if (!ok) break;
+    }
+    const auto end = reinterpret_cast<uintptr_t>(
+        array.template Stream<2>() + capacity);
+    return ok && Expect(
+                     end <= reinterpret_cast<uintptr_t>(memory.GetMemory()) +
+                                memory.GetMemorySize(),
+                     "SoA array past its memory");
+  }
 };
 } // namespace corevutest
\ No newline at end of file
@@ -0,0 +1,409 @@
+#pragma once
+
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/physics/corevu_gravity_solver.hpp>
+#include <corevu/include/simd/corevu_transform_batch.hpp>
+
+#include <glm/glm.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Gravity solver against the pairwise loop the GravityPhysicsSystem ran before
+over its game objects(AoS, every pair updates both bodies, one thread).
+  drift: a heavy body with 32 rings of 32 light ones orbiting it, 1000
+steps of dt 2ms(two orbits at the inner edge). Largest relative energy change
+from the start and the largest position difference at the end to the old loop
+run in double precision, for the old loop(float and double), the exact mode
+(scalar, best simd) and Barnes-Hut at opening angles .3, .5, .7.
+  scaling: one computeAccelerations of a disk of equal masses from 1k to 1M
+bodies, old loop and exact mode as long as they take seconds, Barnes-Hut
+(angle .5) on 1 and all threads, with the acceleration error against a double
+precision sum on 256 of the bodies. Time per body of Barnes-Hut grows with
+log n, the all pairs ones with n.
+
+Throws FAILURE:: if the solver drifts away from the old loop.
+*/
+class NBodySysTest
+{
+public:
+  void run()
+  {
+    std::printf("simd: %s\n", corevu::ToString(corevu::GetSimdLevel()));
+    if (!drift())
+    {
+      throw std::runtime_error(
+          "FAILURE::solver drifts away from the old loop");
+    }
+    scaling();
+  }
+
+private:
+  static constexpr float STRENGTH = 1.f;
+
+  // one body of the old GravityPhysicsSystem, float or double
+  template <typename T>
+  struct ReferenceBody
+  {
+    glm::vec<2, T> position;
+    glm::vec<2, T> velocity;
+    T mass;
+  };
+
+  // GravityPhysicsSystem::stepSimulation as it was
+  template <typename T>
+  static void ReferenceStep(std::vector<ReferenceBody<T>>& bodies, T dt)
+  {
+    for (size_t a = 0; a < bodies.size(); ++a)
+    {
+      for (size_t b = a + 1; b < bodies.size(); ++b)
+      {
+        const glm::vec<2, T> offset = bodies[a].position - bodies[b].position;
+        const T distance2 = glm::dot(offset, offset);
+        if (glm::abs(distance2) < T(1e-10)) continue;
+        const T force = STRENGTH * bodies[b].mass * bodies[a].mass / distance2;
+        const glm::vec<2, T> pull = force * offset / glm::sqrt(distance2);
+        bodies[a].velocity += dt * -pull / bodies[a].mass;
+        bodies[b].velocity += dt * pull / bodies[b].mass;
+      }
+    }
+    for (auto& body : bodies)
+    {
+      body.position += dt * body.velocity;
+    }
+  }
+
+  /* Rings of light bodies around a heavy one, the orbits never cross, there
+   * are no close encounters the unsoftened force law would blow up on. */
+  static corevu::CoreVuGravityBodies OrbitingRings(uint32_t ring_count)
+  {
+    corevu::CoreVuGravityBodies bodies;
+    bodies.add(0.f, 0.f, 0.f, 0.f, 1.f);
+    const uint32_t per_ring = 32;
+    const float body_mass = 1e-5f;
+    for (uint32_t ring = 0; ring < ring_count; ++ring)
+    {
+      const float radius = .3f + .7f * ring / ring_count;
+      const float speed = std::sqrt(STRENGTH * 1.f / radius);
+      for (uint32_t i = 0; i < per_ring; ++i)
+      {
+        const float angle = 6.2831853f * (i + .5f * ring) / per_ring;
+        bodies.add(
+            radius * std::cos(angle), radius * std::sin(angle),
+            -speed * std::sin(angle), speed * std::cos(angle), body_mass);
+      }
+    }
+    return bodies;
+  }
+
+  static corevu::CoreVuGravityBodies Disk(uint32_t count)
+  {
+    std::mt19937 random{7};
+    std::uniform_real_distribution<float> unit{0.f, 1.f};
+    corevu::CoreVuGravityBodies bodies;
+    bodies.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      // denser towards the center
+      const float radius = -.25f * std::log(1.f - .999f * unit(random));
+      const float angle = 6.2831853f * unit(random);
+      bodies.add(
+          radius * std::cos(angle), radius * std::sin(angle), 0.f, 0.f,
+          1.f / count);
+    }
+    return bodies;
+  }
+
+  template <typename T>
+  static std::vector<ReferenceBody<T>> ToReference(
+      const corevu::CoreVuGravityBodies& bodies)
+  {
+    std::vector<ReferenceBody<T>> reference;
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+      reference.push_back(ReferenceBody<T>{
+          {bodies.position_x[i], bodies.position_y[i]},
+          {bodies.velocity_x[i], bodies.velocity_y[i]},
+          bodies.mass[i]});
+    }
+    return reference;
+  }
+
+  struct DriftResult
+  {
+    double max_drift{0.0};
+    double max_offset{0.0}; // to the old loop in double at the end
+    double ms_per_step{0.0};
+  };
+
+  bool drift()
+  {
+    constexpr uint32_t RING_COUNT = 32;
+    constexpr uint32_t STEP_COUNT = 1000;
+    constexpr uint32_t ENERGY_INTERVAL = 50;
+    constexpr float DT = .002f;
+
+    corevu::CoreVuJobSystem job_system{};
+    corevu::CoreVuGravitySolver energy{STRENGTH};
+    const corevu::CoreVuGravityBodies start = OrbitingRings(RING_COUNT);
+    const double start_energy = energy.computeEnergy(start, job_system);
+
+    // old loop in float and in double, the double one is the truth
+    auto reference = ToReference<float>(start);
+    auto truth = ToReference<double>(start);
+    DriftResult old_loop{};
+    DriftResult old_loop_double{};
+    corevu::CoreVuGravityBodies state = start;
+    const auto energyOf = [&](const auto& bodies)
+    {
+      for (size_t i = 0; i < bodies.size(); ++i)
+      {
+        state.position_x[i] = static_cast<float>(bodies[i].position.x);
+        state.position_y[i] = static_cast<float>(bodies[i].position.y);
+        state.velocity_x[i] = static_cast<float>(bodies[i].velocity.x);
+        state.velocity_y[i] = static_cast<float>(bodies[i].velocity.y);
+      }
+      return std::abs(energy.computeEnergy(state, job_system) - start_energy) /
+             std::abs(start_energy);
+    };
+    for (uint32_t s = 0; s < STEP_COUNT; ++s)
+    {
+      old_loop.ms_per_step += Measure([&] { ReferenceStep(reference, DT); });
+      old_loop_double.ms_per_step +=
+          Measure([&] { ReferenceStep(truth, double{DT}); });
+      if ((s + 1) % ENERGY_INTERVAL != 0) continue;
+      old_loop.max_drift = std::max(old_loop.max_drift, energyOf(reference));
+      old_loop_double.max_drift =
+          std::max(old_loop_double.max_drift, energyOf(truth));
+    }
+    old_loop.ms_per_step /= STEP_COUNT;
+    old_loop_double.ms_per_step /= STEP_COUNT;
+    for (size_t i = 0; i < truth.size(); ++i)
+    {
+      old_loop.max_offset = std::max(
+          old_loop.max_offset,
+          glm::length(glm::dvec2{reference[i].position} - truth[i].position));
+    }
+
+    std::printf(
+        "%-22s %12s %12s %10s\n", "drift", "max dE/E", "offset", "step");
+    print("old loop double", old_loop_double);
+    print("old loop", old_loop);
+
+    const auto run = [&](corevu::CoreVuGravityMode mode, float theta)
+    {
+      corevu::CoreVuGravitySolver solver{STRENGTH};
+      solver.setMode(mode);
+      solver.setOpeningAngle(theta);
+      corevu::CoreVuGravityBodies bodies = start;
+      DriftResult result{};
+      for (uint32_t s = 0; s < STEP_COUNT; ++s)
+      {
+        result.ms_per_step +=
+            Measure([&] { solver.step(bodies, DT, job_system); });
+        if ((s + 1) % ENERGY_INTERVAL != 0) continue;
+        result.max_drift = std::max(
+            result.max_drift,
+            std::abs(solver.computeEnergy(bodies, job_system) - start_energy) /
+                std::abs(start_energy));
+      }
+      result.ms_per_step /= STEP_COUNT;
+      for (size_t i = 0; i < bodies.size(); ++i)
+      {
+        result.max_offset = std::max(
+            result.max_offset,
+            glm::length(
+                glm::dvec2{bodies.position_x[i], bodies.position_y[i]} -
+                truth[i].position));
+      }
+      return result;
+    };
+
+    const corevu::CoreVuSimdLevel level = corevu::GetSimdLevel();
+    corevu::SetSimdLevel(corevu::CoreVuSimdLevel::Scalar);
+    print("exact scalar", run(corevu::CoreVuGravityMode::Exact, 0.f));
+    corevu::SetSimdLevel(level);
+    const DriftResult exact = run(corevu::CoreVuGravityMode::Exact, 0.f);
+    print("exact", exact);
+    for (const float theta : {.3f, .5f, .7f})
+    {
+      char name[32];
+      std::snprintf(name, sizeof(name), "barnes-hut %.1f", theta);
+      print(name, run(corevu::CoreVuGravityMode::BarnesHut, theta));
+    }
+
+    // same integrator, only float rounding apart from the truth, the old loop
+    // rounds more: it adds every pair straight to the velocities
+    return exact.max_drift <= 2.0 * old_loop_double.max_drift &&
+           exact.max_offset <= old_loop.max_offset;
+  }
+
+  void print(const char* name, const DriftResult& result) const
+  {
+    std::printf(
+        "%-22s %12.3e %12.3e %7.3f ms\n", name, result.max_drift,
+        result.max_offset, result.ms_per_step);
+  }
+
+  struct ScalingResult
+  {
+    double old_loop_ms{-1.0};
+    double exact_ms{-1.0};
+    double exact_all_ms{-1.0};
+    double tree_ms{-1.0};
+    double tree_all_ms{-1.0};
+    uint32_t node_count{0};
+    uint64_t interactions{0};
+    float median_error{0.f};
+    float max_error{0.f};
+  };
+
+  void scaling()
+  {
+    constexpr uint32_t COUNTS[] = {1024,      4096,       16384,
+                                   65536,     262144,     1048576};
+    constexpr size_t COUNT_COUNT = sizeof(COUNTS) / sizeof(COUNTS[0]);
+    std::vector<corevu::CoreVuGravityBodies> disks;
+    for (const uint32_t count : COUNTS)
+    {
+      disks.push_back(Disk(count));
+    }
+    std::vector<ScalingResult> results(COUNT_COUNT);
+    std::vector<float> ax;
+    std::vector<float> ay;
+
+    {
+      // one job system per thread at a time
+      corevu::CoreVuJobSystem single{1};
+      for (size_t c = 0; c < COUNT_COUNT; ++c)
+      {
+        const auto& bodies = disks[c];
+        if (COUNTS[c] <= 16384)
+        {
+          auto reference = ToReference<float>(bodies);
+          results[c].old_loop_ms = MeasureBest(
+              [&] { ReferenceStep(reference, 0.f); }, Runs(COUNTS[c]));
+        }
+        corevu::CoreVuGravitySolver solver{STRENGTH};
+        if (COUNTS[c] <= 65536)
+        {
+          solver.setMode(corevu::CoreVuGravityMode::Exact);
+          results[c].exact_ms = MeasureBest(
+              [&] { solver.computeAccelerations(bodies, single, ax, ay); },
+              Runs(COUNTS[c]));
+        }
+        solver.setMode(corevu::CoreVuGravityMode::BarnesHut);
+        results[c].tree_ms = MeasureBest(
+            [&] { solver.computeAccelerations(bodies, single, ax, ay); },
+            Runs(COUNTS[c]));
+      }
+    }
+
+    corevu::CoreVuJobSystem all{};
+    for (size_t c = 0; c < COUNT_COUNT; ++c)
+    {
+      const auto& bodies = disks[c];
+      corevu::CoreVuGravitySolver solver{STRENGTH};
+      if (COUNTS[c] <= 65536)
+      {
+        solver.setMode(corevu::CoreVuGravityMode::Exact);
+        results[c].exact_all_ms = MeasureBest(
+            [&] { solver.computeAccelerations(bodies, all, ax, ay); },
+            Runs(COUNTS[c]));
+      }
+      solver.setMode(corevu::CoreVuGravityMode::BarnesHut);
+      results[c].tree_all_ms = MeasureBest(
+          [&] { solver.computeAccelerations(bodies, all, ax, ay); },
+          Runs(COUNTS[c]));
+      results[c].node_count = solver.getStats().node_count;
+      results[c].interactions = solver.getStats().interactions;
+      measureError(bodies, ax, ay, results[c]);
+    }
+
+    std::printf(
+        "\n%8s %10s %10s %10s %10s %10s %9s %8s %9s %9s\n", "bodies",
+        "old loop", "exact", "exact all", "bh", "bh all", "nodes",
+        "pairs/b", "err med", "err max");
+    for (size_t c = 0; c < COUNT_COUNT; ++c)
+    {
+      const ScalingResult& r = results[c];
+      std::printf(
+          "%8u %10s %10s %10s %10s %10s %9u %8llu %9.2e %9.2e\n", COUNTS[c],
+          Ms(r.old_loop_ms).text, Ms(r.exact_ms).text,
+          Ms(r.exact_all_ms).text, Ms(r.tree_ms).text,
+          Ms(r.tree_all_ms).text, r.node_count,
+          static_cast<unsigned long long>(r.interactions / COUNTS[c]),
+          r.median_error, r.max_error);
+    }
+  }
+
+  // relative error of 256 accelerations against a double precision sum
+  static void measureError(
+      const corevu::CoreVuGravityBodies& bodies, const std::vector<float>& ax,
+      const std::vector<float>& ay, ScalingResult& result)
+  {
+    constexpr size_t SAMPLE_COUNT = 256;
+    std::vector<float> errors;
+    const size_t stride = std::max<size_t>(1, bodies.size() / SAMPLE_COUNT);
+    for (size_t i = 0; i < bodies.size(); i += stride)
+    {
+      double sum_x = 0.0;
+      double sum_y = 0.0;
+      for (size_t j = 0; j < bodies.size(); ++j)
+      {
+        const double dx = double{bodies.position_x[j]} - bodies.position_x[i];
+        const double dy = double{bodies.position_y[j]} - bodies.position_y[i];
+        const double distance2 = dx * dx + dy * dy;
+        if (distance2 < 1e-10) continue;
+        const double pull =
+            STRENGTH * bodies.mass[j] / (distance2 * std::sqrt(distance2));
+        sum_x += pull * dx;
+        sum_y += pull * dy;
+      }
+      const double length = std::sqrt(sum_x * sum_x + sum_y * sum_y);
+      errors.push_back(static_cast<float>(
+          std::sqrt(
+              (ax[i] - sum_x) * (ax[i] - sum_x) +
+              (ay[i] - sum_y) * (ay[i] - sum_y)) /
+          length));
+    }
+    std::sort(errors.begin(), errors.end());
+    result.median_error = errors[errors.size() / 2];
+    result.max_error = errors.back();
+  }
+
+  struct MsText
+  {
+    char text[16];
+  };
+  static MsText Ms(double ms)
+  {
+    MsText result{};
+    if (ms < 0.0)
+    {
+      std::snprintf(result.text, sizeof(result.text), "-");
+    }
+    else
+    {
+      std::snprintf(result.text, sizeof(result.text), "%.2f ms", ms);
+    }
+    return result;
+  }
+
+  // timed runs of a scaling step, fewer the bigger the count
+  static int Runs(uint32_t count)
+  {
+    return count <= 65536 ? 5 : 2;
+  }
+};
+} // namespace corevutest
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <corevu/include/culling/corevu_occlusion_buffer.hpp>
+#include <corevu/include/geometry/corevu_bounds.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "test_timing.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Occlusion buffer on a city block scene: 24x24 buildings(boxes 8..14 wide,
+6..40 high) on a 480x480 ground, 100k small objects(0.3..1.5) scattered in
+the streets and inside the blocks. The camera stands in a street at eye height
+and looks down it, most of the city is behind the first rows of houses.
+  frame: begin + addOccluder of every building in the frustum, rasterize with
+1 and all threads, then every object in the frustum is tested.
+  coherent: the next frame, camera moved a bit, skips the buildings that were
+hidden themselves in the first one, like the CullingSystem does.
+  check: a ray from the eye to the center of every occluded object has to hit
+a building first, the buildings are the exact occluders here, throws
+FAILURE:: if one does not.
+*/
+class OcclusionSysTest
+{
+public:
+  void run()
+  {
+    build();
+
+    const glm::vec3 eye{3.f, 1.7f, -230.f};
+    const glm::mat4 projection =
+        glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 600.f);
+    const glm::mat4 view = glm::lookAt(
+        eye, eye + glm::vec3{0.05f, 0.f, 1.f}, glm::vec3{0.f, 1.f, 0.f});
+
+    std::printf(
+        "%10s %8s %10s %10s %10s %8s %8s\n", "frame", "threads", "raster",
+        "test", "triangles", "frustum", "hidden");
+    {
+      // one job system per thread at a time
+      corevu::CoreVuJobSystem single{1};
+      runFrame("full", projection * view, single, false);
+    }
+    corevu::CoreVuJobSystem all{};
+    runFrame("full", projection * view, all, false);
+    if (!check(eye))
+    {
+      throw std::runtime_error(
+          "FAILURE::occluded object has a free line of sight");
+    }
+
+    const glm::vec3 next_eye = eye + glm::vec3{0.f, 0.f, 0.5f};
+    const glm::mat4 next_view = glm::lookAt(
+        next_eye, next_eye + glm::vec3{0.05f, 0.f, 1.f},
+        glm::vec3{0.f, 1.f, 0.f});
+    runFrame("coherent", projection * next_view, all, true);
+  }
+
+private:
+  static constexpr int BLOCKS = 24;
+  static constexpr float BLOCK_SIZE = 20.f;
+  static constexpr uint32_t OBJECT_COUNT = 100'000;
+
+  void build()
+  {
+    std::mt19937 random{17};
+    std::uniform_real_distribution<float> width{4.f, 7.f};
+    std::uniform_real_distribution<float> height{6.f, 40.f};
+    const float half_city = BLOCKS * BLOCK_SIZE * .5f;
+    for (int x = 0; x < BLOCKS; ++x)
+    {
+      for (int z = 0; z < BLOCKS; ++z)
+      {
+        const glm::vec3 center{
+            -half_city + (x + .5f) * BLOCK_SIZE, 0.f,
+            -half_city + (z + .5f) * BLOCK_SIZE};
+        const glm::vec3 extents{width(random), height(random), width(random)};
+        m_buildings.push_back(corevu::CoreVuAabb{
+            glm::vec3{center.x - extents.x, 0.f, center.z - extents.z},
+            glm::vec3{center.x + extents.x, extents.y, center.z + extents.z}});
+      }
+    }
+    // one shared unit box, scaled per building like an instanced mesh
+    m_box_mesh = corevu::CoreVuOccluderMesh::Box(
+        corevu::CoreVuAabb{glm::vec3{0.f}, glm::vec3{1.f}});
+    m_hidden_buildings.assign(m_buildings.size(), 0);
+
+    std::uniform_real_distribution<float> position{-half_city, half_city};
+    std::uniform_real_distribution<float> size{.15f, .75f};
+    for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+    {
+      const glm::vec3 extents{size(random), size(random), size(random)};
+      m_objects.push_back(corevu::CoreVuAabb::FromCenterExtents(
+          glm::vec3{position(random), extents.y, position(random)}, extents));
+    }
+  }
+
+  static glm::mat4 BoxMatrix(const corevu::CoreVuAabb& box)
+  {
+    return glm::scale(
+        glm::translate(glm::mat4{1.f}, box.min), box.max - box.min);
+  }
+
+  void runFrame(
+      const char* name, const glm::mat4& view_projection,
+      corevu::CoreVuJobSystem& job_system, bool coherent)
+  {
+    const auto frustum = corevu::CoreVuFrustum::FromMatrix(view_projection);
+
+    const double raster_ms = MeasureBest(
+        [&]
+        {
+          m_buffer.begin(view_projection);
+          for (size_t i = 0; i < m_buildings.size(); ++i)
+          {
+            if (coherent && m_hidden_buildings[i] != 0) continue;
+            if (!corevu::Intersects(frustum, m_buildings[i])) continue;
+            m_buffer.addOccluder(m_box_mesh, BoxMatrix(m_buildings[i]));
+          }
+          m_buffer.rasterize(job_system);
+        });
+
+    uint32_t in_frustum = 0;
+    const double test_ms = MeasureBest(
+        [&]
+        {
+          in_frustum = 0;
+          m_hidden.clear();
+          for (uint32_t i = 0; i < OBJECT_COUNT; ++i)
+          {
+            if (!corevu::Intersects(frustum, m_objects[i])) continue;
+            in_frustum++;
+            if (!m_buffer.isVisible(m_objects[i])) m_hidden.push_back(i);
+          }
+        });
+    for (size_t i = 0; i < m_buildings.size(); ++i)
+    {
+      m_hidden_buildings[i] = m_buffer.isVisible(m_buildings[i]) ? 0 : 1;
+    }
+
+    std::printf(
+        "%10s %8u %7.3f ms %7.3f ms %10u %8u %8zu\n", name,
+        job_system.getThreadCount(), raster_ms, test_ms,
+        m_buffer.getTriangleCount(), in_frustum, m_hidden.size());
+  }
+
+  bool check(const glm::vec3& eye) const
+  {
+    size_t free = 0;
+    for (const uint32_t i : m_hidden)
+    {
+      const glm::vec3 to_center = m_objects[i].getCenter() - eye;
+      const corevu::CoreVuRay ray{
+          eye, glm::normalize(to_center), glm::length(to_center)};
+      const glm::vec3 inverse_direction = 1.f / ray.direction;
+      bool blocked = false;
+      for (const auto& building : m_buildings)
+      {
+        float distance = 0.f;
+        if (corevu::IntersectRay(ray, inverse_direction, building, distance))
+        {
+          blocked = true;
+          break;
+        }
+      }
+      free += blocked ? 0 : 1;
+    }
+    std::printf("check: %zu of %zu hidden centers in sight\n", free,
+                m_hidden.size());
+    return free == 0;
+  }
+
+  corevu::CoreVuOcclusionBuffer m_buffer;
+  corevu::CoreVuOccluderMesh m_box_mesh;
+  std::vector<corevu::CoreVuAabb> m_buildings;
+  std::vector<uint8_t> m_hidden_buildings;
+  std::vector<corevu::CoreVuAabb> m_objects;
+  std::vector<uint32_t> m_hidden;
+};
+} // namespace corevutest
@@ -0,0 +1,432 @@
+#pragma once
+
+#include <corevu/include/corevu_buffer.hpp>
+#include <corevu/include/corevu_camera.hpp>
+#include <corevu/include/corevu_descriptors.hpp>
+#include <corevu/include/corevu_device.hpp>
+#include <corevu/include/corevu_frame_info.hpp>
+#include <corevu/include/ecs/corevu_world.hpp>
+#include <corevu/include/events/corevu_event_bus.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/physics/corevu_gravity_solver.hpp>
+#include <corevu/include/systems/particle_system.hpp>
+
+#include <glm/glm.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* GpuParticleSystem on a headless device(no window, runs on lavapipe).
+  solver: a heavy body with 64 rings of 32 light ones, 500 steps of dt 2ms on
+the gpu and with CoreVuGravitySolver(exact mode) on the cpu, the largest
+position difference at the end must stay at float rounding.
+  draw: one step and one frame into an offscreen image, every particle center
+must be covered, the corner not.
+  scaling: ms per step of a disk of equal masses on the gpu, cpu exact mode
+and Barnes-Hut(angle .5) on all threads.
+
+Throws FAILURE:: if the solver or draw check fails.
+*/
+class ParticleSysTest
+{
+public:
+  void run()
+  {
+    corevu::CoreVuDevice device{}; // headless
+    corevu::CoreVuJobSystem job_system{};
+    if (!solver(device, job_system))
+    {
+      throw std::runtime_error(
+          "FAILURE::gpu particles drift away from the solver");
+    }
+    if (!draw(device, job_system))
+    {
+      throw std::runtime_error(
+          "FAILURE::gpu particles are not drawn where they are");
+    }
+    scaling(device, job_system);
+  }
+
+private:
+  static constexpr float STRENGTH = 1.f;
+  static constexpr float DT = .002f;
+
+  static corevu::CoreVuGravityBodies OrbitingRings(uint32_t ring_count)
+  {
+    corevu::CoreVuGravityBodies bodies;
+    bodies.add(0.f, 0.f, 0.f, 0.f, 1.f);
+    const uint32_t per_ring = 32;
+    const float body_mass = 1e-5f;
+    for (uint32_t ring = 0; ring < ring_count; ++ring)
+    {
+      const float radius = .3f + .7f * ring / ring_count;
+      const float speed = std::sqrt(STRENGTH * 1.f / radius);
+      for (uint32_t i = 0; i < per_ring; ++i)
+      {
+        const float angle = 6.2831853f * (i + .5f * ring) / per_ring;
+        bodies.add(
+            radius * std::cos(angle), radius * std::sin(angle),
+            -speed * std::sin(angle), speed * std::cos(angle), body_mass);
+      }
+    }
+    return bodies;
+  }
+
+  static corevu::CoreVuGravityBodies Disk(uint32_t count)
+  {
+    std::mt19937 random{7};
+    std::uniform_real_distribution<float> unit{0.f, 1.f};
+    corevu::CoreVuGravityBodies bodies;
+    bodies.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      const float radius = -.25f * std::log(1.f - .999f * unit(random));
+      const float angle = 6.2831853f * unit(random);
+      bodies.add(
+          radius * std::cos(angle), radius * std::sin(angle), 0.f, 0.f,
+          1.f / count);
+    }
+    return bodies;
+  }
+
+  static std::vector<corevu::GpuParticle> ToParticles(
+      const corevu::CoreVuGravityBodies& bodies)
+  {
+    std::vector<corevu::GpuParticle> particles(bodies.size());
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+      particles[i].position = {
+          bodies.position_x[i], bodies.position_y[i], bodies.mass[i], 0.f};
+      particles[i].velocity = {
+          bodies.velocity_x[i], bodies.velocity_y[i], 0.f, 0.f};
+    }
+    return particles;
+  }
+
+  // records step_count steps into one command buffer, waits for them
+  static void Simulate(
+      corevu::CoreVuDevice& device, corevu::GpuParticleSystem& particles,
+      uint32_t step_count)
+  {
+    VkCommandBuffer command_buffer = device.beginSingleTimeCommands();
+    for (uint32_t s = 0; s < step_count; ++s)
+    {
+      particles.simulate(command_buffer, DT);
+    }
+    device.endSingleTimeCommands(command_buffer);
+  }
+
+  bool solver(
+      corevu::CoreVuDevice& device, corevu::CoreVuJobSystem& job_system)
+  {
+    constexpr uint32_t STEP_COUNT = 500;
+    // 2049 bodies, the last workgroup is partly empty
+    corevu::CoreVuGravityBodies bodies = OrbitingRings(64);
+
+    corevu::GpuParticleSystem particles{
+        device, VK_NULL_HANDLE, VK_NULL_HANDLE, ToParticles(bodies)};
+    particles.setStrength(STRENGTH);
+    const double gpu_ms =
+        Measure([&] { Simulate(device, particles, STEP_COUNT); });
+
+    corevu::CoreVuGravitySolver cpu{STRENGTH};
+    cpu.setMode(corevu::CoreVuGravityMode::Exact);
+    const double cpu_ms = Measure(
+        [&]
+        {
+          for (uint32_t s = 0; s < STEP_COUNT; ++s)
+          {
+            cpu.step(bodies, DT, job_system);
+          }
+        });
+
+    std::vector<corevu::GpuParticle> result;
+    particles.download(result);
+    double max_offset = 0.;
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+      max_offset = std::max(
+          max_offset,
+          double{glm::length(
+              glm::vec2{result[i].position} -
+              glm::vec2{bodies.position_x[i], bodies.position_y[i]})});
+    }
+
+    std::printf(
+        "solver: %zu bodies, %u steps, gpu %.3f ms/step, cpu %.3f ms/step, "
+        "max offset %.2e\n",
+        bodies.size(), STEP_COUNT, gpu_ms / STEP_COUNT, cpu_ms / STEP_COUNT,
+        max_offset);
+    // the rings have a radius of 1, the solver itself is 2e-5 off the truth
+    return max_offset < 1e-3;
+  }
+
+  bool draw(corevu::CoreVuDevice& device, corevu::CoreVuJobSystem& job_system)
+  {
+    constexpr uint32_t SIZE = 256;
+    constexpr VkFormat FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+    VkDevice vk_device = device.device();
+
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = FORMAT;
+    image_info.extent = {SIZE, SIZE, 1};
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImage image;
+    VkDeviceMemory image_memory;
+    device.createImageWithInfo(
+        image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, image_memory);
+
+    VkImageViewCreateInfo view_info{};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = FORMAT;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.layerCount = 1;
+    VkImageView image_view;
+    if (vkCreateImageView(vk_device, &view_info, nullptr, &image_view) !=
+        VK_SUCCESS)
+    {
+      throw std::runtime_error("FAILURE::can't create image view");
+    }
+
+    // one color attachment, copied out right after the pass
+    VkAttachmentDescription attachment{};
+    attachment.format = FORMAT;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    VkAttachmentReference color_reference{
+        0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &color_reference;
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass = 0;
+    dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependency.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    VkRenderPassCreateInfo render_pass_info{};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.attachmentCount = 1;
+    render_pass_info.pAttachments = &attachment;
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+    render_pass_info.dependencyCount = 1;
+    render_pass_info.pDependencies = &dependency;
+    VkRenderPass render_pass;
+    if (vkCreateRenderPass(
+            vk_device, &render_pass_info, nullptr, &render_pass) != VK_SUCCESS)
+    {
+      throw std::runtime_error("FAILURE::can't create render pass");
+    }
+
+    VkFramebufferCreateInfo framebuffer_info{};
+    framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_info.renderPass = render_pass;
+    framebuffer_info.attachmentCount = 1;
+    framebuffer_info.pAttachments = &image_view;
+    framebuffer_info.width = SIZE;
+    framebuffer_info.height = SIZE;
+    framebuffer_info.layers = 1;
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(
+            vk_device, &framebuffer_info, nullptr, &framebuffer) != VK_SUCCESS)
+    {
+      throw std::runtime_error("FAILURE::can't create framebuffer");
+    }
+
+    // camera and global ubo as SampleApp sets them up, looking at the xy plane
+    corevu::CoreVuCamera camera{};
+    camera.setViewDirection(
+        glm::vec3{0.f, 0.f, -1.f}, glm::vec3{0.f, 0.f, 1.f});
+    camera.setOrthographicProjection(-1.2f, 1.2f, -1.2f, 1.2f, .1f, 10.f);
+    corevu::GlobalUbo ubo{};
+    ubo.projection_matrix = camera.getProjection();
+    ubo.view_matrix = camera.getView();
+    ubo.inverse_view_matrix = camera.getInverseView();
+    corevu::CoreVuBuffer ubo_buffer{
+        device, sizeof(corevu::GlobalUbo), 1,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+    ubo_buffer.map();
+    ubo_buffer.writeToBuffer(&ubo);
+
+    auto global_pool = corevu::CoreVuDescriptorPool::Builder(device)
+                           .setMaxSets(1)
+                           .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+                           .build();
+    auto global_set_layout =
+        corevu::CoreVuDescriptorSetLayout::Builder(device)
+            .addBinding(
+                0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                VK_SHADER_STAGE_ALL_GRAPHICS)
+            .build();
+    VkDescriptorSet global_set;
+    auto buffer_info = ubo_buffer.descriptorInfo();
+    corevu::CoreVuDescriptorWriter(*global_set_layout, *global_pool)
+        .writeBuffer(0, &buffer_info)
+        .build(global_set);
+
+    corevu::GpuParticleSystem particles{
+        device, render_pass, global_set_layout->getDescriptorSetLayout(),
+        ToParticles(OrbitingRings(8))};
+    particles.setStrength(STRENGTH);
+    particles.setParticleSize(.02f);
+
+    auto frame_pool = corevu::CoreVuDescriptorPool::Builder(device)
+                          .setMaxSets(1)
+                          .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+                          .build();
+    corevu::CoreVuWorld world;
+    corevu::CoreVuEventBus event_bus{job_system};
+
+    corevu::CoreVuBuffer pixels{
+        device, 4, SIZE * SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT};
+
+    VkCommandBuffer command_buffer = device.beginSingleTimeCommands();
+    corevu::FrameInfo frame_info{
+        .frame_index = 0,
+        .frame_time = DT,
+        .command_buffer = command_buffer,
+        .camera = camera,
+        .global_descriptor_set = global_set,
+        .frame_descriptor_pool = frame_pool.get(),
+        .world = world,
+        .job_system = job_system,
+        .event_bus = event_bus};
+
+    particles.simulate(command_buffer, DT);
+
+    VkClearValue clear_value{};
+    clear_value.color = {{0.f, 0.f, 0.f, 0.f}};
+    VkRenderPassBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    begin_info.renderPass = render_pass;
+    begin_info.framebuffer = framebuffer;
+    begin_info.renderArea.extent = {SIZE, SIZE};
+    begin_info.clearValueCount = 1;
+    begin_info.pClearValues = &clear_value;
+    vkCmdBeginRenderPass(
+        command_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    VkViewport viewport{
+        0.f, 0.f, static_cast<float>(SIZE), static_cast<float>(SIZE), 0.f, 1.f};
+    VkRect2D scissor{{0, 0}, {SIZE, SIZE}};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+    particles.render(frame_info);
+    vkCmdEndRenderPass(command_buffer);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {SIZE, SIZE, 1};
+    vkCmdCopyImageToBuffer(
+        command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        pixels.getBuffer(), 1, &region);
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(
+        command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    device.endSingleTimeCommands(command_buffer);
+
+    // alpha of every particle center, where the shader draws it
+    std::vector<corevu::GpuParticle> state;
+    particles.download(state);
+    pixels.map();
+    const auto* rgba = static_cast<const uint8_t*>(pixels.getMappedMemory());
+    const auto alphaAt = [&](glm::vec2 position)
+    {
+      const glm::vec4 clip = ubo.projection_matrix * ubo.view_matrix *
+                             glm::vec4{position, 0.f, 1.f};
+      const glm::vec2 ndc = glm::vec2{clip} / clip.w;
+      const uint32_t x = std::min(
+          SIZE - 1, static_cast<uint32_t>((ndc.x * .5f + .5f) * SIZE));
+      const uint32_t y = std::min(
+          SIZE - 1, static_cast<uint32_t>((ndc.y * .5f + .5f) * SIZE));
+      return rgba[(y * SIZE + x) * 4 + 3];
+    };
+    uint32_t covered = 0;
+    for (const auto& particle : state)
+    {
+      covered += alphaAt(glm::vec2{particle.position}) > 0;
+    }
+    const bool corner_empty = rgba[3] == 0;
+    std::printf(
+        "draw: %u of %zu particle centers covered, corner %s\n", covered,
+        state.size(), corner_empty ? "empty" : "covered");
+
+    vkDestroyFramebuffer(vk_device, framebuffer, nullptr);
+    vkDestroyRenderPass(vk_device, render_pass, nullptr);
+    vkDestroyImageView(vk_device, image_view, nullptr);
+    vkDestroyImage(vk_device, image, nullptr);
+    vkFreeMemory(vk_device, image_memory, nullptr);
+    return covered == state.size() && corner_empty;
+  }
+
+  void scaling(
+      corevu::CoreVuDevice& device, corevu::CoreVuJobSystem& job_system)
+  {
+    constexpr uint32_t STEP_COUNT = 4;
+    std::printf(
+        "%10s %12s %12s %12s\n", "bodies", "gpu", "cpu exact",
+        "cpu bh .5");
+    for (const uint32_t count : {4096u, 16384u, 65536u})
+    {
+      corevu::CoreVuGravityBodies bodies = Disk(count);
+      corevu::GpuParticleSystem particles{
+          device, VK_NULL_HANDLE, VK_NULL_HANDLE, ToParticles(bodies)};
+      Simulate(device, particles, 1); // warm up
+      const double gpu_ms =
+          Measure([&] { Simulate(device, particles, STEP_COUNT); }) /
+          STEP_COUNT;
+
+      corevu::CoreVuGravitySolver cpu{STRENGTH};
+      cpu.setMode(corevu::CoreVuGravityMode::Exact);
+      corevu::CoreVuGravityBodies exact_bodies = bodies;
+      const double exact_ms =
+          Measure([&] { cpu.step(exact_bodies, DT, job_system); });
+      cpu.setMode(corevu::CoreVuGravityMode::BarnesHut);
+      const double barnes_hut_ms =
+          Measure([&] { cpu.step(bodies, DT, job_system); });
+
+      std::printf(
+          "%10u %10.3fms %10.3fms %10.3fms\n", count, gpu_ms, exact_ms,
+          barnes_hut_ms);
+    }
+  }
+};
+} // namespace corevutest
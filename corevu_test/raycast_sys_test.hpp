@@ -0,0 +1,266 @@
+#pragma once
+
+#include <corevu/include/geometry/corevu_mesh_bvh.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/simd/corevu_ray_intersect.hpp>
+#include <corevu/include/simd/corevu_transform_batch.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Ray casts against a vase like surface of revolution of 262k triangles.
+  build: the mesh BVH on one thread and on all of them.
+  check: 256 random rays through the BVH against testing every triangle, then
+all rays one by one against the same rays in packets, throws FAILURE:: if a
+hit differs.
+  rays: million rays per second for random rays one by one, and for coherent
+rays(a camera grid, tiles of 4x2 per packet) one by one, as packets and as
+packets on all threads, at the scalar and the selected SIMD level.
+*/
+class RaycastSysTest
+{
+public:
+  void run()
+  {
+    buildMesh();
+    build();
+    if (!check())
+    {
+      throw std::runtime_error("FAILURE::mesh BVH hits differ");
+    }
+
+    std::printf(
+        "\n%8s %16s %16s %16s %16s\n", "level", "random Mray/s",
+        "coherent Mray/s", "packets Mray/s", "parallel Mray/s");
+    const auto level = corevu::GetSimdLevel();
+    corevu::SetSimdLevel(corevu::CoreVuSimdLevel::Scalar);
+    rays();
+    corevu::SetSimdLevel(level);
+    rays();
+  }
+
+private:
+  static constexpr uint32_t RINGS = 512;
+  static constexpr uint32_t SEGMENTS = 256;
+  static constexpr uint32_t CHECK_RAYS = 256;
+  static constexpr uint32_t RANDOM_RAYS = 100'000;
+  static constexpr uint32_t GRID_WIDTH = 512; // multiples of the tile size
+  static constexpr uint32_t GRID_HEIGHT = 512;
+  static constexpr uint32_t TILE_WIDTH = 4;
+  static constexpr uint32_t TILE_HEIGHT = 2;
+
+  void buildMesh()
+  {
+    m_positions.clear();
+    m_indices.clear();
+    for (uint32_t ring = 0; ring <= RINGS; ++ring)
+    {
+      const float y = 2.f * ring / RINGS;
+      const float radius = 0.5f + 0.25f * std::sin(y * 6.f);
+      for (uint32_t segment = 0; segment < SEGMENTS; ++segment)
+      {
+        const float angle = 6.2831853f * segment / SEGMENTS;
+        m_positions.push_back(
+            {radius * std::cos(angle), y, radius * std::sin(angle)});
+      }
+    }
+    for (uint32_t ring = 0; ring < RINGS; ++ring)
+    {
+      for (uint32_t segment = 0; segment < SEGMENTS; ++segment)
+      {
+        const uint32_t a = ring * SEGMENTS + segment;
+        const uint32_t b = ring * SEGMENTS + (segment + 1) % SEGMENTS;
+        const uint32_t c = a + SEGMENTS;
+        const uint32_t d = b + SEGMENTS;
+        m_indices.insert(m_indices.end(), {a, b, c, b, d, c});
+      }
+    }
+
+    std::mt19937 random{7};
+    std::uniform_real_distribution<float> unit{-1.f, 1.f};
+    m_random_rays.resize(RANDOM_RAYS);
+    for (auto& ray : m_random_rays)
+    {
+      // from a shell around the vase to a point inside its box
+      glm::vec3 from{unit(random), unit(random), unit(random)};
+      from = glm::normalize(from) * 4.f + glm::vec3{0.f, 1.f, 0.f};
+      const glm::vec3 to{unit(random), 1.f + unit(random), unit(random)};
+      ray = corevu::CoreVuRay{from, to - from, 2.f};
+    }
+
+    // tile by tile, the rays of a packet are neighbours on the screen
+    const glm::vec3 eye{0.f, 1.f, -4.f};
+    m_grid_rays.clear();
+    for (uint32_t tile_y = 0; tile_y < GRID_HEIGHT; tile_y += TILE_HEIGHT)
+    {
+      for (uint32_t tile_x = 0; tile_x < GRID_WIDTH; tile_x += TILE_WIDTH)
+      {
+        for (uint32_t y = tile_y; y < tile_y + TILE_HEIGHT; ++y)
+        {
+          for (uint32_t x = tile_x; x < tile_x + TILE_WIDTH; ++x)
+          {
+            const glm::vec3 target{
+                -1.25f + 2.5f * x / GRID_WIDTH,
+                1.f - 1.25f + 2.5f * y / GRID_HEIGHT, 0.f};
+            m_grid_rays.push_back(corevu::CoreVuRay{eye, target - eye, 3.f});
+          }
+        }
+      }
+    }
+  }
+
+  void build()
+  {
+    const double serial_ms =
+        Measure([&] { m_bvh.build(m_positions, m_indices); });
+    corevu::CoreVuJobSystem job_system{};
+    const double parallel_ms =
+        Measure([&] { m_bvh.build(m_positions, m_indices, &job_system); });
+    std::printf(
+        "build %u triangles: %.2f ms, %u threads %.2f ms, %zu nodes, depth "
+        "%u, %.2f slots per triangle\n",
+        m_bvh.getTriangleCount(), serial_ms, job_system.getThreadCount(),
+        parallel_ms, m_bvh.getNodes().size(), m_bvh.getDepth(),
+        static_cast<double>(m_bvh.getSlotCount()) / m_bvh.getTriangleCount());
+  }
+
+  // every triangle, no BVH
+  corevu::CoreVuMeshHit bruteForce(const corevu::CoreVuRay& ray) const
+  {
+    corevu::CoreVuMeshHit closest{};
+    closest.distance = ray.max_distance;
+    for (uint32_t i = 0; i < m_indices.size() / 3; ++i)
+    {
+      const glm::vec3 v0 = m_positions[m_indices[3 * i]];
+      const glm::vec3 e1 = m_positions[m_indices[3 * i + 1]] - v0;
+      const glm::vec3 e2 = m_positions[m_indices[3 * i + 2]] - v0;
+      const glm::vec3 p = glm::cross(ray.direction, e2);
+      const float det = glm::dot(e1, p);
+      if (det == 0.f) continue;
+      const glm::vec3 s = ray.origin - v0;
+      const float u = glm::dot(s, p) / det;
+      const glm::vec3 q = glm::cross(s, e1);
+      const float v = glm::dot(ray.direction, q) / det;
+      const float t = glm::dot(e2, q) / det;
+      if (u >= 0.f && v >= 0.f && u + v <= 1.f && t >= 0.f &&
+          t < closest.distance)
+      {
+        closest = corevu::CoreVuMeshHit{i, t, {u, v}};
+      }
+    }
+    return closest;
+  }
+
+  static bool Same(
+      const corevu::CoreVuMeshHit& a, const corevu::CoreVuMeshHit& b)
+  {
+    // rays through an edge may take either triangle
+    if (a.isHit() != b.isHit()) return false;
+    return !a.isHit() || std::abs(a.distance - b.distance) < 1e-4f;
+  }
+
+  void castPackets(
+      std::span<const corevu::CoreVuRay> rays,
+      std::span<corevu::CoreVuMeshHit> hits, uint32_t begin,
+      uint32_t end) const
+  {
+    constexpr uint32_t SIZE = corevu::CoreVuRayPacket::SIZE;
+    for (uint32_t first = begin; first < end; first += SIZE)
+    {
+      const uint32_t count = std::min(SIZE, end - first);
+      corevu::CoreVuRayPacket packet{};
+      for (uint32_t lane = 0; lane < count; ++lane)
+      {
+        packet.set(lane, rays[first + lane]);
+        hits[first + lane] = corevu::CoreVuMeshHit{};
+      }
+      m_bvh.raycast(packet, (1u << count) - 1, hits.data() + first);
+    }
+  }
+
+  bool check() const
+  {
+    uint32_t hit_count = 0;
+    for (uint32_t i = 0; i < CHECK_RAYS; ++i)
+    {
+      const auto expected = bruteForce(m_random_rays[i]);
+      if (!Same(expected, m_bvh.raycast(m_random_rays[i]))) return false;
+      hit_count += expected.isHit();
+    }
+
+    for (const auto* rays : {&m_random_rays, &m_grid_rays})
+    {
+      std::vector<corevu::CoreVuMeshHit> hits(rays->size());
+      castPackets(*rays, hits, 0, static_cast<uint32_t>(rays->size()));
+      for (size_t i = 0; i < rays->size(); ++i)
+      {
+        if (!Same(hits[i], m_bvh.raycast((*rays)[i]))) return false;
+      }
+    }
+    std::printf(
+        "check: %u rays like brute force(%u hits), packets like single "
+        "rays\n",
+        CHECK_RAYS, hit_count);
+    return true;
+  }
+
+  void rays()
+  {
+    std::vector<corevu::CoreVuMeshHit> hits(
+        std::max(m_random_rays.size(), m_grid_rays.size()));
+    const auto single = [&](const std::vector<corevu::CoreVuRay>& rays)
+    {
+      return MeasureBest(
+          [&]
+          {
+            for (size_t i = 0; i < rays.size(); ++i)
+            {
+              hits[i] = m_bvh.raycast(rays[i]);
+            }
+          });
+    };
+    const auto grid_count = static_cast<uint32_t>(m_grid_rays.size());
+    const double random_ms = single(m_random_rays);
+    const double coherent_ms = single(m_grid_rays);
+    const double packet_ms = MeasureBest(
+        [&] { castPackets(m_grid_rays, hits, 0, grid_count); });
+    corevu::CoreVuJobSystem job_system{};
+    const double parallel_ms = MeasureBest(
+        [&]
+        {
+          // whole packets per batch, 64 of them
+          job_system.parallelFor(
+              grid_count, 512, [&](uint32_t begin, uint32_t end)
+              { castPackets(m_grid_rays, hits, begin, end); });
+        });
+
+    const auto rate = [](size_t count, double ms)
+    { return count / ms / 1000.0; };
+    std::printf(
+        "%8s %16.2f %16.2f %16.2f %16.2f\n",
+        corevu::ToString(corevu::GetSimdLevel()),
+        rate(m_random_rays.size(), random_ms),
+        rate(m_grid_rays.size(), coherent_ms),
+        rate(m_grid_rays.size(), packet_ms),
+        rate(m_grid_rays.size(), parallel_ms));
+  }
+
+  std::vector<glm::vec3> m_positions;
+  std::vector<uint32_t> m_indices;
+  std::vector<corevu::CoreVuRay> m_random_rays;
+  std::vector<corevu::CoreVuRay> m_grid_rays;
+  corevu::CoreVuMeshBvh m_bvh;
+};
+} // namespace corevutest
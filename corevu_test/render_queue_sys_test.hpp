@@ -0,0 +1,156 @@
+#pragma once
+
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/render/corevu_render_queue.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Render queue on 1k..1M draws of a scene with 4 pipelines, 64 materials,
+256 meshes and 4 lods at 0.1..1000 units, a quarter of them transparent.
+  check: the queue against std::stable_sort of the same items, transparent
+draws back to front, equal keys in push order, throws FAILURE:: if not.
+  sort: mean ms of 20 sorts, radix on one and all threads against std::sort
+of the items by key. The first sort is not measured, it grows the buffers.
+*/
+class RenderQueueSysTest
+{
+public:
+  void run()
+  {
+    for (const uint32_t count : COUNTS)
+    {
+      if (!check(count))
+      {
+        throw std::runtime_error(
+            "FAILURE::render queue order is wrong at " +
+            std::to_string(count) + " draws");
+      }
+    }
+
+    std::printf(
+        "\n%8s %8s %12s %12s %8s\n", "draws", "threads", "radix ms",
+        "std::sort ms", "passes");
+    for (const uint32_t count : COUNTS)
+    {
+      sort(count, 1);
+      sort(count, corevu::CoreVuJobSystem::DefaultThreadCount());
+    }
+  }
+
+private:
+  static constexpr uint32_t COUNTS[] = {1'000, 10'000, 100'000, 1'000'000};
+  static constexpr uint32_t SORTS = 20;
+
+  static void Fill(corevu::CoreVuRenderQueue& queue, uint32_t count)
+  {
+    std::mt19937 random{count};
+    std::uniform_int_distribution<uint32_t> pipeline{0, 3};
+    std::uniform_int_distribution<uint32_t> material{0, 63};
+    std::uniform_int_distribution<uint32_t> mesh{0, 255};
+    std::uniform_int_distribution<uint32_t> lod{0, 3};
+    std::uniform_int_distribution<uint32_t> transparent{0, 3};
+    std::uniform_real_distribution<float> depth{0.1f, 1000.f};
+    queue.clear();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      const auto make = transparent(random) == 0
+                            ? corevu::MakeTransparentDrawKey
+                            : corevu::MakeOpaqueDrawKey;
+      queue.push(
+          make(
+              pipeline(random), material(random), mesh(random), lod(random),
+              depth(random)),
+          i);
+    }
+  }
+
+  // back to front inside the transparent pass, keys only differ in depth
+  // and the state below it
+  static bool BackToFront(std::span<const corevu::CoreVuRenderItem> items)
+  {
+    uint32_t last = UINT32_MAX;
+    for (const auto& item : items)
+    {
+      const auto pass = corevu::GetDrawPass(item.key);
+      if (pass != corevu::CoreVuDrawPass::Transparent)
+      {
+        continue;
+      }
+      // the field holds the inverted quantized distance
+      const auto depth = static_cast<uint32_t>(item.key >> 36) & 0xFFFFFF;
+      const uint32_t distance = 0xFFFFFF - depth;
+      if (distance > last) return false;
+      last = distance;
+    }
+    return true;
+  }
+
+  bool check(uint32_t count)
+  {
+    corevu::CoreVuJobSystem job_system{};
+    corevu::CoreVuRenderQueue queue{};
+    Fill(queue, count);
+    std::vector<corevu::CoreVuRenderItem> expected{
+        queue.getItems().begin(), queue.getItems().end()};
+    std::stable_sort(
+        expected.begin(), expected.end(),
+        [](const auto& a, const auto& b) { return a.key < b.key; });
+    queue.sort(job_system);
+
+    bool ok = queue.size() == expected.size();
+    for (size_t i = 0; ok && i < expected.size(); ++i)
+    {
+      ok = queue.getItems()[i].key == expected[i].key &&
+           queue.getItems()[i].payload == expected[i].payload;
+    }
+    ok = ok && BackToFront(queue.getItems());
+    std::printf(
+        "check %8u draws: %s, %u passes\n", count,
+        ok ? "stable and back to front" : "wrong", queue.getSortedPasses());
+    return ok;
+  }
+
+  void sort(uint32_t count, uint32_t threads)
+  {
+    corevu::CoreVuJobSystem job_system{threads};
+    corevu::CoreVuRenderQueue queue{};
+    Fill(queue, count);
+    queue.sort(job_system);
+
+    double radix_ms = 0.0;
+    double std_ms = 0.0;
+    std::vector<corevu::CoreVuRenderItem> items;
+    for (uint32_t i = 0; i < SORTS; ++i)
+    {
+      Fill(queue, count);
+      items.assign(queue.getItems().begin(), queue.getItems().end());
+
+      radix_ms += Measure([&] { queue.sort(job_system); });
+      std_ms += Measure(
+          [&]
+          {
+            std::sort(
+                items.begin(), items.end(),
+                [](const auto& a, const auto& b) { return a.key < b.key; });
+          });
+    }
+
+    std::printf(
+        "%8u %8u %12.3f %12.3f %8u\n", count, job_system.getThreadCount(),
+        radix_ms / SORTS, std_ms / SORTS, queue.getSortedPasses());
+  }
+};
+} // namespace corevutest
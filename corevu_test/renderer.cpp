@@ -2,6 +2,7 @@
 
 // std
 #include <array>
+#include <chrono>
 
 using namespace corevutest;
 
@@ -175,7 +176,15 @@ void SampleRenderer::recreateSwapchain()
   while (extent.width == 0 || extent.height == 0)
   {
     extent = m_corevu_window.GetExtent();
-    glfwWaitEvents();
+    if (std::this_thread::get_id() == m_main_thread)
+    {
+      glfwWaitEvents();
+    }
+    else
+    {
+      // minimized, the main thread keeps polling and updates the extent
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
   }
   vkDeviceWaitIdle(m_corevu_device.device());
 
@@ -206,4 +215,6 @@ void SampleRenderer::recreateSwapchain()
                                                                 // app.
     }
   }
+  m_aspect_ratio.store(
+      m_corevu_swapchain->extentAspectRatio(), std::memory_order_relaxed);
 }
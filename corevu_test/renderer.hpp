@@ -3,10 +3,12 @@
 #include <corevu/include/corevu_swap_chain.hpp>
 
 // std
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
 #include <memory>
+#include <thread>
 
 namespace corevutest
 {
@@ -51,9 +53,10 @@ public:
     return m_corevu_swapchain->getRenderPass();
   }
 
+  // of the last swap chain, safe to read while another thread renders
   float GetAspectRatio() const
   {
-    return m_corevu_swapchain ? m_corevu_swapchain->extentAspectRatio() : 0;
+    return m_aspect_ratio.load(std::memory_order_relaxed);
   }
 
 private:
@@ -70,5 +73,8 @@ private:
   uint32_t m_current_image_index = 0;
   int m_current_frame_index = 0;
   bool m_is_frame_started = false;
+  std::atomic<float> m_aspect_ratio{0.f};
+  // glfw events can only be waited for on the thread creating the renderer
+  std::thread::id m_main_thread{std::this_thread::get_id()};
 };
 } // namespace corevutest
\ No newline at end of file
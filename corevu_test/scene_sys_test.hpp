@@ -0,0 +1,237 @@
+#pragma once
+
+#include <corevu/include/corevu_components.hpp>
+#include <corevu/include/ecs/corevu_world.hpp>
+#include <corevu/include/scene/corevu_scene.hpp>
+#include <corevu/include/systems/transform_system.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Binary scene round trip of 100k entities in three archetypes(transform +
+point light, transform + rigid body, transform only), every 4th transform is
+child of the one before. No asset references, those need a device.
+  Saves the world, loads it into a new one and compares every entity with the
+one loaded from its place in the file: TRS, parent and all fields of its
+other components. Prints the best load time of a few runs(target < 50 ms).
+
+Throws FAILURE:: if the loaded scene differs.
+*/
+class SceneSysTest
+{
+public:
+  void run()
+  {
+    corevu::CoreVuWorld world;
+    corevu::TransformSystem transform_system;
+    build(world, transform_system);
+
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "scene_sys_test.cvscene")
+            .string();
+    const double save_ms =
+        Measure([&] { corevu::CoreVuScene::Save(world, path, nullptr); });
+    std::printf(
+        "saved %zu entities, %.1f MB in %.2f ms\n", world.getEntityCount(),
+        std::filesystem::file_size(path) / (1024.0 * 1024.0), save_ms);
+
+    double best_ms = 1e30;
+    for (int i = 0; i < REPEATS; ++i)
+    {
+      corevu::CoreVuWorld loaded;
+      corevu::TransformSystem loaded_transforms;
+      std::vector<corevu::CoreVuEntity> loaded_entities;
+      const double load_ms = Measure(
+          [&]
+          {
+            loaded_entities = corevu::CoreVuScene::Load(
+                path, loaded, loaded_transforms, nullptr);
+          });
+      best_ms = std::min(best_ms, load_ms);
+      if (i == 0 && !equal(world, loaded, loaded_entities))
+      {
+        std::filesystem::remove(path);
+        throw std::runtime_error(
+            "FAILURE::loaded scene differs from the saved one");
+      }
+    }
+    std::printf("loaded in %.2f ms\n", best_ms);
+    std::filesystem::remove(path);
+  }
+
+private:
+  static constexpr int ENTITY_COUNT = 100'000;
+  static constexpr int REPEATS = 5;
+
+  void build(
+      corevu::CoreVuWorld& world, corevu::TransformSystem& transform_system)
+  {
+    std::vector<corevu::CoreVuEntity> entities;
+    entities.reserve(ENTITY_COUNT);
+    for (int i = 0; i < ENTITY_COUNT; ++i)
+    {
+      const float x = static_cast<float>(i);
+      const corevu::TransformComponent transform{
+          {x, 0.f, -x}, {0.f, x * .01f, 0.f}, {1.f, 2.f, 1.f}};
+      if (i % 3 == 0)
+      {
+        entities.push_back(world.createEntity(
+            transform, corevu::PointLightComponent{{1.f, .5f, .1f}, x}));
+      }
+      else if (i % 3 == 1)
+      {
+        entities.push_back(world.createEntity(
+            transform, corevu::RigidBody2dComponent{{x, 1.f}, 2.f}));
+      }
+      else
+      {
+        entities.push_back(world.createEntity(transform));
+      }
+      if (i % 4 == 1)
+      {
+        transform_system.setParent(world, entities[i], entities[i - 1]);
+      }
+    }
+  }
+
+  static bool Expect(bool condition, const char* message)
+  {
+    if (!condition)
+    {
+      std::cout << "FAILURE::" << message << "\n";
+    }
+    return condition;
+  }
+
+  /* The order Save writes entities in: archetype by archetype, chunk, row.
+   * Every archetype here has a transform, none is skipped by Save. */
+  static std::vector<corevu::CoreVuEntity> FileOrder(
+      const corevu::CoreVuWorld& world)
+  {
+    std::vector<corevu::CoreVuEntity> entities;
+    for (const auto* archetype : world.getArchetypes())
+    {
+      for (size_t chunk = 0; chunk < archetype->getChunkCount(); ++chunk)
+      {
+        const auto* chunk_entities = archetype->getEntities(chunk);
+        entities.insert(
+            entities.end(), chunk_entities,
+            chunk_entities + archetype->getChunk(chunk).count);
+      }
+    }
+    return entities;
+  }
+
+  template <typename T>
+  static const T* Find(
+      const corevu::CoreVuWorld& world, corevu::CoreVuEntity entity)
+  {
+    return world.hasComponent<T>(entity)
+               ? world.getComponent<const T>(entity)
+               : nullptr;
+  }
+
+  /* Entity ids differ between both worlds, the i-th saved entity is the i-th
+   * one Load returns. Parents are compared through that mapping as well. */
+  static bool equal(
+      const corevu::CoreVuWorld& world, const corevu::CoreVuWorld& loaded,
+      const std::vector<corevu::CoreVuEntity>& loaded_entities)
+  {
+    const std::vector<corevu::CoreVuEntity> saved = FileOrder(world);
+    if (!Expect(
+            saved.size() == loaded_entities.size() &&
+                loaded.getEntityCount() == saved.size(),
+            "loaded entity count differs"))
+    {
+      return false;
+    }
+    std::unordered_map<uint32_t, corevu::CoreVuEntity> loaded_of;
+    for (size_t i = 0; i < saved.size(); ++i)
+    {
+      loaded_of[corevu::GetEntityIndex(saved[i])] = loaded_entities[i];
+    }
+
+    for (size_t i = 0; i < saved.size(); ++i)
+    {
+      const corevu::CoreVuEntity entity = saved[i];
+      const corevu::CoreVuEntity copy = loaded_entities[i];
+      if (!Expect(loaded.isAlive(copy), "Load returned a dead entity"))
+      {
+        return false;
+      }
+
+      const auto* transform = Find<corevu::TransformComponent>(world, entity);
+      const auto* loaded_transform =
+          Find<corevu::TransformComponent>(loaded, copy);
+      if (!Expect(
+              (transform == nullptr) == (loaded_transform == nullptr),
+              "transform lost or added on load"))
+      {
+        return false;
+      }
+      if (transform != nullptr)
+      {
+        const corevu::CoreVuEntity parent = transform->GetParent();
+        const corevu::CoreVuEntity expected_parent =
+            parent == corevu::NULL_ENTITY
+                ? corevu::NULL_ENTITY
+                : loaded_of.at(corevu::GetEntityIndex(parent));
+        if (!Expect(
+                loaded_transform->GetTranslation() ==
+                        transform->GetTranslation() &&
+                    loaded_transform->GetRotation() ==
+                        transform->GetRotation() &&
+                    loaded_transform->GetScale() == transform->GetScale(),
+                "transform TRS differs after load") ||
+            !Expect(
+                loaded_transform->GetParent() == expected_parent,
+                "transform parent differs after load"))
+        {
+          return false;
+        }
+      }
+
+      const auto* light = Find<corevu::PointLightComponent>(world, entity);
+      const auto* loaded_light =
+          Find<corevu::PointLightComponent>(loaded, copy);
+      if (!Expect(
+              (light == nullptr) == (loaded_light == nullptr),
+              "point light lost or added on load") ||
+          (light != nullptr &&
+           !Expect(
+               loaded_light->color == light->color &&
+                   loaded_light->intensity == light->intensity,
+               "point light differs after load")))
+      {
+        return false;
+      }
+
+      const auto* body = Find<corevu::RigidBody2dComponent>(world, entity);
+      const auto* loaded_body =
+          Find<corevu::RigidBody2dComponent>(loaded, copy);
+      if (!Expect(
+              (body == nullptr) == (loaded_body == nullptr),
+              "rigid body lost or added on load") ||
+          (body != nullptr &&
+           !Expect(
+               loaded_body->velocity == body->velocity &&
+                   loaded_body->mass == body->mass,
+               "rigid body differs after load")))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+} // namespace corevutest
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <coremem/include/AlignedMemory.hpp>
+#include <corevu/include/corevu_components.hpp>
+#include <corevu/include/simd/corevu_frustum_cull.hpp>
+#include <corevu/include/simd/corevu_transform_batch.hpp>
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Batch transform kernel, model + normal matrices of N objects from SoA
+translation, rotation and scale streams.
+  verify: every instruction set the cpu supports against the scalar functions
+of TransformComponent(ToMat4() and inverseTranspose of its 3x3), prints the
+largest error relative to the magnitude of the entry. The vector paths use
+their own sin/cos, so they are close but not bit equal.
+  throughput: millions of objects per second for 1k to 1M objects, "aos" is a
+plain loop over TransformComponent::ToMat4() + inverseTranspose, the way the
+transform system did it before. 1k fits L1/L2, 1M is bound by the ~100 bytes
+written per object.
+  culling: CullSpheres on 1M spheres(the translations as centers, scale x as
+radius) per instruction set, the visible lists must equal the scalar one.
+
+A kernel out of tolerance or a visible list that differs throws FAILURE::.
+*/
+class SimdSysTest
+{
+public:
+  void run()
+  {
+    const corevu::CoreVuSimdLevel supported = corevu::GetSupportedSimdLevel();
+    std::cout << "Batch transform kernel, supported: "
+              << corevu::ToString(supported) << "\n";
+
+    prepare(MAX_COUNT);
+
+    bool passed = true;
+    for (auto level : LEVELS)
+    {
+      if (level > supported) continue;
+      passed &= verify(level);
+    }
+    if (!passed)
+    {
+      throw std::runtime_error(
+          "FAILURE::batch transform kernel out of tolerance");
+    }
+
+    std::printf("%10s %10s", "objects", "aos");
+    for (auto level : LEVELS)
+    {
+      if (level <= supported)
+      {
+        std::printf(" %10s", corevu::ToString(level));
+      }
+    }
+    std::printf("   [M objects/s]\n");
+
+    for (size_t count = 1'000; count <= MAX_COUNT; count *= 10)
+    {
+      const size_t repeats = std::max<size_t>(3, MAX_COUNT / count);
+      std::printf(
+          "%10zu %10.1f", count,
+          throughput(count, repeats, [&] { runAoS(count); }));
+      for (auto level : LEVELS)
+      {
+        if (level > supported) continue;
+        corevu::SetSimdLevel(level);
+        std::printf(
+            " %10.1f", throughput(count, repeats, [&] { runBatch(count); }));
+      }
+      std::printf("\n");
+    }
+    corevu::SetSimdLevel(supported);
+
+    if (!runCulling(supported))
+    {
+      throw std::runtime_error("FAILURE::culled visible lists differ");
+    }
+  }
+
+private:
+  using TransformStreams = coremem::SoAArray<
+      float, float, float, float, float, float, float, float, float>;
+
+  static constexpr size_t MAX_COUNT = 1'000'000;
+  static constexpr float TOLERANCE = 1e-5f;
+  static constexpr corevu::CoreVuSimdLevel LEVELS[] = {
+      corevu::CoreVuSimdLevel::Scalar, corevu::CoreVuSimdLevel::SSE42,
+      corevu::CoreVuSimdLevel::AVX2, corevu::CoreVuSimdLevel::AVX512};
+
+  void prepare(size_t count)
+  {
+    m_memory = coremem::AlignedBuffer{
+        TransformStreams::Layout::MemorySize(count)};
+    m_streams = TransformStreams{m_memory.GetMemory(), count};
+    m_soa = corevu::CoreVuTransformSoA{
+        m_streams.Stream<0>(), m_streams.Stream<1>(), m_streams.Stream<2>(),
+        m_streams.Stream<3>(), m_streams.Stream<4>(), m_streams.Stream<5>(),
+        m_streams.Stream<6>(), m_streams.Stream<7>(), m_streams.Stream<8>()};
+
+    m_transforms.resize(count);
+    m_models.resize(count);
+    m_normals.resize(count);
+
+    // angles over a few turns in both directions, scale 0.1 to 4
+    uint32_t state = 0x12345678u;
+    auto next = [&state](float min, float max)
+    {
+      state = state * 1664525u + 1013904223u;
+      return min + (max - min) * static_cast<float>(state >> 8) / 16777216.f;
+    };
+    for (size_t i = 0; i < count; ++i)
+    {
+      const glm::vec3 translation{
+          next(-100.f, 100.f), next(-100.f, 100.f), next(-100.f, 100.f)};
+      const glm::vec3 rotation{
+          next(-20.f, 20.f), next(-20.f, 20.f), next(-20.f, 20.f)};
+      const glm::vec3 scale{next(.1f, 4.f), next(.1f, 4.f), next(.1f, 4.f)};
+      m_transforms[i] =
+          corevu::TransformComponent{translation, rotation, scale};
+
+      m_streams.Stream<0>()[i] = translation.x;
+      m_streams.Stream<1>()[i] = translation.y;
+      m_streams.Stream<2>()[i] = translation.z;
+      m_streams.Stream<3>()[i] = rotation.x;
+      m_streams.Stream<4>()[i] = rotation.y;
+      m_streams.Stream<5>()[i] = rotation.z;
+      m_streams.Stream<6>()[i] = scale.x;
+      m_streams.Stream<7>()[i] = scale.y;
+      m_streams.Stream<8>()[i] = scale.z;
+    }
+  }
+
+  bool verify(corevu::CoreVuSimdLevel level)
+  {
+    corevu::SetSimdLevel(level);
+    runBatch(MAX_COUNT);
+
+    auto relative_error = [](float value, float reference)
+    {
+      return std::abs(value - reference) /
+             std::max(1.0f, std::abs(reference));
+    };
+
+    float model_error = 0.0f;
+    float normal_error = 0.0f;
+    bool model_equal = true;
+    for (size_t i = 0; i < MAX_COUNT; ++i)
+    {
+      const glm::mat4 model = m_transforms[i].ToMat4();
+      const glm::mat3 normal = glm::inverseTranspose(glm::mat3{model});
+      model_equal &= model == m_models[i];
+      for (int c = 0; c < 4; ++c)
+      {
+        for (int r = 0; r < 4; ++r)
+        {
+          model_error = std::max(
+              model_error, relative_error(m_models[i][c][r], model[c][r]));
+        }
+      }
+      for (int c = 0; c < 3; ++c)
+      {
+        for (int r = 0; r < 3; ++r)
+        {
+          normal_error = std::max(
+              normal_error, relative_error(m_normals[i][c][r], normal[c][r]));
+        }
+      }
+    }
+
+    const bool passed = model_error <= TOLERANCE && normal_error <= TOLERANCE;
+    std::printf(
+        "%10s model %s max error %.3g, normal max error %.3g %s\n",
+        corevu::ToString(level), model_equal ? "bit equal," : "",
+        model_error, normal_error, passed ? "ok" : "FAILED");
+    return passed;
+  }
+
+  void runAoS(size_t count)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      m_models[i] = m_transforms[i].ToMat4();
+      m_normals[i] = glm::inverseTranspose(glm::mat3{m_models[i]});
+    }
+  }
+
+  void runBatch(size_t count)
+  {
+    corevu::ComputeTransformMatrices(
+        m_soa, count, m_models.data(), m_normals.data());
+  }
+
+  bool runCulling(corevu::CoreVuSimdLevel supported)
+  {
+    const auto frustum = corevu::CoreVuFrustum::FromMatrix(
+        glm::perspective(glm::radians(50.f), 16.f / 9.f, 0.1f, 100.f) *
+        glm::lookAt(
+            glm::vec3{0.f}, glm::vec3{1.f, 0.f, 1.f},
+            glm::vec3{0.f, 1.f, 0.f}));
+    const corevu::CoreVuSphereSoA spheres{
+        m_streams.Stream<0>(), m_streams.Stream<1>(), m_streams.Stream<2>(),
+        m_streams.Stream<6>()};
+
+    std::vector<uint32_t> reference(MAX_COUNT);
+    std::vector<uint32_t> visible(MAX_COUNT);
+    corevu::SetSimdLevel(corevu::CoreVuSimdLevel::Scalar);
+    reference.resize(
+        corevu::CullSpheres(frustum, spheres, MAX_COUNT, reference.data()));
+
+    std::printf(
+        "Frustum culling of %zu spheres, %zu visible  [M spheres/s]\n",
+        MAX_COUNT, reference.size());
+    bool passed = true;
+    for (auto level : LEVELS)
+    {
+      if (level > supported) continue;
+      corevu::SetSimdLevel(level);
+      size_t visible_count = 0;
+      const double rate = throughput(
+          MAX_COUNT, 10,
+          [&]
+          {
+            visible_count = corevu::CullSpheres(
+                frustum, spheres, MAX_COUNT, visible.data());
+          });
+      const bool equal =
+          visible_count == reference.size() &&
+          std::equal(reference.begin(), reference.end(), visible.begin());
+      std::printf(
+          "%10s %10.1f %s\n", corevu::ToString(level), rate,
+          equal ? "ok" : "FAILED");
+      passed &= equal;
+    }
+    corevu::SetSimdLevel(supported);
+    return passed;
+  }
+
+  template <typename Fn>
+  double throughput(size_t count, size_t repeats, Fn&& fn)
+  {
+    const double best_ms = MeasureBest(fn, static_cast<int>(repeats));
+    return static_cast<double>(count) / best_ms / 1000.0;
+  }
+
+  coremem::AlignedBuffer m_memory;
+  TransformStreams m_streams;
+  corevu::CoreVuTransformSoA m_soa{};
+
+  std::vector<corevu::TransformComponent> m_transforms;
+  std::vector<glm::mat4> m_models;
+  std::vector<glm::mat3> m_normals;
+};
+} // namespace corevutest
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <corevu/include/corevu_model.hpp>
+#include <corevu/include/geometry/corevu_mesh_simplify.hpp>
+
+#include <glm/glm.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Quadric error simplification and LOD selection, no device needed.
+  folds: a noisy heightfield simplified down to 1/16th, every triangle still
+has to face up, any collapse folding one over is rejected.
+  borders: a flat square grid simplified to 1/8th keeps its four corners, its
+area and a border of the same length.
+  sphere: a unit UV sphere of ~160k triangles halved down to 800 triangles,
+no triangle may face inwards at any level, the error grows with every level
+and stays within 0.0001..0.05.
+  lods: Builder::generateLods on the sphere, LOD errors never decrease.
+  selection: CoreVuModel::SelectLod moves to the coarsest LOD within the
+error, and only back once the error is the hysteresis past the limit.
+
+Prints the error and time of every sphere level, throws FAILURE:: at the
+first check that fails.
+*/
+class SimplifySysTest
+{
+public:
+  void run()
+  {
+    if (!checkFolds() || !checkBorders() || !checkSphere() || !checkLods() ||
+        !checkLodSelection())
+    {
+      throw std::runtime_error("FAILURE::simplify checks failed");
+    }
+    std::cout << "Simplify checks passed\n";
+  }
+
+private:
+  static constexpr uint32_t SPHERE_SEGMENTS = 400;
+  static constexpr uint32_t SPHERE_RINGS = 201;
+  static constexpr size_t SPHERE_MIN_TRIANGLES = 800;
+  static constexpr float SPHERE_MIN_ERROR = 0.0001f;
+  static constexpr float SPHERE_MAX_ERROR = 0.05f;
+
+  struct Mesh
+  {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t> indices;
+  };
+
+  static bool Expect(bool condition, const char* message)
+  {
+    if (!condition)
+    {
+      std::cout << "FAILURE::" << message << "\n";
+    }
+    return condition;
+  }
+
+  /* Rows of rings from pole to pole, the last column repeats the first one
+   * (a uv seam the simplifier has to weld). */
+  static Mesh MakeSphere(uint32_t segments, uint32_t rings)
+  {
+    Mesh mesh{};
+    const float pi = 3.14159265358979f;
+    for (uint32_t ring = 0; ring <= rings; ++ring)
+    {
+      const float theta = pi * ring / rings;
+      for (uint32_t segment = 0; segment <= segments; ++segment)
+      {
+        const float phi = 2.f * pi * (segment % segments) / segments;
+        const glm::vec3 p{
+            std::sin(theta) * std::cos(phi), std::cos(theta),
+            std::sin(theta) * std::sin(phi)};
+        mesh.positions.push_back(p);
+        mesh.normals.push_back(p);
+      }
+    }
+
+    const uint32_t row = segments + 1;
+    for (uint32_t ring = 0; ring < rings; ++ring)
+    {
+      for (uint32_t segment = 0; segment < segments; ++segment)
+      {
+        const uint32_t a = ring * row + segment;
+        const uint32_t b = a + row;
+        // the pole rows only have one triangle per quad
+        if (ring != 0)
+        {
+          mesh.indices.insert(mesh.indices.end(), {a, a + 1, b});
+        }
+        if (ring != rings - 1)
+        {
+          mesh.indices.insert(mesh.indices.end(), {a + 1, b + 1, b});
+        }
+      }
+    }
+    return mesh;
+  }
+
+  /* n x n quads over [-1, 1]^2 in xz, y up, waves of amplitude with noise
+   * of a fraction of the quad size: steep enough to fold when collapsed
+   * carelessly, still a heightfield. Flat without amplitude. */
+  static Mesh MakeGrid(uint32_t n, float amplitude)
+  {
+    Mesh mesh{};
+    std::mt19937 random{5};
+    std::uniform_real_distribution<float> noise{-.2f / n, .2f / n};
+    for (uint32_t z = 0; z <= n; ++z)
+    {
+      for (uint32_t x = 0; x <= n; ++x)
+      {
+        const float fx = -1.f + 2.f * x / n;
+        const float fz = -1.f + 2.f * z / n;
+        const float wave = std::sin(5.f * fx) * std::cos(3.f * fz);
+        const float y =
+            amplitude > 0.f ? amplitude * wave + noise(random) : 0.f;
+        mesh.positions.push_back({fx, y, fz});
+        mesh.normals.push_back({0.f, 1.f, 0.f});
+      }
+    }
+    for (uint32_t z = 0; z < n; ++z)
+    {
+      for (uint32_t x = 0; x < n; ++x)
+      {
+        const uint32_t a = z * (n + 1) + x;
+        const uint32_t b = a + n + 1;
+        mesh.indices.insert(mesh.indices.end(), {a, b, a + 1});
+        mesh.indices.insert(mesh.indices.end(), {a + 1, b, b + 1});
+      }
+    }
+    return mesh;
+  }
+
+  static glm::vec3 TriangleNormal(
+      const std::vector<glm::vec3>& positions, const uint32_t* corners)
+  {
+    const glm::vec3& p0 = positions[corners[0]];
+    return glm::cross(positions[corners[1]] - p0, positions[corners[2]] - p0);
+  }
+
+  /* triangles facing away from facing(centroid), edge-on ones(three corners
+   * on a grid line of the heightfield) fold nothing over and don't count */
+  template <typename Facing>
+  static size_t CountFlips(
+      const Mesh& mesh, const std::vector<uint32_t>& indices, Facing&& facing)
+  {
+    size_t flips = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+      const glm::vec3 normal = TriangleNormal(mesh.positions, &indices[i]);
+      const glm::vec3 centroid =
+          (mesh.positions[indices[i]] + mesh.positions[indices[i + 1]] +
+           mesh.positions[indices[i + 2]]) /
+          3.f;
+      if (glm::dot(normal, facing(centroid)) < 0.f) flips++;
+    }
+    return flips;
+  }
+
+  static std::vector<uint32_t> Simplify(
+      const Mesh& mesh, size_t target_triangles, float* error)
+  {
+    return corevu::SimplifyMesh(
+        mesh.positions, mesh.normals, mesh.indices, target_triangles * 3,
+        error);
+  }
+
+  bool checkFolds()
+  {
+    const Mesh grid = MakeGrid(128, .08f);
+    const auto up = [](const glm::vec3&) { return glm::vec3{0.f, 1.f, 0.f}; };
+    if (!Expect(CountFlips(grid, grid.indices, up) == 0, "grid faces down"))
+    {
+      return false;
+    }
+    const size_t triangles = grid.indices.size() / 3;
+    for (size_t target = triangles / 2; target >= triangles / 16; target /= 2)
+    {
+      float error = 0.f;
+      const auto lod = Simplify(grid, target, &error);
+      if (!Expect(
+              lod.size() < grid.indices.size(), "heightfield not simplified") ||
+          !Expect(
+              CountFlips(grid, lod, up) == 0,
+              "simplification folded a triangle"))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool checkBorders()
+  {
+    const Mesh grid = MakeGrid(64, 0.f);
+    float error = 0.f;
+    const auto lod = Simplify(grid, grid.indices.size() / 3 / 8, &error);
+    if (!Expect(
+            lod.size() <= grid.indices.size() / 4,
+            "flat grid not simplified"))
+    {
+      return false;
+    }
+
+    // edges used by one triangle only form the border
+    std::map<std::pair<uint32_t, uint32_t>, int> edges;
+    float area = 0.f;
+    for (size_t i = 0; i < lod.size(); i += 3)
+    {
+      area += .5f * glm::length(TriangleNormal(grid.positions, &lod[i]));
+      for (int k = 0; k < 3; ++k)
+      {
+        const uint32_t a = lod[i + k];
+        const uint32_t b = lod[i + (k + 1) % 3];
+        edges[{std::min(a, b), std::max(a, b)}]++;
+      }
+    }
+    float border_length = 0.f;
+    bool on_square = true;
+    for (const auto& [edge, count] : edges)
+    {
+      if (count != 1) continue;
+      const glm::vec3& a = grid.positions[edge.first];
+      const glm::vec3& b = grid.positions[edge.second];
+      border_length += glm::length(b - a);
+      // both ends on the same side of the square
+      on_square = on_square && ((std::abs(a.x) == 1.f && a.x == b.x) ||
+                                (std::abs(a.z) == 1.f && a.z == b.z));
+    }
+
+    bool corners = true;
+    for (const glm::vec3 corner :
+         {glm::vec3{-1.f, 0.f, -1.f}, glm::vec3{1.f, 0.f, -1.f},
+          glm::vec3{-1.f, 0.f, 1.f}, glm::vec3{1.f, 0.f, 1.f}})
+    {
+      corners = corners && std::any_of(
+                               lod.begin(), lod.end(), [&](uint32_t index)
+                               { return grid.positions[index] == corner; });
+    }
+    return Expect(on_square, "border edge left the square") &&
+           Expect(corners, "square lost a corner") &&
+           Expect(std::abs(area - 4.f) < 1e-3f, "flat grid area changed") &&
+           Expect(
+               std::abs(border_length - 8.f) < 1e-3f, "border length changed");
+  }
+
+  bool checkSphere()
+  {
+    const Mesh sphere = MakeSphere(SPHERE_SEGMENTS, SPHERE_RINGS);
+    const size_t triangles = sphere.indices.size() / 3;
+    const auto outwards = [](const glm::vec3& centroid) { return centroid; };
+    std::printf("sphere of %zu triangles\n", triangles);
+    std::printf("%10s %10s %10s %10s\n", "target", "triangles", "error", "ms");
+
+    float previous_error = 0.f;
+    float first_error = -1.f;
+    size_t target = triangles;
+    while (target > SPHERE_MIN_TRIANGLES)
+    {
+      target = std::max(target / 2, SPHERE_MIN_TRIANGLES);
+      float error = 0.f;
+      std::vector<uint32_t> lod;
+      const double ms =
+          Measure([&] { lod = Simplify(sphere, target, &error); });
+      std::printf(
+          "%10zu %10zu %10.5f %10.1f\n", target, lod.size() / 3, error, ms);
+
+      if (!Expect(lod.size() / 3 <= target, "sphere target missed") ||
+          !Expect(
+              CountFlips(sphere, lod, outwards) == 0,
+              "sphere triangle flipped") ||
+          !Expect(error >= previous_error, "error shrank on a coarser level"))
+      {
+        return false;
+      }
+      if (first_error < 0.f) first_error = error;
+      previous_error = error;
+    }
+    return Expect(
+        first_error >= SPHERE_MIN_ERROR && previous_error <= SPHERE_MAX_ERROR,
+        "sphere errors out of range");
+  }
+
+  bool checkLods()
+  {
+    const Mesh sphere = MakeSphere(64, 33);
+    corevu::CoreVuModel::Builder builder{};
+    for (size_t i = 0; i < sphere.positions.size(); ++i)
+    {
+      corevu::CoreVuModel::Vertex vertex{};
+      vertex.position = sphere.positions[i];
+      vertex.normal = sphere.normals[i];
+      builder.vertices.push_back(vertex);
+    }
+    for (uint32_t index : sphere.indices)
+    {
+      builder.indices.push_back(corevu::CoreVuModel::Index{index});
+    }
+    builder.generateLods();
+
+    if (!Expect(builder.lods.size() >= 3, "sphere got too few LODs"))
+    {
+      return false;
+    }
+    for (size_t i = 1; i < builder.lods.size(); ++i)
+    {
+      const auto& finer = builder.lods[i - 1];
+      const auto& lod = builder.lods[i];
+      if (!Expect(lod.error >= finer.error, "LOD error decreased") ||
+          !Expect(lod.index_count < finer.index_count, "LOD not coarser") ||
+          !Expect(
+              lod.first_index + lod.index_count <= builder.indices.size(),
+              "LOD range outside the index buffer"))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool checkLodSelection()
+  {
+    using Lod = corevu::CoreVuModel::Lod;
+    const std::vector<Lod> lods{
+        {0, 0, 0.f}, {0, 0, .001f}, {0, 0, .004f}, {0, 0, .016f}};
+    constexpr float MAX_ERROR = .01f;
+    constexpr float HYSTERESIS = .25f;
+    const auto select = [&](float scale, uint32_t previous)
+    {
+      return corevu::CoreVuModel::SelectLod(
+          lods, scale, MAX_ERROR, HYSTERESIS, previous);
+    };
+
+    // LOD 3 shows .011 on screen, between the limits .0075 and .0125
+    const float boundary = .011f / .016f;
+    if (!Expect(select(1.f, 0) == 2, "coarsest LOD within the error") ||
+        !Expect(select(1.f, 3) == 2, "too coarse LOD kept") ||
+        !Expect(select(.1f, 0) == 3, "far object not at the last LOD") ||
+        !Expect(select(100.f, 3) == 0, "close object not at LOD 0") ||
+        !Expect(select(boundary, 2) == 2, "switched to coarser too early") ||
+        !Expect(select(boundary, 3) == 3, "switched to finer too early") ||
+        !Expect(select(boundary, 7) == 3, "previous past the last LOD"))
+    {
+      return false;
+    }
+
+    // wobbling around the limit of LOD 3 switches once, not every frame
+    uint32_t lod = 0;
+    uint32_t switches = 0;
+    for (int frame = 0; frame < 100; ++frame)
+    {
+      const float wobble = frame % 2 == 0 ? .95f : 1.05f;
+      const uint32_t next = select(MAX_ERROR / .016f * wobble, lod);
+      switches += next != lod ? 1 : 0;
+      lod = next;
+    }
+    return Expect(switches == 1, "LOD pops at the limit");
+  }
+};
+} // namespace corevutest
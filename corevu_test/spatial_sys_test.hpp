@@ -0,0 +1,225 @@
+#pragma once
+
+#include <corevu/include/geometry/corevu_bounds.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/spatial/corevu_aabb_tree.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "test_timing.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Spatial index on 100k boxes(0.2..2 units) spread over a 400^3 volume, the
+tree against a linear scan over all boxes.
+  build: inserting all of them one by one.
+  move: 10% of the boxes move by up to 0.5 units, the frame to frame case.
+  frustum/sphere/box/ray: one query each, sphere and ray also as batches of
+1024 through the job system.
+The first results of every query are compared against the linear scan, a
+difference or a broken tree throws FAILURE::.
+*/
+class SpatialSysTest
+{
+public:
+  void run()
+  {
+    build();
+    std::printf("%10s %12s %12s %10s\n", "query", "tree", "linear", "hits");
+    std::printf(
+        "%10s %9.2f ms %12s %10u\n", "build", m_build_ms, "",
+        m_tree.getProxyCount());
+
+    const double move_ms = Measure([&] { moveSome(); });
+    std::printf("%10s %9.2f ms %12s %10s\n", "move 10%", move_ms, "", "");
+    if (!m_tree.validate())
+    {
+      throw std::runtime_error("FAILURE::tree is broken after moving");
+    }
+    std::printf("tree height %d\n", m_tree.getHeight());
+
+    const auto frustum = corevu::CoreVuFrustum::FromMatrix(
+        glm::perspective(glm::radians(50.f), 16.f / 9.f, 0.1f, 150.f) *
+        glm::lookAt(
+            glm::vec3{0.f}, glm::vec3{1.f, 0.2f, 1.f},
+            glm::vec3{0.f, 1.f, 0.f}));
+    const corevu::CoreVuSphere sphere{glm::vec3{20.f, 5.f, -30.f}, 25.f};
+    const corevu::CoreVuAabb box{glm::vec3{-40.f}, glm::vec3{0.f, 40.f, 10.f}};
+    const corevu::CoreVuRay ray{glm::vec3{-200.f, 0.f, 0.f},
+                                glm::normalize(glm::vec3{1.f, 0.01f, 0.02f})};
+
+    compare(
+        "frustum",
+        [&](auto&& fn) { m_tree.queryFrustum(frustum, fn); },
+        [&](const corevu::CoreVuAabb& b)
+        { return corevu::Intersects(frustum, b); });
+    compare(
+        "sphere", [&](auto&& fn) { m_tree.querySphere(sphere, fn); },
+        [&](const corevu::CoreVuAabb& b)
+        { return corevu::Intersects(b, sphere); });
+    compare(
+        "box", [&](auto&& fn) { m_tree.queryAabb(box, fn); },
+        [&](const corevu::CoreVuAabb& b)
+        { return corevu::Intersects(b, box); });
+    compareRay(ray);
+    runBatches();
+  }
+
+private:
+  static constexpr uint32_t COUNT = 100'000;
+  static constexpr float HALF_VOLUME = 200.f;
+  static constexpr uint32_t BATCH_COUNT = 1024;
+
+  void build()
+  {
+    std::mt19937 random{7};
+    std::uniform_real_distribution<float> position{-HALF_VOLUME, HALF_VOLUME};
+    std::uniform_real_distribution<float> extent{0.1f, 1.f};
+    m_boxes.resize(COUNT);
+    for (auto& b : m_boxes)
+    {
+      b = corevu::CoreVuAabb::FromCenterExtents(
+          {position(random), position(random), position(random)},
+          {extent(random), extent(random), extent(random)});
+    }
+
+    m_build_ms = Measure(
+        [&]
+        {
+          m_proxies.resize(COUNT);
+          for (uint32_t i = 0; i < COUNT; ++i)
+          {
+            m_proxies[i] = m_tree.createProxy(m_boxes[i], i);
+          }
+        });
+  }
+
+  void moveSome()
+  {
+    std::mt19937 random{11};
+    std::uniform_real_distribution<float> offset{-0.5f, 0.5f};
+    for (uint32_t i = 0; i < COUNT; i += 10)
+    {
+      const glm::vec3 delta{offset(random), offset(random), offset(random)};
+      m_boxes[i].min += delta;
+      m_boxes[i].max += delta;
+      m_tree.moveProxy(m_proxies[i], m_boxes[i]);
+    }
+  }
+
+  template <typename Query, typename Test>
+  void compare(const char* name, Query&& query, Test&& test)
+  {
+    std::vector<corevu::CoreVuEntity> tree_hits;
+    std::vector<corevu::CoreVuEntity> linear_hits;
+    const double tree_ms = MeasureBest(
+        [&]
+        {
+          tree_hits.clear();
+          query([&](corevu::CoreVuEntity e) { tree_hits.push_back(e); });
+        });
+    const double linear_ms = MeasureBest(
+        [&]
+        {
+          linear_hits.clear();
+          for (uint32_t i = 0; i < COUNT; ++i)
+          {
+            if (test(m_boxes[i])) linear_hits.push_back(i);
+          }
+        });
+
+    std::sort(tree_hits.begin(), tree_hits.end());
+    if (tree_hits != linear_hits)
+    {
+      throw std::runtime_error(
+          std::string("FAILURE::") + name + " query differs from linear scan");
+    }
+    std::printf(
+        "%10s %9.3f ms %9.3f ms %10zu\n", name, tree_ms, linear_ms,
+        tree_hits.size());
+  }
+
+  void compareRay(const corevu::CoreVuRay& ray)
+  {
+    corevu::CoreVuRayHit tree_hit{};
+    corevu::CoreVuRayHit linear_hit{};
+    const double tree_ms =
+        MeasureBest([&] { tree_hit = m_tree.raycastClosest(ray); });
+    const double linear_ms = MeasureBest(
+        [&]
+        {
+          linear_hit = corevu::CoreVuRayHit{};
+          linear_hit.distance = ray.max_distance;
+          const glm::vec3 inverse_direction = 1.f / ray.direction;
+          for (uint32_t i = 0; i < COUNT; ++i)
+          {
+            float distance = 0.f;
+            if (corevu::IntersectRay(
+                    ray, inverse_direction, m_boxes[i], distance) &&
+                distance < linear_hit.distance)
+            {
+              linear_hit = corevu::CoreVuRayHit{i, distance};
+            }
+          }
+        });
+
+    if (tree_hit.entity != linear_hit.entity)
+    {
+      throw std::runtime_error(
+          "FAILURE::closest ray hit differs from linear scan");
+    }
+    std::printf(
+        "%10s %9.3f ms %9.3f ms %10s\n", "ray", tree_ms, linear_ms,
+        tree_hit.entity == corevu::NULL_ENTITY ? "miss" : "hit");
+  }
+
+  void runBatches()
+  {
+    std::mt19937 random{13};
+    std::uniform_real_distribution<float> position{-HALF_VOLUME, HALF_VOLUME};
+    std::vector<corevu::CoreVuSphere> spheres(BATCH_COUNT);
+    std::vector<corevu::CoreVuRay> rays(BATCH_COUNT);
+    for (uint32_t i = 0; i < BATCH_COUNT; ++i)
+    {
+      spheres[i] = corevu::CoreVuSphere{
+          {position(random), position(random), position(random)}, 10.f};
+      rays[i] = corevu::CoreVuRay{
+          {position(random), position(random), position(random)},
+          glm::normalize(
+              glm::vec3{position(random), position(random), position(random)})};
+    }
+
+    corevu::CoreVuJobSystem job_system{};
+    std::vector<std::vector<corevu::CoreVuEntity>> results;
+    std::vector<corevu::CoreVuRayHit> hits(BATCH_COUNT);
+    const double spheres_ms = MeasureBest(
+        [&] { m_tree.querySpheres(job_system, spheres, results); });
+    const double rays_ms = MeasureBest(
+        [&] { m_tree.raycastClosest(job_system, rays, hits); });
+
+    size_t sphere_hits = 0;
+    for (const auto& result : results)
+    {
+      sphere_hits += result.size();
+    }
+    std::printf(
+        "%u spheres %.3f ms(%zu hits), %u rays %.3f ms, %u threads\n",
+        BATCH_COUNT, spheres_ms, sphere_hits, BATCH_COUNT, rays_ms,
+        job_system.getThreadCount());
+  }
+
+  corevu::CoreVuAabbTree m_tree;
+  std::vector<corevu::CoreVuAabb> m_boxes;
+  std::vector<corevu::CoreVuAabbTree::ProxyId> m_proxies;
+  double m_build_ms{0.0};
+};
+} // namespace corevutest
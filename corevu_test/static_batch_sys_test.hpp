@@ -0,0 +1,272 @@
+#pragma once
+
+#include <corevu/include/corevu_model.hpp>
+#include <corevu/include/jobs/corevu_job_system.hpp>
+#include <corevu/include/scene/corevu_static_batcher.hpp>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace corevutest
+{
+/** NOTE
+* Static batching on the CPU, CoreVuStaticBatcher::Merge(), no device.
+  merge: props moved, turned, scaled and mirrored(negative scale) end up in a
+single batch, every merged vertex is its source vertex through the world
+matrix of its prop, normals through the inverse transpose. The triangles of
+the mirrored prop have two corners swapped, so every merged triangle still
+winds counter clockwise around its vertex normals.
+  grouping: props are merged per grid cell of their world bounding sphere
+(negative cells included) and per pipeline, props alone in a group are left
+out.
+  split: a group is cut where the next prop would go past MAX_BATCH_VERTICES,
+a batch of exactly MAX_BATCH_VERTICES is allowed.
+
+Prints FAILURE:: and throws at the first check that fails.
+*/
+class StaticBatchSysTest
+{
+public:
+  void run()
+  {
+    if (!checkMerge() || !checkGrouping() || !checkSplit())
+    {
+      throw std::runtime_error("FAILURE::static batch checks failed");
+    }
+    std::cout << "Static batch checks passed\n";
+  }
+
+private:
+  static constexpr float EPSILON = 1e-4f;
+  // corners of a source triangle in merged order
+  static constexpr uint32_t FORWARD[] = {0, 1, 2};
+  static constexpr uint32_t MIRRORED[] = {0, 2, 1};
+
+  static bool Expect(bool condition, const char* message)
+  {
+    if (!condition)
+    {
+      std::cout << "FAILURE::" << message << "\n";
+    }
+    return condition;
+  }
+
+  static bool Near(const glm::vec3& a, const glm::vec3& b)
+  {
+    return glm::length(a - b) <= EPSILON;
+  }
+
+  /* A unit quad in the xy plane around the origin, facing +z, counter
+   * clockwise seen from the front. */
+  static corevu::CoreVuModel::Builder Quad()
+  {
+    corevu::CoreVuModel::Builder quad{};
+    const glm::vec2 corners[] = {{-.5f, -.5f}, {.5f, -.5f}, {.5f, .5f},
+                                 {-.5f, .5f}};
+    for (const glm::vec2& corner : corners)
+    {
+      corevu::CoreVuModel::Vertex vertex{};
+      vertex.position = glm::vec3{corner, 0.f};
+      vertex.normal = glm::vec3{0.f, 0.f, 1.f};
+      vertex.texCoord = corner + .5f;
+      quad.vertices.push_back(vertex);
+    }
+    for (uint32_t index : {0u, 1u, 2u, 2u, 3u, 0u})
+    {
+      quad.indices.push_back(index);
+    }
+    quad.computeBounds();
+    return quad;
+  }
+
+  static corevu::CoreVuStaticBatchMesh Prop(
+      const corevu::CoreVuModel::Builder& source, const glm::vec3& position,
+      bool textured = false)
+  {
+    return corevu::CoreVuStaticBatchMesh{
+        &source, glm::translate(glm::mat4{1.f}, position), textured, nullptr};
+  }
+
+  bool checkMerge()
+  {
+    const corevu::CoreVuModel::Builder quad = Quad();
+    const glm::mat4 identity{1.f};
+    const glm::mat4 moved = glm::rotate(
+        glm::translate(identity, {3.f, 1.f, 0.f}), 1.f, {0.f, 1.f, 0.f});
+    const glm::mat4 scaled = glm::scale(
+        glm::rotate(glm::translate(identity, {0.f, 4.f, 2.f}), .5f,
+                    {1.f, 0.f, 0.f}),
+        {1.f, 2.f, 3.f});
+    const glm::mat4 mirrored = glm::scale(
+        glm::translate(identity, {6.f, 0.f, 1.f}), {-1.f, 1.f, 2.f});
+    const std::vector<corevu::CoreVuStaticBatchMesh> meshes{
+        {&quad, identity, false, nullptr},
+        {&quad, moved, false, nullptr},
+        {&quad, scaled, false, nullptr},
+        {&quad, mirrored, false, nullptr}};
+
+    corevu::CoreVuJobSystem job_system{2};
+    const auto batches =
+        corevu::CoreVuStaticBatcher::Merge(meshes, 16.f, &job_system);
+    if (!Expect(batches.size() == 1, "props of one cell not in one batch") ||
+        !Expect(
+            batches[0].meshes == std::vector<uint32_t>({0, 1, 2, 3}),
+            "batch lost a prop or changed their order"))
+    {
+      return false;
+    }
+
+    const corevu::CoreVuModel::Builder& batch = batches[0].builder;
+    const uint32_t vertex_count = static_cast<uint32_t>(quad.vertices.size());
+    const uint32_t index_count = static_cast<uint32_t>(quad.indices.size());
+    if (!Expect(
+            batch.vertices.size() == meshes.size() * vertex_count &&
+                batch.indices.size() == meshes.size() * index_count,
+            "merged buffers have the wrong size"))
+    {
+      return false;
+    }
+
+    for (uint32_t mesh = 0; mesh < meshes.size(); ++mesh)
+    {
+      const glm::mat4& world_matrix = meshes[mesh].world_matrix;
+      const glm::mat3 normal_matrix =
+          glm::transpose(glm::inverse(glm::mat3{world_matrix}));
+      for (uint32_t i = 0; i < vertex_count; ++i)
+      {
+        const auto& source = quad.vertices[i];
+        const auto& merged = batch.vertices[mesh * vertex_count + i];
+        const glm::vec3 position{
+            world_matrix * glm::vec4{source.position, 1.f}};
+        const glm::vec3 normal = glm::normalize(normal_matrix * source.normal);
+        if (!Expect(
+                Near(merged.position, position),
+                "merged position is not the prop transform") ||
+            !Expect(
+                Near(merged.normal, normal),
+                "merged normal is not the prop normal transform") ||
+            !Expect(
+                merged.texCoord == source.texCoord,
+                "merged vertex lost its attributes"))
+        {
+          return false;
+        }
+      }
+
+      // same corners per triangle, only mirrored props wind the other way
+      const bool flip = glm::determinant(glm::mat3{world_matrix}) < 0.f;
+      for (uint32_t i = 0; i < index_count; i += 3)
+      {
+        const uint32_t* expected_corners = flip ? MIRRORED : FORWARD;
+        for (uint32_t corner = 0; corner < 3; ++corner)
+        {
+          const uint32_t expected =
+              mesh * vertex_count +
+              quad.indices[i + expected_corners[corner]].value;
+          if (!Expect(
+                  batch.indices[mesh * index_count + i + corner].value ==
+                      expected,
+                  "triangle corners not swapped for a mirrored prop"))
+          {
+            return false;
+          }
+        }
+      }
+    }
+
+    for (uint32_t i = 0; i < batch.indices.size(); i += 3)
+    {
+      const auto& a = batch.vertices[batch.indices[i].value];
+      const auto& b = batch.vertices[batch.indices[i + 1].value];
+      const auto& c = batch.vertices[batch.indices[i + 2].value];
+      const glm::vec3 face =
+          glm::cross(b.position - a.position, c.position - a.position);
+      if (!Expect(
+              glm::dot(face, a.normal) > 0.f, "merged triangle inside out"))
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /* Cells of 4 units:
+   *   untextured  x -3, -2 -> cell -1     x 1, 2, 3 -> cell 0
+   *               x 5      -> cell 1      y 9       -> cell (0, 2)
+   *   textured    x 1      -> cell 0
+   * two batches, the props at x 5, y 9 and the textured one stay out. */
+  bool checkGrouping()
+  {
+    const corevu::CoreVuModel::Builder quad = Quad();
+    const std::vector<corevu::CoreVuStaticBatchMesh> meshes{
+        Prop(quad, {1.f, 0.f, 0.f}),       Prop(quad, {-3.f, 0.f, 0.f}),
+        Prop(quad, {5.f, 0.f, 0.f}),       Prop(quad, {1.f, 0.f, 0.f}, true),
+        Prop(quad, {2.f, 0.f, 0.f}),       Prop(quad, {1.f, 9.f, 0.f}),
+        Prop(quad, {-2.f, 0.f, 0.f}),      Prop(quad, {3.f, 0.f, 0.f})};
+
+    const auto batches = corevu::CoreVuStaticBatcher::Merge(meshes, 4.f);
+    if (!Expect(batches.size() == 2, "wrong number of batches"))
+    {
+      return false;
+    }
+    return Expect(
+               batches[0].meshes == std::vector<uint32_t>({1, 6}),
+               "negative cell grouped wrong") &&
+           Expect(
+               batches[1].meshes == std::vector<uint32_t>({0, 4, 7}),
+               "cell or pipeline grouped wrong");
+  }
+
+  /* Two props of half MAX_BATCH_VERTICES - 2 and a quad fill a batch
+   * exactly, the next quads start a new one. */
+  bool checkSplit()
+  {
+    const uint32_t max_vertices =
+        corevu::CoreVuStaticBatcher::MAX_BATCH_VERTICES;
+    corevu::CoreVuModel::Builder large{};
+    // without indices, drawn in order
+    large.vertices.resize(max_vertices / 2 - 2);
+    for (size_t i = 0; i < large.vertices.size(); ++i)
+    {
+      large.vertices[i].position =
+          glm::vec3{static_cast<float>(i % 3), static_cast<float>(i % 2), 0.f};
+      large.vertices[i].normal = glm::vec3{0.f, 0.f, 1.f};
+    }
+    large.computeBounds();
+    const corevu::CoreVuModel::Builder quad = Quad();
+
+    const std::vector<corevu::CoreVuStaticBatchMesh> meshes{
+        Prop(large, glm::vec3{0.f}), Prop(large, glm::vec3{0.f}),
+        Prop(quad, glm::vec3{0.f}),  Prop(quad, glm::vec3{0.f}),
+        Prop(quad, glm::vec3{0.f})};
+    const auto batches = corevu::CoreVuStaticBatcher::Merge(meshes, 16.f);
+    if (!Expect(batches.size() == 2, "full group not split in two") ||
+        !Expect(
+            batches[0].meshes == std::vector<uint32_t>({0, 1, 2}) &&
+                batches[1].meshes == std::vector<uint32_t>({3, 4}),
+            "group split at the wrong prop") ||
+        !Expect(
+            batches[0].builder.vertices.size() == max_vertices,
+            "first batch not filled up to MAX_BATCH_VERTICES"))
+    {
+      return false;
+    }
+
+    // the indexless props are drawn in order, the quad behind them indexed
+    const auto& indices = batches[0].builder.indices;
+    const uint32_t large_count = static_cast<uint32_t>(large.vertices.size());
+    return Expect(
+        indices.size() == 2 * large_count + quad.indices.size() &&
+            indices[large_count].value == large_count &&
+            indices[2 * large_count].value == 2 * large_count,
+        "indexless props not drawn in order");
+  }
+};
+} // namespace corevutest
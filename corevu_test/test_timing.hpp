@@ -0,0 +1,30 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace corevutest
+{
+// wall clock time of one call of fn in ms
+template <typename Fn>
+double Measure(Fn&& fn)
+{
+  const auto start = std::chrono::steady_clock::now();
+  fn();
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/* Fastest of runs calls of fn in ms, the later runs find warm caches and
+ * already touched pages, the best one is the least disturbed. */
+template <typename Fn>
+double MeasureBest(Fn&& fn, int runs = 5)
+{
+  double best = Measure(fn);
+  for (int i = 1; i < runs; ++i)
+  {
+    best = std::min(best, Measure(fn));
+  }
+  return best;
+}
+} // namespace corevutest